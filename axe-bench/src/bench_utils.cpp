@@ -0,0 +1,127 @@
+#include "bench_utils.h"
+
+// std headers
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace Axe
+{
+	double MeasureMilliseconds( const uint32_t runs, const std::function<void()>& function )
+	{
+		double fastest = std::numeric_limits<double>::max();
+
+		for ( uint32_t i = 0; i < runs; i++ )
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			const auto end = std::chrono::steady_clock::now();
+
+			fastest = std::min( fastest, std::chrono::duration<double, std::milli>( end - start ).count() );
+		}
+
+		return fastest;
+	}
+
+	void WriteScaledObj( const std::string& sourcePath, const uint32_t copies, const std::string& outputPath )
+	{
+		std::ifstream source{ sourcePath };
+		if ( !source.is_open() )
+		{
+			throw std::runtime_error( "Failed to open " + sourcePath );
+		}
+
+		std::vector<std::string> lines = {};
+		int positionCount = 0;
+		int texcoordCount = 0;
+		int normalCount = 0;
+
+		for ( std::string line; std::getline( source, line ); )
+		{
+			if ( !line.empty() && line.back() == '\r' )
+			{
+				line.pop_back();
+			}
+
+			positionCount += line.starts_with( "v " );
+			texcoordCount += line.starts_with( "vt " );
+			normalCount += line.starts_with( "vn " );
+
+			lines.push_back( std::move( line ) );
+		}
+
+		std::ofstream output{ outputPath, std::ios::binary | std::ios::trunc };
+		if ( !output.is_open() )
+		{
+			throw std::runtime_error( "Failed to create " + outputPath );
+		}
+
+		for ( uint32_t copy = 0; copy < copies; copy++ )
+		{
+			const int offsets[ 3 ] = {
+				static_cast<int>(copy) * positionCount,
+				static_cast<int>(copy) * texcoordCount,
+				static_cast<int>(copy) * normalCount,
+			};
+
+			for ( const std::string& line : lines )
+			{
+				if ( line.starts_with( "v " ) )
+				{
+					std::istringstream values{ line.substr( 2 ) };
+					float x, y, z;
+					values >> x >> y >> z;
+
+					std::string rest;
+					std::getline( values, rest );
+
+					output << "v " << x + 2.0f * static_cast<float>(copy) << ' ' << y << ' ' << z << rest << '\n';
+				}
+				else if ( line.starts_with( "f " ) )
+				{
+					std::istringstream corners{ line.substr( 2 ) };
+					output << 'f';
+
+					for ( std::string corner; corners >> corner; )
+					{
+						output << ' ';
+
+						// v, v/vt, v//vn or v/vt/vn, only positive indices need moving
+						size_t component = 0;
+						size_t start = 0;
+						while ( true )
+						{
+							const size_t slash = corner.find( '/', start );
+							const std::string index = corner.substr( start, slash == std::string::npos ? std::string::npos : slash - start );
+
+							if ( !index.empty() )
+							{
+								const int value = std::stoi( index );
+								output << ( value > 0 ? value + offsets[ component ] : value );
+							}
+
+							if ( slash == std::string::npos )
+							{
+								break;
+							}
+
+							output << '/';
+							start = slash + 1;
+							component++;
+						}
+					}
+
+					output << '\n';
+				}
+				else
+				{
+					output << line << '\n';
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Axe
+{
+	// Runs the function the given number of times and returns the fastest run in milliseconds
+	double MeasureMilliseconds( uint32_t runs, const std::function<void()>& function );
+
+	// Writes copies of an OBJ file with absolute indices next to each other into one big file,
+	// each copy moved along X so none of its vertices are shared with the others
+	void WriteScaledObj( const std::string& sourcePath, uint32_t copies, const std::string& outputPath );
+}
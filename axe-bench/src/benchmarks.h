@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Axe
+{
+	// Each benchmark takes the command line arguments following its name and returns the process exit code
+	int RunObjParserBenchmark( const std::vector<std::string>& arguments );
+	int RunVertexWelderBenchmark( const std::vector<std::string>& arguments );
+	int RunVertexQuantizationBenchmark( const std::vector<std::string>& arguments );
+	int RunMeshCodecBenchmark( const std::vector<std::string>& arguments );
+	int RunFrustumCullingBenchmark( const std::vector<std::string>& arguments );
+	int RunRenderQueueBenchmark( const std::vector<std::string>& arguments );
+	int RunLightClustersBenchmark( const std::vector<std::string>& arguments );
+}
@@ -0,0 +1,98 @@
+#include "benchmarks.h"
+
+#include "bench_utils.h"
+
+#include "axe_camera.h"
+#include "axe_frustum_culler.h"
+
+// std headers
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace Axe
+{
+	// One sphere at a time with glm, the way the meshlet culler tests its bounds, as the baseline
+	static uint32_t CullScalar( const std::vector<glm::vec4>& spheres, const std::array<glm::vec4, 6>& planes, std::vector<uint8_t>& visibility )
+	{
+		uint32_t visibleCount = 0;
+
+		for ( size_t i = 0; i < spheres.size(); i++ )
+		{
+			bool outside = false;
+			for ( const glm::vec4& plane : planes )
+			{
+				outside |= glm::dot( glm::vec3{ plane }, glm::vec3{ spheres[ i ] } ) + plane.w < -spheres[ i ].w;
+			}
+
+			visibility[ i ] = !outside;
+			visibleCount += !outside;
+		}
+
+		return visibleCount;
+	}
+
+	// Culls random spheres scattered around a camera looking down the Z axis, with the scalar loop and the SSE kernel of AxeFrustumCuller
+	// Usage: axe-bench cull [spheres] [runs]
+	int RunFrustumCullingBenchmark( const std::vector<std::string>& arguments )
+	{
+		const uint32_t sphereCount = arguments.size() > 0 ? static_cast<uint32_t>(std::stoul( arguments[ 0 ] )) : 1'000'000;
+		const uint32_t runs = arguments.size() > 1 ? static_cast<uint32_t>(std::stoul( arguments[ 1 ] )) : 10;
+
+		AxeCamera camera = {};
+		camera.SetPerspectiveProjection( glm::radians( 90.0f ), 4.0f / 3.0f, 0.1f, 100.0f );
+		camera.SetViewYXZ( glm::vec3{ 0.0f }, glm::vec3{ 0.0f } );
+		const std::array<glm::vec4, 6> planes = camera.GetFrustumPlanes();
+
+		// Fixed seed, so every run culls the same scene
+		std::mt19937 random{ 42 };
+		std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> radius{ 0.1f, 2.0f };
+
+		std::vector<glm::vec4> spheres( sphereCount );
+		for ( glm::vec4& sphere : spheres )
+		{
+			sphere = glm::vec4{ position( random ), position( random ), position( random ), radius( random ) };
+		}
+
+		std::vector<uint8_t> scalarVisibility( sphereCount );
+		uint32_t scalarVisibleCount = 0;
+		const double scalarTime = MeasureMilliseconds( runs, [&]() { scalarVisibleCount = CullScalar( spheres, planes, scalarVisibility ); } );
+
+		// Filling the arrays is part of every frame's work, so it's measured with the culling as well as apart from it
+		AxeFrustumCuller culler = {};
+		const double fillAndCullTime = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				culler.Clear();
+				for ( const glm::vec4& sphere : spheres )
+				{
+					culler.Add( sphere );
+				}
+				culler.Cull( planes );
+			} );
+		const double cullTime = MeasureMilliseconds( runs, [&]() { culler.Cull( planes ); } );
+
+		bool identical = culler.GetStatistics().visibleCount == scalarVisibleCount;
+		for ( uint32_t i = 0; i < sphereCount; i++ )
+		{
+			identical &= culler.IsVisible( i ) == ( scalarVisibility[ i ] != 0 );
+		}
+
+		std::cout << std::fixed << std::setprecision( 2 );
+		std::cout << sphereCount << " spheres, " << scalarVisibleCount << " visible\n";
+
+		for ( const auto& [ name, time ] : { std::pair{ "scalar", scalarTime }, std::pair{ "SSE fill and cull", fillAndCullTime }, std::pair{ "SSE cull only", cullTime } } )
+		{
+			std::cout << "    " << std::left << std::setw( 20 ) << name << std::right
+				<< std::setw( 9 ) << time << " ms  "
+				<< std::setw( 8 ) << static_cast<double>(sphereCount) / ( time * 1000.0 ) << " M spheres/s  "
+				<< std::setw( 5 ) << scalarTime / time << "x\n";
+		}
+
+		std::cout << ( identical ? "Results are identical\n" : "Results DIFFER\n" );
+
+		return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,144 @@
+#include "benchmarks.h"
+
+#include "bench_utils.h"
+
+#include "axe_camera.h"
+#include "axe_light_grid.h"
+
+// std headers
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace Axe
+{
+	// Assigns random point lights in front of a camera looking down the Z axis to the light grid's clusters, with the shared pool and a single
+	// worker, then lights random points in the view frustum by going through every light the way the fragment shader used to and through only
+	// the lights of their cluster, and checks that both find the same lights
+	// Usage: axe-bench clusters [lights] [points] [runs]
+	int RunLightClustersBenchmark( const std::vector<std::string>& arguments )
+	{
+		const uint32_t lightCount = arguments.size() > 0 ? static_cast<uint32_t>(std::stoul( arguments[ 0 ] )) : 4096;
+		const uint32_t pointCount = arguments.size() > 1 ? static_cast<uint32_t>(std::stoul( arguments[ 1 ] )) : 100'000;
+		const uint32_t runs = arguments.size() > 2 ? static_cast<uint32_t>(std::stoul( arguments[ 2 ] )) : 10;
+
+		constexpr float NEAR = 0.1f;
+		constexpr float FAR = 100.0f;
+
+		AxeCamera camera = {};
+		camera.SetPerspectiveProjection( glm::radians( 90.0f ), 16.0f / 9.0f, NEAR, FAR );
+		camera.SetViewYXZ( glm::vec3{ 0.0f }, glm::vec3{ 0.0f } );
+		const glm::mat4& projection = camera.GetProjection();
+
+		// Fixed seed, so every run lights the same scene
+		std::mt19937 random{ 42 };
+		std::uniform_real_distribution<float> lightX{ -80.0f, 80.0f };
+		std::uniform_real_distribution<float> lightY{ -45.0f, 45.0f };
+		std::uniform_real_distribution<float> lightZ{ 0.0f, FAR };
+		std::uniform_real_distribution<float> lightRange{ 0.5f, 4.0f };
+
+		std::vector<glm::vec4> lights( lightCount );
+		for ( glm::vec4& light : lights )
+		{
+			light = glm::vec4{ lightX( random ), lightY( random ), lightZ( random ), lightRange( random ) };
+		}
+
+		// Spread over the screen and, like the slices, evenly over the logarithm of the depth
+		std::uniform_real_distribution<float> ndc{ -1.0f, 1.0f };
+		std::uniform_real_distribution<float> logDepth{ std::log( NEAR ), std::log( FAR ) };
+
+		std::vector<glm::vec3> points( pointCount );
+		for ( glm::vec3& point : points )
+		{
+			const float depth = std::exp( logDepth( random ) );
+			point = glm::vec3{ ndc( random ) * depth / projection[ 0 ][ 0 ], ndc( random ) * depth / projection[ 1 ][ 1 ], depth };
+		}
+
+		AxeLightGrid lightGrid = {};
+		const double assignTime = MeasureMilliseconds(
+			runs,
+			[&]() { lightGrid.Assign( lights, camera.GetView(), projection, NEAR, FAR ); } );
+
+		AxeThreadPool singleWorker{ 1 };
+		AxeLightGrid singleWorkerGrid = {};
+		const double singleWorkerAssignTime = MeasureMilliseconds(
+			runs,
+			[&]() { singleWorkerGrid.Assign( lights, camera.GetView(), projection, NEAR, FAR, singleWorker ); } );
+
+		// The light count reaching each point, summed over all points so the loops can't be optimized away
+		const auto reaches = []( const glm::vec4& light, const glm::vec3& point )
+		{
+			const glm::vec3 offset = glm::vec3{ light } - point;
+			return glm::dot( offset, offset ) < light.w * light.w;
+		};
+
+		std::vector<uint32_t> bruteForceCounts( pointCount );
+		const double bruteForceTime = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				for ( uint32_t i = 0; i < pointCount; i++ )
+				{
+					uint32_t count = 0;
+					for ( const glm::vec4& light : lights )
+					{
+						count += reaches( light, points[ i ] );
+					}
+					bruteForceCounts[ i ] = count;
+				}
+			} );
+
+		std::vector<uint32_t> clusteredCounts( pointCount );
+		uint64_t testedCount = 0;
+		const double clusteredTime = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				testedCount = 0;
+				for ( uint32_t i = 0; i < pointCount; i++ )
+				{
+					const AxeLightGrid::Cluster& cluster = lightGrid.GetClusters()[ lightGrid.FindCluster( points[ i ] ) ];
+
+					uint32_t count = 0;
+					for ( uint32_t j = cluster.offset; j < cluster.offset + cluster.count; j++ )
+					{
+						count += reaches( lights[ lightGrid.GetLightIndices()[ j ] ], points[ i ] );
+					}
+					clusteredCounts[ i ] = count;
+					testedCount += cluster.count;
+				}
+			} );
+
+		const bool identical = bruteForceCounts == clusteredCounts &&
+			lightGrid.GetClusters() == singleWorkerGrid.GetClusters() &&
+			lightGrid.GetLightIndices() == singleWorkerGrid.GetLightIndices();
+
+		const AxeLightGrid::Statistics& statistics = lightGrid.GetStatistics();
+
+		std::cout << std::fixed << std::setprecision( 2 );
+		std::cout << lightCount << " lights, " << statistics.visibleLightCount << " in view, " << AxeLightGrid::CLUSTER_COUNT << " clusters, "
+			<< statistics.indexCount << " light indices, at most " << statistics.maxClusterLightCount << " per cluster\n";
+
+		std::cout << "Assigning lights to clusters\n";
+		for ( const auto& [ name, time ] : { std::pair{ "1 worker", singleWorkerAssignTime }, std::pair{ "shared pool", assignTime } } )
+		{
+			std::cout << "    " << std::left << std::setw( 20 ) << name << std::right
+				<< std::setw( 9 ) << time << " ms  "
+				<< std::setw( 5 ) << singleWorkerAssignTime / time << "x\n";
+		}
+
+		std::cout << "Lighting " << pointCount << " points, " << static_cast<double>(testedCount) / pointCount << " lights tested per point when clustered\n";
+		for ( const auto& [ name, time ] : { std::pair{ "every light", bruteForceTime }, std::pair{ "cluster's lights", clusteredTime } } )
+		{
+			std::cout << "    " << std::left << std::setw( 20 ) << name << std::right
+				<< std::setw( 9 ) << time << " ms  "
+				<< std::setw( 8 ) << static_cast<double>(pointCount) / ( time * 1000.0 ) << " M points/s  "
+				<< std::setw( 8 ) << bruteForceTime / time << "x\n";
+		}
+
+		std::cout << ( identical ? "Results are identical\n" : "Results DIFFER\n" );
+
+		return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,42 @@
+#include "benchmarks.h"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+
+int main( int argc, char* argv[] )
+{
+	const std::map<std::string, std::function<int( const std::vector<std::string>& )>> benchmarks = {
+		{ "obj", Axe::RunObjParserBenchmark },
+		{ "weld", Axe::RunVertexWelderBenchmark },
+		{ "quantize", Axe::RunVertexQuantizationBenchmark },
+		{ "codec", Axe::RunMeshCodecBenchmark },
+		{ "cull", Axe::RunFrustumCullingBenchmark },
+		{ "queue", Axe::RunRenderQueueBenchmark },
+		{ "clusters", Axe::RunLightClustersBenchmark },
+	};
+
+	if ( argc < 2 || !benchmarks.contains( argv[ 1 ] ) )
+	{
+		std::cerr << "Usage: axe-bench <benchmark> [arguments...]\nBenchmarks:";
+		for ( const auto& [ name, benchmark ] : benchmarks )
+		{
+			std::cerr << " " << name;
+		}
+		std::cerr << "\n";
+
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		return benchmarks.at( argv[ 1 ] )( { argv + 2, argv + argc } );
+	}
+	catch ( const std::exception& e )
+	{
+		std::cerr << "\nError: " << e.what() << "\n";
+
+		return EXIT_FAILURE;
+	}
+}
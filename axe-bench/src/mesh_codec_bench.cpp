@@ -0,0 +1,160 @@
+#include "benchmarks.h"
+#include "bench_utils.h"
+
+#include "axe_geometry_pool.h"
+#include "axe_mesh_codec.h"
+#include "axe_mesh_optimizer.h"
+#include "axe_model.h"
+
+// std headers
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <stdexcept>
+
+namespace Axe
+{
+	// A sphere of resolution x resolution vertices with a bumpy surface, so positions and normals vary like in a scanned model
+	static AxeModel::Data CreateSyntheticMesh( const uint32_t resolution )
+	{
+		AxeModel::Data data{};
+		data.vertices.reserve( static_cast<size_t>(resolution) * resolution );
+
+		const auto surface = []( const float u, const float v )
+		{
+			const float theta = u * 2.0f * std::numbers::pi_v<float>;
+			const float phi = v * std::numbers::pi_v<float>;
+			const float radius = 1.0f + 0.05f * std::sin( theta * 7.0f ) * std::sin( phi * 11.0f );
+			return glm::vec3{ std::sin( phi ) * std::cos( theta ), std::cos( phi ), std::sin( phi ) * std::sin( theta ) } * radius;
+		};
+
+		const float step = 1.0f / static_cast<float>(resolution - 1);
+
+		for ( uint32_t y = 0; y < resolution; y++ )
+		{
+			for ( uint32_t x = 0; x < resolution; x++ )
+			{
+				const float u = static_cast<float>(x) * step;
+				const float v = static_cast<float>(y) * step;
+
+				AxeModel::Vertex vertex{};
+				vertex.position = surface( u, v );
+				vertex.color = { 1.0f, 1.0f, 1.0f };
+				vertex.uv = { u, v };
+
+				const glm::vec3 normal = glm::cross( surface( u, v + step * 0.5f ) - vertex.position, surface( u + step * 0.5f, v ) - vertex.position );
+				vertex.normal = glm::length( normal ) > 0.0f ? glm::normalize( normal ) : glm::vec3{ 0.0f, 1.0f, 0.0f };
+
+				data.vertices.push_back( vertex );
+			}
+		}
+
+		for ( uint32_t y = 0; y + 1 < resolution; y++ )
+		{
+			for ( uint32_t x = 0; x + 1 < resolution; x++ )
+			{
+				const uint32_t corner = y * resolution + x;
+				data.indices.insert( data.indices.end(), { corner, corner + resolution, corner + 1, corner + 1, corner + resolution, corner + resolution + 1 } );
+			}
+		}
+
+		data.ComputeBounds();
+		return data;
+	}
+
+	static void BenchmarkMesh( const std::string& name, AxeModel::Data& data, const uint32_t runs )
+	{
+		// Encoded the way the mesh cache stores them, after optimizing and at the index width the geometry pool uses
+		AxeMeshOptimizer::Optimize( data );
+
+		const uint32_t indexSize = data.vertices.size() <= AxeGeometryPool::MAX_UINT16_VERTEX_COUNT ? sizeof( uint16_t ) : sizeof( uint32_t );
+		std::vector<uint16_t> narrowIndices( data.indices.begin(), data.indices.end() );
+		const void* indices = indexSize == sizeof( uint16_t ) ? static_cast<const void*>(narrowIndices.data()) : data.indices.data();
+
+		std::vector<std::byte> encodedVertices = {};
+		std::vector<std::byte> encodedIndices = {};
+
+		const double encodeMilliseconds = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				encodedVertices = AxeMeshCodec::EncodeWords( data.vertices.data(), data.vertices.size(), sizeof( AxeModel::Vertex ) );
+				encodedIndices = AxeMeshCodec::EncodeIndices( indices, data.indices.size(), indexSize );
+			} );
+
+		std::vector<AxeModel::Vertex> decodedVertices( data.vertices.size() );
+		std::vector<std::byte> decodedIndices( data.indices.size() * indexSize );
+
+		const double vertexMilliseconds = MeasureMilliseconds(
+			runs,
+			[&]() { AxeMeshCodec::DecodeWords( encodedVertices, decodedVertices.data(), decodedVertices.size(), sizeof( AxeModel::Vertex ) ); } );
+		const double indexMilliseconds = MeasureMilliseconds(
+			runs,
+			[&]() { AxeMeshCodec::DecodeIndices( encodedIndices, decodedIndices.data(), data.indices.size(), indexSize ); } );
+
+		if ( memcmp( decodedVertices.data(), data.vertices.data(), data.vertices.size() * sizeof( AxeModel::Vertex ) ) != 0 ||
+		     memcmp( decodedIndices.data(), indices, decodedIndices.size() ) != 0 )
+		{
+			throw std::runtime_error( "Decoded " + name + " differs from the original" );
+		}
+
+		const auto gigabytesPerSecond = []( const size_t bytes, const double milliseconds ) { return static_cast<double>(bytes) / ( milliseconds * 1e6 ); };
+		const auto ratio = []( const size_t raw, const size_t encoded ) { return static_cast<double>(raw) / static_cast<double>(encoded); };
+
+		const size_t vertexBytes = data.vertices.size() * sizeof( AxeModel::Vertex );
+		const size_t indexBytes = decodedIndices.size();
+		// The mesh cache stores the arrays encoding doesn't make any smaller as they are
+		const auto storage = []( const size_t raw, const size_t encoded ) { return encoded >= raw ? "  stored raw" : ""; };
+
+		std::cout << name << " (" << data.vertices.size() << " vertices, " << data.indices.size() / 3 << " triangles, " << indexSize * 8 << "-bit indices)\n"
+			<< "    vertices " << std::setw( 11 ) << vertexBytes << " -> " << std::setw( 11 ) << encodedVertices.size()
+			<< "  ratio " << std::setw( 5 ) << ratio( vertexBytes, encodedVertices.size() )
+			<< "  decode " << std::setw( 5 ) << gigabytesPerSecond( vertexBytes, vertexMilliseconds ) << " GB/s"
+			<< storage( vertexBytes, encodedVertices.size() ) << "\n"
+			<< "    indices  " << std::setw( 11 ) << indexBytes << " -> " << std::setw( 11 ) << encodedIndices.size()
+			<< "  ratio " << std::setw( 5 ) << ratio( indexBytes, encodedIndices.size() )
+			<< "  decode " << std::setw( 5 ) << gigabytesPerSecond( indexBytes, indexMilliseconds ) << " GB/s"
+			<< storage( indexBytes, encodedIndices.size() ) << "\n"
+			<< "    total ratio " << ratio( vertexBytes + indexBytes, encodedVertices.size() + encodedIndices.size() )
+			<< ", encode " << encodeMilliseconds << " ms, decode " << vertexMilliseconds + indexMilliseconds << " ms on one thread\n";
+	}
+
+	// Encodes the optimized vertex and index arrays of the shipped models and of synthetic meshes with AxeMeshCodec,
+	// checks that they decode to the originals and reports the compression ratio and single threaded decoding speed
+	// Usage: axe-bench codec [runs] [synthetic resolution...]
+	int RunMeshCodecBenchmark( const std::vector<std::string>& arguments )
+	{
+		const uint32_t runs = arguments.size() > 0 ? static_cast<uint32_t>(std::stoul( arguments[ 0 ] )) : 10;
+
+		std::vector<uint32_t> resolutions = { 256, 1024, 2048 };
+		if ( arguments.size() > 1 )
+		{
+			resolutions.clear();
+			for ( size_t i = 1; i < arguments.size(); i++ )
+			{
+				resolutions.push_back( static_cast<uint32_t>(std::stoul( arguments[ i ] )) );
+			}
+		}
+
+		std::cout << std::fixed << std::setprecision( 2 );
+
+		for ( const std::string modelPath : { "../axe-engine/models/smooth_vase.obj", "../axe-engine/models/flat_vase.obj", "../axe-engine/models/colored_cube.obj" } )
+		{
+			AxeModel::Data data{};
+			data.LoadModel( modelPath );
+
+			BenchmarkMesh( modelPath, data, runs );
+		}
+
+		for ( const uint32_t resolution : resolutions )
+		{
+			AxeModel::Data data = CreateSyntheticMesh( resolution );
+
+			BenchmarkMesh( "synthetic sphere " + std::to_string( resolution ) + "x" + std::to_string( resolution ), data, runs );
+		}
+
+		return EXIT_SUCCESS;
+	}
+}
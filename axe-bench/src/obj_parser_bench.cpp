@@ -0,0 +1,68 @@
+#include "benchmarks.h"
+
+#include "bench_utils.h"
+
+#include "axe_model.h"
+#include "axe_obj_parser.h"
+#include "axe_thread_pool.h"
+
+// std headers
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace Axe
+{
+	// Compares AxeObjParser against the tinyobjloader path on a scaled up model, for every power of two thread count
+	// Usage: axe-bench obj [model.obj] [copies] [runs]
+	int RunObjParserBenchmark( const std::vector<std::string>& arguments )
+	{
+		const std::string sourcePath = arguments.size() > 0 ? arguments[ 0 ] : "../axe-engine/models/smooth_vase.obj";
+		const uint32_t copies = arguments.size() > 1 ? static_cast<uint32_t>(std::stoul( arguments[ 1 ] )) : 64;
+		const uint32_t runs = arguments.size() > 2 ? static_cast<uint32_t>(std::stoul( arguments[ 2 ] )) : 3;
+
+		const std::string scaledPath = ( std::filesystem::temp_directory_path() / "axe_bench_scaled.obj" ).string();
+		WriteScaledObj( sourcePath, copies, scaledPath );
+
+		const double megabytes = static_cast<double>(std::filesystem::file_size( scaledPath )) / ( 1024.0 * 1024.0 );
+
+		std::cout << std::fixed << std::setprecision( 1 );
+		std::cout << sourcePath << " x" << copies << " (" << megabytes << " MiB)\n";
+
+		AxeModel::Data reference{};
+		const double referenceTime = MeasureMilliseconds( runs, [&]() { reference.LoadModelWithTinyObj( scaledPath ); } );
+
+		std::cout << "  tinyobjloader          " << std::setw( 9 ) << referenceTime << " ms  "
+			<< std::setw( 7 ) << megabytes / ( referenceTime / 1000.0 ) << " MiB/s  "
+			<< reference.vertices.size() << " vertices, " << reference.indices.size() << " indices\n";
+
+		bool identical = true;
+		const uint32_t maxThreads = std::max( std::thread::hardware_concurrency(), 1u );
+
+		for ( uint32_t threads = 1; ; threads = std::min( threads * 2, maxThreads ) )
+		{
+			AxeThreadPool threadPool{ threads };
+			std::vector<AxeModel::Vertex> vertices;
+			std::vector<uint32_t> indices;
+
+			const double time = MeasureMilliseconds( runs, [&]() { AxeObjParser::Parse( scaledPath, vertices, indices, threadPool ); } );
+
+			const bool matches = vertices == reference.vertices && indices == reference.indices;
+			identical &= matches;
+
+			std::cout << "  AxeObjParser " << std::setw( 2 ) << threads << " threads " << std::setw( 9 ) << time << " ms  "
+				<< std::setw( 7 ) << megabytes / ( time / 1000.0 ) << " MiB/s  "
+				<< std::setw( 5 ) << referenceTime / time << "x  " << ( matches ? "identical" : "MISMATCH" ) << "\n";
+
+			if ( threads == maxThreads )
+			{
+				break;
+			}
+		}
+
+		std::filesystem::remove( scaledPath );
+
+		return identical ? 0 : 1;
+	}
+}
@@ -0,0 +1,82 @@
+#include "benchmarks.h"
+
+#include "bench_utils.h"
+
+#include "axe_render_queue.h"
+
+// std headers
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace Axe
+{
+	// Sorts a frame's worth of opaque and transparent packets with std::stable_sort and with the render queue's radix sort
+	// Usage: axe-bench queue [packets] [runs]
+	int RunRenderQueueBenchmark( const std::vector<std::string>& arguments )
+	{
+		const uint32_t packetCount = arguments.size() > 0 ? static_cast<uint32_t>(std::stoul( arguments[ 0 ] )) : 100'000;
+		const uint32_t runs = arguments.size() > 1 ? static_cast<uint32_t>(std::stoul( arguments[ 1 ] )) : 20;
+
+		// A scene's worth of state, a few pipelines and materials, a few hundred models and every tenth packet transparent.
+		// Fixed seed, so every run sorts the same keys
+		std::mt19937 random{ 42 };
+		std::uniform_int_distribution<uint32_t> pipeline{ 0, 3 };
+		std::uniform_int_distribution<uint32_t> material{ 0, 15 };
+		std::uniform_int_distribution<uint32_t> model{ 0, 499 };
+		std::uniform_real_distribution<float> depth{ 0.0f, 10'000.0f };
+
+		std::vector<AxeRenderQueue::Packet> packets( packetCount );
+		for ( uint32_t i = 0; i < packetCount; i++ )
+		{
+			packets[ i ].key = i % 10 == 0
+				                   ? AxeRenderQueue::MakeTransparentKey( pipeline( random ), material( random ), model( random ), depth( random ) )
+				                   : AxeRenderQueue::MakeOpaqueKey( pipeline( random ), material( random ), model( random ), depth( random ) );
+			packets[ i ].payload = i;
+		}
+
+		std::vector<AxeRenderQueue::Packet> sorted = {};
+		const double stableSortTime = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				sorted = packets;
+				std::ranges::stable_sort( sorted, {}, &AxeRenderQueue::Packet::key );
+			} );
+
+		AxeRenderQueue renderQueue = {};
+		const double radixSortTime = MeasureMilliseconds(
+			runs,
+			[&]()
+			{
+				renderQueue.Clear();
+				for ( const AxeRenderQueue::Packet& packet : packets )
+				{
+					renderQueue.Submit( packet.key, packet.payload );
+				}
+				renderQueue.Sort();
+			} );
+
+		const std::span<const AxeRenderQueue::Packet> radixSorted = renderQueue.GetPackets();
+		const bool identical = std::ranges::equal(
+			sorted,
+			radixSorted,
+			[]( const AxeRenderQueue::Packet& a, const AxeRenderQueue::Packet& b ) { return a.key == b.key && a.payload == b.payload; } );
+
+		std::cout << std::fixed << std::setprecision( 3 );
+		std::cout << packetCount << " packets\n";
+
+		for ( const auto& [ name, time ] : { std::pair{ "std::stable_sort", stableSortTime }, std::pair{ "AxeRenderQueue", radixSortTime } } )
+		{
+			std::cout << "    " << std::left << std::setw( 18 ) << name << std::right
+				<< std::setw( 9 ) << time << " ms  "
+				<< std::setw( 8 ) << static_cast<double>(packetCount) / ( time * 1000.0 ) << " M packets/s  "
+				<< std::setw( 6 ) << stableSortTime / time << "x\n";
+		}
+
+		std::cout << ( identical ? "Results are identical\n" : "Results DIFFER\n" );
+
+		return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
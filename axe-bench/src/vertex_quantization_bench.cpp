@@ -0,0 +1,93 @@
+#include "benchmarks.h"
+
+#include "axe_model.h"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+
+namespace Axe
+{
+	struct ErrorStatistics
+	{
+		double max = 0.0;
+		double sum = 0.0;
+
+		void Add( const double error )
+		{
+			max = std::max( max, error );
+			sum += error;
+		}
+	};
+
+	static void PrintError( const std::string& name, const ErrorStatistics& error, const size_t count, const std::string& unit )
+	{
+		std::cout << "    " << std::left << std::setw( 10 ) << name << std::right
+			<< "max " << std::setw( 12 ) << error.max << unit
+			<< "  mean " << std::setw( 12 ) << error.sum / static_cast<double>(count) << unit << "\n";
+	}
+
+	// Packs every vertex of the models into AxeModel::PackedVertex and compares the decoded vertices with the originals
+	// Usage: axe-bench quantize [model.obj...]
+	int RunVertexQuantizationBenchmark( const std::vector<std::string>& arguments )
+	{
+		std::vector<std::string> modelPaths = arguments;
+		if ( modelPaths.empty() )
+		{
+			modelPaths = { "../axe-engine/models/smooth_vase.obj", "../axe-engine/models/flat_vase.obj", "../axe-engine/models/colored_cube.obj" };
+		}
+
+		std::cout << std::fixed << std::setprecision( 6 );
+
+		for ( const std::string& modelPath : modelPaths )
+		{
+			AxeModel::Data data{};
+			data.LoadModel( modelPath );
+
+			const double extent = glm::length( data.boundsMax - data.boundsMin );
+
+			ErrorStatistics position = {};
+			ErrorStatistics normal = {};
+			ErrorStatistics color = {};
+			ErrorStatistics uv = {};
+
+			for ( const AxeModel::Vertex& vertex : data.vertices )
+			{
+				const AxeModel::Vertex decoded = AxeModel::PackedVertex::Pack( vertex, data.boundsMin, data.boundsMax ).Unpack( data.boundsMin, data.boundsMax );
+
+				position.Add( glm::distance( vertex.position, decoded.position ) );
+				color.Add( glm::distance( vertex.color, decoded.color ) );
+				uv.Add( glm::distance( vertex.uv, decoded.uv ) );
+
+				// Zero normals have no direction to lose
+				if ( glm::length( vertex.normal ) > 0.0f )
+				{
+					const float cosine = glm::clamp( glm::dot( glm::normalize( vertex.normal ), decoded.normal ), -1.0f, 1.0f );
+					normal.Add( std::acos( static_cast<double>(cosine) ) * 180.0 / std::numbers::pi );
+				}
+			}
+
+			const size_t vertexCount = data.vertices.size();
+			const size_t indexBytes = data.indices.size() * sizeof( uint32_t );
+			const size_t fullBytes = vertexCount * sizeof( AxeModel::Vertex );
+			const size_t packedBytes = vertexCount * sizeof( AxeModel::PackedVertex );
+
+			std::cout << modelPath << " (" << vertexCount << " vertices)\n";
+			PrintError( "position", position, vertexCount, "" );
+			std::cout << "              relative to the bounds diagonal " << position.max / extent * 100.0 << "%\n";
+			PrintError( "normal", normal, vertexCount, " deg" );
+			PrintError( "color", color, vertexCount, "" );
+			PrintError( "uv", uv, vertexCount, "" );
+
+			std::cout << "    vertex bytes " << fullBytes << " -> " << packedBytes
+				<< ", with indices " << fullBytes + indexBytes << " -> " << packedBytes + indexBytes
+				<< " (saves " << std::setprecision( 1 ) << 100.0 * static_cast<double>(fullBytes - packedBytes) / static_cast<double>(fullBytes + indexBytes) << "%)\n"
+				<< std::setprecision( 6 );
+		}
+
+		return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,108 @@
+#include "benchmarks.h"
+
+#include "bench_utils.h"
+
+#include "axe_model.h"
+#include "axe_vertex_welder.h"
+
+// std headers
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+namespace Axe
+{
+	// The deduplication AxeModel used before the welder, as the baseline
+	static AxeVertexWelder::Result WeldWithUnorderedMap( const std::vector<AxeModel::Vertex>& corners )
+	{
+		AxeVertexWelder::Result result = {};
+		std::unordered_map<AxeModel::Vertex, uint32_t> uniqueVertices = {};
+
+		for ( const AxeModel::Vertex& vertex : corners )
+		{
+			if ( !uniqueVertices.contains( vertex ) )
+			{
+				uniqueVertices[ vertex ] = static_cast<uint32_t>(result.vertices.size());
+				result.vertices.push_back( vertex );
+			}
+			result.indices.push_back( uniqueVertices[ vertex ] );
+		}
+
+		return result;
+	}
+
+	static void PrintResult( const std::string& name, const double time, const double baselineTime, const size_t cornerCount, const bool matches )
+	{
+		std::cout << "    " << std::left << std::setw( 22 ) << name << std::right
+			<< std::setw( 9 ) << time << " ms  "
+			<< std::setw( 7 ) << static_cast<double>(cornerCount) / ( time * 1000.0 ) << " M corners/s  "
+			<< std::setw( 5 ) << baselineTime / time << "x  " << ( matches ? "identical" : "MISMATCH" ) << "\n";
+	}
+
+	// Welds the unindexed triangles of the vase models, repeated the given number of times side by side
+	// Usage: axe-bench weld [copies] [runs]
+	int RunVertexWelderBenchmark( const std::vector<std::string>& arguments )
+	{
+		const uint32_t copies = arguments.size() > 0 ? static_cast<uint32_t>(std::stoul( arguments[ 0 ] )) : 64;
+		const uint32_t runs = arguments.size() > 1 ? static_cast<uint32_t>(std::stoul( arguments[ 1 ] )) : 3;
+
+		const uint32_t maxThreads = std::max( std::thread::hardware_concurrency(), 1u );
+		bool identical = true;
+
+		std::cout << std::fixed << std::setprecision( 1 );
+
+		for ( const std::string modelPath : { "../axe-engine/models/smooth_vase.obj", "../axe-engine/models/flat_vase.obj" } )
+		{
+			AxeModel::Data data{};
+			data.LoadModel( modelPath );
+
+			std::vector<AxeModel::Vertex> corners = {};
+			corners.reserve( data.indices.size() * copies );
+
+			for ( uint32_t copy = 0; copy < copies; copy++ )
+			{
+				for ( const uint32_t index : data.indices )
+				{
+					AxeModel::Vertex vertex = data.vertices[ index ];
+					vertex.position.x += 2.0f * static_cast<float>(copy);
+					corners.push_back( vertex );
+				}
+			}
+
+			std::cout << modelPath << " x" << copies << " (" << corners.size() << " corners)\n";
+
+			AxeVertexWelder::Result baseline = {};
+			const double baselineTime = MeasureMilliseconds( runs, [&]() { baseline = WeldWithUnorderedMap( corners ); } );
+			PrintResult( "std::unordered_map", baselineTime, baselineTime, corners.size(), true );
+
+			const auto measure = [&]( const std::string& name, const AxeVertexWelder::Strategy strategy, AxeThreadPool& threadPool )
+			{
+				AxeVertexWelder::Result result = {};
+				const double time = MeasureMilliseconds( runs, [&]() { result = AxeVertexWelder::Weld( corners, strategy, threadPool ); } );
+
+				const bool matches = result.vertices == baseline.vertices && result.indices == baseline.indices;
+				identical &= matches;
+
+				PrintResult( name, time, baselineTime, corners.size(), matches );
+			};
+
+			measure( "hash table", AxeVertexWelder::Strategy::HashTable, AxeThreadPool::Shared() );
+
+			for ( uint32_t threads = 1; ; threads = std::min( threads * 2, maxThreads ) )
+			{
+				AxeThreadPool threadPool{ threads };
+				measure( "radix sort " + std::to_string( threads ) + " threads", AxeVertexWelder::Strategy::RadixSort, threadPool );
+
+				if ( threads == maxThreads )
+				{
+					break;
+				}
+			}
+
+			std::cout << "    " << baseline.vertices.size() << " unique vertices\n";
+		}
+
+		return identical ? 0 : 1;
+	}
+}
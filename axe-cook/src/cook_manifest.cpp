@@ -0,0 +1,82 @@
+#include "cook_manifest.h"
+
+// std headers
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Axe
+{
+	CookManifest::CookManifest( std::filesystem::path manifestPath, const uint64_t settingsHash )
+		: path{ std::move( manifestPath ) }, settingsHash{ settingsHash }
+	{
+		std::ifstream file{ path };
+		if ( !file.is_open() )
+		{
+			return;
+		}
+
+		uint64_t fileSettingsHash = 0;
+		if ( !( file >> std::hex >> fileSettingsHash ) || fileSettingsHash != settingsHash )
+		{
+			return;
+		}
+
+		// <size> <write time> <hash> <input>, the input is last since paths can contain spaces
+		std::string line;
+		while ( std::getline( file, line ) )
+		{
+			std::istringstream stream{ line };
+
+			Entry entry = {};
+			std::string input;
+			if ( stream >> std::dec >> entry.size >> entry.writeTime >> std::hex >> entry.hash && std::getline( stream >> std::ws, input ) )
+			{
+				entries[ input ] = entry;
+			}
+		}
+	}
+
+	std::optional<CookManifest::Entry> CookManifest::Find( const std::string& input ) const
+	{
+		std::scoped_lock lock{ mutex };
+
+		const auto entry = entries.find( input );
+		if ( entry == entries.end() )
+		{
+			return std::nullopt;
+		}
+
+		return entry->second;
+	}
+
+	void CookManifest::Record( const std::string& input, const Entry& entry )
+	{
+		std::scoped_lock lock{ mutex };
+		entries[ input ] = entry;
+	}
+
+	void CookManifest::Save() const
+	{
+		std::filesystem::path tempPath = path;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream file{ tempPath, std::ios::trunc };
+			if ( !file.is_open() )
+			{
+				throw std::runtime_error( "Failed to write cook manifest " + tempPath.string() );
+			}
+
+			std::scoped_lock lock{ mutex };
+
+			file << std::hex << settingsHash << "\n";
+			for ( const auto& [input, entry] : entries )
+			{
+				file << std::dec << entry.size << " " << entry.writeTime << " " << std::hex << entry.hash << " " << input << "\n";
+			}
+		}
+
+		std::filesystem::rename( tempPath, path );
+	}
+}
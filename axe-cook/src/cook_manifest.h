@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace Axe
+{
+	// Remembers the inputs the last cook built, so a rebuild can skip the ones whose content hasn't changed.
+	// A text file with one line per input, starting with a hash of everything that affects the outputs besides the inputs themselves.
+	class CookManifest
+	{
+	public:
+		struct Entry
+		{
+			uint64_t size = 0;
+			int64_t writeTime = 0;
+			uint64_t hash = 0;
+		};
+
+		// Starts out empty when the file doesn't exist or was written with different settings
+		CookManifest( std::filesystem::path manifestPath, uint64_t settingsHash );
+
+		CookManifest( const CookManifest& ) = delete;
+		CookManifest& operator=( const CookManifest& ) = delete;
+		CookManifest( CookManifest&& ) = delete;
+		CookManifest& operator=( CookManifest&& ) = delete;
+
+		// Thread safe, the cook jobs look up and record their inputs in parallel
+		[[nodiscard]] std::optional<Entry> Find( const std::string& input ) const;
+		void Record( const std::string& input, const Entry& entry );
+
+		// Writes to a temporary file first, like the mesh cache
+		void Save() const;
+
+	private:
+		std::filesystem::path path;
+		uint64_t settingsHash;
+
+		mutable std::mutex mutex;
+		std::unordered_map<std::string, Entry> entries = {};
+	};
+}
@@ -0,0 +1,241 @@
+#include "cooker.h"
+
+#include "cook_manifest.h"
+
+#include "axe_asset_pack.h"
+#include "axe_mapped_file.h"
+#include "axe_mesh_cache.h"
+#include "axe_thread_pool.h"
+#include "axe_utils.h"
+
+// std headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	static constexpr std::array<const char*, 6> SHADER_EXTENSIONS = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+
+	static std::vector<std::filesystem::path> FindFiles( const std::filesystem::path& directory, const std::span<const char* const> extensions )
+	{
+		std::vector<std::filesystem::path> files = {};
+
+		std::error_code error;
+		if ( !std::filesystem::is_directory( directory, error ) )
+		{
+			return files;
+		}
+
+		for ( const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator{ directory } )
+		{
+			const std::string extension = entry.path().extension().string();
+			if ( entry.is_regular_file() && std::ranges::find( extensions, extension ) != extensions.end() )
+			{
+				files.push_back( entry.path() );
+			}
+		}
+
+		// Directory iteration order is unspecified, sorting keeps the log stable between runs
+		std::ranges::sort( files );
+		return files;
+	}
+
+	static CookManifest::Entry DescribeFile( const std::filesystem::path& path )
+	{
+		CookManifest::Entry entry = {};
+		entry.size = std::filesystem::file_size( path );
+		entry.writeTime = static_cast<int64_t>(std::filesystem::last_write_time( path ).time_since_epoch().count());
+		return entry;
+	}
+
+	static uint64_t HashFile( const std::filesystem::path& path )
+	{
+		if ( std::filesystem::file_size( path ) == 0 )
+		{
+			return HashBytes( nullptr, 0 );
+		}
+
+		const AxeMappedFile file{ path.string() };
+		return HashBytes( file.Data(), file.Size() );
+	}
+
+	Cooker::Report Cooker::Cook( const Settings& settings )
+	{
+		const std::filesystem::path& root = settings.engineDirectory;
+		const std::string glslcPath = FindGlslc();
+
+		std::vector<Job> jobs = {};
+
+		constexpr std::array<const char*, 1> modelExtensions = { ".obj" };
+		for ( const std::filesystem::path& model : FindFiles( root / "models", modelExtensions ) )
+		{
+			jobs.push_back( { JobType::Model, model, AxeMeshCache::GetCachePath( model.string() ) } );
+		}
+
+		// Next to the source, where the engine's shader build step puts them too
+		for ( std::filesystem::path shader : FindFiles( root / "shaders", SHADER_EXTENSIONS ) )
+		{
+			std::filesystem::path output = shader;
+			output += ".spv";
+			jobs.push_back( { JobType::Shader, std::move( shader ), std::move( output ) } );
+		}
+
+		// Anything that changes the outputs of unchanged inputs invalidates the whole manifest
+		const std::string settingsDescription = "mesh cache " + std::to_string( AxeMeshCache::VERSION )
+		                                        + " flags " + std::to_string( AxeMeshCache::GetFlags( MODEL_OPTIONS ) )
+		                                        + ( settings.compress ? " compressed" : "" )
+		                                        + " glslc " + glslcPath;
+
+		CookManifest manifest{ root / MANIFEST_NAME, HashBytes( settingsDescription.data(), settingsDescription.size() ) };
+
+		std::atomic<uint32_t> cookedCount = 0;
+		std::atomic<uint32_t> upToDateCount = 0;
+		std::atomic<uint32_t> failedCount = 0;
+		std::mutex logMutex;
+
+		AxeThreadPool::Shared().ParallelFor(
+			static_cast<uint32_t>(jobs.size()),
+			[&]( const uint32_t i )
+			{
+				const Job& job = jobs[ i ];
+				const std::string input = job.input.lexically_relative( root ).generic_string();
+
+				try
+				{
+					CookManifest::Entry current = DescribeFile( job.input );
+
+					// Size and write time are checked first so unchanged inputs don't even have to be read
+					std::error_code error;
+					const std::optional<CookManifest::Entry> previous = settings.force ? std::nullopt : manifest.Find( input );
+					if ( previous && std::filesystem::exists( job.output, error ) )
+					{
+						if ( previous->size == current.size && previous->writeTime == current.writeTime )
+						{
+							upToDateCount++;
+							return;
+						}
+
+						current.hash = HashFile( job.input );
+						if ( previous->hash == current.hash )
+						{
+							manifest.Record( input, current );
+							upToDateCount++;
+							return;
+						}
+					}
+					else
+					{
+						current.hash = HashFile( job.input );
+					}
+
+					const auto startTime = std::chrono::steady_clock::now();
+
+					if ( job.type == JobType::Model )
+					{
+						CookModel( job, settings.compress );
+					}
+					else
+					{
+						CookShader( job, glslcPath );
+					}
+
+					const double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+
+					manifest.Record( input, current );
+					cookedCount++;
+
+					std::scoped_lock lock{ logMutex };
+					std::cout << "Cooked " << input << " in " << milliseconds << " ms\n";
+				}
+				catch ( const std::exception& exception )
+				{
+					failedCount++;
+
+					std::scoped_lock lock{ logMutex };
+					std::cerr << "Failed to cook " << input << ": " << exception.what() << "\n";
+				}
+			} );
+
+		manifest.Save();
+
+		// A pack with missing or stale assets would silently ship them, so it's only written after a clean cook
+		if ( settings.pack && failedCount == 0 )
+		{
+			WritePack( root, jobs );
+		}
+
+		return { cookedCount.load(), upToDateCount.load(), failedCount.load() };
+	}
+
+	void Cooker::WritePack( const std::filesystem::path& engineDirectory, const std::span<const Job> jobs )
+	{
+		std::vector<AxeAssetPack::Asset> assets = {};
+		assets.reserve( jobs.size() );
+
+		for ( const Job& job : jobs )
+		{
+			const std::filesystem::path& name = job.type == JobType::Model ? job.input : job.output;
+			assets.push_back( { name.lexically_relative( engineDirectory ).generic_string(), job.output } );
+		}
+
+		const std::filesystem::path packPath = engineDirectory / AxeAssetPack::DEFAULT_PATH;
+		if ( !AxeAssetPack::Write( packPath.string(), assets ) )
+		{
+			throw std::runtime_error( "Failed to write asset pack " + packPath.string() );
+		}
+
+		std::cout << "Packed " << assets.size() << " assets into " << packPath.string() << "\n";
+	}
+
+	void Cooker::CookModel( const Job& job, const bool compress )
+	{
+		const std::string inputPath = job.input.string();
+
+		// Processing writes the mesh cache itself, loading it back checks that it was written and is valid
+		const AxeModel::Data data = AxeModel::ProcessModelFile( inputPath, MODEL_OPTIONS );
+
+		if ( compress && !AxeMeshCache::Write( inputPath, data, AxeMeshCache::GetFlags( MODEL_OPTIONS ) | AxeMeshCache::FLAG_COMPRESSED ) )
+		{
+			throw std::runtime_error( "Failed to write compressed mesh cache " + job.output.string() );
+		}
+
+		if ( !AxeMeshCache::Load( inputPath, AxeMeshCache::GetFlags( MODEL_OPTIONS ) ) )
+		{
+			throw std::runtime_error( "Mesh cache " + job.output.string() + " wasn't written" );
+		}
+	}
+
+	void Cooker::CookShader( const Job& job, const std::string& glslcPath )
+	{
+		std::string command = "\"" + glslcPath + "\" \"" + job.input.string() + "\" -o \"" + job.output.string() + "\"";
+
+#ifdef _WIN32
+		// cmd.exe strips the outer quotes of a command line that starts with one, which would break the quoted executable path
+		command = "\"" + command + "\"";
+#endif
+
+		if ( std::system( command.c_str() ) != 0 )
+		{
+			throw std::runtime_error( "glslc failed" );
+		}
+	}
+
+	std::string Cooker::FindGlslc()
+	{
+		if ( const char* vulkanSdk = std::getenv( "VULKAN_SDK" ) )
+		{
+			return ( std::filesystem::path{ vulkanSdk } / "Bin" / "glslc" ).string();
+		}
+
+		return "glslc";
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "axe_model.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace Axe
+{
+	// Builds the engine's runtime assets ahead of time: mesh caches for the OBJ models and SPIR-V for the GLSL shaders.
+	// Inputs are cooked in parallel on the shared thread pool, and inputs whose content matches the manifest of the last cook are skipped.
+	class Cooker
+	{
+	public:
+		static constexpr const char* MANIFEST_NAME = "axe-cook.manifest";
+
+		// Cooked mesh caches get every processing flag, a cache counts for loads asking for any subset of them
+		static constexpr AxeModel::LoadOptions MODEL_OPTIONS = { .optimize = true, .buildMeshlets = true };
+
+		struct Settings
+		{
+			std::filesystem::path engineDirectory = ".";	// Holds the models and shaders directories
+			bool force = false;	// Cook everything, even inputs the manifest says are up to date
+			bool pack = false;	// Also bundle every output into a single asset pack for shipping
+			bool compress = false;	// Write compressed mesh caches, smaller on disk but decoded on every load
+		};
+
+		struct Report
+		{
+			uint32_t cookedCount = 0;
+			uint32_t upToDateCount = 0;
+			uint32_t failedCount = 0;
+		};
+
+		[[nodiscard]] static Report Cook( const Settings& settings );
+
+	private:
+		enum class JobType
+		{
+			Model,
+			Shader,
+		};
+
+		struct Job
+		{
+			JobType type = JobType::Model;
+			std::filesystem::path input = {};
+			std::filesystem::path output = {};
+		};
+
+		// Models are packed under their source path and shaders under their SPIR-V path, the paths the engine asks for
+		static void WritePack( const std::filesystem::path& engineDirectory, std::span<const Job> jobs );
+
+		static void CookModel( const Job& job, bool compress );
+		static void CookShader( const Job& job, const std::string& glslcPath );
+
+		// The glslc of the Vulkan SDK if VULKAN_SDK is set, otherwise the one on the PATH
+		[[nodiscard]] static std::string FindGlslc();
+	};
+}
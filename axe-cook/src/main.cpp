@@ -0,0 +1,59 @@
+#include "cooker.h"
+
+// std headers
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Usage: axe-cook [engine directory] [--force] [--pack] [--compress]
+int main( int argc, char* argv[] )
+{
+	Axe::Cooker::Settings settings = {};
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		const std::string argument = argv[ i ];
+
+		if ( argument == "--force" )
+		{
+			settings.force = true;
+		}
+		else if ( argument == "--pack" )
+		{
+			settings.pack = true;
+		}
+		else if ( argument == "--compress" )
+		{
+			settings.compress = true;
+		}
+		else if ( argument.starts_with( "-" ) )
+		{
+			std::cerr << "Usage: axe-cook [engine directory] [--force] [--pack] [--compress]\n";
+			return EXIT_FAILURE;
+		}
+		else
+		{
+			settings.engineDirectory = argument;
+		}
+	}
+
+	try
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+
+		const Axe::Cooker::Report report = Axe::Cooker::Cook( settings );
+
+		const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+		std::cout << report.cookedCount << " cooked, " << report.upToDateCount << " up to date, " << report.failedCount << " failed in "
+			<< seconds << " s\n";
+
+		return report.failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	catch ( const std::exception& e )
+	{
+		std::cerr << "\nError: " << e.what() << "\n";
+
+		return EXIT_FAILURE;
+	}
+}
@@ -9,38 +9,40 @@ const vec2 OFFSETS[6] = vec2[](
   vec2(1.0, 1.0)
 );
 
-layout (push_constant) uniform Push
-{
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
-
-struct PointLight
-{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
 layout (set = 0, binding = 0) uniform GlobalUBO 
 {
 	mat4 projectionMartix;
 	mat4 viewMartix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
 } ubo;
 
+// Matches PointLightSystem::Billboard
+struct Billboard
+{
+	vec4 position; // w is the radius
+	vec4 color; // w is intensity
+};
+
+// The visible billboards sorted back to front, one instance each
+layout (set = 1, binding = 0) readonly buffer Billboards
+{
+	Billboard billboards[];
+};
+
 layout (location = 0) out vec2 fragOffset;
+layout (location = 1) flat out vec4 fragColor;
 
 void main()
 {
+	Billboard billboard = billboards[gl_InstanceIndex];
+
 	fragOffset = OFFSETS[gl_VertexIndex];
+	fragColor = billboard.color;
 
 	// Camera space version
-	vec4 lightInCameraSpace = ubo.viewMartix * push.position;
-	vec4 positionInCameraSpace = lightInCameraSpace + push.radius * vec4(fragOffset, 0.0, 0.0);
+	vec4 lightInCameraSpace = ubo.viewMartix * vec4(billboard.position.xyz, 1.0);
+	vec4 positionInCameraSpace = lightInCameraSpace + billboard.position.w * vec4(fragOffset, 0.0, 0.0);
 
 	gl_Position = ubo.projectionMartix * positionInCameraSpace;
 
@@ -48,9 +50,9 @@ void main()
 	/*vec3 cameraRightWorld = {ubo.viewMartix[0][0], ubo.viewMartix[1][0], ubo.viewMartix[2][0]};
 	vec3 cameraUpWorld = {ubo.viewMartix[0][1], ubo.viewMartix[1][1], ubo.viewMartix[2][1]};
 
-	vec3 positionWorld = push.position.xyz
-		+ push.radius * fragOffset.x * cameraRightWorld
-		+ push.radius * fragOffset.y * cameraUpWorld;
+	vec3 positionWorld = billboard.position.xyz
+		+ billboard.position.w * fragOffset.x * cameraRightWorld
+		+ billboard.position.w * fragOffset.y * cameraUpWorld;
 
 	gl_Position = ubo.projectionMartix * ubo.viewMartix * vec4(positionWorld, 1.0);*/
 }
\ No newline at end of file
@@ -4,30 +4,54 @@ layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPositionWorld;
 layout (location = 2) in vec3 fragNormalWorld;
 
-layout (push_constant) uniform Push 
+layout (set = 0, binding = 0) uniform GlobalUBO 
 {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+	mat4 projectionMartix;
+	mat4 viewMartix;
+	mat4 inverseViewMatrix;
+	vec4 ambientLightColor; // w is intensity
+} ubo;
 
+// Matches AxeLightClusters::PointLight
 struct PointLight
 {
-	vec4 position; // ignore w
+	vec4 position; // w is the range
 	vec4 color; // w is intensity
 };
 
-layout (set = 0, binding = 0) uniform GlobalUBO 
+layout (set = 2, binding = 0) readonly buffer Lights
 {
-	mat4 projectionMartix;
-	mat4 viewMartix;
-	mat4 inverseViewMatrix;
-	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
-} ubo;
+	PointLight lights[];
+};
+
+// Matches AxeLightClusters::ClusterHeader followed by AxeLightGrid::Cluster, each cluster is an offset and a count into lightIndices.
+// Clusters are ordered by slice, then row, then column
+layout (set = 2, binding = 1) readonly buffer Clusters
+{
+	uvec4 gridSize; // w is the light count
+	vec4 depthParameters; // A depth's slice is floor(log(depth) * x + y)
+	uvec2 clusters[];
+};
+
+layout (set = 2, binding = 2) readonly buffer LightIndices
+{
+	uint lightIndices[];
+};
 
 layout (location = 0) out vec4 outColor;
 
+// Found the same way as AxeLightGrid::FindCluster
+uvec2 FindCluster(vec3 positionWorld)
+{
+	vec4 positionView = ubo.viewMartix * vec4(positionWorld, 1.0);
+	vec4 positionClip = ubo.projectionMartix * positionView;
+
+	uvec2 tile = uvec2(clamp(floor((positionClip.xy / positionClip.w * 0.5 + 0.5) * vec2(gridSize.xy)), vec2(0.0), vec2(gridSize.xy - 1u)));
+	uint slice = uint(clamp(floor(log(positionView.z) * depthParameters.x + depthParameters.y), 0.0, float(gridSize.z - 1u)));
+
+	return clusters[(slice * gridSize.y + tile.y) * gridSize.x + tile.x];
+}
+
 // Blinn-Phong lighting model
 void main()
 {
@@ -38,12 +62,18 @@ void main()
 	vec3 cameraWorldPosition = ubo.inverseViewMatrix[3].xyz;
 	vec3 directionToViewer = normalize(cameraWorldPosition - fragPositionWorld);
 
-	for (int i = 0; i < ubo.numLights; i++)
+	// Only the lights that reach the fragment's cluster
+	uvec2 cluster = FindCluster(fragPositionWorld);
+	for (uint i = 0; i < cluster.y; i++)
 	{
-		PointLight light = ubo.pointLights[i];
+		PointLight light = lights[lightIndices[cluster.x + i]];
 
 		vec3 directionToLight = light.position.xyz - fragPositionWorld;
-		float attenuation = 1.0 / dot(directionToLight, directionToLight); // Magnitude squared
+		float distanceSquared = dot(directionToLight, directionToLight); // Magnitude squared
+		// Faded out towards the light's range, so it doesn't end in a visible edge where it stops being assigned to clusters
+		float rangeFraction = distanceSquared / (light.position.w * light.position.w);
+		float window = clamp(1.0 - rangeFraction * rangeFraction, 0.0, 1.0);
+		float attenuation = window * window / distanceSquared;
 		directionToLight = normalize(directionToLight);
 
 		// Diffuse light
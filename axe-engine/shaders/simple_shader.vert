@@ -5,16 +5,23 @@ layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 uv;
 
-layout (push_constant) uniform Push 
+// Matches AxeSceneBuffer::Object
+struct SceneObject
 {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+	vec4 boundingSphere;
+};
 
-struct PointLight
+// The scene buffer slots of the instances, written in draw order so a draw's instances start at its firstInstance
+layout (set = 1, binding = 0) readonly buffer Instances
 {
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
+	uint objectSlots[];
+};
+
+layout (set = 1, binding = 1) readonly buffer SceneObjects
+{
+	SceneObject objects[];
 };
 
 layout (set = 0, binding = 0) uniform GlobalUBO 
@@ -23,8 +30,6 @@ layout (set = 0, binding = 0) uniform GlobalUBO
 	mat4 viewMartix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
 } ubo;
 
 layout (location = 0) out vec3 fragColor;
@@ -33,8 +38,10 @@ layout (location = 2) out vec3 fragNormalWorld;
 
 void main()
 {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0f);
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	SceneObject object = objects[objectSlots[gl_InstanceIndex]];
+
+	vec4 positionWorld = object.modelMatrix * vec4(position, 1.0f);
+	fragNormalWorld = normalize(mat3(object.normalMatrix) * normal);
 	fragPositionWorld = positionWorld.xyz;
 	fragColor = color;
 
@@ -0,0 +1,60 @@
+#version 460
+
+// AxeModel::PackedVertex, positions are 0..1 within the model bounds and the model matrix has the dequantization folded in
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec2 octahedralNormal;
+layout (location = 3) in vec2 uv;
+
+// Matches AxeSceneBuffer::Object
+struct SceneObject
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	vec4 boundingSphere;
+};
+
+// The scene buffer slots of the instances, written in draw order so a draw's instances start at its firstInstance
+layout (set = 1, binding = 0) readonly buffer Instances
+{
+	uint objectSlots[];
+};
+
+layout (set = 1, binding = 1) readonly buffer SceneObjects
+{
+	SceneObject objects[];
+};
+
+layout (set = 0, binding = 0) uniform GlobalUBO 
+{
+	mat4 projectionMartix;
+	mat4 viewMartix;
+	mat4 inverseViewMatrix;
+	vec4 ambientLightColor; // w is intensity
+} ubo;
+
+layout (location = 0) out vec3 fragColor;
+layout (location = 1) out vec3 fragPositionWorld;
+layout (location = 2) out vec3 fragNormalWorld;
+
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0f)));
+	return normalize(normal);
+}
+
+void main()
+{
+	vec3 normal = OctahedralDecode(octahedralNormal);
+
+	SceneObject object = objects[objectSlots[gl_InstanceIndex]];
+
+	vec4 positionWorld = object.modelMatrix * vec4(position, 1.0f);
+	fragNormalWorld = normalize(mat3(object.normalMatrix) * normal);
+	fragPositionWorld = positionWorld.xyz;
+	fragColor = color;
+
+	gl_Position = ubo.projectionMartix * ubo.viewMartix * positionWorld;
+}
\ No newline at end of file
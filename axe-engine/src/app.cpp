@@ -7,6 +7,10 @@
 #include "systems/point_light_system.h"
 
 #include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
 
 namespace Axe
 {
@@ -16,6 +20,7 @@ namespace Axe
 		             .SetMaxSets( AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
 		             .AddPoolSize( VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
 		             .Build();
+		// Models stream in while the game loop runs, their uploads go out with the frames that drain them
 		LoadGameObjects();
 	}
 
@@ -52,8 +57,14 @@ namespace Axe
 		}
 
 		// Render systems
-		const SimpleRenderSystem simpleRenderSystem{ axeDevice, axeRenderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout() };
-		const PointLightSystem pointLightSystem{ axeDevice, axeRenderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout() };
+		SimpleRenderSystem simpleRenderSystem{
+			axeDevice,
+			axeSceneBuffer,
+			axeLightClusters,
+			axeRenderer.GetSwapChainRenderPass(),
+			globalSetLayout->GetDescriptorSetLayout()
+		};
+		PointLightSystem pointLightSystem{ axeDevice, axeRenderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout() };
 
 		// Camera
 		AxeCamera camera = {};
@@ -65,11 +76,25 @@ namespace Axe
 
 		// Frame start time
 		auto startTime = std::chrono::high_resolution_clock::now();
+		float statisticsTimer = 0.0f;
+		bool gpuDrivenKeyWasPressed = false;
 
 		while ( !axeWindow.ShouldClose() )
 		{
 			glfwPollEvents();
 
+			// G switches between CPU and GPU-driven rendering on the key press only, not every frame it's held down
+			const bool gpuDrivenKeyPressed = glfwGetKey( axeWindow.GetGLFWwindow(), GLFW_KEY_G ) == GLFW_PRESS;
+			if ( gpuDrivenKeyPressed && !gpuDrivenKeyWasPressed )
+			{
+				simpleRenderSystem.SetGpuDriven( !simpleRenderSystem.IsGpuDriven() );
+				if ( !simpleRenderSystem.SupportsGpuDriven() )
+				{
+					std::cerr << "GPU-driven rendering needs multiDrawIndirect and drawIndirectCount, which the device doesn't support\n";
+				}
+			}
+			gpuDrivenKeyWasPressed = gpuDrivenKeyPressed;
+
 			// Game loop timing
 			auto currentTime = std::chrono::high_resolution_clock::now();
 			const float frameTime = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
@@ -85,11 +110,22 @@ namespace Axe
 
 			if ( const auto commandBuffer = axeRenderer.BeginFrame() )	// BeginFrame() returns a nullptr if the swap chain needs to be recreated
 			{
+				// The oldest frame in flight has finished, so geometry freed back then can be reused
+				axeGeometryPool.AdvanceFrame();
+
+				// Models that finished loading in the background get uploaded within this frame's budget
+				axeModelStreamer.Update();
+				AssignStreamedModels();
+
+				// Uploads recorded since the last frame have to be submitted before the frame that uses them
+				axeUploadContext.Submit();
+
 				int frameIndex = axeRenderer.GetFrameIndex();
 				FrameInfo frameInfo{
 					frameIndex,
 					frameTime,
 					commandBuffer,
+					axeRenderer,
 					camera,
 					globalDescriptorSets[ frameIndex ],
 					gameObjects
@@ -101,7 +137,9 @@ namespace Axe
 				ubo.viewMatrix = camera.GetView();
 				ubo.inverseViewMatrix = camera.GetInverseView();
 
-				pointLightSystem.Update( frameInfo, ubo );
+				pointLightSystem.Update( frameInfo );
+				// The lights are assigned to the clusters after they've moved, on the worker threads
+				axeLightClusters.Update( frameIndex, camera, gameObjects );
 
 				globalUBObuffers[ frameIndex ]->WriteToBuffer( &ubo );
 				if ( globalUBObuffers[ frameIndex ]->Flush() != VK_SUCCESS )
@@ -109,14 +147,62 @@ namespace Axe
 					throw std::runtime_error( "Error flushing global uniform buffer object buffer to GPU" );
 				}
 
+				// Copies and compute passes can't be recorded inside the render pass.
+				// Only the objects that moved or changed model since the last frame are uploaded
+				axeSceneBuffer.Update( commandBuffer, frameIndex, gameObjects );
+				simpleRenderSystem.CullGameObjects( frameInfo );
+
 				// Render
-				axeRenderer.BeginSwapChainRenderPass( commandBuffer );
+				// The render systems record into secondary command buffers, the render pass only executes them
+				axeRenderer.BeginSwapChainRenderPass( commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
 
 				simpleRenderSystem.RenderGameObjects( frameInfo );
 				pointLightSystem.Render( frameInfo );
 
 				axeRenderer.EndSwapChainRenderPass( commandBuffer );
 				axeRenderer.EndFrame();
+
+				// Draw calls, culled or visible objects, triangles drawn per level of detail, the share of culled meshlets, the objects uploaded to the
+				// scene buffer, the lights assigned to clusters and the culled light billboards go in the window title once a second
+				statisticsTimer += frameTime;
+				if ( statisticsTimer >= 1.0f )
+				{
+					statisticsTimer = 0.0f;
+
+					const SimpleRenderSystem::LodStatistics& lodStatistics = simpleRenderSystem.GetLodStatistics();
+
+					std::ostringstream title;
+					title << WINDOW_TITLE << " | Draws: " << simpleRenderSystem.GetDrawCount();
+					if ( simpleRenderSystem.IsGpuDriven() )
+					{
+						title << " (GPU-driven) | Visible objects: " << simpleRenderSystem.GetVisibleObjectCount();
+					}
+					else
+					{
+						const AxeFrustumCuller::Statistics& cullingStatistics = simpleRenderSystem.GetCullingStatistics();
+						title << " | Objects culled: " << cullingStatistics.culledCount << " of " << cullingStatistics.visibleCount + cullingStatistics.culledCount;
+					}
+					title << " | LOD triangles:";
+					for ( uint32_t lod = 0; lod < AxeModel::MAX_LODS; lod++ )
+					{
+						title << " " << lodStatistics.triangleCounts[ lod ];
+					}
+
+					const AxeMeshletCuller::Statistics& meshletStatistics = simpleRenderSystem.GetMeshletStatistics();
+					title << " | Meshlets culled: " << std::fixed << std::setprecision( 1 ) << meshletStatistics.GetCulledPercentage() << "% of "
+						<< meshletStatistics.meshletCount << " in " << meshletStatistics.drawCount << " draws";
+
+					title << " | Uploaded objects: " << axeSceneBuffer.GetStatistics().uploadedCount << " of " << axeSceneBuffer.GetStatistics().objectCount;
+
+					const AxeLightGrid::Statistics& lightStatistics = axeLightClusters.GetStatistics();
+					title << " | Lights: " << lightStatistics.visibleLightCount << " of " << lightStatistics.lightCount << ", at most "
+						<< lightStatistics.maxClusterLightCount << " per cluster";
+
+					const AxeFrustumCuller::Statistics& billboardStatistics = pointLightSystem.GetCullingStatistics();
+					title << " | Billboards culled: " << billboardStatistics.culledCount << " of " << billboardStatistics.visibleCount + billboardStatistics.culledCount;
+
+					glfwSetWindowTitle( axeWindow.GetGLFWwindow(), title.str().c_str() );
+				}
 			}
 		}
 
@@ -168,33 +254,37 @@ namespace Axe
 
 	void App::LoadGameObjects()
 	{
-		std::shared_ptr<AxeModel> axeModel = AxeModel::CreateModelFromFile( axeDevice, "models/flat_vase.obj" );
 		{
 			auto flatVase = AxeGameObject::CreateGameObject();
-			flatVase.model = axeModel;
+			pendingModels.emplace_back( flatVase.GetId(), axeAssetRegistry.StreamModel( "models/flat_vase.obj", { .buildMeshlets = true } ) );
 			flatVase.transform.translation = { -0.5f, 0.5f, 0.0f };
 			flatVase.transform.scale = glm::vec3{ 3.0f, 1.5f, 3.0f };
 			gameObjects.emplace( flatVase.GetId(), std::move( flatVase ) );
 		}
 
 		{
-			axeModel = AxeModel::CreateModelFromFile( axeDevice, "models/smooth_vase.obj" );
 			auto smoothVase = AxeGameObject::CreateGameObject();
-			smoothVase.model = axeModel;
+			pendingModels.emplace_back(
+				smoothVase.GetId(),
+				axeAssetRegistry.StreamModel( "models/smooth_vase.obj", { .buildMeshlets = true, .vertexFormat = AxeModel::VertexFormat::Packed } ) );
 			smoothVase.transform.translation = { 0.5f, 0.5f, 0.0f };
 			smoothVase.transform.scale = glm::vec3{ 3.0f, 1.5f, 3.0f };
 			gameObjects.emplace( smoothVase.GetId(), std::move( smoothVase ) );
 		}
 
 		{
-			axeModel = AxeModel::CreateModelFromFile( axeDevice, "models/quad.obj" );
 			auto floor = AxeGameObject::CreateGameObject();
-			floor.model = axeModel;
+			pendingModels.emplace_back( floor.GetId(), axeAssetRegistry.StreamModel( "models/quad.obj" ) );
 			floor.transform.translation = { 0.0f, 0.5f, 0.0f };
 			floor.transform.scale = glm::vec3{ 3.0f, 1.0f, 3.0f };
+			// The floor never moves, the vases stay dynamic so they go through the LOD selection and the culling
+			floor.isStatic = true;
 			gameObjects.emplace( floor.GetId(), std::move( floor ) );
 		}
 
+		const AxeAssetRegistry::Statistics registryStatistics = axeAssetRegistry.GetStatistics();
+		std::cout << "Asset registry requested " << registryStatistics.misses << " model loads, " << registryStatistics.hits << " hits\n";
+
 		{
 			std::vector<glm::vec3> lightColors{
 				{ 1.f, .1f, .1f },
@@ -217,6 +307,46 @@ namespace Axe
 				pointLight.transform.translation = glm::vec3{ rotateLight * glm::vec4{ -1.0f, -1.0f, -1.0f, 1.0f } };
 				gameObjects.emplace( pointLight.GetId(), std::move( pointLight ) );
 			}
+
+			// A swarm of dim lights just above the floor, each only reaching a few of the clusters
+			if constexpr ( LIGHT_STRESS_SCENE )
+			{
+				constexpr uint32_t SMALL_LIGHT_COUNT = 1024;
+				std::mt19937 random{ 42 };
+				std::uniform_real_distribution<float> position{ -3.0f, 3.0f };
+				std::uniform_int_distribution<size_t> color{ 0, lightColors.size() - 1 };
+
+				for ( uint32_t i = 0; i < SMALL_LIGHT_COUNT; i++ )
+				{
+					auto pointLight = AxeGameObject::MakePointLight( 0.001f, 0.01f, lightColors[ color( random ) ] );
+					pointLight.transform.translation = glm::vec3{ position( random ), 0.45f, position( random ) };
+					gameObjects.emplace( pointLight.GetId(), std::move( pointLight ) );
+				}
+			}
 		}
 	}
+
+	void App::AssignStreamedModels()
+	{
+		std::erase_if(
+			pendingModels,
+			[this]( const std::pair<AxeGameObject::UID, AxeModelStreamer::Handle>& pendingModel )
+			{
+				const auto& [id, handle] = pendingModel;
+
+				if ( handle.IsResident() )
+				{
+					gameObjects.at( id ).model = handle.GetModel();
+					return true;
+				}
+
+				if ( handle.HasFailed() )
+				{
+					std::cerr << "Game object " << id << " has no model: " << handle.GetError() << "\n";
+					return true;
+				}
+
+				return false;
+			} );
+	}
 }
@@ -1,12 +1,20 @@
 ﻿#pragma once
 
 #include "axe_window.h"
+#include "axe_asset_registry.h"
 #include "axe_device.h"
+#include "axe_geometry_pool.h"
+#include "axe_light_clusters.h"
+#include "axe_model_streamer.h"
 #include "axe_renderer.h"
+#include "axe_scene_buffer.h"
+#include "axe_upload_context.h"
 #include "axe_game_object.h"
 #include "axe_descriptors.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace Axe
 {
@@ -15,6 +23,9 @@ namespace Axe
 	public:
 		static constexpr int WIDTH = 1200;
 		static constexpr int HEIGHT = 900;
+		static constexpr const char* WINDOW_TITLE = "Hey Paul!";
+		// Adds a swarm of small lights to the scene to stress the light clusters, axe-bench clusters measures them on their own
+		static constexpr bool LIGHT_STRESS_SCENE = false;
 
 		App();
 		~App();
@@ -27,14 +38,23 @@ namespace Axe
 		void Run();
 
 	private:
-		AxeWindow axeWindow{ WIDTH, HEIGHT, "Hey Paul!" };
+		AxeWindow axeWindow{ WIDTH, HEIGHT, WINDOW_TITLE };
 		AxeDevice axeDevice{ axeWindow };
 		AxeRenderer axeRenderer{ axeWindow, axeDevice };
+		AxeSceneBuffer axeSceneBuffer{ axeDevice };
+		AxeLightClusters axeLightClusters{ axeDevice };
+		AxeUploadContext axeUploadContext{ axeDevice };
+		AxeGeometryPool axeGeometryPool{ axeDevice, axeUploadContext };	// Has to outlive every model, so it's declared before the game objects
+		AxeModelStreamer axeModelStreamer{ axeGeometryPool };
+		AxeAssetRegistry axeAssetRegistry{ axeGeometryPool, axeModelStreamer };
 
 		std::unique_ptr<AxeDescriptorPool> globalPool = {};
 
 		AxeGameObject::Map gameObjects;
+		// Game objects whose model is still streaming, they aren't drawn until it's resident
+		std::vector<std::pair<AxeGameObject::UID, AxeModelStreamer::Handle>> pendingModels = {};
 
 		void LoadGameObjects();
+		void AssignStreamedModels();
 	};
 }
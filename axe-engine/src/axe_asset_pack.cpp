@@ -0,0 +1,217 @@
+#include "axe_asset_pack.h"
+
+#include "axe_utils.h"
+
+// std headers
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Axe
+{
+	static_assert( std::is_trivially_copyable_v<AxeAssetPack::Header>, "Pack header is written as raw bytes" );
+	static_assert( std::is_trivially_copyable_v<AxeAssetPack::Bucket>, "Pack buckets are written as raw bytes" );
+
+	static std::unique_ptr<AxeAssetPack> mountedPack = {};
+
+	static uint64_t AlignUp( const uint64_t value, const uint64_t alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	AxeAssetPack::AxeAssetPack( const std::string& packPath )
+		: file{ packPath }
+	{
+		if ( file.Size() < sizeof( Header ) )
+		{
+			throw std::runtime_error( "Asset pack is too small: " + packPath );
+		}
+
+		Header header;
+		memcpy( &header, file.Data(), sizeof( Header ) );
+
+		if ( memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0 || header.version != VERSION )
+		{
+			throw std::runtime_error( "Not an asset pack or from another version: " + packPath );
+		}
+
+		const uint64_t bucketEnd = header.bucketOffset + static_cast<uint64_t>(header.bucketCount) * sizeof( Bucket );
+		if ( !std::has_single_bit( header.bucketCount ) || header.bucketOffset % alignof( Bucket ) != 0 || bucketEnd > file.Size() || header.nameOffset > file.Size() )
+		{
+			throw std::runtime_error( "Corrupt asset pack table of contents: " + packPath );
+		}
+
+		buckets = { reinterpret_cast<const Bucket*>(file.Data() + header.bucketOffset), header.bucketCount };
+		names = reinterpret_cast<const char*>(file.Data() + header.nameOffset);
+
+		// Checked once here, so lookups can trust every range in the table
+		for ( const Bucket& bucket : buckets )
+		{
+			if ( bucket.nameLength == 0 )
+			{
+				continue;
+			}
+
+			if ( header.nameOffset + bucket.nameOffset + bucket.nameLength > file.Size() || bucket.dataOffset + bucket.dataSize > file.Size() )
+			{
+				throw std::runtime_error( "Corrupt asset pack table of contents: " + packPath );
+			}
+
+			assetCount++;
+		}
+
+		std::error_code error;
+		packDirectory = std::filesystem::absolute( packPath, error ).parent_path().lexically_normal();
+		workingDirectory = std::filesystem::current_path( error ).lexically_relative( packDirectory );
+	}
+
+	std::span<const std::byte> AxeAssetPack::Find( const std::string& filePath ) const
+	{
+		const std::string name = GetAssetName( filePath );
+		const uint64_t nameHash = HashName( name );
+		const uint64_t mask = buckets.size() - 1;
+
+		for ( uint64_t i = nameHash & mask; buckets[ i ].nameLength != 0; i = ( i + 1 ) & mask )
+		{
+			const Bucket& bucket = buckets[ i ];
+			if ( bucket.nameHash == nameHash && std::string_view{ names + bucket.nameOffset, bucket.nameLength } == name )
+			{
+				return { file.Data() + bucket.dataOffset, bucket.dataSize };
+			}
+		}
+
+		return {};
+	}
+
+	bool AxeAssetPack::Mount( const std::string& packPath )
+	{
+		std::error_code error;
+		if ( !std::filesystem::exists( packPath, error ) )
+		{
+			return false;
+		}
+
+		mountedPack = std::make_unique<AxeAssetPack>( packPath );
+		return true;
+	}
+
+	const AxeAssetPack* AxeAssetPack::Mounted()
+	{
+		return mountedPack.get();
+	}
+
+	bool AxeAssetPack::Write( const std::string& packPath, const std::span<const Asset> assets )
+	{
+		Header header = {};
+		memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+		header.version = VERSION;
+		header.bucketCount = std::bit_ceil( static_cast<uint32_t>(assets.size()) * 2 + 1 );
+
+		const uint64_t mask = header.bucketCount - 1;
+
+		std::vector<Bucket> table( header.bucketCount );
+		std::vector<uint64_t> assetBuckets( assets.size() );
+		std::string nameBlock = {};
+
+		for ( size_t a = 0; a < assets.size(); a++ )
+		{
+			const std::string name = std::filesystem::path{ assets[ a ].name }.lexically_normal().generic_string();
+			const uint64_t nameHash = HashName( name );
+
+			uint64_t i = nameHash & mask;
+			for ( ; table[ i ].nameLength != 0; i = ( i + 1 ) & mask )
+			{
+				// The same name twice would make one of the assets unreachable
+				if ( table[ i ].nameHash == nameHash && std::string_view{ nameBlock }.substr( table[ i ].nameOffset, table[ i ].nameLength ) == name )
+				{
+					return false;
+				}
+			}
+
+			table[ i ].nameHash = nameHash;
+			table[ i ].nameOffset = static_cast<uint32_t>(nameBlock.size());
+			table[ i ].nameLength = static_cast<uint32_t>(name.size());
+			nameBlock += name;
+			assetBuckets[ a ] = i;
+		}
+
+		header.bucketOffset = AlignUp( sizeof( Header ), DATA_ALIGNMENT );
+		header.nameOffset = header.bucketOffset + table.size() * sizeof( Bucket );
+
+		const std::filesystem::path finalPath{ packPath };
+		std::filesystem::path tempPath = finalPath;
+		tempPath += ".tmp";
+
+		bool written = false;
+		try
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+
+			constexpr char padding[ DATA_ALIGNMENT ] = {};
+
+			// The data goes after the table, which is written last once every offset is known
+			uint64_t offset = AlignUp( header.nameOffset + nameBlock.size(), DATA_ALIGNMENT );
+			file.seekp( static_cast<std::streamoff>(offset) );
+
+			for ( size_t a = 0; a < assets.size() && file.good(); a++ )
+			{
+				const AxeMappedFile data{ assets[ a ].filePath.string() };
+				const uint64_t alignedSize = AlignUp( data.Size(), DATA_ALIGNMENT );
+
+				table[ assetBuckets[ a ] ].dataOffset = offset;
+				table[ assetBuckets[ a ] ].dataSize = data.Size();
+
+				file.write( reinterpret_cast<const char*>(data.Data()), static_cast<std::streamsize>(data.Size()) );
+				file.write( padding, static_cast<std::streamsize>(alignedSize - data.Size()) );
+				offset += alignedSize;
+			}
+
+			file.seekp( 0 );
+			file.write( reinterpret_cast<const char*>(&header), sizeof( Header ) );
+			file.write( padding, static_cast<std::streamsize>(header.bucketOffset - sizeof( Header )) );
+			file.write( reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof( Bucket )) );
+			file.write( nameBlock.data(), static_cast<std::streamsize>(nameBlock.size()) );
+
+			written = file.good();
+		}
+		catch ( const std::exception& )
+		{
+			written = false;
+		}
+
+		std::error_code error;
+		if ( written )
+		{
+			std::filesystem::rename( tempPath, finalPath, error );
+		}
+
+		if ( !written || error )
+		{
+			std::filesystem::remove( tempPath, error );
+			return false;
+		}
+
+		return true;
+	}
+
+	std::string AxeAssetPack::GetAssetName( const std::string& filePath ) const
+	{
+		const std::filesystem::path path{ filePath };
+		if ( path.is_absolute() )
+		{
+			return path.lexically_normal().lexically_relative( packDirectory ).generic_string();
+		}
+
+		return ( workingDirectory / path ).lexically_normal().generic_string();
+	}
+
+	uint64_t AxeAssetPack::HashName( const std::string_view name )
+	{
+		return HashBytes( name.data(), name.size() );
+	}
+}
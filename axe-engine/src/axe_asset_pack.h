@@ -0,0 +1,81 @@
+#pragma once
+
+#include "axe_mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace Axe
+{
+	// A single .axepack file holding cooked assets (mesh caches and SPIR-V) behind a hashed table of contents.
+	// It's mapped once and assets are handed out as spans straight into the mapping, so loading one costs no file opens or reads.
+	class AxeAssetPack
+	{
+	public:
+		static constexpr char MAGIC[ 8 ] = { 'A', 'X', 'E', 'P', 'A', 'C', 'K', '\0' };
+		static constexpr uint32_t VERSION = 1;
+		// Asset data starts at multiples of this, enough for the mesh cache's own alignment and for SPIR-V words
+		static constexpr uint64_t DATA_ALIGNMENT = 16;
+		static constexpr const char* DEFAULT_PATH = "assets.axepack";
+
+		struct Header
+		{
+			char magic[ 8 ] = {};
+			uint32_t version = 0;
+			uint32_t bucketCount = 0;	// A power of two, at least twice the asset count so probing always ends at an empty bucket
+			uint64_t bucketOffset = 0;
+			uint64_t nameOffset = 0;
+		};
+
+		// Open addressing with linear probing on the hash of the asset name
+		struct Bucket
+		{
+			uint64_t nameHash = 0;
+			uint64_t dataOffset = 0;
+			uint64_t dataSize = 0;
+			uint32_t nameOffset = 0;	// Into the name block, names are kept to tell colliding hashes apart
+			uint32_t nameLength = 0;	// 0 for an empty bucket
+		};
+
+		struct Asset
+		{
+			std::string name = {};	// Relative to the pack's directory, e.g. shaders/simple_shader.vert.spv
+			std::filesystem::path filePath = {};	// Where the data comes from when writing the pack
+		};
+
+		// Throws if the file can't be mapped or isn't a valid pack
+		explicit AxeAssetPack( const std::string& packPath );
+
+		AxeAssetPack( const AxeAssetPack& ) = delete;
+		AxeAssetPack& operator=( const AxeAssetPack& ) = delete;
+		AxeAssetPack( AxeAssetPack&& ) = delete;
+		AxeAssetPack& operator=( AxeAssetPack&& ) = delete;
+
+		// Takes the same paths as loose files, relative to the working directory or absolute. Empty if the asset isn't in the pack
+		[[nodiscard]] std::span<const std::byte> Find( const std::string& filePath ) const;
+		[[nodiscard]] uint32_t GetAssetCount() const { return assetCount; }
+
+		// Makes the pack the first place the engine looks for assets, returns false if there's no pack and only loose files are used.
+		// Call it before any assets are loaded, the mounted pack isn't guarded against concurrent access
+		static bool Mount( const std::string& packPath = DEFAULT_PATH );
+		[[nodiscard]] static const AxeAssetPack* Mounted();
+
+		// Writes to a temporary file first, like the mesh cache
+		static bool Write( const std::string& packPath, std::span<const Asset> assets );
+
+	private:
+		AxeMappedFile file;
+		std::span<const Bucket> buckets = {};
+		const char* names = nullptr;
+		uint32_t assetCount = 0;
+
+		std::filesystem::path packDirectory = {};
+		std::filesystem::path workingDirectory = {};	// Relative to the pack's directory, relative paths are resolved against it once instead of per lookup
+
+		[[nodiscard]] std::string GetAssetName( const std::string& filePath ) const;
+		[[nodiscard]] static uint64_t HashName( std::string_view name );
+	};
+}
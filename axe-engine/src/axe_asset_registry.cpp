@@ -0,0 +1,145 @@
+#include "axe_asset_registry.h"
+
+#include "axe_utils.h"
+
+// std headers
+#include <algorithm>
+#include <filesystem>
+#include <ranges>
+
+namespace Axe
+{
+	AxeAssetRegistry::AxeAssetRegistry( AxeGeometryPool& geometryPool, AxeModelStreamer& modelStreamer )
+		: axeGeometryPool{ geometryPool }, axeModelStreamer{ modelStreamer } {}
+
+	size_t AxeAssetRegistry::ModelKeyHash::operator()( const ModelKey& key ) const noexcept
+	{
+		size_t seed = 0;
+		HashCombine( seed, key.path, key.options.optimize, key.options.buildMeshlets, key.options.vertexFormat );
+
+		return seed;
+	}
+
+	std::shared_ptr<AxeModel> AxeAssetRegistry::LoadModel( const std::string& filePath, const AxeModel::LoadOptions& options )
+	{
+		const ModelKey key{ NormalizePath( filePath ), options };
+
+		std::promise<std::shared_ptr<AxeModel>> promise;
+		{
+			std::unique_lock lock{ mutex };
+
+			ModelEntry& entry = models[ key ];
+
+			if ( std::shared_ptr<AxeModel> model = entry.model.lock() )
+			{
+				statistics.hits++;
+				return model;
+			}
+
+			if ( entry.pendingLoad.valid() )
+			{
+				statistics.hits++;
+				statistics.coalescedLoads++;
+
+				const std::shared_future<std::shared_ptr<AxeModel>> pendingLoad = entry.pendingLoad;
+				lock.unlock();
+
+				return pendingLoad.get();
+			}
+
+			statistics.misses++;
+			entry.pendingLoad = promise.get_future().share();
+		}
+
+		// Loaded outside the lock so other models can be requested meanwhile
+		std::shared_ptr<AxeModel> model;
+		try
+		{
+			model = AxeModel::CreateModelFromFile( axeGeometryPool, filePath, options );
+		}
+		catch ( ... )
+		{
+			{
+				std::lock_guard lock{ mutex };
+				models[ key ].pendingLoad = {};
+			}
+
+			promise.set_exception( std::current_exception() );
+			throw;
+		}
+
+		{
+			std::lock_guard lock{ mutex };
+
+			ModelEntry& entry = models[ key ];
+			entry.model = model;
+			entry.pendingLoad = {};
+		}
+
+		promise.set_value( model );
+		return model;
+	}
+
+	AxeModelStreamer::Handle AxeAssetRegistry::StreamModel( const std::string& filePath, const AxeModel::LoadOptions& options )
+	{
+		const ModelKey key{ NormalizePath( filePath ), options };
+
+		std::scoped_lock lock{ mutex };
+
+		ModelEntry& entry = models[ key ];
+
+		if ( std::shared_ptr<AxeModel> model = entry.model.lock() )
+		{
+			statistics.hits++;
+			return AxeModelStreamer::Handle::FromModel( std::move( model ) );
+		}
+
+		if ( entry.pendingStream.IsValid() && !entry.pendingStream.HasFailed() )
+		{
+			statistics.hits++;
+			statistics.coalescedLoads++;
+			return entry.pendingStream;
+		}
+
+		statistics.misses++;
+
+		// Runs on the render thread, the registry only keeps the model weakly from then on
+		entry.pendingStream = axeModelStreamer.Load(
+			filePath,
+			options,
+			[this, key]( const std::shared_ptr<AxeModel>& model )
+			{
+				std::scoped_lock callbackLock{ mutex };
+
+				ModelEntry& streamedEntry = models[ key ];
+				streamedEntry.model = model;
+				streamedEntry.pendingStream = {};
+			} );
+
+		return entry.pendingStream;
+	}
+
+	std::string AxeAssetRegistry::NormalizePath( const std::string& filePath )
+	{
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::weakly_canonical( filePath, error );
+		if ( error )
+		{
+			path = std::filesystem::absolute( filePath, error ).lexically_normal();
+		}
+
+		return path.generic_string();
+	}
+
+	AxeAssetRegistry::Statistics AxeAssetRegistry::GetStatistics() const
+	{
+		std::lock_guard lock{ mutex };
+		return statistics;
+	}
+
+	size_t AxeAssetRegistry::GetLoadedModelCount() const
+	{
+		std::lock_guard lock{ mutex };
+		return static_cast<size_t>(std::ranges::count_if( models | std::views::values, []( const ModelEntry& entry ) { return !entry.model.expired(); } ));
+	}
+}
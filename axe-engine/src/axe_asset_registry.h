@@ -0,0 +1,83 @@
+#pragma once
+
+#include "axe_geometry_pool.h"
+#include "axe_model.h"
+#include "axe_model_streamer.h"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Axe
+{
+	// Hands out shared models keyed by their normalized path and load options, so every placement of a mesh shares one parse and one GPU copy.
+	// The registry only keeps weak references, a model's geometry goes back to the pool as soon as its last user releases it.
+	// Requests for a model that is still loading wait for that load instead of starting another one. StreamModel and releasing models are safe
+	// from any thread, LoadModel uploads on the calling thread and so has to be called on the render thread, like AxeModelStreamer::Update.
+	class AxeAssetRegistry
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t hits = 0;	// Requests served by a model that was already loaded or loading
+			uint64_t misses = 0;	// Requests that had to load the model
+			uint64_t coalescedLoads = 0;	// Hits that waited on a load in flight
+		};
+
+		AxeAssetRegistry( AxeGeometryPool& geometryPool, AxeModelStreamer& modelStreamer );
+
+		AxeAssetRegistry( const AxeAssetRegistry& ) = delete;
+		AxeAssetRegistry& operator=( const AxeAssetRegistry& ) = delete;
+		AxeAssetRegistry( AxeAssetRegistry&& ) = delete;
+		AxeAssetRegistry& operator=( AxeAssetRegistry&& ) = delete;
+
+		// Loads and uploads on the calling thread on a miss, a failed load throws for every request waiting on it and leaves the next request to try again
+		[[nodiscard]] std::shared_ptr<AxeModel> LoadModel( const std::string& filePath, const AxeModel::LoadOptions& options = {} );
+		// Streams the model in the background with AxeModelStreamer, the handle is resident right away if the model already is.
+		// Only coalesced with other streamed requests, a synchronous load of a model that is streaming at the same time loads its own copy.
+		[[nodiscard]] AxeModelStreamer::Handle StreamModel( const std::string& filePath, const AxeModel::LoadOptions& options = {} );
+
+		// Absolute, with "." and ".." segments and symbolic links resolved and forward slashes, so different spellings of one file share a key
+		[[nodiscard]] static std::string NormalizePath( const std::string& filePath );
+
+		[[nodiscard]] Statistics GetStatistics() const;
+		// Models that still have users
+		[[nodiscard]] size_t GetLoadedModelCount() const;
+
+	private:
+		struct ModelKey
+		{
+			std::string path;
+			AxeModel::LoadOptions options;
+
+			bool operator==( const ModelKey& other ) const
+			{
+				return path == other.path
+				       && options.optimize == other.options.optimize
+				       && options.buildMeshlets == other.options.buildMeshlets
+				       && options.vertexFormat == other.options.vertexFormat;
+			}
+		};
+
+		struct ModelKeyHash
+		{
+			size_t operator()( const ModelKey& key ) const noexcept;
+		};
+
+		struct ModelEntry
+		{
+			std::weak_ptr<AxeModel> model = {};
+			std::shared_future<std::shared_ptr<AxeModel>> pendingLoad = {};	// Valid while the model is being loaded
+			AxeModelStreamer::Handle pendingStream = {};	// Valid while the model is being streamed
+		};
+
+		AxeGeometryPool& axeGeometryPool;
+		AxeModelStreamer& axeModelStreamer;
+
+		mutable std::mutex mutex;
+		std::unordered_map<ModelKey, ModelEntry, ModelKeyHash> models = {};
+		Statistics statistics = {};
+	};
+}
@@ -45,43 +45,49 @@ namespace Axe
 	{
 		alignmentSize = GetAlignment( instanceSize, minOffsetAlignment );
 		bufferSize = alignmentSize * instanceCount;
-		device.CreateBuffer( bufferSize, usageFlags, memoryPropertyFlags, buffer, memory );
+		device.CreateBuffer( bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation );
 	}
 
 	AxeBuffer::~AxeBuffer()
 	{
 		Unmap();
 		vkDestroyBuffer( axeDevice.Device(), buffer, nullptr );
-		vkFreeMemory( axeDevice.Device(), memory, nullptr );
+		axeDevice.FreeMemory( allocation );
 	}
 
 	/**
 	 * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
 	 *
+	 * @note Host visible memory is persistently mapped by the allocator, so this only hands out a pointer into it
+	 *
 	 * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
 	 * buffer range.
 	 * @param offset (Optional) Byte offset from beginning
 	 *
 	 * @return VkResult of the buffer mapping call
 	 */
-	VkResult AxeBuffer::Map( const VkDeviceSize size, const VkDeviceSize offset )
+	VkResult AxeBuffer::Map( [[maybe_unused]] const VkDeviceSize size, const VkDeviceSize offset )
 	{
-		assert( buffer && memory && "Buffer needs to be created before it can be mapped" );
-		return vkMapMemory( axeDevice.Device(), memory, offset, size, 0, &mapped );
+		assert( buffer && allocation.IsValid() && "Buffer needs to be created before it can be mapped" );
+		assert( ( size == VK_WHOLE_SIZE ? offset <= bufferSize : offset + size <= bufferSize ) && "Mapped range has to be inside the buffer" );
+
+		if ( allocation.mapped == nullptr )
+		{
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		}
+
+		mapped = static_cast<char *>(allocation.mapped) + offset;
+		return VK_SUCCESS;
 	}
 
 	/**
 	 * Unmap a mapped memory range
 	 *
-	 * @note Does not return a result as vkUnmapMemory can't fail
+	 * @note The memory block itself stays mapped until the allocator frees it
 	 */
 	void AxeBuffer::Unmap()
 	{
-		if ( mapped )
-		{
-			vkUnmapMemory( axeDevice.Device(), memory );
-			mapped = nullptr;
-		}
+		mapped = nullptr;
 	}
 
 	/**
@@ -122,12 +128,7 @@ namespace Axe
 	 */
 	VkResult AxeBuffer::Flush( const VkDeviceSize size, const VkDeviceSize offset ) const
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
-		return vkFlushMappedMemoryRanges( axeDevice.Device(), 1, &mappedRange );
+		return axeDevice.MemoryAllocator().Flush( allocation, size, offset );
 	}
 
 	/**
@@ -143,12 +144,7 @@ namespace Axe
 	 */
 	VkResult AxeBuffer::Invalidate( const VkDeviceSize size, const VkDeviceSize offset ) const
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
-		return vkInvalidateMappedMemoryRanges( axeDevice.Device(), 1, &mappedRange );
+		return axeDevice.MemoryAllocator().Invalidate( allocation, size, offset );
 	}
 
 	/**
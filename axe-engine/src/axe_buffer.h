@@ -43,12 +43,13 @@ namespace Axe
 		[[nodiscard]] VkBufferUsageFlags GetUsageFlags() const { return usageFlags; }
 		[[nodiscard]] VkMemoryPropertyFlags GetMemoryPropertyFlags() const { return memoryPropertyFlags; }
 		[[nodiscard]] VkDeviceSize GetBufferSize() const { return bufferSize; }
+		[[nodiscard]] const AxeAllocation& GetAllocation() const { return allocation; }
 
 	private:
 		AxeDevice& axeDevice;
 		void* mapped = nullptr;
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		AxeAllocation allocation = {};
 
 		VkDeviceSize bufferSize;
 		uint32_t instanceCount;
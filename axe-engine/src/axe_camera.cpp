@@ -15,6 +15,8 @@ namespace Axe
 		projectionMatrix[ 3 ][ 0 ] = -( right + left ) / ( right - left );
 		projectionMatrix[ 3 ][ 1 ] = -( bottom + top ) / ( bottom - top );
 		projectionMatrix[ 3 ][ 2 ] = -near / ( far - near );
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	void AxeCamera::SetPerspectiveProjection( const float fovY, const float aspectRatio, const float near, const float far )
@@ -28,6 +30,8 @@ namespace Axe
 		projectionMatrix[ 2 ][ 2 ] = far / ( far - near );
 		projectionMatrix[ 2 ][ 3 ] = 1.0f;
 		projectionMatrix[ 3 ][ 2 ] = -( far * near ) / ( far - near );
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	void AxeCamera::SetViewDirection( const glm::vec3 position, const glm::vec3 direction, const glm::vec3 up )
@@ -113,4 +117,27 @@ namespace Axe
 		inverseViewMatrix[3][1] = position.y;
 		inverseViewMatrix[3][2] = position.z;
 	}
+
+	std::array<glm::vec4, 6> AxeCamera::GetFrustumPlanes() const
+	{
+		// Gribb & Hartmann plane extraction from the rows of the view projection matrix, with the 0..1 depth range the near plane is the third row alone
+		const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+		const auto row = [&]( const int i ) { return glm::vec4{ viewProjection[ 0 ][ i ], viewProjection[ 1 ][ i ], viewProjection[ 2 ][ i ], viewProjection[ 3 ][ i ] }; };
+
+		std::array<glm::vec4, 6> planes = {
+			row( 3 ) + row( 0 ),
+			row( 3 ) - row( 0 ),
+			row( 3 ) + row( 1 ),
+			row( 3 ) - row( 1 ),
+			row( 2 ),
+			row( 3 ) - row( 2 )
+		};
+
+		for ( glm::vec4& plane : planes )
+		{
+			plane /= glm::length( glm::vec3{ plane } );
+		}
+
+		return planes;
+	}
 }
@@ -3,6 +3,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <array>
+
 namespace Axe
 {
 	class AxeCamera
@@ -13,6 +15,13 @@ namespace Axe
 		void SetPerspectiveProjection( float fovY, float aspectRatio, float near, float far );
 
 		[[nodiscard]] const glm::mat4& GetProjection() const { return projectionMatrix; }
+		// View space depths of the near and far planes of the last projection set
+		[[nodiscard]] float GetNear() const { return nearPlane; }
+		[[nodiscard]] float GetFar() const { return farPlane; }
+
+		// Left, right, bottom, top, near and far planes in world space with normalized normals pointing inwards, a point p is inside a plane when
+		// dot(plane.xyz, p) + plane.w >= 0
+		[[nodiscard]] std::array<glm::vec4, 6> GetFrustumPlanes() const;
 
 		// Camera
 		[[nodiscard]] const glm::mat4& GetView() const { return viewMatrix; }
@@ -27,5 +36,7 @@ namespace Axe
 		glm::mat4 projectionMatrix{ 1.0f };
 		glm::mat4 viewMatrix{ 1.0f };
 		glm::mat4 inverseViewMatrix{ 1.0f };
+		float nearPlane = 0.0f;
+		float farPlane = 1.0f;
 	};
 }
@@ -70,6 +70,8 @@ namespace Axe
 		PickPhysicalDevice();
 		CreateLogicalDevice();
 		CreateCommandPool();
+
+		memoryAllocator = std::make_unique<AxeMemoryAllocator>( physicalDevice, logicalDevice );
 	}
 
 	AxeDevice::~AxeDevice()
@@ -77,6 +79,9 @@ namespace Axe
 		vkDestroyCommandPool( logicalDevice, commandPool, nullptr );
 		// Command buffers are destroyed when the command pool they are allocated from is destroyed
 
+		memoryAllocator->PrintStatistics();
+		memoryAllocator.reset();
+
 		vkDestroyDevice( logicalDevice, nullptr );
 
 		if ( enableValidationLayers )
@@ -189,13 +194,40 @@ namespace Axe
 
 		// ####################   Setup physical device features   ####################
 
+		VkPhysicalDeviceVulkan12Features supportedFeatures12 = {};
+		supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		// The 1.2 features can only be queried and enabled on devices that report 1.2, older ones keep the GPU-driven path disabled
+		const bool vulkan12Supported = physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures = {};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &supportedFeatures12;
+		if ( vulkan12Supported )
+		{
+			vkGetPhysicalDeviceFeatures2( physicalDevice, &supportedFeatures );
+		}
+
+		// Optional, without them the render systems only record draws on the CPU
+		drawIndirectCountSupported = vulkan12Supported &&
+		                             supportedFeatures12.drawIndirectCount &&
+		                             supportedFeatures.features.multiDrawIndirect &&
+		                             supportedFeatures.features.drawIndirectFirstInstance;
+
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.multiDrawIndirect = drawIndirectCountSupported;
+		deviceFeatures.drawIndirectFirstInstance = drawIndirectCountSupported;
+
+		VkPhysicalDeviceVulkan12Features deviceFeatures12 = {};
+		deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		deviceFeatures12.drawIndirectCount = drawIndirectCountSupported;
 
 		// ####################   Create logical device   ####################
 
 		VkDeviceCreateInfo logicalDeviceInfo = {};
 		logicalDeviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		logicalDeviceInfo.pNext = vulkan12Supported ? &deviceFeatures12 : nullptr;
 
 		logicalDeviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		logicalDeviceInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -500,7 +532,7 @@ namespace Axe
 		const VkBufferUsageFlags usage,
 		const VkMemoryPropertyFlags memoryProperties,
 		VkBuffer& buffer,
-		VkDeviceMemory& bufferMemory ) const
+		AxeAllocation& bufferAllocation ) const
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -516,17 +548,15 @@ namespace Axe
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements( logicalDevice, buffer, &memRequirements );
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType( memRequirements.memoryTypeBits, memoryProperties );
+		bufferAllocation = memoryAllocator->Allocate(
+			memRequirements,
+			FindMemoryType( memRequirements.memoryTypeBits, memoryProperties ),
+			AxeMemoryAllocator::ResourceTiling::Linear );
 
-		if ( vkAllocateMemory( logicalDevice, &allocInfo, nullptr, &bufferMemory ) != VK_SUCCESS )
+		if ( vkBindBufferMemory( logicalDevice, buffer, bufferAllocation.memory, bufferAllocation.offset ) != VK_SUCCESS )
 		{
-			throw std::runtime_error( "Failed to allocate vertex buffer memory" );
+			throw std::runtime_error( "Failed to bind buffer memory" );
 		}
-
-		vkBindBufferMemory( logicalDevice, buffer, bufferMemory, 0 );
 	}
 
 	VkCommandBuffer AxeDevice::BeginSingleTimeCommands() const
@@ -563,13 +593,18 @@ namespace Axe
 		vkFreeCommandBuffers( logicalDevice, commandPool, 1, &commandBuffer );
 	}
 
-	void AxeDevice::CopyBuffer( VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size ) const
+	void AxeDevice::CopyBuffer(
+		const VkBuffer srcBuffer,
+		const VkBuffer dstBuffer,
+		const VkDeviceSize size,
+		const VkDeviceSize srcOffset,
+		const VkDeviceSize dstOffset ) const
 	{
 		const VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 
 		VkBufferCopy copyRegion;
-		copyRegion.srcOffset = 0; // Optional
-		copyRegion.dstOffset = 0; // Optional
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
 		copyRegion.size = size;
 		vkCmdCopyBuffer( commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion );
 
@@ -609,7 +644,7 @@ namespace Axe
 		const VkImageCreateInfo& imageInfo,
 		const VkMemoryPropertyFlags memoryProperties,
 		VkImage& image,
-		VkDeviceMemory& imageMemory ) const
+		AxeAllocation& imageAllocation ) const
 	{
 		if ( vkCreateImage( logicalDevice, &imageInfo, nullptr, &image ) != VK_SUCCESS )
 		{
@@ -619,17 +654,14 @@ namespace Axe
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements( logicalDevice, image, &memRequirements );
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType( memRequirements.memoryTypeBits, memoryProperties );
-
-		if ( vkAllocateMemory( logicalDevice, &allocInfo, nullptr, &imageMemory ) != VK_SUCCESS )
-		{
-			throw std::runtime_error( "Failed to allocate image memory" );
-		}
+		imageAllocation = memoryAllocator->Allocate(
+			memRequirements,
+			FindMemoryType( memRequirements.memoryTypeBits, memoryProperties ),
+			imageInfo.tiling == VK_IMAGE_TILING_LINEAR
+				? AxeMemoryAllocator::ResourceTiling::Linear
+				: AxeMemoryAllocator::ResourceTiling::Optimal );
 
-		if ( vkBindImageMemory( logicalDevice, image, imageMemory, 0 ) != VK_SUCCESS )
+		if ( vkBindImageMemory( logicalDevice, image, imageAllocation.memory, imageAllocation.offset ) != VK_SUCCESS )
 		{
 			throw std::runtime_error( "Failed to bind image memory" );
 		}
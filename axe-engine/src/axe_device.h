@@ -1,7 +1,9 @@
 #pragma once
 
+#include "axe_memory_allocator.h"
 #include "axe_window.h"
 
+#include <memory>
 #include <vector>
 
 namespace Axe
@@ -48,6 +50,8 @@ namespace Axe
 		[[nodiscard]] VkSurfaceKHR Surface() const { return surface; }
 		[[nodiscard]] VkQueue GraphicsQueue() const { return graphicsQueue; }
 		[[nodiscard]] VkQueue PresentQueue() const { return presentQueue; }
+		// Multi-draw indirect with a GPU written draw count and first instance, which GPU-driven rendering needs. Enabled when supported
+		[[nodiscard]] bool SupportsDrawIndirectCount() const { return drawIndirectCountSupported; }
 
 		[[nodiscard]] SwapChainSupportDetails GetSwapChainSupport() const { return QuerySwapChainSupport( physicalDevice ); }
 		[[nodiscard]] QueueFamilyIndices FindPhysicalQueueFamilies() const { return FindQueueFamilies( physicalDevice ); }
@@ -60,11 +64,11 @@ namespace Axe
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags memoryProperties,
 			VkBuffer& buffer,
-			VkDeviceMemory& bufferMemory
+			AxeAllocation& bufferAllocation
 		) const;
 		[[nodiscard]] VkCommandBuffer BeginSingleTimeCommands() const;
 		void EndSingleTimeCommands( VkCommandBuffer commandBuffer ) const;
-		void CopyBuffer( VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size ) const;
+		void CopyBuffer( VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0 ) const;
 		void CopyBufferToImage(
 			VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount
 		) const;
@@ -73,9 +77,13 @@ namespace Axe
 			const VkImageCreateInfo& imageInfo,
 			VkMemoryPropertyFlags memoryProperties,
 			VkImage& image,
-			VkDeviceMemory& imageMemory
+			AxeAllocation& imageAllocation
 		) const;
 
+		// Memory helper functions
+		void FreeMemory( AxeAllocation& allocation ) const { memoryAllocator->Free( allocation ); }
+		[[nodiscard]] AxeMemoryAllocator& MemoryAllocator() const { return *memoryAllocator; }
+
 	private:
 		VkInstance instance = {};
 		VkDebugUtilsMessengerEXT debugMessenger = {};
@@ -87,6 +95,9 @@ namespace Axe
 		VkSurfaceKHR surface = {};
 		VkQueue graphicsQueue = {};
 		VkQueue presentQueue = {};
+		bool drawIndirectCountSupported = false;
+
+		std::unique_ptr<AxeMemoryAllocator> memoryAllocator;
 
 		const std::vector<const char *> validationLayers = { "VK_LAYER_KHRONOS_validation" };
 		const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
@@ -2,27 +2,18 @@
 
 #include "axe_camera.h"
 #include "axe_game_object.h"
+#include "axe_renderer.h"
 
 #include <vulkan/vulkan.h>
 
 namespace Axe
 {
-	constexpr int MAX_LIGHTS = 10;
-
-	struct PointLight
-	{
-		glm::vec4 position{}; // ignore w
-		glm::vec4 color{}; // w is intensity
-	};
-
 	struct GlobalUBO
 	{
 		glm::mat4 projectionMatrix{ 1.0f };
 		glm::mat4 viewMatrix{ 1.0f };
 		glm::mat4 inverseViewMatrix{1.0f};
-		glm::vec4 ambientColor{ 1.0f, 1.0f, 1.0f, 0.02f }; // w is intensity
-		PointLight pointLights[ MAX_LIGHTS ];
-		int numActiveLights = 0;
+		glm::vec4 ambientColor{ 1.0f, 1.0f, 1.0f, 0.02f }; // w is intensity, the point lights are in AxeLightClusters
 	};
 
 	struct FrameInfo
@@ -30,6 +21,7 @@ namespace Axe
 		int frameIndex;
 		float frameTime;
 		VkCommandBuffer commandBuffer;
+		AxeRenderer& renderer;	// Hands out the secondary command buffers the render systems record into
 		AxeCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
 		AxeGameObject::Map& gameObjects;
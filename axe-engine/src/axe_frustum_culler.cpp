@@ -0,0 +1,95 @@
+#include "axe_frustum_culler.h"
+
+// std headers
+#include <algorithm>
+#include <xmmintrin.h>
+
+namespace Axe
+{
+	glm::vec4 AxeFrustumCuller::TransformSphere( const glm::vec4& sphere, const glm::mat4& modelMatrix )
+	{
+		const glm::vec3 center = glm::vec3{ modelMatrix * glm::vec4{ glm::vec3{ sphere }, 1.0f } };
+		const float scale = std::max( {
+			glm::length( glm::vec3{ modelMatrix[ 0 ] } ),
+			glm::length( glm::vec3{ modelMatrix[ 1 ] } ),
+			glm::length( glm::vec3{ modelMatrix[ 2 ] } )
+		} );
+
+		return glm::vec4{ center, sphere.w * scale };
+	}
+
+	void AxeFrustumCuller::Clear()
+	{
+		sphereCount = 0;
+		statistics = {};
+	}
+
+	uint32_t AxeFrustumCuller::Add( const glm::vec4& sphere )
+	{
+		// Grown together and written through one count, push_back on each array would update four sizes per sphere
+		if ( sphereCount == centersX.size() )
+		{
+			const size_t capacity = std::max<size_t>( 2 * centersX.size(), 64 * BATCH_SIZE );
+			centersX.resize( capacity );
+			centersY.resize( capacity );
+			centersZ.resize( capacity );
+			radii.resize( capacity );
+		}
+
+		centersX[ sphereCount ] = sphere.x;
+		centersY[ sphereCount ] = sphere.y;
+		centersZ[ sphereCount ] = sphere.z;
+		radii[ sphereCount ] = sphere.w;
+
+		return sphereCount++;
+	}
+
+	void AxeFrustumCuller::Cull( const std::array<glm::vec4, 6>& planes )
+	{
+		// The arrays always grow by whole batches, the spheres past the count get tested too but their results are never looked at
+		const size_t paddedCount = ( sphereCount + BATCH_SIZE - 1 ) / BATCH_SIZE * BATCH_SIZE;
+		visibility.resize( centersX.size() );
+
+		// Every plane component broadcast to all lanes, loaded once for all batches
+		__m128 planesX[ 6 ] = {};
+		__m128 planesY[ 6 ] = {};
+		__m128 planesZ[ 6 ] = {};
+		__m128 planesW[ 6 ] = {};
+		for ( size_t i = 0; i < planes.size(); i++ )
+		{
+			planesX[ i ] = _mm_set1_ps( planes[ i ].x );
+			planesY[ i ] = _mm_set1_ps( planes[ i ].y );
+			planesZ[ i ] = _mm_set1_ps( planes[ i ].z );
+			planesW[ i ] = _mm_set1_ps( planes[ i ].w );
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+
+		for ( size_t i = 0; i < paddedCount; i += BATCH_SIZE )
+		{
+			const __m128 x = _mm_loadu_ps( &centersX[ i ] );
+			const __m128 y = _mm_loadu_ps( &centersY[ i ] );
+			const __m128 z = _mm_loadu_ps( &centersZ[ i ] );
+			const __m128 radius = _mm_loadu_ps( &radii[ i ] );
+
+			// A sphere is outside when its center is further than its radius behind any plane, dot(plane.xyz, center) + plane.w + radius < 0
+			__m128 outside = zero;
+			for ( size_t plane = 0; plane < planes.size(); plane++ )
+			{
+				__m128 distance = _mm_add_ps( _mm_mul_ps( planesX[ plane ], x ), planesW[ plane ] );
+				distance = _mm_add_ps( distance, _mm_mul_ps( planesY[ plane ], y ) );
+				distance = _mm_add_ps( distance, _mm_mul_ps( planesZ[ plane ], z ) );
+				outside = _mm_or_ps( outside, _mm_cmplt_ps( _mm_add_ps( distance, radius ), zero ) );
+			}
+
+			const int outsideMask = _mm_movemask_ps( outside );
+			for ( uint32_t lane = 0; lane < BATCH_SIZE; lane++ )
+			{
+				visibility[ i + lane ] = static_cast<uint8_t>(( ~outsideMask >> lane ) & 1);
+			}
+		}
+
+		statistics.visibleCount = static_cast<uint32_t>(std::count( visibility.begin(), visibility.begin() + sphereCount, uint8_t{ 1 } ));
+		statistics.culledCount = sphereCount - statistics.visibleCount;
+	}
+}
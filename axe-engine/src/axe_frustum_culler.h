@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Axe
+{
+	// Tests the world space bounding spheres of a frame's objects against the view frustum before any draws are recorded.
+	// The spheres are kept as separate arrays of x, y, z and radius so the SSE kernel tests four of them per instruction against each plane
+	class AxeFrustumCuller
+	{
+	public:
+		// Spheres tested at once, the arrays are always a multiple of it long
+		static constexpr uint32_t BATCH_SIZE = 4;
+
+		struct Statistics
+		{
+			uint32_t visibleCount = 0;
+			uint32_t culledCount = 0;
+		};
+
+		// Moves a model space bounding sphere, as returned by AxeModel::GetBoundingSphere, into world space.
+		// The radius grows with the longest scaled axis, so the sphere stays conservative under non-uniform scaling
+		[[nodiscard]] static glm::vec4 TransformSphere( const glm::vec4& sphere, const glm::mat4& modelMatrix );
+
+		// Forgets the last frame's spheres and statistics, keeping the memory
+		void Clear();
+		// Returns the index to look the sphere's visibility up with after culling
+		uint32_t Add( const glm::vec4& sphere );
+
+		// Planes are in world space as returned by AxeCamera::GetFrustumPlanes
+		void Cull( const std::array<glm::vec4, 6>& planes );
+
+		[[nodiscard]] bool IsVisible( const uint32_t index ) const { return visibility[ index ] != 0; }
+		[[nodiscard]] uint32_t GetSphereCount() const { return sphereCount; }
+		// What the last Cull call found
+		[[nodiscard]] const Statistics& GetStatistics() const { return statistics; }
+
+	private:
+		std::vector<float> centersX = {};
+		std::vector<float> centersY = {};
+		std::vector<float> centersZ = {};
+		std::vector<float> radii = {};
+		std::vector<uint8_t> visibility = {};
+		uint32_t sphereCount = 0;	// The arrays are larger, they only ever grow
+
+		Statistics statistics = {};
+	};
+}
@@ -16,6 +16,8 @@ namespace Axe
 
 		[[nodiscard]] glm::mat4 Mat4() const;
 		[[nodiscard]] glm::mat3 NormalMatrix() const;
+
+		bool operator==( const TransformComponent& ) const = default;
 	};
 
 	struct PointLightComponent
@@ -44,6 +46,13 @@ namespace Axe
 		std::shared_ptr<AxeModel> model;
 		std::unique_ptr<PointLightComponent> pointLight = nullptr;
 
+		// The CPU-driven renderer records static objects once and replays them until one is added, removed or changes model, at their finest level
+		// and without culling. Their transforms are read from the scene buffer, so moving them now and then still works
+		bool isStatic = false;
+
+		uint32_t lod = 0;	// Level of detail the model was last drawn with, kept for the hysteresis of the selection
+		uint32_t sceneSlot = UINT32_MAX;	// Where AxeSceneBuffer keeps the object, UINT32_MAX until it has a model
+
 		AxeGameObject( const AxeGameObject& ) = delete;
 		AxeGameObject& operator=( const AxeGameObject& ) = delete;
 		AxeGameObject( AxeGameObject&& ) = default;
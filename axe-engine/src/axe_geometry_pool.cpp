@@ -0,0 +1,265 @@
+#include "axe_geometry_pool.h"
+
+#include "axe_swap_chain.h"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Axe
+{
+	AxeGeometryPool::AxeGeometryPool( AxeDevice& device, AxeUploadContext& uploadContext )
+		: axeDevice{ device }, axeUploadContext{ uploadContext } {}
+
+	// Pages are destroyed with the pool, this has to happen after the device is idle
+	AxeGeometryPool::~AxeGeometryPool() {}
+
+	static uint32_t IndexSize( const VkIndexType indexType )
+	{
+		return indexType == VK_INDEX_TYPE_UINT16 ? sizeof( uint16_t ) : sizeof( uint32_t );
+	}
+
+	AxeGeometryPool::Allocation AxeGeometryPool::Allocate(
+		const void* vertices,
+		const uint32_t vertexCount,
+		const uint32_t vertexSize,
+		const std::span<const uint32_t> indices )
+	{
+		if ( vertexCount > MAX_UINT16_VERTEX_COUNT || indices.empty() )
+		{
+			return Allocate( vertices, vertexCount, vertexSize, indices.data(), static_cast<uint32_t>(indices.size()), VK_INDEX_TYPE_UINT32 );
+		}
+
+		// Every index is below the vertex count, so nothing gets cut off. The upload copies the temporary array into the staging ring right away.
+		const std::vector<uint16_t> narrowIndices{ indices.begin(), indices.end() };
+		return Allocate( vertices, vertexCount, vertexSize, std::span{ narrowIndices } );
+	}
+
+	AxeGeometryPool::Allocation AxeGeometryPool::Allocate(
+		const void* vertices,
+		const uint32_t vertexCount,
+		const uint32_t vertexSize,
+		const std::span<const uint16_t> indices )
+	{
+		return Allocate( vertices, vertexCount, vertexSize, indices.data(), static_cast<uint32_t>(indices.size()), VK_INDEX_TYPE_UINT16 );
+	}
+
+	AxeGeometryPool::Allocation AxeGeometryPool::Allocate(
+		const void* vertices,
+		const uint32_t vertexCount,
+		const uint32_t vertexSize,
+		const void* indices,
+		const uint32_t indexCount,
+		const VkIndexType indexType )
+	{
+		assert( vertexCount > 0 && vertexSize > 0 && "Cannot allocate empty geometry" );
+
+		const uint32_t indexSize = IndexSize( indexType );
+		const VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexCount) * vertexSize;
+		const VkDeviceSize indexBytes = static_cast<VkDeviceSize>(indexCount) * indexSize;
+
+		// Aligning to the vertex size makes every vertex range start at a whole vertex, which is what vertexOffset counts in
+		const auto tryAllocate = [&]( const uint32_t pageIndex, Allocation& allocation )
+		{
+			Page& page = pages[ pageIndex ];
+
+			const AxeTlsfAllocator::Allocation vertexRange = page.vertexAllocator.Allocate( vertexBytes, vertexSize );
+			if ( !vertexRange.IsValid() )
+			{
+				return false;
+			}
+
+			AxeTlsfAllocator::Allocation indexRange = {};
+			if ( indexBytes > 0 )
+			{
+				indexRange = page.indexAllocator.Allocate( indexBytes, indexSize );
+				if ( !indexRange.IsValid() )
+				{
+					page.vertexAllocator.Free( vertexRange.node );
+					return false;
+				}
+			}
+
+			allocation.page = pageIndex;
+			allocation.vertexOffset = static_cast<int32_t>(vertexRange.offset / vertexSize);
+			allocation.vertexCount = vertexCount;
+			allocation.vertexNode = vertexRange.node;
+			allocation.firstIndex = static_cast<uint32_t>(indexRange.offset / indexSize);
+			allocation.indexCount = indexCount;
+			allocation.indexType = indexType;
+			allocation.indexNode = indexRange.node;
+			return true;
+		};
+
+		Allocation allocation = {};
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+
+		// The upload can wait for the staging ring, Free and the render thread's Bind and AdvanceFrame mustn't wait along with it
+		{
+			std::scoped_lock lock{ mutex };
+
+			for ( uint32_t i = 0; i < pages.size() && !allocation.IsValid(); i++ )
+			{
+				tryAllocate( i, allocation );
+			}
+
+			// Geometry that doesn't fit into a default page gets a page of its own
+			if ( !allocation.IsValid() )
+			{
+				const uint32_t page = CreatePage(
+					std::max( VERTEX_PAGE_SIZE, vertexBytes ),
+					std::max( INDEX_PAGE_SIZE, indexBytes ) );
+
+				[[maybe_unused]] const bool allocated = tryAllocate( page, allocation );
+				assert( allocated && "Fresh geometry page is too small for the allocation" );
+			}
+
+			vertexBuffer = pages[ allocation.page ].vertexBuffer->GetBufferHandle();
+			indexBuffer = pages[ allocation.page ].indexBuffer->GetBufferHandle();
+		}
+
+		Upload( allocation, vertexBuffer, indexBuffer, vertices, vertexSize, indices );
+
+		return allocation;
+	}
+
+	void AxeGeometryPool::Free( Allocation& allocation )
+	{
+		if ( !allocation.IsValid() )
+		{
+			return;
+		}
+
+		std::scoped_lock lock{ mutex };
+		pendingFrees.push_back( { allocation, currentFrame } );
+		allocation = {};
+	}
+
+	void AxeGeometryPool::AdvanceFrame()
+	{
+		std::scoped_lock lock{ mutex };
+		currentFrame++;
+
+		std::erase_if(
+			pendingFrees,
+			[this]( const PendingFree& pendingFree )
+			{
+				if ( currentFrame - pendingFree.frame < AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+				{
+					return false;
+				}
+
+				Release( pendingFree.allocation );
+				return true;
+			} );
+	}
+
+	void AxeGeometryPool::Bind( const VkCommandBuffer commandBuffer, const uint32_t page, const VkIndexType indexType ) const
+	{
+		// Only taken when the bound page changes, which draws sorted by geometry rarely do
+		std::scoped_lock lock{ mutex };
+		assert( page < pages.size() && "Cannot bind a geometry page that doesn't exist" );
+
+		const VkBuffer buffers[ ] = { pages[ page ].vertexBuffer->GetBufferHandle() };
+		constexpr VkDeviceSize offsets[ ] = { 0 };
+
+		vkCmdBindVertexBuffers( commandBuffer, 0, 1, buffers, offsets );
+		vkCmdBindIndexBuffer( commandBuffer, pages[ page ].indexBuffer->GetBufferHandle(), 0, indexType );
+	}
+
+	uint32_t AxeGeometryPool::GetPageCount() const
+	{
+		std::scoped_lock lock{ mutex };
+		return static_cast<uint32_t>(pages.size());
+	}
+
+	VkDeviceSize AxeGeometryPool::GetUsedVertexBytes() const
+	{
+		std::scoped_lock lock{ mutex };
+		VkDeviceSize used = 0;
+		for ( const Page& page : pages )
+		{
+			used += page.vertexAllocator.GetUsedSize();
+		}
+		return used;
+	}
+
+	VkDeviceSize AxeGeometryPool::GetUsedIndexBytes() const
+	{
+		std::scoped_lock lock{ mutex };
+		VkDeviceSize used = 0;
+		for ( const Page& page : pages )
+		{
+			used += page.indexAllocator.GetUsedSize();
+		}
+		return used;
+	}
+
+	uint32_t AxeGeometryPool::CreatePage( const VkDeviceSize vertexBytes, const VkDeviceSize indexBytes )
+	{
+		pages.push_back(
+			Page{
+				std::make_unique<AxeBuffer>(
+					axeDevice,
+					vertexBytes,
+					1,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+				),
+				std::make_unique<AxeBuffer>(
+					axeDevice,
+					indexBytes,
+					1,
+					VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+				),
+				AxeTlsfAllocator{ vertexBytes },
+				AxeTlsfAllocator{ indexBytes }
+			} );
+
+		return static_cast<uint32_t>(pages.size() - 1);
+	}
+
+	void AxeGeometryPool::Release( const Allocation& allocation )
+	{
+		Page& page = pages[ allocation.page ];
+
+		page.vertexAllocator.Free( allocation.vertexNode );
+
+		if ( allocation.indexNode != AxeTlsfAllocator::INVALID_NODE )
+		{
+			page.indexAllocator.Free( allocation.indexNode );
+		}
+	}
+
+	void AxeGeometryPool::Upload(
+		Allocation& allocation,
+		const VkBuffer vertexBuffer,
+		const VkBuffer indexBuffer,
+		const void* vertices,
+		const uint32_t vertexSize,
+		const void* indices ) const
+	{
+		const uint32_t indexSize = IndexSize( allocation.indexType );
+		const VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(allocation.vertexCount) * vertexSize;
+		const VkDeviceSize indexBytes = static_cast<VkDeviceSize>(allocation.indexCount) * indexSize;
+
+		allocation.uploadTicket = axeUploadContext.CopyToBuffer(
+			vertices,
+			vertexBytes,
+			vertexBuffer,
+			static_cast<VkDeviceSize>(allocation.vertexOffset) * vertexSize );
+
+		if ( indexBytes > 0 )
+		{
+			allocation.uploadTicket = axeUploadContext.CopyToBuffer(
+				indices,
+				indexBytes,
+				indexBuffer,
+				static_cast<VkDeviceSize>(allocation.firstIndex) * indexSize );
+		}
+	}
+}
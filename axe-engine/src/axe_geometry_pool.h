@@ -0,0 +1,123 @@
+#pragma once
+
+#include "axe_buffer.h"
+#include "axe_device.h"
+#include "axe_tlsf_allocator.h"
+#include "axe_upload_context.h"
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Sub-allocates the vertex and index ranges of all models from a few large device local buffers ("pages"),
+	// so that render systems only have to bind geometry when the page changes instead of once per object.
+	// Models draw with vertexOffset/firstIndex into the bound page.
+	// Index buffers hold 16 and 32-bit indices side by side, each allocation is bound with its own index type.
+	// Allocate records the upload right away, which submits to the graphics queue when the staging ring is full, so it has to be called on the
+	// render thread like the rest of the uploads. Free can be called from any thread, models are released by whichever thread drops them last.
+	class AxeGeometryPool
+	{
+	public:
+		static constexpr uint32_t INVALID_PAGE = ~0u;
+		static constexpr VkDeviceSize VERTEX_PAGE_SIZE = 64ull * 1024ull * 1024ull;
+		static constexpr VkDeviceSize INDEX_PAGE_SIZE = 32ull * 1024ull * 1024ull;
+		// Geometry with at most this many vertices gets 16-bit indices
+		static constexpr uint32_t MAX_UINT16_VERTEX_COUNT = 1u << 16;
+
+		struct Allocation
+		{
+			uint32_t page = INVALID_PAGE;
+
+			int32_t vertexOffset = 0;	// In vertices, can be passed straight to vkCmdDrawIndexed/vkCmdDraw
+			uint32_t vertexCount = 0;
+			uint32_t firstIndex = 0;	// In indices of the index type
+			uint32_t indexCount = 0;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+			uint32_t vertexNode = AxeTlsfAllocator::INVALID_NODE;
+			uint32_t indexNode = AxeTlsfAllocator::INVALID_NODE;
+
+			AxeUploadContext::Ticket uploadTicket = 0;	// The geometry can be drawn by anything submitted after this ticket
+
+			[[nodiscard]] bool IsValid() const { return page != INVALID_PAGE; }
+			[[nodiscard]] bool HasIndices() const { return indexCount > 0; }
+		};
+
+		AxeGeometryPool( AxeDevice& device, AxeUploadContext& uploadContext );
+		~AxeGeometryPool();
+
+		AxeGeometryPool( const AxeGeometryPool& ) = delete;
+		AxeGeometryPool& operator=( const AxeGeometryPool& ) = delete;
+		AxeGeometryPool( AxeGeometryPool&& ) = delete;
+		AxeGeometryPool& operator=( AxeGeometryPool&& ) = delete;
+
+		// Finds room for the geometry (creating a new page if needed) and records its upload.
+		// 32-bit indices are narrowed to 16-bit whenever the vertex count allows it.
+		[[nodiscard]] Allocation Allocate(
+			const void* vertices,
+			uint32_t vertexCount,
+			uint32_t vertexSize,
+			std::span<const uint32_t> indices );
+		[[nodiscard]] Allocation Allocate(
+			const void* vertices,
+			uint32_t vertexCount,
+			uint32_t vertexSize,
+			std::span<const uint16_t> indices );
+
+		// The ranges might still be used by frames in flight, so they only become reusable after MAX_FRAMES_IN_FLIGHT calls to AdvanceFrame()
+		void Free( Allocation& allocation );
+		void AdvanceFrame();
+
+		void Bind( VkCommandBuffer commandBuffer, uint32_t page, VkIndexType indexType ) const;
+
+		[[nodiscard]] uint32_t GetPageCount() const;
+		[[nodiscard]] VkDeviceSize GetUsedVertexBytes() const;
+		[[nodiscard]] VkDeviceSize GetUsedIndexBytes() const;
+
+	private:
+		struct Page
+		{
+			std::unique_ptr<AxeBuffer> vertexBuffer;
+			std::unique_ptr<AxeBuffer> indexBuffer;
+			AxeTlsfAllocator vertexAllocator;
+			AxeTlsfAllocator indexAllocator;
+		};
+
+		struct PendingFree
+		{
+			Allocation allocation;
+			uint64_t frame = 0;
+		};
+
+		AxeDevice& axeDevice;
+		AxeUploadContext& axeUploadContext;
+
+		// Guards everything below against models freed off the render thread, it isn't held while uploading
+		mutable std::mutex mutex;
+		std::vector<Page> pages;
+		std::vector<PendingFree> pendingFrees;
+		uint64_t currentFrame = 0;
+
+		[[nodiscard]] Allocation Allocate(
+			const void* vertices,
+			uint32_t vertexCount,
+			uint32_t vertexSize,
+			const void* indices,
+			uint32_t indexCount,
+			VkIndexType indexType );
+
+		uint32_t CreatePage( VkDeviceSize vertexBytes, VkDeviceSize indexBytes );
+		void Release( const Allocation& allocation );
+		// Only reads the buffers it is given, so it can run without holding the mutex
+		void Upload(
+			Allocation& allocation,
+			VkBuffer vertexBuffer,
+			VkBuffer indexBuffer,
+			const void* vertices,
+			uint32_t vertexSize,
+			const void* indices ) const;
+	};
+}
@@ -0,0 +1,304 @@
+#include "axe_gpu_culler.h"
+
+#include "axe_swap_chain.h"
+
+// std headers
+#include <cstddef>
+#include <stdexcept>
+
+namespace Axe
+{
+	static_assert( sizeof( AxeGpuCuller::Object ) == 8, "Objects are read by the culling shaders with std430 layout" );
+	static_assert( sizeof( AxeGpuCuller::Draw ) == 28 && offsetof( AxeGpuCuller::Draw, batch ) == 20, "Draws are read by the culling shaders with std430 layout" );
+
+	// Instances are the scene buffer slots of the visible objects
+	static constexpr VkDeviceSize INSTANCE_SIZE = sizeof( uint32_t );
+
+	static std::unique_ptr<AxeBuffer> CreateBuffer(
+		AxeDevice& device,
+		const VkDeviceSize elementSize,
+		const uint32_t elementCount,
+		const VkBufferUsageFlags usageFlags,
+		const VkMemoryPropertyFlags memoryPropertyFlags )
+	{
+		auto buffer = std::make_unique<AxeBuffer>( device, elementSize, elementCount, usageFlags, memoryPropertyFlags );
+		if ( memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+		{
+			buffer->Map();
+		}
+
+		return buffer;
+	}
+
+	static uint32_t GrowCapacity( uint32_t capacity, const size_t count )
+	{
+		while ( capacity < count )
+		{
+			capacity *= 2;
+		}
+
+		return capacity;
+	}
+
+	static void RecordBarrier(
+		VkCommandBuffer commandBuffer,
+		const VkPipelineStageFlags sourceStages,
+		const VkAccessFlags sourceAccess,
+		const VkPipelineStageFlags destinationStages,
+		const VkAccessFlags destinationAccess )
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = sourceAccess;
+		barrier.dstAccessMask = destinationAccess;
+
+		vkCmdPipelineBarrier( commandBuffer, sourceStages, destinationStages, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+	}
+
+	AxeGpuCuller::AxeGpuCuller( AxeDevice& device, AxeDescriptorSetLayout& instanceSetLayout, const AxeSceneBuffer& sceneBuffer )
+		: axeDevice{ device },
+		  instanceSetLayout{ instanceSetLayout },
+		  sceneBuffer{ sceneBuffer }
+	{
+		CreatePipelines();
+		CreateFrameResources();
+	}
+
+	AxeGpuCuller::~AxeGpuCuller()
+	{
+		vkDestroyPipelineLayout( axeDevice.Device(), pipelineLayout, nullptr );
+	}
+
+	void AxeGpuCuller::CreatePipelines()
+	{
+		cullSetLayout = AxeDescriptorSetLayout::Builder( axeDevice )
+		                .AddBinding( 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Objects
+		                .AddBinding( 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Draws
+		                .AddBinding( 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Compacted commands
+		                .AddBinding( 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Counts
+		                .AddBinding( 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Instances
+		                .AddBinding( 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT )	// Scene objects
+		                .Build();
+
+		VkPushConstantRange pushConstantRange = {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof( PushConstants );
+
+		const VkDescriptorSetLayout descriptorSetLayout = cullSetLayout->GetDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if ( vkCreatePipelineLayout( axeDevice.Device(), &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to create culling pipeline layout" );
+		}
+
+		cullPipeline = std::make_unique<AxePipeline>( axeDevice, pipelineLayout, "shaders/cull_objects.comp.spv" );
+		compactPipeline = std::make_unique<AxePipeline>( axeDevice, pipelineLayout, "shaders/compact_draws.comp.spv" );
+	}
+
+	void AxeGpuCuller::CreateFrameResources()
+	{
+		descriptorPool = AxeDescriptorPool::Builder( axeDevice )
+		                 .SetMaxSets( 2 * AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		                 .AddPoolSize( VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8 * AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		                 .Build();
+
+		frames.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		for ( FrameResources& frame : frames )
+		{
+			Reserve( frame, INITIAL_CAPACITY, INITIAL_CAPACITY, INITIAL_CAPACITY );
+
+			if ( !descriptorPool->AllocateDescriptorSet( cullSetLayout->GetDescriptorSetLayout(), frame.cullDescriptorSet ) ||
+			     !descriptorPool->AllocateDescriptorSet( instanceSetLayout.GetDescriptorSetLayout(), frame.instanceDescriptorSet ) )
+			{
+				throw std::runtime_error( "Failed to allocate culling descriptor sets" );
+			}
+
+			WriteDescriptorSets( frame );
+		}
+	}
+
+	void AxeGpuCuller::Reserve( FrameResources& frame, const size_t objectCount, const size_t drawCount, const size_t batchCount ) const
+	{
+		bool replaced = false;
+
+		// The frame's fence has been waited on, so neither the old buffers nor the descriptor sets pointing at them are in use anymore
+		if ( frame.objectBuffer == nullptr || objectCount > frame.objectBuffer->GetInstanceCount() )
+		{
+			const uint32_t capacity = GrowCapacity( frame.objectBuffer ? frame.objectBuffer->GetInstanceCount() : INITIAL_CAPACITY, objectCount );
+
+			frame.objectBuffer = CreateBuffer( axeDevice, sizeof( Object ), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+			frame.instanceBuffer = CreateBuffer( axeDevice, INSTANCE_SIZE, capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+			replaced = true;
+		}
+
+		if ( frame.drawBuffer == nullptr || drawCount > frame.drawBuffer->GetInstanceCount() )
+		{
+			const uint32_t capacity = GrowCapacity( frame.drawBuffer ? frame.drawBuffer->GetInstanceCount() : INITIAL_CAPACITY, drawCount );
+
+			frame.drawBuffer = CreateBuffer( axeDevice, sizeof( Draw ), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+			frame.indirectBuffer = CreateBuffer(
+				axeDevice,
+				sizeof( VkDrawIndexedIndirectCommand ),
+				capacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+			replaced = true;
+		}
+
+		// Read back for the visible object count, so it stays host visible
+		if ( frame.countBuffer == nullptr || 1 + batchCount > frame.countBuffer->GetInstanceCount() )
+		{
+			const uint32_t capacity = GrowCapacity( frame.countBuffer ? frame.countBuffer->GetInstanceCount() : INITIAL_CAPACITY, 1 + batchCount );
+
+			frame.countBuffer = CreateBuffer(
+				axeDevice,
+				sizeof( uint32_t ),
+				capacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+			frame.hasResults = false;
+			replaced = true;
+		}
+
+		if ( replaced && frame.cullDescriptorSet != VK_NULL_HANDLE )
+		{
+			WriteDescriptorSets( frame );
+		}
+	}
+
+	void AxeGpuCuller::WriteDescriptorSets( FrameResources& frame ) const
+	{
+		auto objectInfo = frame.objectBuffer->DescriptorInfo();
+		auto drawInfo = frame.drawBuffer->DescriptorInfo();
+		auto indirectInfo = frame.indirectBuffer->DescriptorInfo();
+		auto countInfo = frame.countBuffer->DescriptorInfo();
+		auto instanceInfo = frame.instanceBuffer->DescriptorInfo();
+		auto sceneInfo = sceneBuffer.DescriptorInfo();
+
+		AxeDescriptorWriter( *cullSetLayout, *descriptorPool )
+			.WriteBuffer( 0, &objectInfo )
+			.WriteBuffer( 1, &drawInfo )
+			.WriteBuffer( 2, &indirectInfo )
+			.WriteBuffer( 3, &countInfo )
+			.WriteBuffer( 4, &instanceInfo )
+			.WriteBuffer( 5, &sceneInfo )
+			.Overwrite( frame.cullDescriptorSet );
+
+		AxeDescriptorWriter( instanceSetLayout, *descriptorPool )
+			.WriteBuffer( 0, &instanceInfo )
+			.WriteBuffer( 1, &sceneInfo )
+			.Overwrite( frame.instanceDescriptorSet );
+
+		frame.sceneGeneration = sceneBuffer.GetGeneration();
+	}
+
+	void AxeGpuCuller::Cull(
+		VkCommandBuffer commandBuffer,
+		const int frameIndex,
+		const std::span<const Object> objects,
+		const std::span<const Draw> draws,
+		const uint32_t batchCount,
+		const std::array<glm::vec4, 6>& frustumPlanes )
+	{
+		FrameResources& frame = frames[ frameIndex ];
+
+		// The frame's fence has been waited on, so the counts are the ones of the last frame with this index
+		if ( frame.hasResults )
+		{
+			if ( frame.countBuffer->Invalidate() != VK_SUCCESS )
+			{
+				throw std::runtime_error( "Error invalidating culling count buffer" );
+			}
+
+			visibleObjectCount = *static_cast<const uint32_t*>(frame.countBuffer->GetMappedMemory());
+		}
+
+		frame.hasResults = false;
+		if ( objects.empty() )
+		{
+			return;
+		}
+
+		Reserve( frame, objects.size(), draws.size(), batchCount );
+
+		// The scene buffer was replaced by a larger one since the frame last culled
+		if ( frame.sceneGeneration != sceneBuffer.GetGeneration() )
+		{
+			WriteDescriptorSets( frame );
+		}
+
+		frame.objectBuffer->WriteToBuffer( objects.data(), objects.size_bytes() );
+		frame.drawBuffer->WriteToBuffer( draws.data(), draws.size_bytes() );
+
+		if ( frame.objectBuffer->Flush() != VK_SUCCESS || frame.drawBuffer->Flush() != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Error flushing culling buffers to GPU" );
+		}
+
+		vkCmdFillBuffer( commandBuffer, frame.countBuffer->GetBufferHandle(), 0, ( 1 + batchCount ) * sizeof( uint32_t ), 0 );
+		RecordBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT );
+
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.cullDescriptorSet, 0, nullptr );
+
+		PushConstants push = {};
+		push.frustumPlanes = frustumPlanes;
+		push.objectCount = static_cast<uint32_t>(objects.size());
+		push.drawCount = static_cast<uint32_t>(draws.size());
+		vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( PushConstants ), &push );
+
+		cullPipeline->Bind( commandBuffer );
+		vkCmdDispatch( commandBuffer, ( push.objectCount + WORKGROUP_SIZE - 1 ) / WORKGROUP_SIZE, 1, 1 );
+
+		// Compaction reads the instance counts culling added up
+		RecordBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT );
+
+		compactPipeline->Bind( commandBuffer );
+		vkCmdDispatch( commandBuffer, ( push.drawCount + WORKGROUP_SIZE - 1 ) / WORKGROUP_SIZE, 1, 1 );
+
+		RecordBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT );
+
+		frame.hasResults = true;
+	}
+
+	void AxeGpuCuller::DrawBatch(
+		VkCommandBuffer commandBuffer,
+		const int frameIndex,
+		const uint32_t batch,
+		const uint32_t firstDraw,
+		const uint32_t drawCount ) const
+	{
+		const FrameResources& frame = frames[ frameIndex ];
+
+		vkCmdDrawIndexedIndirectCount(
+			commandBuffer,
+			frame.indirectBuffer->GetBufferHandle(),
+			firstDraw * sizeof( VkDrawIndexedIndirectCommand ),
+			frame.countBuffer->GetBufferHandle(),
+			( 1 + batch ) * sizeof( uint32_t ),
+			drawCount,
+			sizeof( VkDrawIndexedIndirectCommand ) );
+	}
+}
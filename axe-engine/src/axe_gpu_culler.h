@@ -0,0 +1,116 @@
+#pragma once
+
+#include "axe_buffer.h"
+#include "axe_descriptors.h"
+#include "axe_device.h"
+#include "axe_pipeline.h"
+#include "axe_scene_buffer.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Frustum culls objects on the GPU and turns the visible ones into compacted indirect draws, so the CPU records one
+	// vkCmdDrawIndexedIndirectCount per batch of draws that share a pipeline and geometry binding instead of a draw per object.
+	// A first compute pass tests the objects' bounds from the scene buffer and appends the slots of the visible ones to the instances of their draw,
+	// a second one drops the draws
+	// that ended up without instances and packs the rest of each batch together, writing the batch's draw count for the indirect draw
+	class AxeGpuCuller
+	{
+	public:
+		static constexpr uint32_t WORKGROUP_SIZE = 64;	// local_size_x of the culling shaders
+		// The buffers start out with room for this many objects and draws and double whenever they run out
+		static constexpr uint32_t INITIAL_CAPACITY = 256;
+
+		// Matches Object in the culling shaders
+		struct Object
+		{
+			uint32_t slot = 0;	// In the scene buffer
+			uint32_t drawIndex = 0;
+		};
+
+		// A level of detail of a model, matches Draw in the culling shaders.
+		// The draws of a batch are consecutive and the instances of a draw start at its command's firstInstance, with room for every object
+		// that uses it
+		struct Draw
+		{
+			VkDrawIndexedIndirectCommand command = {};	// instanceCount has to be 0, culling counts the visible instances into it
+			uint32_t batch = 0;
+			uint32_t batchFirstDraw = 0;	// Where the batch's compacted commands start
+		};
+
+		AxeGpuCuller( AxeDevice& device, AxeDescriptorSetLayout& instanceSetLayout, const AxeSceneBuffer& sceneBuffer );
+		~AxeGpuCuller();
+
+		AxeGpuCuller( const AxeGpuCuller& ) = delete;
+		AxeGpuCuller& operator=( const AxeGpuCuller& ) = delete;
+		AxeGpuCuller( const AxeGpuCuller&& ) = delete;
+		AxeGpuCuller& operator=( const AxeGpuCuller&& ) = delete;
+
+		// Uploads the frame's objects and draws and records both culling passes, outside of a render pass and after the scene buffer's update.
+		// Barriers make the results visible to indirect draws and vertex shaders that come after it
+		void Cull(
+			VkCommandBuffer commandBuffer,
+			int frameIndex,
+			std::span<const Object> objects,
+			std::span<const Draw> draws,
+			uint32_t batchCount,
+			const std::array<glm::vec4, 6>& frustumPlanes );
+
+		// Draws the surviving draws of a batch, its geometry and a pipeline using the instance set have to be bound
+		void DrawBatch( VkCommandBuffer commandBuffer, int frameIndex, uint32_t batch, uint32_t firstDraw, uint32_t drawCount ) const;
+
+		// Points the instance set layout's bindings at the instances culling writes and at the scene buffer
+		[[nodiscard]] VkDescriptorSet GetInstanceDescriptorSet( const int frameIndex ) const { return frames[ frameIndex ].instanceDescriptorSet; }
+
+		// Read back from the last frame that used the same frame index, so it lags behind by the frames in flight
+		[[nodiscard]] uint32_t GetVisibleObjectCount() const { return visibleObjectCount; }
+
+	private:
+		struct PushConstants
+		{
+			std::array<glm::vec4, 6> frustumPlanes = {};
+			uint32_t objectCount = 0;
+			uint32_t drawCount = 0;
+		};
+
+		// One per frame in flight, a frame only rewrites its buffers once the GPU is done with them
+		struct FrameResources
+		{
+			std::unique_ptr<AxeBuffer> objectBuffer = {};
+			std::unique_ptr<AxeBuffer> drawBuffer = {};
+			std::unique_ptr<AxeBuffer> indirectBuffer = {};	// The compacted commands
+			std::unique_ptr<AxeBuffer> countBuffer = {};	// The visible object count followed by the draw count of each batch
+			std::unique_ptr<AxeBuffer> instanceBuffer = {};
+			VkDescriptorSet cullDescriptorSet = VK_NULL_HANDLE;
+			VkDescriptorSet instanceDescriptorSet = VK_NULL_HANDLE;
+			uint32_t sceneGeneration = 0;	// Of the scene buffer the descriptor sets point at
+			bool hasResults = false;	// Whether the count buffer holds the results of an earlier frame
+		};
+
+		AxeDevice& axeDevice;
+		AxeDescriptorSetLayout& instanceSetLayout;
+		const AxeSceneBuffer& sceneBuffer;
+
+		std::unique_ptr<AxeDescriptorSetLayout> cullSetLayout = {};
+		std::unique_ptr<AxeDescriptorPool> descriptorPool = {};
+		VkPipelineLayout pipelineLayout = {};
+		std::unique_ptr<AxePipeline> cullPipeline = {};
+		std::unique_ptr<AxePipeline> compactPipeline = {};
+
+		std::vector<FrameResources> frames = {};
+		uint32_t visibleObjectCount = 0;
+
+		void CreatePipelines();
+		void CreateFrameResources();
+		// Replaces the frame's buffers that are too small with ones twice as large until everything fits, then points the descriptor sets at them
+		void Reserve( FrameResources& frame, size_t objectCount, size_t drawCount, size_t batchCount ) const;
+		void WriteDescriptorSets( FrameResources& frame ) const;
+	};
+}
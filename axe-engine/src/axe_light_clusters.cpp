@@ -0,0 +1,158 @@
+#include "axe_light_clusters.h"
+
+#include "axe_swap_chain.h"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <ranges>
+#include <stdexcept>
+
+namespace Axe
+{
+	static_assert( sizeof( AxeLightClusters::PointLight ) == 32, "Lights are read by the fragment shader with std430 layout" );
+	static_assert( sizeof( AxeLightClusters::ClusterHeader ) == 32, "The clusters follow the header at an 8 byte aligned offset" );
+
+	static std::unique_ptr<AxeBuffer> CreateStorageBuffer( AxeDevice& device, const VkDeviceSize instanceSize, const uint32_t instanceCount )
+	{
+		auto buffer = std::make_unique<AxeBuffer>(
+			device,
+			instanceSize,
+			instanceCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+
+		return buffer;
+	}
+
+	static void FlushBuffer( const AxeBuffer& buffer )
+	{
+		if ( buffer.Flush() != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Error flushing light buffer to GPU" );
+		}
+	}
+
+	AxeLightClusters::AxeLightClusters( AxeDevice& device )
+		: axeDevice{ device }
+	{
+		lightSetLayout = AxeDescriptorSetLayout::Builder( axeDevice )
+		                 .AddBinding( 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT )	// Lights
+		                 .AddBinding( 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT )	// Clusters
+		                 .AddBinding( 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT )	// Light indices
+		                 .Build();
+
+		lightPool = AxeDescriptorPool::Builder( axeDevice )
+		            .SetMaxSets( AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		            .AddPoolSize( VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		            .Build();
+
+		frames.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		for ( Frame& frame : frames )
+		{
+			frame.lightBuffer = CreateStorageBuffer( axeDevice, sizeof( PointLight ), INITIAL_LIGHT_CAPACITY );
+			frame.clusterBuffer = CreateStorageBuffer(
+				axeDevice,
+				sizeof( ClusterHeader ) + AxeLightGrid::CLUSTER_COUNT * sizeof( AxeLightGrid::Cluster ),
+				1 );
+			frame.indexBuffer = CreateStorageBuffer( axeDevice, sizeof( uint32_t ), INITIAL_INDEX_CAPACITY );
+
+			auto lightInfo = frame.lightBuffer->DescriptorInfo();
+			auto clusterInfo = frame.clusterBuffer->DescriptorInfo();
+			auto indexInfo = frame.indexBuffer->DescriptorInfo();
+			AxeDescriptorWriter( *lightSetLayout, *lightPool )
+				.WriteBuffer( 0, &lightInfo )
+				.WriteBuffer( 1, &clusterInfo )
+				.WriteBuffer( 2, &indexInfo )
+				.Build( frame.descriptorSet );
+		}
+	}
+
+	float AxeLightClusters::GetLightRange( const float intensity, const glm::vec3& color )
+	{
+		// The shader's attenuation is intensity * color / distance^2
+		const float brightest = intensity * std::max( { color.r, color.g, color.b } );
+
+		return std::sqrt( std::max( brightest, 0.0f ) / LIGHT_CUTOFF );
+	}
+
+	bool AxeLightClusters::ReserveBuffer( std::unique_ptr<AxeBuffer>& buffer, const size_t count )
+	{
+		if ( count <= buffer->GetInstanceCount() )
+		{
+			return false;
+		}
+
+		uint32_t capacity = buffer->GetInstanceCount();
+		while ( capacity < count )
+		{
+			capacity *= 2;
+		}
+
+		// The frame's fence has been waited on, so neither the old buffer nor the descriptor set pointing at it is in use anymore
+		buffer = CreateStorageBuffer( axeDevice, buffer->GetInstanceSize(), capacity );
+
+		return true;
+	}
+
+	void AxeLightClusters::Update( const int frameIndex, const AxeCamera& camera, const AxeGameObject::Map& gameObjects )
+	{
+		lights.clear();
+		lightSpheres.clear();
+		for ( const AxeGameObject& gameObject : gameObjects | std::views::values )
+		{
+			if ( gameObject.pointLight == nullptr )
+			{
+				continue;
+			}
+
+			const float range = GetLightRange( gameObject.pointLight->lightIntensity, gameObject.color );
+			lights.push_back( { glm::vec4{ gameObject.transform.translation, range }, glm::vec4{ gameObject.color, gameObject.pointLight->lightIntensity } } );
+			lightSpheres.emplace_back( gameObject.transform.translation, range );
+		}
+
+		lightGrid.Assign( lightSpheres, camera.GetView(), camera.GetProjection(), camera.GetNear(), camera.GetFar() );
+
+		Frame& frame = frames[ frameIndex ];
+		const std::vector<uint32_t>& lightIndices = lightGrid.GetLightIndices();
+
+		bool replaced = ReserveBuffer( frame.lightBuffer, lights.size() );
+		replaced |= ReserveBuffer( frame.indexBuffer, lightIndices.size() );
+		if ( replaced )
+		{
+			auto lightInfo = frame.lightBuffer->DescriptorInfo();
+			auto clusterInfo = frame.clusterBuffer->DescriptorInfo();
+			auto indexInfo = frame.indexBuffer->DescriptorInfo();
+			AxeDescriptorWriter( *lightSetLayout, *lightPool )
+				.WriteBuffer( 0, &lightInfo )
+				.WriteBuffer( 1, &clusterInfo )
+				.WriteBuffer( 2, &indexInfo )
+				.Overwrite( frame.descriptorSet );
+			generation++;
+		}
+
+		if ( !lights.empty() )
+		{
+			frame.lightBuffer->WriteToBuffer( lights.data(), lights.size() * sizeof( PointLight ) );
+			FlushBuffer( *frame.lightBuffer );
+		}
+
+		ClusterHeader header = {};
+		header.gridSize = { AxeLightGrid::TILE_COUNT_X, AxeLightGrid::TILE_COUNT_Y, AxeLightGrid::SLICE_COUNT, static_cast<uint32_t>(lights.size()) };
+		header.depthParameters = { lightGrid.GetDepthScale(), lightGrid.GetDepthBias(), 0.0f, 0.0f };
+		frame.clusterBuffer->WriteToBuffer( &header, sizeof( ClusterHeader ) );
+		frame.clusterBuffer->WriteToBuffer(
+			lightGrid.GetClusters().data(),
+			lightGrid.GetClusters().size() * sizeof( AxeLightGrid::Cluster ),
+			sizeof( ClusterHeader ) );
+		FlushBuffer( *frame.clusterBuffer );
+
+		if ( !lightIndices.empty() )
+		{
+			frame.indexBuffer->WriteToBuffer( lightIndices.data(), lightIndices.size() * sizeof( uint32_t ) );
+			FlushBuffer( *frame.indexBuffer );
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "axe_buffer.h"
+#include "axe_camera.h"
+#include "axe_descriptors.h"
+#include "axe_device.h"
+#include "axe_game_object.h"
+#include "axe_light_grid.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Axe
+{
+	// Keeps the frame's point lights and their assignment to the clusters of an AxeLightGrid in per-frame storage buffers, read by the simple
+	// fragment shader through the descriptor set handed out here. Lights can be as many as fit in memory, a fragment only goes through the
+	// lights of its cluster
+	class AxeLightClusters
+	{
+	public:
+		// The buffers start out with room for this many lights and light indices and double whenever they run out
+		static constexpr uint32_t INITIAL_LIGHT_CAPACITY = 256;
+		static constexpr uint32_t INITIAL_INDEX_CAPACITY = 4096;
+		// A light's range ends where it would light a surface facing it less than this, the shader fades it out towards there
+		static constexpr float LIGHT_CUTOFF = 0.01f;
+
+		// Matches PointLight in the simple fragment shader
+		struct PointLight
+		{
+			glm::vec4 position = {};	// w is the range
+			glm::vec4 color = {};	// w is intensity
+		};
+
+		// Matches the start of the clusters buffer in the simple fragment shader, followed by AxeLightGrid::CLUSTER_COUNT clusters
+		struct ClusterHeader
+		{
+			glm::uvec4 gridSize = {};	// w is the light count
+			glm::vec4 depthParameters = {};	// The grid's depth scale and bias
+		};
+
+		explicit AxeLightClusters( AxeDevice& device );
+
+		AxeLightClusters( const AxeLightClusters& ) = delete;
+		AxeLightClusters& operator=( const AxeLightClusters& ) = delete;
+		AxeLightClusters( const AxeLightClusters&& ) = delete;
+		AxeLightClusters& operator=( const AxeLightClusters&& ) = delete;
+
+		// Distance at which a light of the given intensity and color falls to LIGHT_CUTOFF
+		[[nodiscard]] static float GetLightRange( float intensity, const glm::vec3& color );
+
+		// Collects the game objects' point lights, assigns them to the clusters of the camera's view and writes both to the frame's buffers.
+		// The camera has to have a perspective projection
+		void Update( int frameIndex, const AxeCamera& camera, const AxeGameObject::Map& gameObjects );
+
+		[[nodiscard]] VkDescriptorSetLayout GetDescriptorSetLayout() const { return lightSetLayout->GetDescriptorSetLayout(); }
+		[[nodiscard]] VkDescriptorSet GetDescriptorSet( const int frameIndex ) const { return frames[ frameIndex ].descriptorSet; }
+		// Changes whenever a frame's buffer is replaced by a larger one, command buffers that bound its descriptor set have to be recorded again
+		[[nodiscard]] uint32_t GetGeneration() const { return generation; }
+
+		// What the last Update call assigned
+		[[nodiscard]] const AxeLightGrid::Statistics& GetStatistics() const { return lightGrid.GetStatistics(); }
+
+	private:
+		struct Frame
+		{
+			std::unique_ptr<AxeBuffer> lightBuffer = {};
+			std::unique_ptr<AxeBuffer> clusterBuffer = {};
+			std::unique_ptr<AxeBuffer> indexBuffer = {};
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+		AxeDevice& axeDevice;
+
+		std::unique_ptr<AxeDescriptorSetLayout> lightSetLayout = {};
+		std::unique_ptr<AxeDescriptorPool> lightPool = {};
+		std::vector<Frame> frames = {};	// One per frame in flight, a frame only rewrites its buffers once the GPU is done with them
+		uint32_t generation = 0;
+
+		AxeLightGrid lightGrid = {};
+		// Reused between updates
+		std::vector<PointLight> lights = {};
+		std::vector<glm::vec4> lightSpheres = {};
+
+		// Replaces the buffer with one twice as large until the count fits, returns whether it did
+		bool ReserveBuffer( std::unique_ptr<AxeBuffer>& buffer, size_t count );
+	};
+}
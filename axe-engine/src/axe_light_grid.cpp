@@ -0,0 +1,211 @@
+#include "axe_light_grid.h"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+
+namespace Axe
+{
+	static uint32_t ToTile( const float ndc, const uint32_t tileCount )
+	{
+		const float tile = std::floor( ( ndc * 0.5f + 0.5f ) * static_cast<float>(tileCount) );
+
+		return static_cast<uint32_t>(std::clamp( tile, 0.0f, static_cast<float>(tileCount - 1) ));
+	}
+
+	uint32_t AxeLightGrid::FindSlice( const float depth ) const
+	{
+		const float slice = std::floor( std::log( depth ) * depthScale + depthBias );
+
+		return static_cast<uint32_t>(std::clamp( slice, 0.0f, static_cast<float>(SLICE_COUNT - 1) ));
+	}
+
+	bool AxeLightGrid::FindTileRange( const VisibleLight& light, const float minDepth, const float maxDepth, TileRange& range ) const
+	{
+		// x / z of the box's corners, the projection scales and offsets it into NDC. Both depths are past the near plane, so the extremes are at corners
+		const float minX = light.center.x - light.radius;
+		const float maxX = light.center.x + light.radius;
+		const float minY = light.center.y - light.radius;
+		const float maxY = light.center.y + light.radius;
+
+		const std::array<float, 4> projectedX = { minX / minDepth, minX / maxDepth, maxX / minDepth, maxX / maxDepth };
+		const std::array<float, 4> projectedY = { minY / minDepth, minY / maxDepth, maxY / minDepth, maxY / maxDepth };
+
+		float minNdcX = projectionMatrix[ 0 ][ 0 ] * projectedX[ 0 ];
+		float maxNdcX = minNdcX;
+		float minNdcY = projectionMatrix[ 1 ][ 1 ] * projectedY[ 0 ];
+		float maxNdcY = minNdcY;
+		for ( size_t i = 1; i < 4; i++ )
+		{
+			minNdcX = std::min( minNdcX, projectionMatrix[ 0 ][ 0 ] * projectedX[ i ] );
+			maxNdcX = std::max( maxNdcX, projectionMatrix[ 0 ][ 0 ] * projectedX[ i ] );
+			minNdcY = std::min( minNdcY, projectionMatrix[ 1 ][ 1 ] * projectedY[ i ] );
+			maxNdcY = std::max( maxNdcY, projectionMatrix[ 1 ][ 1 ] * projectedY[ i ] );
+		}
+		minNdcX += projectionMatrix[ 2 ][ 0 ];
+		maxNdcX += projectionMatrix[ 2 ][ 0 ];
+		minNdcY += projectionMatrix[ 2 ][ 1 ];
+		maxNdcY += projectionMatrix[ 2 ][ 1 ];
+
+		if ( maxNdcX < -1.0f || minNdcX > 1.0f || maxNdcY < -1.0f || minNdcY > 1.0f )
+		{
+			return false;
+		}
+
+		range.minX = ToTile( minNdcX, TILE_COUNT_X );
+		range.maxX = ToTile( maxNdcX, TILE_COUNT_X );
+		range.minY = ToTile( minNdcY, TILE_COUNT_Y );
+		range.maxY = ToTile( maxNdcY, TILE_COUNT_Y );
+
+		return true;
+	}
+
+	void AxeLightGrid::Assign(
+		const std::vector<glm::vec4>& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const float near,
+		const float far,
+		AxeThreadPool& threadPool )
+	{
+		projectionMatrix = projection;
+		nearPlane = near;
+		farPlane = far;
+		depthScale = static_cast<float>(SLICE_COUNT) / std::log( far / near );
+		depthBias = -std::log( near ) * depthScale;
+		for ( uint32_t slice = 0; slice <= SLICE_COUNT; slice++ )
+		{
+			sliceDepths[ slice ] = near * std::pow( far / near, static_cast<float>(slice) / static_cast<float>(SLICE_COUNT) );
+		}
+
+		statistics = {};
+		statistics.lightCount = static_cast<uint32_t>(lights.size());
+
+		// Finding the slices a light reaches is cheap enough to not be worth spreading over the workers
+		visibleLights.clear();
+		for ( uint32_t i = 0; i < lights.size(); i++ )
+		{
+			const glm::vec3 center{ view * glm::vec4{ glm::vec3{ lights[ i ] }, 1.0f } };
+			const float radius = lights[ i ].w;
+			if ( center.z + radius < near || center.z - radius > far )
+			{
+				continue;
+			}
+
+			visibleLights.push_back(
+				{ center, radius, i, FindSlice( std::max( center.z - radius, near ) ), FindSlice( std::min( center.z + radius, far ) ) } );
+		}
+
+		threadPool.ParallelFor( SLICE_COUNT, [this]( const uint32_t slice ) { AssignSlice( slice ); } );
+
+		// The slices' runs go one after the other, in slice order
+		uint32_t indexCount = 0;
+		for ( const SliceScratch& scratch : slices )
+		{
+			indexCount += static_cast<uint32_t>(scratch.indices.size());
+		}
+		lightIndices.resize( indexCount );
+
+		assignedLights.assign( lights.size(), 0 );
+
+		uint32_t sliceOffset = 0;
+		for ( uint32_t slice = 0; slice < SLICE_COUNT; slice++ )
+		{
+			const SliceScratch& scratch = slices[ slice ];
+			for ( const TileRange& range : scratch.tileRanges )
+			{
+				assignedLights[ range.light ] = 1;
+			}
+
+			const uint32_t firstCluster = GetClusterIndex( 0, 0, slice );
+			for ( uint32_t tile = 0; tile < TILE_COUNT_X * TILE_COUNT_Y; tile++ )
+			{
+				clusters[ firstCluster + tile ] = { sliceOffset + scratch.offsets[ tile ], scratch.counts[ tile ] };
+			}
+
+			std::ranges::copy( scratch.indices, lightIndices.begin() + sliceOffset );
+			sliceOffset += static_cast<uint32_t>(scratch.indices.size());
+
+			statistics.maxClusterLightCount = std::max( statistics.maxClusterLightCount, scratch.maxCount );
+		}
+
+		statistics.visibleLightCount = static_cast<uint32_t>(std::ranges::count( assignedLights, 1 ));
+		statistics.indexCount = indexCount;
+	}
+
+	void AxeLightGrid::AssignSlice( const uint32_t slice )
+	{
+		SliceScratch& scratch = slices[ slice ];
+		scratch.tileRanges.clear();
+		scratch.counts.assign( TILE_COUNT_X * TILE_COUNT_Y, 0 );
+		scratch.offsets.resize( TILE_COUNT_X * TILE_COUNT_Y );
+		scratch.maxCount = 0;
+
+		for ( const VisibleLight& light : visibleLights )
+		{
+			if ( slice < light.firstSlice || slice > light.lastSlice )
+			{
+				continue;
+			}
+
+			// Only the part of the light's depth range inside the slice, the bounds are tighter the thinner it gets
+			const float minDepth = std::max( sliceDepths[ slice ], light.center.z - light.radius );
+			const float maxDepth = std::max( std::min( sliceDepths[ slice + 1 ], light.center.z + light.radius ), minDepth );
+
+			TileRange range = {};
+			range.light = light.index;
+			if ( !FindTileRange( light, minDepth, maxDepth, range ) )
+			{
+				continue;
+			}
+
+			for ( uint32_t y = range.minY; y <= range.maxY; y++ )
+			{
+				for ( uint32_t x = range.minX; x <= range.maxX; x++ )
+				{
+					scratch.counts[ y * TILE_COUNT_X + x ]++;
+				}
+			}
+			scratch.tileRanges.push_back( range );
+		}
+
+		// Counting first lets every tile's run be written in place, in the order the lights were given
+		uint32_t offset = 0;
+		for ( uint32_t tile = 0; tile < TILE_COUNT_X * TILE_COUNT_Y; tile++ )
+		{
+			scratch.offsets[ tile ] = offset;
+			offset += scratch.counts[ tile ];
+			scratch.maxCount = std::max( scratch.maxCount, scratch.counts[ tile ] );
+		}
+		scratch.indices.resize( offset );
+
+		// The counts are counted up again while filling, ending up where they were
+		std::ranges::fill( scratch.counts, 0 );
+		for ( const TileRange& range : scratch.tileRanges )
+		{
+			for ( uint32_t y = range.minY; y <= range.maxY; y++ )
+			{
+				for ( uint32_t x = range.minX; x <= range.maxX; x++ )
+				{
+					const uint32_t tile = y * TILE_COUNT_X + x;
+					scratch.indices[ scratch.offsets[ tile ] + scratch.counts[ tile ]++ ] = range.light;
+				}
+			}
+		}
+	}
+
+	uint32_t AxeLightGrid::FindCluster( const glm::vec3& viewPosition ) const
+	{
+		if ( viewPosition.z < nearPlane || viewPosition.z > farPlane )
+		{
+			return UINT32_MAX;
+		}
+
+		const glm::vec4 clip = projectionMatrix * glm::vec4{ viewPosition, 1.0f };
+
+		return GetClusterIndex(
+			ToTile( clip.x / clip.w, TILE_COUNT_X ),
+			ToTile( clip.y / clip.w, TILE_COUNT_Y ),
+			FindSlice( viewPosition.z ) );
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "axe_thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Axe
+{
+	// Divides the view frustum into clusters, screen space tiles split into depth slices spaced exponentially between the near and far plane,
+	// and finds the point lights whose range overlaps each of them, so a fragment is only lit by the lights of its cluster instead of all of them.
+	// The slices are assigned in parallel, each one walks the lights reaching into it and adds them to the tiles their bounds cover at that depth.
+	// The assignment is conservative, a cluster may list a light that doesn't reach it but never misses one that does
+	class AxeLightGrid
+	{
+	public:
+		static constexpr uint32_t TILE_COUNT_X = 16;
+		static constexpr uint32_t TILE_COUNT_Y = 9;
+		static constexpr uint32_t SLICE_COUNT = 24;
+		static constexpr uint32_t CLUSTER_COUNT = TILE_COUNT_X * TILE_COUNT_Y * SLICE_COUNT;
+
+		// Matches the clusters in the simple fragment shader, a run of the light index list
+		struct Cluster
+		{
+			uint32_t offset = 0;
+			uint32_t count = 0;
+
+			bool operator==( const Cluster& ) const = default;
+		};
+
+		struct Statistics
+		{
+			uint32_t lightCount = 0;
+			uint32_t visibleLightCount = 0;	// Assigned to at least one cluster
+			uint32_t indexCount = 0;
+			uint32_t maxClusterLightCount = 0;
+		};
+
+		// Clusters are ordered by slice, then row, then column
+		[[nodiscard]] static uint32_t GetClusterIndex( const uint32_t x, const uint32_t y, const uint32_t slice )
+		{
+			return ( slice * TILE_COUNT_Y + y ) * TILE_COUNT_X + x;
+		}
+
+		// Lights are world space spheres whose radius is the light's range. The projection has to be a perspective one looking down +Z,
+		// with the near and far plane it was made with
+		void Assign(
+			const std::vector<glm::vec4>& lights,
+			const glm::mat4& view,
+			const glm::mat4& projection,
+			float near,
+			float far,
+			AxeThreadPool& threadPool = AxeThreadPool::Shared() );
+
+		// The cluster a view space position falls into, found the same way the fragment shader does, or UINT32_MAX in front of the near plane
+		// or behind the far plane
+		[[nodiscard]] uint32_t FindCluster( const glm::vec3& viewPosition ) const;
+
+		// A position's slice is floor( log( depth ) * scale + bias )
+		[[nodiscard]] float GetDepthScale() const { return depthScale; }
+		[[nodiscard]] float GetDepthBias() const { return depthBias; }
+
+		// What the last Assign call found, the light indices of a cluster's run refer to the lights it was given
+		[[nodiscard]] const std::vector<Cluster>& GetClusters() const { return clusters; }
+		[[nodiscard]] const std::vector<uint32_t>& GetLightIndices() const { return lightIndices; }
+		[[nodiscard]] const Statistics& GetStatistics() const { return statistics; }
+
+	private:
+		// A light reaching into the grid, in view space
+		struct VisibleLight
+		{
+			glm::vec3 center = {};
+			float radius = 0.0f;
+			uint32_t index = 0;
+			uint32_t firstSlice = 0;
+			uint32_t lastSlice = 0;
+		};
+
+		// The tiles a light covers in one slice, inclusive
+		struct TileRange
+		{
+			uint32_t light = 0;
+			uint32_t minX = 0;
+			uint32_t maxX = 0;
+			uint32_t minY = 0;
+			uint32_t maxY = 0;
+		};
+
+		// Built by one worker for its slice, reused between frames
+		struct SliceScratch
+		{
+			std::vector<TileRange> tileRanges = {};
+			std::vector<uint32_t> counts = {};
+			std::vector<uint32_t> offsets = {};
+			std::vector<uint32_t> indices = {};
+			uint32_t maxCount = 0;
+		};
+
+		glm::mat4 projectionMatrix{ 1.0f };
+		float nearPlane = 0.0f;
+		float farPlane = 1.0f;
+		float depthScale = 0.0f;
+		float depthBias = 0.0f;
+		std::array<float, SLICE_COUNT + 1> sliceDepths = {};	// Where each slice starts, the last one is the far plane
+
+		std::vector<VisibleLight> visibleLights = {};	// Reaching into the grid's depth range, they may still be off screen
+		std::vector<uint8_t> assignedLights = {};	// Whether each light ended up in a cluster
+		std::array<SliceScratch, SLICE_COUNT> slices = {};
+
+		std::vector<Cluster> clusters = std::vector<Cluster>( CLUSTER_COUNT );
+		std::vector<uint32_t> lightIndices = {};
+		Statistics statistics = {};
+
+		[[nodiscard]] uint32_t FindSlice( float depth ) const;
+		// Finds the tiles covered by the light's view space bounding box clipped to the depth range, false if it's off screen
+		[[nodiscard]] bool FindTileRange( const VisibleLight& light, float minDepth, float maxDepth, TileRange& range ) const;
+		void AssignSlice( uint32_t slice );
+	};
+}
@@ -0,0 +1,169 @@
+#include "axe_mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Axe
+{
+#ifdef _WIN32
+	AxeMappedFile::AxeMappedFile( const std::string& filePath )
+	{
+		fileHandle = CreateFileA(
+			filePath.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr );
+
+		if ( fileHandle == INVALID_HANDLE_VALUE )
+		{
+			fileHandle = nullptr;
+			throw std::runtime_error( "Failed to open file for mapping: " + filePath );
+		}
+
+		LARGE_INTEGER fileSize;
+		if ( !GetFileSizeEx( fileHandle, &fileSize ) )
+		{
+			Close();
+			throw std::runtime_error( "Failed to get size of file: " + filePath );
+		}
+
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		// Empty files can't be mapped, they simply have no data
+		if ( size == 0 )
+		{
+			return;
+		}
+
+		mappingHandle = CreateFileMappingA( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( mappingHandle == nullptr )
+		{
+			Close();
+			throw std::runtime_error( "Failed to create file mapping: " + filePath );
+		}
+
+		data = static_cast<const std::byte*>(MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ));
+		if ( data == nullptr )
+		{
+			Close();
+			throw std::runtime_error( "Failed to map view of file: " + filePath );
+		}
+	}
+
+	void AxeMappedFile::Close()
+	{
+		if ( data != nullptr )
+		{
+			UnmapViewOfFile( data );
+		}
+
+		if ( mappingHandle != nullptr )
+		{
+			CloseHandle( mappingHandle );
+		}
+
+		if ( fileHandle != nullptr )
+		{
+			CloseHandle( fileHandle );
+		}
+
+		data = nullptr;
+		size = 0;
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+	}
+#else
+	AxeMappedFile::AxeMappedFile( const std::string& filePath )
+	{
+		fileDescriptor = open( filePath.c_str(), O_RDONLY );
+		if ( fileDescriptor < 0 )
+		{
+			throw std::runtime_error( "Failed to open file for mapping: " + filePath );
+		}
+
+		struct stat fileStatus = {};
+		if ( fstat( fileDescriptor, &fileStatus ) != 0 )
+		{
+			Close();
+			throw std::runtime_error( "Failed to get size of file: " + filePath );
+		}
+
+		size = static_cast<size_t>(fileStatus.st_size);
+
+		// Empty files can't be mapped, they simply have no data
+		if ( size == 0 )
+		{
+			return;
+		}
+
+		void* mapping = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+		if ( mapping == MAP_FAILED )
+		{
+			Close();
+			throw std::runtime_error( "Failed to map file: " + filePath );
+		}
+
+		data = static_cast<const std::byte*>(mapping);
+	}
+
+	void AxeMappedFile::Close()
+	{
+		if ( data != nullptr )
+		{
+			munmap( const_cast<std::byte*>(data), size );
+		}
+
+		if ( fileDescriptor >= 0 )
+		{
+			close( fileDescriptor );
+		}
+
+		data = nullptr;
+		size = 0;
+		fileDescriptor = -1;
+	}
+#endif
+
+	AxeMappedFile::~AxeMappedFile()
+	{
+		Close();
+	}
+
+	AxeMappedFile::AxeMappedFile( AxeMappedFile&& other ) noexcept
+	{
+		*this = std::move( other );
+	}
+
+	AxeMappedFile& AxeMappedFile::operator=( AxeMappedFile&& other ) noexcept
+	{
+		if ( this != &other )
+		{
+			Close();
+
+			data = std::exchange( other.data, nullptr );
+			size = std::exchange( other.size, 0 );
+#ifdef _WIN32
+			fileHandle = std::exchange( other.fileHandle, nullptr );
+			mappingHandle = std::exchange( other.mappingHandle, nullptr );
+#else
+			fileDescriptor = std::exchange( other.fileDescriptor, -1 );
+#endif
+		}
+
+		return *this;
+	}
+}
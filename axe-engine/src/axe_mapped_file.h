@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Axe
+{
+	// Read-only memory mapping of a whole file. The OS pages the contents in on demand,
+	// so nothing is copied until the data is actually touched.
+	class AxeMappedFile
+	{
+	public:
+		// Throws if the file can't be opened or mapped
+		explicit AxeMappedFile( const std::string& filePath );
+		~AxeMappedFile();
+
+		AxeMappedFile( const AxeMappedFile& ) = delete;
+		AxeMappedFile& operator=( const AxeMappedFile& ) = delete;
+		AxeMappedFile( AxeMappedFile&& other ) noexcept;
+		AxeMappedFile& operator=( AxeMappedFile&& other ) noexcept;
+
+		[[nodiscard]] const std::byte* Data() const { return data; }
+		[[nodiscard]] size_t Size() const { return size; }
+
+	private:
+		const std::byte* data = nullptr;
+		size_t size = 0;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+
+		void Close();
+	};
+}
@@ -0,0 +1,383 @@
+#include "axe_memory_allocator.h"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace Axe
+{
+	// One vkAllocateMemory call, sub-allocated with a TLSF allocator
+	struct AxeMemoryBlock
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		uint32_t memoryTypeIndex = 0;
+		AxeMemoryAllocator::ResourceTiling tiling = AxeMemoryAllocator::ResourceTiling::Linear;
+		AxeTlsfAllocator allocator;
+
+		AxeMemoryBlock( const VkDeviceSize size ) : allocator{ size } {}
+	};
+
+	static constexpr VkDeviceSize MEBIBYTE = 1024ull * 1024ull;
+	static constexpr VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 256 * MEBIBYTE;
+	static constexpr VkDeviceSize SMALL_HEAP_THRESHOLD = 1024 * MEBIBYTE;
+
+	static VkDeviceSize AlignUp( const VkDeviceSize value, const VkDeviceSize alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	AxeMemoryAllocator::AxeMemoryAllocator( const VkPhysicalDevice physicalDevice, const VkDevice device ) : device{ device }
+	{
+		vkGetPhysicalDeviceMemoryProperties( physicalDevice, &memoryProperties );
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties( physicalDevice, &properties );
+		nonCoherentAtomSize = std::max<VkDeviceSize>( properties.limits.nonCoherentAtomSize, 1 );
+		maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		for ( auto& tilingPools : pools )
+		{
+			tilingPools.resize( memoryProperties.memoryTypeCount );
+		}
+
+		dedicatedStatistics.resize( memoryProperties.memoryTypeCount );
+	}
+
+	AxeMemoryAllocator::~AxeMemoryAllocator()
+	{
+		for ( auto& tilingPools : pools )
+		{
+			for ( auto& pool : tilingPools )
+			{
+				for ( const auto& block : pool.blocks )
+				{
+					assert( block->allocator.IsEmpty() && "Device memory block still has live allocations on shutdown" );
+					vkFreeMemory( device, block->memory, nullptr );
+				}
+			}
+		}
+
+		for ( [[maybe_unused]] const auto& statistics : dedicatedStatistics )
+		{
+			assert( statistics.dedicatedAllocationCount == 0 && "Dedicated device memory allocation still alive on shutdown" );
+		}
+	}
+
+	AxeAllocation AxeMemoryAllocator::Allocate(
+		const VkMemoryRequirements& requirements, const uint32_t memoryTypeIndex, const ResourceTiling tiling )
+	{
+		std::scoped_lock lock{ mutex };
+
+		const VkDeviceSize blockSize = GetPreferredBlockSize( memoryTypeIndex );
+
+		// Big resources (e.g. large render targets) would waste most of a block, so give them their own memory
+		if ( requirements.size > blockSize / 2 )
+		{
+			return AllocateDedicated( requirements, memoryTypeIndex );
+		}
+
+		// Non-coherent memory is flushed in nonCoherentAtomSize chunks, so allocations mustn't share an atom with their neighbours
+		VkDeviceSize alignment = std::max<VkDeviceSize>( requirements.alignment, 1 );
+		VkDeviceSize size = requirements.size;
+		if ( IsHostVisible( memoryTypeIndex ) && !IsHostCoherent( memoryTypeIndex ) )
+		{
+			alignment = std::max( alignment, nonCoherentAtomSize );
+			size = AlignUp( size, nonCoherentAtomSize );
+		}
+
+		Pool& pool = pools[ static_cast<size_t>(tiling) ][ memoryTypeIndex ];
+
+		// ####################   Try to fit into an existing block   ####################
+
+		for ( const auto& block : pool.blocks )
+		{
+			const AxeTlsfAllocator::Allocation range = block->allocator.Allocate( size, alignment );
+			if ( !range.IsValid() )
+			{
+				continue;
+			}
+
+			AxeAllocation allocation = {};
+			allocation.memory = block->memory;
+			allocation.offset = range.offset;
+			allocation.size = range.size;
+			allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + range.offset : nullptr;
+			allocation.memoryTypeIndex = memoryTypeIndex;
+			allocation.block = block.get();
+			allocation.node = range.node;
+			return allocation;
+		}
+
+		// ####################   Create a new block   ####################
+
+		auto block = std::make_unique<AxeMemoryBlock>( blockSize );
+		block->memory = AllocateDeviceMemory( blockSize, memoryTypeIndex, &block->mapped );
+		block->memoryTypeIndex = memoryTypeIndex;
+		block->tiling = tiling;
+
+		const AxeTlsfAllocator::Allocation range = block->allocator.Allocate( size, alignment );
+		assert( range.IsValid() && "Fresh device memory block is too small for the allocation" );
+
+		AxeAllocation allocation = {};
+		allocation.memory = block->memory;
+		allocation.offset = range.offset;
+		allocation.size = range.size;
+		allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + range.offset : nullptr;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.block = block.get();
+		allocation.node = range.node;
+
+		pool.blocks.push_back( std::move( block ) );
+		return allocation;
+	}
+
+	void AxeMemoryAllocator::Free( AxeAllocation& allocation )
+	{
+		if ( !allocation.IsValid() )
+		{
+			return;
+		}
+
+		std::scoped_lock lock{ mutex };
+
+		if ( allocation.block == nullptr )
+		{
+			vkFreeMemory( device, allocation.memory, nullptr );
+
+			Statistics& statistics = dedicatedStatistics[ allocation.memoryTypeIndex ];
+			statistics.dedicatedAllocationCount--;
+			statistics.allocationCount--;
+			statistics.reservedBytes -= allocation.size;
+			statistics.usedBytes -= allocation.size;
+
+			allocation = {};
+			return;
+		}
+
+		AxeMemoryBlock* block = allocation.block;
+		block->allocator.Free( allocation.node );
+		allocation = {};
+
+		if ( !block->allocator.IsEmpty() )
+		{
+			return;
+		}
+
+		// Keep one empty block around per pool, so that a resource being recreated every frame doesn't cause a vkAllocateMemory every frame
+		Pool& pool = pools[ static_cast<size_t>(block->tiling) ][ block->memoryTypeIndex ];
+
+		const auto emptyBlockCount = std::ranges::count_if(
+			pool.blocks,
+			[]( const auto& poolBlock ) { return poolBlock->allocator.IsEmpty(); } );
+
+		if ( emptyBlockCount > 1 )
+		{
+			vkFreeMemory( device, block->memory, nullptr );
+			std::erase_if( pool.blocks, [block]( const auto& poolBlock ) { return poolBlock.get() == block; } );
+		}
+	}
+
+	VkResult AxeMemoryAllocator::Flush( const AxeAllocation& allocation, const VkDeviceSize size, const VkDeviceSize offset ) const
+	{
+		if ( IsHostCoherent( allocation.memoryTypeIndex ) )
+		{
+			return VK_SUCCESS;
+		}
+
+		const VkMappedMemoryRange mappedRange = GetMappedRange( allocation, size, offset );
+		return vkFlushMappedMemoryRanges( device, 1, &mappedRange );
+	}
+
+	VkResult AxeMemoryAllocator::Invalidate( const AxeAllocation& allocation, const VkDeviceSize size, const VkDeviceSize offset ) const
+	{
+		if ( IsHostCoherent( allocation.memoryTypeIndex ) )
+		{
+			return VK_SUCCESS;
+		}
+
+		const VkMappedMemoryRange mappedRange = GetMappedRange( allocation, size, offset );
+		return vkInvalidateMappedMemoryRanges( device, 1, &mappedRange );
+	}
+
+	AxeMemoryAllocator::Statistics AxeMemoryAllocator::GetStatistics() const
+	{
+		Statistics total = {};
+
+		for ( uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++ )
+		{
+			const Statistics statistics = GetStatistics( i );
+			total.blockCount += statistics.blockCount;
+			total.dedicatedAllocationCount += statistics.dedicatedAllocationCount;
+			total.allocationCount += statistics.allocationCount;
+			total.reservedBytes += statistics.reservedBytes;
+			total.usedBytes += statistics.usedBytes;
+		}
+
+		return total;
+	}
+
+	AxeMemoryAllocator::Statistics AxeMemoryAllocator::GetStatistics( const uint32_t memoryTypeIndex ) const
+	{
+		std::scoped_lock lock{ mutex };
+
+		Statistics statistics = dedicatedStatistics[ memoryTypeIndex ];
+
+		for ( const auto& tilingPools : pools )
+		{
+			for ( const auto& block : tilingPools[ memoryTypeIndex ].blocks )
+			{
+				statistics.blockCount++;
+				statistics.allocationCount += block->allocator.GetAllocationCount();
+				statistics.reservedBytes += block->allocator.GetSize();
+				statistics.usedBytes += block->allocator.GetUsedSize();
+			}
+		}
+
+		return statistics;
+	}
+
+	void AxeMemoryAllocator::PrintStatistics() const
+	{
+		std::cout << "Device memory:" << std::endl;
+
+		for ( uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++ )
+		{
+			const Statistics statistics = GetStatistics( i );
+			if ( statistics.DeviceMemoryObjectCount() == 0 )
+			{
+				continue;
+			}
+
+			std::cout << "\tType " << i
+				<< ": " << statistics.allocationCount << " allocations in "
+				<< statistics.blockCount << " blocks + "
+				<< statistics.dedicatedAllocationCount << " dedicated, "
+				<< statistics.usedBytes / 1024 << " / " << statistics.reservedBytes / 1024 << " KiB used" << std::endl;
+		}
+
+		const Statistics total = GetStatistics();
+		std::cout << "\tTotal: " << total.allocationCount << " allocations using "
+			<< total.DeviceMemoryObjectCount() << " / " << maxMemoryAllocationCount << " device memory objects\n" << std::endl;
+	}
+
+	VkDeviceSize AxeMemoryAllocator::GetPreferredBlockSize( const uint32_t memoryTypeIndex ) const
+	{
+		const uint32_t heapIndex = memoryProperties.memoryTypes[ memoryTypeIndex ].heapIndex;
+		const VkDeviceSize heapSize = memoryProperties.memoryHeaps[ heapIndex ].size;
+
+		// Small heaps (e.g. the 256 MiB BAR heap) would be used up by a couple of blocks
+		if ( heapSize <= SMALL_HEAP_THRESHOLD )
+		{
+			return AlignUp( std::max<VkDeviceSize>( heapSize / 8, MEBIBYTE ), MEBIBYTE );
+		}
+
+		return LARGE_HEAP_BLOCK_SIZE;
+	}
+
+	bool AxeMemoryAllocator::IsHostVisible( const uint32_t memoryTypeIndex ) const
+	{
+		return memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	}
+
+	bool AxeMemoryAllocator::IsHostCoherent( const uint32_t memoryTypeIndex ) const
+	{
+		return memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	uint32_t AxeMemoryAllocator::CountDeviceMemoryObjects() const
+	{
+		uint32_t count = 0;
+
+		for ( const auto& tilingPools : pools )
+		{
+			for ( const auto& pool : tilingPools )
+			{
+				count += static_cast<uint32_t>(pool.blocks.size());
+			}
+		}
+
+		for ( const auto& statistics : dedicatedStatistics )
+		{
+			count += statistics.dedicatedAllocationCount;
+		}
+
+		return count;
+	}
+
+	VkDeviceMemory AxeMemoryAllocator::AllocateDeviceMemory(
+		const VkDeviceSize size, const uint32_t memoryTypeIndex, void** mapped ) const
+	{
+		if ( CountDeviceMemoryObjects() >= maxMemoryAllocationCount )
+		{
+			throw std::runtime_error( "Exceeded maxMemoryAllocationCount" );
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		if ( vkAllocateMemory( device, &allocInfo, nullptr, &memory ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to allocate device memory" );
+		}
+
+		// Host visible memory stays mapped for its whole lifetime, mapping is too expensive to do per resource
+		*mapped = nullptr;
+		if ( IsHostVisible( memoryTypeIndex ) )
+		{
+			if ( vkMapMemory( device, memory, 0, VK_WHOLE_SIZE, 0, mapped ) != VK_SUCCESS )
+			{
+				vkFreeMemory( device, memory, nullptr );
+				throw std::runtime_error( "Failed to map device memory" );
+			}
+		}
+
+		return memory;
+	}
+
+	AxeAllocation AxeMemoryAllocator::AllocateDedicated( const VkMemoryRequirements& requirements, const uint32_t memoryTypeIndex )
+	{
+		const VkDeviceSize size = IsHostCoherent( memoryTypeIndex )
+			                          ? requirements.size
+			                          : AlignUp( requirements.size, nonCoherentAtomSize );
+
+		AxeAllocation allocation = {};
+		allocation.memory = AllocateDeviceMemory( size, memoryTypeIndex, &allocation.mapped );
+		allocation.offset = 0;
+		allocation.size = size;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+
+		Statistics& statistics = dedicatedStatistics[ memoryTypeIndex ];
+		statistics.dedicatedAllocationCount++;
+		statistics.allocationCount++;
+		statistics.reservedBytes += size;
+		statistics.usedBytes += size;
+
+		return allocation;
+	}
+
+	VkMappedMemoryRange AxeMemoryAllocator::GetMappedRange(
+		const AxeAllocation& allocation, const VkDeviceSize size, const VkDeviceSize offset ) const
+	{
+		assert( offset <= allocation.size && "Mapped range offset is outside of the allocation" );
+
+		// Allocations in non-coherent memory are atom aligned, so expanding the range never touches a neighbour
+		const VkDeviceSize begin = ( allocation.offset + offset ) / nonCoherentAtomSize * nonCoherentAtomSize;
+		const VkDeviceSize end = size == VK_WHOLE_SIZE
+			                         ? allocation.offset + allocation.size
+			                         : std::min( AlignUp( allocation.offset + offset + size, nonCoherentAtomSize ),
+			                                     allocation.offset + allocation.size );
+
+		VkMappedMemoryRange mappedRange = {};
+		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mappedRange.memory = allocation.memory;
+		mappedRange.offset = begin;
+		mappedRange.size = end - begin;
+		return mappedRange;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "axe_tlsf_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Axe
+{
+	struct AxeMemoryBlock;
+
+	// Handle to a range of device memory handed out by AxeMemoryAllocator.
+	// Resources are bound at (memory, offset), host visible allocations are persistently mapped.
+	struct AxeAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;	// Already offset to the start of the allocation, nullptr if the memory isn't host visible
+		uint32_t memoryTypeIndex = 0;
+
+		AxeMemoryBlock* block = nullptr;	// nullptr for dedicated allocations
+		uint32_t node = AxeTlsfAllocator::INVALID_NODE;
+
+		[[nodiscard]] bool IsValid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	// Sub-allocates resources from large per-memory-type blocks instead of calling vkAllocateMemory per resource,
+	// which keeps us far away from maxMemoryAllocationCount and makes resource creation a lot cheaper.
+	class AxeMemoryAllocator
+	{
+	public:
+		// Linear (buffers) and optimal (images) resources live in separate blocks, so we never have to care about bufferImageGranularity
+		enum class ResourceTiling
+		{
+			Linear,
+			Optimal
+		};
+
+		struct Statistics
+		{
+			uint32_t blockCount = 0;
+			uint32_t dedicatedAllocationCount = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize reservedBytes = 0;	// Total size of all device memory objects
+			VkDeviceSize usedBytes = 0;		// Part of the reserved memory that is handed out to resources
+
+			[[nodiscard]] uint32_t DeviceMemoryObjectCount() const { return blockCount + dedicatedAllocationCount; }
+		};
+
+		AxeMemoryAllocator( VkPhysicalDevice physicalDevice, VkDevice device );
+		~AxeMemoryAllocator();
+
+		AxeMemoryAllocator( const AxeMemoryAllocator& ) = delete;
+		AxeMemoryAllocator& operator=( const AxeMemoryAllocator& ) = delete;
+		AxeMemoryAllocator( AxeMemoryAllocator&& ) = delete;
+		AxeMemoryAllocator& operator=( AxeMemoryAllocator&& ) = delete;
+
+		[[nodiscard]] AxeAllocation Allocate( const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, ResourceTiling tiling );
+		void Free( AxeAllocation& allocation );
+
+		// Offset and size are relative to the allocation and get expanded to nonCoherentAtomSize
+		[[nodiscard]] VkResult Flush( const AxeAllocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0 ) const;
+		[[nodiscard]] VkResult Invalidate( const AxeAllocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0 ) const;
+
+		[[nodiscard]] Statistics GetStatistics() const;
+		[[nodiscard]] Statistics GetStatistics( uint32_t memoryTypeIndex ) const;
+		void PrintStatistics() const;
+
+	private:
+		struct Pool
+		{
+			std::vector<std::unique_ptr<AxeMemoryBlock>> blocks;
+		};
+
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties = {};
+		VkDeviceSize nonCoherentAtomSize = 1;
+		uint32_t maxMemoryAllocationCount = 0;
+
+		// Indexed by memory type, then by ResourceTiling
+		std::vector<Pool> pools[ 2 ];
+		std::vector<Statistics> dedicatedStatistics;
+
+		mutable std::mutex mutex;
+
+		[[nodiscard]] VkDeviceSize GetPreferredBlockSize( uint32_t memoryTypeIndex ) const;
+		[[nodiscard]] bool IsHostVisible( uint32_t memoryTypeIndex ) const;
+		[[nodiscard]] bool IsHostCoherent( uint32_t memoryTypeIndex ) const;
+		[[nodiscard]] uint32_t CountDeviceMemoryObjects() const;
+
+		VkDeviceMemory AllocateDeviceMemory( VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped ) const;
+		AxeAllocation AllocateDedicated( const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex );
+
+		[[nodiscard]] VkMappedMemoryRange GetMappedRange( const AxeAllocation& allocation, VkDeviceSize size, VkDeviceSize offset ) const;
+	};
+}
@@ -0,0 +1,399 @@
+#include "axe_mesh_cache.h"
+
+#include "axe_asset_pack.h"
+#include "axe_mesh_codec.h"
+#include "axe_utils.h"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Axe
+{
+	static_assert( std::is_trivially_copyable_v<AxeMeshCache::Header>, "Mesh cache header is written as raw bytes" );
+	static_assert( std::is_trivially_copyable_v<AxeModel::Vertex>, "Vertices are written as raw bytes" );
+	static_assert( std::is_trivially_copyable_v<AxeModel::Meshlet>, "Meshlets are written as raw bytes" );
+	static_assert( sizeof( AxeModel::Vertex ) % 4 == 0 && sizeof( AxeModel::Meshlet ) % 4 == 0, "Compressed caches encode vertices and meshlets as 32-bit words" );
+	static_assert( AxeAssetPack::DATA_ALIGNMENT % AxeMeshCache::DATA_ALIGNMENT == 0, "Packed caches keep the alignment of their arrays" );
+
+	static uint64_t AlignUp( const uint64_t value, const uint64_t alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	// Copies an array a compressed cache stored as it is and returns its size
+	static size_t CopyRaw( const std::span<const std::byte> data, std::byte* destination, const size_t size )
+	{
+		if ( data.size() < size )
+		{
+			throw std::runtime_error( "Compressed mesh cache ends early" );
+		}
+
+		memcpy( destination, data.data(), size );
+		return size;
+	}
+
+	std::span<const AxeModel::Vertex> AxeMeshCache::CachedMesh::Vertices() const
+	{
+		const Header& header = GetHeader();
+		return { reinterpret_cast<const AxeModel::Vertex*>(data.data() + header.vertexDataOffset), header.vertexCount };
+	}
+
+	std::span<const uint16_t> AxeMeshCache::CachedMesh::Indices16() const
+	{
+		const Header& header = GetHeader();
+		if ( header.indexSize != sizeof( uint16_t ) )
+		{
+			return {};
+		}
+
+		return { reinterpret_cast<const uint16_t*>(data.data() + header.indexDataOffset), header.indexCount };
+	}
+
+	std::span<const uint32_t> AxeMeshCache::CachedMesh::Indices32() const
+	{
+		const Header& header = GetHeader();
+		if ( header.indexSize != sizeof( uint32_t ) )
+		{
+			return {};
+		}
+
+		return { reinterpret_cast<const uint32_t*>(data.data() + header.indexDataOffset), header.indexCount };
+	}
+
+	std::span<const AxeModel::Meshlet> AxeMeshCache::CachedMesh::Meshlets() const
+	{
+		const Header& header = GetHeader();
+		return { reinterpret_cast<const AxeModel::Meshlet*>(data.data() + header.meshletDataOffset), header.meshletCount };
+	}
+
+	std::filesystem::path AxeMeshCache::GetCachePath( const std::string& sourcePath )
+	{
+		return std::filesystem::path{ sourcePath }.replace_extension( ".axemesh" );
+	}
+
+	uint32_t AxeMeshCache::GetFlags( const AxeModel::LoadOptions& options )
+	{
+		uint32_t flags = 0;
+		flags |= options.optimize ? FLAG_OPTIMIZED : 0;
+		flags |= options.buildMeshlets ? FLAG_MESHLETS : 0;
+		return flags;
+	}
+
+	std::optional<AxeMeshCache::CachedMesh> AxeMeshCache::Load( const std::string& sourcePath, const uint32_t flags )
+	{
+		try
+		{
+			// A stale pack entry falls through to the loose cache, so edited sources still work with an old pack around
+			if ( const AxeAssetPack* pack = AxeAssetPack::Mounted() )
+			{
+				const std::span<const std::byte> packedData = pack->Find( sourcePath );
+				if ( !packedData.empty() && IsUsable( packedData, sourcePath, flags ) )
+				{
+					const Header& header = *reinterpret_cast<const Header*>(packedData.data());
+					return header.flags & FLAG_COMPRESSED ? Decompress( packedData ) : CachedMesh{ packedData };
+				}
+			}
+
+			const std::filesystem::path cachePath = GetCachePath( sourcePath );
+
+			std::error_code error;
+			if ( !std::filesystem::exists( cachePath, error ) )
+			{
+				return std::nullopt;
+			}
+
+			AxeMappedFile file{ cachePath.string() };
+			if ( !IsUsable( { file.Data(), file.Size() }, sourcePath, flags ) )
+			{
+				return std::nullopt;
+			}
+
+			// The file is unmapped right after decoding, only the decoded arrays are kept around
+			const Header& header = *reinterpret_cast<const Header*>(file.Data());
+			if ( header.flags & FLAG_COMPRESSED )
+			{
+				return Decompress( { file.Data(), file.Size() } );
+			}
+
+			return CachedMesh{ std::move( file ) };
+		}
+		catch ( const std::exception& )
+		{
+			return std::nullopt;
+		}
+	}
+
+	bool AxeMeshCache::Write( const std::string& sourcePath, const AxeModel::Data& data, const uint32_t flags )
+	{
+		const SourceInfo source = GetSourceInfo( sourcePath );
+
+		Header header = {};
+		memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+		header.version = VERSION;
+		header.vertexSize = sizeof( AxeModel::Vertex );
+		header.sourceSize = source.size;
+		header.sourceWriteTime = source.writeTime;
+		header.sourceHash = HashSource( sourcePath );
+		header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+		header.indexCount = static_cast<uint32_t>(data.indices.size());
+		header.flags = flags;
+		header.boundsMin = data.boundsMin;
+		header.boundsMax = data.boundsMax;
+
+		if ( data.lods.size() > AxeModel::MAX_LODS )
+		{
+			return false;
+		}
+
+		header.lodCount = static_cast<uint32_t>(data.lods.size());
+		std::ranges::copy( data.lods, header.lods );
+		header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+
+		// Stored at the width the geometry pool uploads them with, so loading never converts them
+		std::vector<uint16_t> narrowIndices = {};
+		const void* indexData = data.indices.data();
+		header.indexSize = sizeof( uint32_t );
+
+		if ( data.vertices.size() <= AxeGeometryPool::MAX_UINT16_VERTEX_COUNT )
+		{
+			narrowIndices.assign( data.indices.begin(), data.indices.end() );
+			indexData = narrowIndices.data();
+			header.indexSize = sizeof( uint16_t );
+		}
+
+		const uint64_t vertexBytes = data.vertices.size() * sizeof( AxeModel::Vertex );
+		const uint64_t indexBytes = data.indices.size() * header.indexSize;
+		const uint64_t meshletBytes = data.meshlets.size() * sizeof( AxeModel::Meshlet );
+
+		header.vertexDataOffset = AlignUp( sizeof( Header ), DATA_ALIGNMENT );
+		header.indexDataOffset = AlignUp( header.vertexDataOffset + vertexBytes, DATA_ALIGNMENT );
+		header.meshletDataOffset = AlignUp( header.indexDataOffset + indexBytes, DATA_ALIGNMENT );
+
+		// Encoded before the header is written, it says which arrays are stored raw
+		std::vector<std::byte> encodedVertices = {};
+		std::vector<std::byte> encodedIndices = {};
+		std::vector<std::byte> encodedMeshlets = {};
+		if ( flags & FLAG_COMPRESSED )
+		{
+			encodedVertices = AxeMeshCodec::EncodeWords( data.vertices.data(), data.vertices.size(), sizeof( AxeModel::Vertex ) );
+			encodedIndices = AxeMeshCodec::EncodeIndices( indexData, data.indices.size(), header.indexSize );
+			encodedMeshlets = AxeMeshCodec::EncodeWords( data.meshlets.data(), data.meshlets.size(), sizeof( AxeModel::Meshlet ) );
+
+			header.flags |= encodedVertices.size() >= vertexBytes ? FLAG_RAW_VERTICES : 0;
+			header.flags |= encodedIndices.size() >= indexBytes ? FLAG_RAW_INDICES : 0;
+			header.flags |= encodedMeshlets.size() >= meshletBytes ? FLAG_RAW_MESHLETS : 0;
+		}
+
+		const std::filesystem::path cachePath = GetCachePath( sourcePath );
+		std::filesystem::path tempPath = cachePath;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+			if ( !file.is_open() )
+			{
+				return false;
+			}
+
+			constexpr char padding[ DATA_ALIGNMENT ] = {};
+
+			file.write( reinterpret_cast<const char*>(&header), sizeof( Header ) );
+			file.write( padding, static_cast<std::streamsize>(header.vertexDataOffset - sizeof( Header )) );
+
+			if ( flags & FLAG_COMPRESSED )
+			{
+				const auto writeArray = [&]( const void* raw, const uint64_t rawBytes, const std::vector<std::byte>& encoded, const uint32_t rawFlag )
+				{
+					if ( header.flags & rawFlag )
+					{
+						file.write( static_cast<const char*>(raw), static_cast<std::streamsize>(rawBytes) );
+						return;
+					}
+
+					file.write( reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()) );
+				};
+
+				writeArray( data.vertices.data(), vertexBytes, encodedVertices, FLAG_RAW_VERTICES );
+				writeArray( indexData, indexBytes, encodedIndices, FLAG_RAW_INDICES );
+				writeArray( data.meshlets.data(), meshletBytes, encodedMeshlets, FLAG_RAW_MESHLETS );
+			}
+			else
+			{
+				file.write( reinterpret_cast<const char*>(data.vertices.data()), static_cast<std::streamsize>(vertexBytes) );
+				file.write( padding, static_cast<std::streamsize>(header.indexDataOffset - header.vertexDataOffset - vertexBytes) );
+				file.write( static_cast<const char*>(indexData), static_cast<std::streamsize>(indexBytes) );
+				file.write( padding, static_cast<std::streamsize>(header.meshletDataOffset - header.indexDataOffset - indexBytes) );
+				file.write( reinterpret_cast<const char*>(data.meshlets.data()), static_cast<std::streamsize>(meshletBytes) );
+			}
+
+			if ( !file.good() )
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename( tempPath, cachePath, error );
+		if ( error )
+		{
+			std::filesystem::remove( tempPath, error );
+			return false;
+		}
+
+		return true;
+	}
+
+	AxeMeshCache::CachedMesh AxeMeshCache::Decompress( const std::span<const std::byte> data )
+	{
+		const Header& header = *reinterpret_cast<const Header*>(data.data());
+
+		std::vector<std::byte> decoded( header.meshletDataOffset + static_cast<uint64_t>(header.meshletCount) * sizeof( AxeModel::Meshlet ) );
+		memcpy( decoded.data(), &header, sizeof( Header ) );
+		reinterpret_cast<Header*>(decoded.data())->flags &= ~( FLAG_COMPRESSED | FLAG_RAW_VERTICES | FLAG_RAW_INDICES | FLAG_RAW_MESHLETS );
+
+		std::byte* vertices = decoded.data() + header.vertexDataOffset;
+		std::byte* indices = decoded.data() + header.indexDataOffset;
+		std::byte* meshlets = decoded.data() + header.meshletDataOffset;
+
+		size_t position = header.vertexDataOffset;
+		position += header.flags & FLAG_RAW_VERTICES
+			            ? CopyRaw( data.subspan( position ), vertices, header.vertexCount * sizeof( AxeModel::Vertex ) )
+			            : AxeMeshCodec::DecodeWords( data.subspan( position ), vertices, header.vertexCount, sizeof( AxeModel::Vertex ) );
+		position += header.flags & FLAG_RAW_INDICES
+			            ? CopyRaw( data.subspan( position ), indices, static_cast<size_t>(header.indexCount) * header.indexSize )
+			            : AxeMeshCodec::DecodeIndices( data.subspan( position ), indices, header.indexCount, header.indexSize );
+		if ( header.flags & FLAG_RAW_MESHLETS )
+		{
+			CopyRaw( data.subspan( position ), meshlets, header.meshletCount * sizeof( AxeModel::Meshlet ) );
+		}
+		else
+		{
+			AxeMeshCodec::DecodeWords( data.subspan( position ), meshlets, header.meshletCount, sizeof( AxeModel::Meshlet ) );
+		}
+
+		// Checks the decoded meshlets against the index count like for any other cache
+		if ( !IsValid( decoded ) )
+		{
+			throw std::runtime_error( "Compressed mesh cache is corrupt" );
+		}
+
+		return CachedMesh{ std::move( decoded ) };
+	}
+
+	AxeMeshCache::SourceInfo AxeMeshCache::GetSourceInfo( const std::string& sourcePath )
+	{
+		SourceInfo source = {};
+		source.size = std::filesystem::file_size( sourcePath );
+		source.writeTime = static_cast<int64_t>(std::filesystem::last_write_time( sourcePath ).time_since_epoch().count());
+		return source;
+	}
+
+	uint64_t AxeMeshCache::HashSource( const std::string& sourcePath )
+	{
+		const AxeMappedFile source{ sourcePath };
+		return HashBytes( source.Data(), source.Size() );
+	}
+
+	bool AxeMeshCache::IsValid( const std::span<const std::byte> data )
+	{
+		if ( data.size() < sizeof( Header ) )
+		{
+			return false;
+		}
+
+		Header header;
+		memcpy( &header, data.data(), sizeof( Header ) );
+
+		if ( memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0 ||
+		     header.version != VERSION ||
+		     header.vertexSize != sizeof( AxeModel::Vertex ) )
+		{
+			return false;
+		}
+
+		if ( header.indexSize != sizeof( uint16_t ) && header.indexSize != sizeof( uint32_t ) )
+		{
+			return false;
+		}
+
+		if ( header.vertexDataOffset % DATA_ALIGNMENT != 0 || header.indexDataOffset % DATA_ALIGNMENT != 0 || header.meshletDataOffset % DATA_ALIGNMENT != 0 )
+		{
+			return false;
+		}
+
+		const uint64_t vertexEnd = header.vertexDataOffset + static_cast<uint64_t>(header.vertexCount) * sizeof( AxeModel::Vertex );
+		const uint64_t indexEnd = header.indexDataOffset + static_cast<uint64_t>(header.indexCount) * header.indexSize;
+		const uint64_t meshletEnd = header.meshletDataOffset + static_cast<uint64_t>(header.meshletCount) * sizeof( AxeModel::Meshlet );
+
+		// The arrays are decoded into a buffer laid out by the offsets, which have to be the ones Write gives them
+		if ( header.flags & FLAG_COMPRESSED )
+		{
+			return header.vertexCount >= 3 && header.lodCount <= AxeModel::MAX_LODS &&
+			       header.vertexDataOffset == AlignUp( sizeof( Header ), DATA_ALIGNMENT ) && header.vertexDataOffset <= data.size() &&
+			       header.indexDataOffset == AlignUp( vertexEnd, DATA_ALIGNMENT ) &&
+			       header.meshletDataOffset == AlignUp( indexEnd, DATA_ALIGNMENT );
+		}
+
+		if ( header.vertexCount < 3 || vertexEnd > data.size() || indexEnd > data.size() || meshletEnd > data.size() || header.lodCount > AxeModel::MAX_LODS )
+		{
+			return false;
+		}
+
+		for ( uint32_t i = 0; i < header.lodCount; i++ )
+		{
+			const AxeModel::Lod& lod = header.lods[ i ];
+			if ( static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header.indexCount )
+			{
+				return false;
+			}
+		}
+
+		const AxeModel::Meshlet* meshlets = reinterpret_cast<const AxeModel::Meshlet*>(data.data() + header.meshletDataOffset);
+		for ( uint32_t i = 0; i < header.meshletCount; i++ )
+		{
+			if ( static_cast<uint64_t>(meshlets[ i ].firstIndex) + meshlets[ i ].indexCount > header.indexCount )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool AxeMeshCache::IsUsable( const std::span<const std::byte> data, const std::string& sourcePath, const uint32_t flags )
+	{
+		if ( !IsValid( data ) )
+		{
+			return false;
+		}
+
+		const Header& header = *reinterpret_cast<const Header*>(data.data());
+		if ( ( header.flags & flags ) != flags )
+		{
+			return false;
+		}
+
+		// Without the source there's nothing to compare against, the cache is all we've got
+		std::error_code error;
+		if ( std::filesystem::exists( sourcePath, error ) )
+		{
+			const SourceInfo source = GetSourceInfo( sourcePath );
+			if ( source.size != header.sourceSize )
+			{
+				return false;
+			}
+
+			// A touched but unchanged source (e.g. after a checkout) still hits the cache, it only costs a hash
+			if ( source.writeTime != header.sourceWriteTime && HashSource( sourcePath ) != header.sourceHash )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "axe_mapped_file.h"
+#include "axe_model.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Axe
+{
+	// Binary .axemesh files next to the source models, holding the final deduplicated vertex and index arrays.
+	// Loading one is a memory mapping plus a header check, the arrays are handed out as spans straight into the mapping.
+	// Compressed caches trade that for smaller files, their arrays are decoded into memory on the loading thread.
+	class AxeMeshCache
+	{
+	public:
+		static constexpr char MAGIC[ 8 ] = { 'A', 'X', 'E', 'M', 'E', 'S', 'H', '\0' };
+		static constexpr uint32_t VERSION = 7;
+		static constexpr uint64_t DATA_ALIGNMENT = 16;
+
+		// What was done to the arrays after loading, a cache counts for loads asking for any subset of its flags
+		static constexpr uint32_t FLAG_OPTIMIZED = 1 << 0;	// Reordered by AxeMeshOptimizer
+		static constexpr uint32_t FLAG_MESHLETS = 1 << 1;	// Split into meshlets by AxeMeshletBuilder
+		// How the arrays are stored rather than what was done to them, loads never ask for these
+		static constexpr uint32_t FLAG_COMPRESSED = 1 << 2;	// Encoded back to back with AxeMeshCodec, the offsets describe the decoded layout
+		// Arrays of a compressed cache that encoding wouldn't make any smaller, stored as they are in its place
+		static constexpr uint32_t FLAG_RAW_VERTICES = 1 << 3;
+		static constexpr uint32_t FLAG_RAW_INDICES = 1 << 4;
+		static constexpr uint32_t FLAG_RAW_MESHLETS = 1 << 5;
+
+		struct Header
+		{
+			char magic[ 8 ] = {};
+			uint32_t version = 0;
+			uint32_t vertexSize = 0;	// Guards against AxeModel::Vertex changing without a version bump
+
+			// The cache is stale when the source size or modification time differs and its content hash doesn't match anymore
+			uint64_t sourceSize = 0;
+			int64_t sourceWriteTime = 0;
+			uint64_t sourceHash = 0;
+
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			uint32_t flags = 0;
+			uint32_t lodCount = 0;
+			uint32_t indexSize = 0;	// 2 when the vertex count fits 16-bit indices, 4 otherwise
+			uint32_t meshletCount = 0;
+			uint64_t vertexDataOffset = 0;
+			uint64_t indexDataOffset = 0;
+			uint64_t meshletDataOffset = 0;
+
+			glm::vec3 boundsMin = {};
+			glm::vec3 boundsMax = {};
+
+			AxeModel::Lod lods[ AxeModel::MAX_LODS ] = {};
+		};
+
+		// A validated cache, either a loose file whose mapping it keeps alive for as long as the spans are used, an entry of the mounted asset pack
+		// or the decoded arrays of a compressed cache
+		class CachedMesh
+		{
+		public:
+			explicit CachedMesh( AxeMappedFile&& mappedFile ) : file{ std::move( mappedFile ) }, data{ file->Data(), file->Size() } {}
+			explicit CachedMesh( const std::span<const std::byte> packedData ) : data{ packedData } {}
+			explicit CachedMesh( std::vector<std::byte>&& decodedData ) : decoded{ std::move( decodedData ) }, data{ decoded } {}
+
+			[[nodiscard]] const Header& GetHeader() const { return *reinterpret_cast<const Header*>(data.data()); }
+			[[nodiscard]] std::span<const AxeModel::Vertex> Vertices() const;
+			// Only the one matching the header's index size holds the indices, the other one is empty
+			[[nodiscard]] std::span<const uint16_t> Indices16() const;
+			[[nodiscard]] std::span<const uint32_t> Indices32() const;
+			[[nodiscard]] std::span<const AxeModel::Lod> Lods() const { return { GetHeader().lods, GetHeader().lodCount }; }
+			[[nodiscard]] std::span<const AxeModel::Meshlet> Meshlets() const;
+
+			// Uploads the arrays straight from the mapping or decoded memory with the index width they were stored with
+			[[nodiscard]] std::unique_ptr<AxeModel> CreateModel( AxeGeometryPool& geometryPool, const AxeModel::LoadOptions& options ) const;
+
+		private:
+			std::optional<AxeMappedFile> file = {};	// Empty for pack entries, the pack stays mapped for the whole run
+			std::vector<std::byte> decoded = {};	// Only used by compressed caches
+			std::span<const std::byte> data = {};	// Stays valid when moved, a moved mapping or vector keeps its address
+		};
+
+		[[nodiscard]] static std::filesystem::path GetCachePath( const std::string& sourcePath );
+		// The flags a model loaded with these options is cached with
+		[[nodiscard]] static uint32_t GetFlags( const AxeModel::LoadOptions& options );
+
+		// Looks in the mounted asset pack first and then for a loose cache file.
+		// Returns nothing if there's no cache or it is stale, corrupt or from an older version
+		[[nodiscard]] static std::optional<CachedMesh> Load( const std::string& sourcePath, uint32_t flags = 0 );
+
+		// Writes to a temporary file first, so a crash never leaves a half written cache behind
+		static bool Write( const std::string& sourcePath, const AxeModel::Data& data, uint32_t flags = 0 );
+
+	private:
+		struct SourceInfo
+		{
+			uint64_t size = 0;
+			int64_t writeTime = 0;
+		};
+
+		[[nodiscard]] static SourceInfo GetSourceInfo( const std::string& sourcePath );
+		[[nodiscard]] static uint64_t HashSource( const std::string& sourcePath );
+		// Compressed caches only get their header checked, their arrays are checked once they're decoded
+		[[nodiscard]] static bool IsValid( std::span<const std::byte> data );
+		// Valid, cached with at least the given flags and not older than the source if that's around
+		[[nodiscard]] static bool IsUsable( std::span<const std::byte> data, const std::string& sourcePath, uint32_t flags );
+		// Decodes the arrays of a usable compressed cache into memory, throws if they turn out to be corrupt
+		[[nodiscard]] static CachedMesh Decompress( std::span<const std::byte> data );
+	};
+}
@@ -0,0 +1,867 @@
+#include "axe_mesh_codec.h"
+
+// std headers
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <emmintrin.h>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Axe
+{
+	static constexpr uint32_t TABLE_SIZE = 1 << AxeMeshCodec::MAX_CODE_LENGTH;
+	// Records are put back together a lane at a time in chunks small enough for the written records to stay in the L1 cache
+	static constexpr size_t RECONSTRUCT_CHUNK_SIZE = 256;
+
+	template <typename Lane>
+	static Lane ZigzagEncode( const Lane delta )
+	{
+		using Signed = std::make_signed_t<Lane>;
+		return static_cast<Lane>(( delta << 1 ) ^ static_cast<Lane>(static_cast<Signed>(delta) >> ( sizeof( Lane ) * 8 - 1 )));
+	}
+
+	template <typename Lane>
+	static Lane ZigzagDecode( const Lane value )
+	{
+		return static_cast<Lane>(( value >> 1 ) ^ static_cast<Lane>(0 - ( value & 1 )));
+	}
+
+	// Sums of the 4 words of the delta with all words before them, plus the last value of the previous group
+	static __m128i PrefixSum32( __m128i delta, const __m128i previous )
+	{
+		delta = _mm_add_epi32( delta, _mm_slli_si128( delta, 4 ) );
+		delta = _mm_add_epi32( delta, _mm_slli_si128( delta, 8 ) );
+		return _mm_add_epi32( delta, _mm_shuffle_epi32( previous, _MM_SHUFFLE( 3, 3, 3, 3 ) ) );
+	}
+
+	static __m128i PrefixSum16( __m128i delta, const __m128i previous )
+	{
+		delta = _mm_add_epi16( delta, _mm_slli_si128( delta, 2 ) );
+		delta = _mm_add_epi16( delta, _mm_slli_si128( delta, 4 ) );
+		delta = _mm_add_epi16( delta, _mm_slli_si128( delta, 8 ) );
+		const __m128i last = _mm_shufflehi_epi16( previous, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+		return _mm_add_epi16( delta, _mm_unpackhi_epi64( last, last ) );
+	}
+
+	static __m128i ZigzagDecode32( const __m128i value )
+	{
+		return _mm_xor_si128( _mm_srli_epi32( value, 1 ), _mm_sub_epi32( _mm_setzero_si128(), _mm_and_si128( value, _mm_set1_epi32( 1 ) ) ) );
+	}
+
+	static __m128i ZigzagDecode16( const __m128i value )
+	{
+		return _mm_xor_si128( _mm_srli_epi16( value, 1 ), _mm_sub_epi16( _mm_setzero_si128(), _mm_and_si128( value, _mm_set1_epi16( 1 ) ) ) );
+	}
+
+	// Puts 16 values of a lane back together from its byte planes, planeStride apart, and adds them up starting from the last word of previous,
+	// which is left holding the last of them. Records are written stride bytes apart
+	template <typename Lane>
+	static void Reconstruct16( const uint8_t* planes, const size_t planeStride, std::byte* records, const size_t stride, __m128i& previous )
+	{
+		alignas( 16 ) Lane values[ 16 ];
+		const __m128i plane0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>(planes) );
+		const __m128i plane1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>(planes + planeStride) );
+
+		if constexpr ( sizeof( Lane ) == sizeof( uint16_t ) )
+		{
+			previous = PrefixSum16( ZigzagDecode16( _mm_unpacklo_epi8( plane0, plane1 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values), previous );
+			previous = PrefixSum16( ZigzagDecode16( _mm_unpackhi_epi8( plane0, plane1 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values + 8), previous );
+		}
+		else
+		{
+			const __m128i plane2 = _mm_loadu_si128( reinterpret_cast<const __m128i*>(planes + 2 * planeStride) );
+			const __m128i plane3 = _mm_loadu_si128( reinterpret_cast<const __m128i*>(planes + 3 * planeStride) );
+
+			// Interleaving the low and high pairs of planes gives the words in order
+			const __m128i low0 = _mm_unpacklo_epi8( plane0, plane1 );
+			const __m128i low1 = _mm_unpackhi_epi8( plane0, plane1 );
+			const __m128i high0 = _mm_unpacklo_epi8( plane2, plane3 );
+			const __m128i high1 = _mm_unpackhi_epi8( plane2, plane3 );
+
+			previous = PrefixSum32( ZigzagDecode32( _mm_unpacklo_epi16( low0, high0 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values), previous );
+			previous = PrefixSum32( ZigzagDecode32( _mm_unpackhi_epi16( low0, high0 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values + 4), previous );
+			previous = PrefixSum32( ZigzagDecode32( _mm_unpacklo_epi16( low1, high1 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values + 8), previous );
+			previous = PrefixSum32( ZigzagDecode32( _mm_unpackhi_epi16( low1, high1 ) ), previous );
+			_mm_store_si128( reinterpret_cast<__m128i*>(values + 12), previous );
+		}
+
+		if ( stride == sizeof( Lane ) )
+		{
+			memcpy( records, values, sizeof( values ) );
+			return;
+		}
+
+		for ( size_t i = 0; i < 16; i++ )
+		{
+			memcpy( records + i * stride, &values[ i ], sizeof( Lane ) );
+		}
+	}
+
+	// Canonical codes, shorter codes come first and codes of the same length are in symbol order.
+	// The streams are read starting from the highest bit, so every code's table entries are one run
+	static std::array<uint32_t, 256> BuildCodes( const std::array<uint8_t, 256>& lengths )
+	{
+		uint32_t lengthCounts[ AxeMeshCodec::MAX_CODE_LENGTH + 1 ] = {};
+		for ( const uint8_t length : lengths )
+		{
+			lengthCounts[ length ]++;
+		}
+		lengthCounts[ 0 ] = 0;
+
+		uint32_t nextCode[ AxeMeshCodec::MAX_CODE_LENGTH + 1 ] = {};
+		for ( uint32_t length = 1, code = 0; length <= AxeMeshCodec::MAX_CODE_LENGTH; length++ )
+		{
+			code = ( code + lengthCounts[ length - 1 ] ) << 1;
+			nextCode[ length ] = code;
+		}
+
+		std::array<uint32_t, 256> codes = {};
+		for ( uint32_t symbol = 0; symbol < 256; symbol++ )
+		{
+			if ( lengths[ symbol ] != 0 )
+			{
+				codes[ symbol ] = nextCode[ lengths[ symbol ] ]++;
+			}
+		}
+
+		return codes;
+	}
+
+	static uint64_t LoadBigEndian( const uint8_t* data )
+	{
+		uint64_t word;
+		memcpy( &word, data, sizeof( word ) );
+#if defined( _MSC_VER )
+		return _byteswap_uint64( word );
+#else
+		return __builtin_bswap64( word );
+#endif
+	}
+
+	// The used symbols in the order of their canonical codes
+	struct SortedCodes
+	{
+		std::array<uint8_t, 256> symbols = {};
+		std::array<uint8_t, 256> lengths = {};
+		uint32_t count = 0;
+	};
+
+	// Fills the entries of the table run whose first length bits are taken by the codes of the symbols decoded so far. An entry holds the total
+	// length of its codes in its low byte, up to 6 symbols in the bytes after it, the length of the first code in bits 56-59 and the symbol
+	// count in the top 3 bits. Every code that still fits takes one run after the other, the entries left over start with a code that doesn't
+	// and only hold the symbols so far. Returns the end of the run
+	static uint64_t* FillEntries( uint64_t* entry, const uint64_t decoded, const uint32_t length, const SortedCodes& codes )
+	{
+		uint64_t* const end = entry + ( TABLE_SIZE >> length );
+		const uint32_t decodedCount = static_cast<uint32_t>(decoded >> 61);
+
+		for ( uint32_t i = 0; decodedCount < 6 && i < codes.count && length + codes.lengths[ i ] <= AxeMeshCodec::MAX_CODE_LENGTH; i++ )
+		{
+			uint64_t next = decoded | static_cast<uint64_t>(codes.symbols[ i ]) << ( decodedCount * 8 + 8 );
+			next += static_cast<uint64_t>(codes.lengths[ i ]) | 1ull << 61;
+			next |= decodedCount == 0 ? static_cast<uint64_t>(codes.lengths[ i ]) << 56 : 0;
+
+			// Most runs are too short for another code, filling them here saves a call each
+			const uint32_t nextLength = length + codes.lengths[ i ];
+			if ( decodedCount == 5 || nextLength + codes.lengths[ 0 ] > AxeMeshCodec::MAX_CODE_LENGTH )
+			{
+				uint64_t* const runEnd = entry + ( TABLE_SIZE >> nextLength );
+				std::fill( entry, runEnd, next );
+				entry = runEnd;
+			}
+			else
+			{
+				entry = FillEntries( entry, next, nextLength, codes );
+			}
+		}
+
+		std::fill( entry, end, decoded );
+		return end;
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter( std::vector<std::byte>& output ) : output{ output } {}
+
+		// Codes go in from the highest bit down
+		void Write( const uint32_t code, const uint32_t length )
+		{
+			bits |= static_cast<uint64_t>(code) << ( 64 - count - length );
+			count += length;
+
+			while ( count >= 8 )
+			{
+				output.push_back( static_cast<std::byte>(bits >> 56) );
+				bits <<= 8;
+				count -= 8;
+			}
+		}
+
+		void Flush()
+		{
+			if ( count > 0 )
+			{
+				output.push_back( static_cast<std::byte>(bits >> 56) );
+			}
+
+			bits = 0;
+			count = 0;
+		}
+
+	private:
+		std::vector<std::byte>& output;
+		uint64_t bits = 0;
+		uint32_t count = 0;
+	};
+
+	// Keeps a marker bit below the bits it hands out, the marker moves up with every code taken, so the position only has to be updated on refills
+	class BitReader
+	{
+	public:
+		// Can read on past the stream up to the end of the readable bytes, the bits read there are never used by a valid stream
+		BitReader( const uint8_t* data, const size_t size, const size_t readableSize ) : data{ data }, size{ size }, readableSize{ readableSize } {}
+
+		// Leaves at least 56 bits in the buffer, enough for 5 entries. The next bit is the highest one
+		void Refill()
+		{
+			position += std::countr_zero( bits ) - 7;
+
+			const size_t byteOffset = position >> 3;
+			uint64_t word = 0;
+			if ( byteOffset + sizeof( word ) <= readableSize )
+			{
+				word = LoadBigEndian( data + byteOffset );
+			}
+			else
+			{
+				// Past the end of the readable bytes the buffer is filled up with zeros
+				uint8_t lastBytes[ sizeof( word ) ] = {};
+				if ( byteOffset < readableSize )
+				{
+					memcpy( lastBytes, data + byteOffset, readableSize - byteOffset );
+				}
+				word = LoadBigEndian( lastBytes );
+			}
+
+			bits = ( ( word << ( position & 7 ) ) & ~uint64_t{ 0xFF } ) | MARKER;
+		}
+
+		// Writes the up to 6 symbols of the next entry and returns how many there were, 8 bytes are written either way
+		uint32_t DecodeMulti( const uint64_t* table, uint8_t* output )
+		{
+			const uint64_t entry = table[ bits >> ( 64 - AxeMeshCodec::MAX_CODE_LENGTH ) ];
+			const uint64_t symbols = entry >> 8;
+			memcpy( output, &symbols, sizeof( symbols ) );
+			bits <<= entry & 63;
+			return static_cast<uint32_t>(entry >> 61);
+		}
+
+		// Only takes the first symbol of the entry
+		uint8_t Decode( const uint64_t* table )
+		{
+			const uint64_t entry = table[ bits >> ( 64 - AxeMeshCodec::MAX_CODE_LENGTH ) ];
+			bits <<= ( entry >> 56 ) & 15;
+			return static_cast<uint8_t>(entry >> 8);
+		}
+
+		[[nodiscard]] bool IsOverrun() const
+		{
+			return position + std::countr_zero( bits ) - 7 > size * 8;
+		}
+
+	private:
+		static constexpr uint64_t MARKER = 1 << 7;
+
+		const uint8_t* data;
+		size_t size;
+		size_t readableSize;
+		uint64_t position = 0;	// In bits, up to the last refill
+		uint64_t bits = MARKER;
+	};
+
+	// 5 entries write at most 32 bytes, counting the unused bytes written after their symbols
+	static constexpr size_t MULTI_MARGIN = 32;
+
+	// Decodes two streams in turn until one of them has no room left for 5 more entries
+	static void DecodePair(
+		const uint64_t* table,
+		BitReader& firstReader,
+		uint8_t*& firstOutput,
+		const uint8_t* firstEnd,
+		BitReader& secondReader,
+		uint8_t*& secondOutput,
+		const uint8_t* secondEnd )
+	{
+		BitReader reader0 = firstReader;
+		BitReader reader1 = secondReader;
+		uint8_t* output0 = firstOutput;
+		uint8_t* output1 = secondOutput;
+
+		while ( output0 < firstEnd && output1 < secondEnd )
+		{
+			reader0.Refill();
+			reader1.Refill();
+
+			for ( uint32_t j = 0; j < 5; j++ )
+			{
+				output0 += reader0.DecodeMulti( table, output0 );
+				output1 += reader1.DecodeMulti( table, output1 );
+			}
+		}
+
+		firstReader = reader0;
+		secondReader = reader1;
+		firstOutput = output0;
+		secondOutput = output1;
+	}
+
+	std::vector<std::byte> AxeMeshCodec::EncodeWords( const void* records, const size_t count, const size_t stride )
+	{
+		if ( stride == 0 || stride % sizeof( uint32_t ) != 0 )
+		{
+			throw std::runtime_error( "Encoded records have to be a whole number of 32-bit words" );
+		}
+
+		return Encode<uint32_t>( static_cast<const std::byte*>(records), count, stride );
+	}
+
+	std::vector<std::byte> AxeMeshCodec::EncodeIndices( const void* indices, const size_t count, const uint32_t indexSize )
+	{
+		if ( indexSize == sizeof( uint16_t ) )
+		{
+			return Encode<uint16_t>( static_cast<const std::byte*>(indices), count, sizeof( uint16_t ) );
+		}
+
+		if ( indexSize == sizeof( uint32_t ) )
+		{
+			return Encode<uint32_t>( static_cast<const std::byte*>(indices), count, sizeof( uint32_t ) );
+		}
+
+		throw std::runtime_error( "Indices have to be 16 or 32 bits" );
+	}
+
+	size_t AxeMeshCodec::DecodeWords( const std::span<const std::byte> encoded, void* records, const size_t count, const size_t stride )
+	{
+		if ( stride == 0 || stride % sizeof( uint32_t ) != 0 )
+		{
+			throw std::runtime_error( "Encoded records have to be a whole number of 32-bit words" );
+		}
+
+		return Decode<uint32_t>( encoded, static_cast<std::byte*>(records), count, stride );
+	}
+
+	size_t AxeMeshCodec::DecodeIndices( const std::span<const std::byte> encoded, void* indices, const size_t count, const uint32_t indexSize )
+	{
+		if ( indexSize == sizeof( uint16_t ) )
+		{
+			return Decode<uint16_t>( encoded, static_cast<std::byte*>(indices), count, sizeof( uint16_t ) );
+		}
+
+		if ( indexSize == sizeof( uint32_t ) )
+		{
+			return Decode<uint32_t>( encoded, static_cast<std::byte*>(indices), count, sizeof( uint32_t ) );
+		}
+
+		throw std::runtime_error( "Indices have to be 16 or 32 bits" );
+	}
+
+	template <typename Lane>
+	std::vector<std::byte> AxeMeshCodec::Encode( const std::byte* records, const size_t count, const size_t stride )
+	{
+		const size_t laneCount = stride / sizeof( Lane );
+		const size_t planeCount = laneCount * sizeof( Lane );
+
+		// Plane p of lane l holds byte p of every record's zigzag coded delta of that lane
+		std::vector<uint8_t> planes( planeCount * count );
+
+		for ( size_t lane = 0; lane < laneCount; lane++ )
+		{
+			uint8_t* lanePlanes = planes.data() + lane * sizeof( Lane ) * count;
+			Lane previous = 0;
+
+			for ( size_t i = 0; i < count; i++ )
+			{
+				Lane value;
+				memcpy( &value, records + i * stride + lane * sizeof( Lane ), sizeof( Lane ) );
+
+				const Lane delta = ZigzagEncode<Lane>( static_cast<Lane>(value - previous) );
+				previous = value;
+
+				for ( size_t byte = 0; byte < sizeof( Lane ); byte++ )
+				{
+					lanePlanes[ byte * count + i ] = static_cast<uint8_t>(delta >> ( byte * 8 ));
+				}
+			}
+		}
+
+		std::vector<std::byte> output = {};
+		output.reserve( planes.size() / 2 );
+
+		// Blocks of all planes for the same records follow each other, so the decoder only ever holds one block of every plane
+		for ( size_t offset = 0; offset < count; offset += BLOCK_SIZE )
+		{
+			for ( size_t plane = 0; plane < planeCount; plane++ )
+			{
+				EncodeBlock( { planes.data() + plane * count + offset, std::min<size_t>( BLOCK_SIZE, count - offset ) }, output );
+			}
+		}
+
+		return output;
+	}
+
+	template <typename Lane>
+	size_t AxeMeshCodec::Decode( const std::span<const std::byte> encoded, std::byte* records, const size_t count, const size_t stride )
+	{
+		const size_t laneCount = stride / sizeof( Lane );
+		const size_t planeCount = laneCount * sizeof( Lane );
+
+		// Decoding the whole arrays into planes first would double the memory the decoder touches, only a block of every plane is kept around.
+		// Every byte of it is decoded into before it's read, so it's left uninitialized
+		const std::unique_ptr<uint8_t[]> planes = std::make_unique_for_overwrite<uint8_t[]>( planeCount * std::min<size_t>( count, BLOCK_SIZE ) );
+		std::vector<Lane> previous( laneCount, 0 );
+
+		size_t position = 0;
+		for ( size_t offset = 0; offset < count; offset += BLOCK_SIZE )
+		{
+			const size_t blockLength = std::min<size_t>( BLOCK_SIZE, count - offset );
+
+			for ( size_t plane = 0; plane < planeCount; plane++ )
+			{
+				position += DecodeBlock( encoded.subspan( position ), { planes.get() + plane * blockLength, blockLength } );
+			}
+
+			for ( size_t chunk = 0; chunk < blockLength; chunk += RECONSTRUCT_CHUNK_SIZE )
+			{
+				const size_t chunkLength = std::min<size_t>( RECONSTRUCT_CHUNK_SIZE, blockLength - chunk );
+
+				for ( size_t lane = 0; lane < laneCount; lane++ )
+				{
+					const uint8_t* lanePlanes = planes.get() + lane * sizeof( Lane ) * blockLength + chunk;
+					std::byte* destination = records + ( offset + chunk ) * stride + lane * sizeof( Lane );
+
+					// 16 values at a time across the words of a register, the running sum is carried over in the last word
+					__m128i sum = sizeof( Lane ) == sizeof( uint16_t ) ? _mm_set1_epi16( static_cast<short>(previous[ lane ]) )
+					                                                   : _mm_set1_epi32( static_cast<int>(previous[ lane ]) );
+					size_t i = 0;
+					for ( ; i + 16 <= chunkLength; i += 16 )
+					{
+						Reconstruct16<Lane>( lanePlanes + i, blockLength, destination + i * stride, stride, sum );
+					}
+
+					Lane value = static_cast<Lane>(sizeof( Lane ) == sizeof( uint16_t )
+						                               ? _mm_extract_epi16( sum, 7 )
+						                               : _mm_cvtsi128_si32( _mm_shuffle_epi32( sum, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ));
+					for ( ; i < chunkLength; i++ )
+					{
+						Lane delta = {};
+						if constexpr ( sizeof( Lane ) == sizeof( uint16_t ) )
+						{
+							delta = static_cast<Lane>(lanePlanes[ i ] | lanePlanes[ blockLength + i ] << 8);
+						}
+						else
+						{
+							delta = lanePlanes[ i ] | lanePlanes[ blockLength + i ] << 8 | lanePlanes[ 2 * blockLength + i ] << 16 |
+							        static_cast<Lane>(lanePlanes[ 3 * blockLength + i ]) << 24;
+						}
+
+						value = static_cast<Lane>(value + ZigzagDecode<Lane>( delta ));
+						memcpy( destination + i * stride, &value, sizeof( Lane ) );
+					}
+
+					previous[ lane ] = value;
+				}
+			}
+		}
+
+		return position;
+	}
+
+	void AxeMeshCodec::EncodeBlock( const std::span<const uint8_t> block, std::vector<std::byte>& output )
+	{
+		std::array<uint32_t, 256> frequencies = {};
+		for ( const uint8_t symbol : block )
+		{
+			frequencies[ symbol ]++;
+		}
+
+		const uint32_t usedSymbolCount = static_cast<uint32_t>(std::ranges::count_if( frequencies, []( const uint32_t frequency ) { return frequency != 0; } ));
+
+		// High byte planes of smooth data are often a single value throughout
+		if ( usedSymbolCount == 1 )
+		{
+			output.push_back( static_cast<std::byte>(BlockMode::Constant) );
+			output.push_back( static_cast<std::byte>(block[ 0 ]) );
+			return;
+		}
+
+		const CodeLengths lengths = BuildCodeLengths( frequencies );
+
+		uint32_t symbolCount = 0;
+		uint64_t codedBits = 0;
+		for ( uint32_t symbol = 0; symbol < 256; symbol++ )
+		{
+			codedBits += static_cast<uint64_t>(frequencies[ symbol ]) * lengths[ symbol ];
+			symbolCount = lengths[ symbol ] != 0 ? symbol + 1 : symbolCount;
+		}
+
+		// Noisy low planes barely shrink, copying them is several times faster than decoding them
+		const uint64_t headerSize = 2 + ( symbolCount + 1 ) / 2 + STREAM_COUNT * sizeof( uint32_t );
+		if ( headerSize + codedBits / 8 + STREAM_COUNT >= block.size() - block.size() / 8 )
+		{
+			output.push_back( static_cast<std::byte>(BlockMode::Raw) );
+			output.insert( output.end(), reinterpret_cast<const std::byte*>(block.data()), reinterpret_cast<const std::byte*>(block.data() + block.size()) );
+			return;
+		}
+
+		output.push_back( static_cast<std::byte>(BlockMode::Huffman) );
+		output.push_back( static_cast<std::byte>(symbolCount - 1) );
+
+		for ( uint32_t symbol = 0; symbol < symbolCount; symbol += 2 )
+		{
+			const uint8_t high = symbol + 1 < symbolCount ? lengths[ symbol + 1 ] : 0;
+			output.push_back( static_cast<std::byte>(lengths[ symbol ] | ( high << 4 )) );
+		}
+
+		const std::array<uint32_t, 256> codes = BuildCodes( lengths );
+
+		// Stream sizes are filled in once each stream is written
+		const size_t sizesOffset = output.size();
+		output.resize( output.size() + STREAM_COUNT * sizeof( uint32_t ) );
+
+		const size_t streamLength = ( block.size() + STREAM_COUNT - 1 ) / STREAM_COUNT;
+		for ( uint32_t stream = 0; stream < STREAM_COUNT; stream++ )
+		{
+			const size_t streamStart = output.size();
+			BitWriter writer{ output };
+
+			for ( size_t i = stream * streamLength; i < std::min( block.size(), ( stream + 1 ) * streamLength ); i++ )
+			{
+				writer.Write( codes[ block[ i ] ], lengths[ block[ i ] ] );
+			}
+
+			writer.Flush();
+
+			const uint32_t streamSize = static_cast<uint32_t>(output.size() - streamStart);
+			memcpy( output.data() + sizesOffset + stream * sizeof( uint32_t ), &streamSize, sizeof( uint32_t ) );
+		}
+	}
+
+	size_t AxeMeshCodec::DecodeBlock( const std::span<const std::byte> encoded, const std::span<uint8_t> block )
+	{
+		const auto* input = reinterpret_cast<const uint8_t*>(encoded.data());
+
+		if ( encoded.empty() )
+		{
+			throw std::runtime_error( "Encoded mesh data ends early" );
+		}
+
+		switch ( static_cast<BlockMode>(input[ 0 ]) )
+		{
+			case BlockMode::Raw:
+			{
+				if ( encoded.size() < 1 + block.size() )
+				{
+					throw std::runtime_error( "Encoded mesh data ends early" );
+				}
+
+				memcpy( block.data(), input + 1, block.size() );
+				return 1 + block.size();
+			}
+			case BlockMode::Constant:
+			{
+				if ( encoded.size() < 2 )
+				{
+					throw std::runtime_error( "Encoded mesh data ends early" );
+				}
+
+				memset( block.data(), input[ 1 ], block.size() );
+				return 2;
+			}
+			case BlockMode::Huffman:
+				break;
+			default:
+				throw std::runtime_error( "Unknown encoded mesh block" );
+		}
+
+		if ( encoded.size() < 2 )
+		{
+			throw std::runtime_error( "Encoded mesh data ends early" );
+		}
+
+		const uint32_t symbolCount = input[ 1 ] + 1u;
+		size_t position = 2 + ( symbolCount + 1 ) / 2;
+		if ( encoded.size() < position + STREAM_COUNT * sizeof( uint32_t ) )
+		{
+			throw std::runtime_error( "Encoded mesh data ends early" );
+		}
+
+		CodeLengths lengths = {};
+		for ( uint32_t symbol = 0; symbol < symbolCount; symbol++ )
+		{
+			lengths[ symbol ] = ( input[ 2 + symbol / 2 ] >> ( symbol % 2 * 4 ) ) & 15;
+
+			if ( lengths[ symbol ] > MAX_CODE_LENGTH )
+			{
+				throw std::runtime_error( "Corrupt encoded mesh code lengths" );
+			}
+		}
+
+		// Counting sort by code length gives the used symbols in the order of their canonical codes
+		uint32_t lengthOffsets[ MAX_CODE_LENGTH + 2 ] = {};
+		for ( uint32_t symbol = 0; symbol < symbolCount; symbol++ )
+		{
+			lengthOffsets[ lengths[ symbol ] + 1 ] += lengths[ symbol ] != 0;
+		}
+
+		// An incomplete code would leave entries of the table undefined, an oversubscribed one would run past it
+		uint32_t kraftSum = 0;
+		for ( uint32_t length = 1; length <= MAX_CODE_LENGTH; length++ )
+		{
+			kraftSum += lengthOffsets[ length + 1 ] << ( MAX_CODE_LENGTH - length );
+		}
+
+		if ( kraftSum != TABLE_SIZE )
+		{
+			throw std::runtime_error( "Corrupt encoded mesh code lengths" );
+		}
+
+		std::partial_sum( lengthOffsets, lengthOffsets + MAX_CODE_LENGTH + 2, lengthOffsets );
+
+		SortedCodes sortedCodes = {};
+		for ( uint32_t symbol = 0; symbol < symbolCount; symbol++ )
+		{
+			if ( lengths[ symbol ] != 0 )
+			{
+				const uint32_t index = lengthOffsets[ lengths[ symbol ] ]++;
+				sortedCodes.symbols[ index ] = static_cast<uint8_t>(symbol);
+				sortedCodes.lengths[ index ] = lengths[ symbol ];
+				sortedCodes.count++;
+			}
+		}
+
+		// Maps the next MAX_CODE_LENGTH bits to the symbols whose codes they start with
+		uint64_t table[ TABLE_SIZE ];
+		FillEntries( table, 0, 0, sortedCodes );
+
+		uint32_t streamSizes[ STREAM_COUNT ];
+		memcpy( streamSizes, input + position, sizeof( streamSizes ) );
+		position += sizeof( streamSizes );
+
+		const size_t streamLength = ( block.size() + STREAM_COUNT - 1 ) / STREAM_COUNT;
+
+		// The last stream can be shorter, or empty for tiny blocks
+		size_t streamEnds[ STREAM_COUNT ];
+		std::array<BitReader, STREAM_COUNT> readers = {
+			BitReader{ nullptr, 0, 0 }, BitReader{ nullptr, 0, 0 }, BitReader{ nullptr, 0, 0 }, BitReader{ nullptr, 0, 0 }
+		};
+
+		for ( uint32_t stream = 0; stream < STREAM_COUNT; stream++ )
+		{
+			if ( encoded.size() - position < streamSizes[ stream ] )
+			{
+				throw std::runtime_error( "Encoded mesh data ends early" );
+			}
+
+			readers[ stream ] = BitReader{ input + position, streamSizes[ stream ], encoded.size() - position };
+			streamEnds[ stream ] = std::min( block.size(), ( stream + 1 ) * streamLength );
+			position += streamSizes[ stream ];
+		}
+
+		std::array<uint8_t*, STREAM_COUNT> outputs = {};
+		std::array<const uint8_t*, STREAM_COUNT> multiEnds = {};
+		for ( uint32_t stream = 0; stream < STREAM_COUNT; stream++ )
+		{
+			outputs[ stream ] = block.data() + std::min( block.size(), stream * streamLength );
+
+			const uint8_t* streamEnd = block.data() + streamEnds[ stream ];
+			multiEnds[ stream ] = streamEnd - std::min<size_t>( streamEnd - outputs[ stream ], MULTI_MARGIN );
+		}
+
+		// A refill is good for 5 entries of each stream, decoding the four streams in turn keeps four independent lookups in flight.
+		// The readers are copied to locals for the loop, the compiler can't keep array elements in registers across the byte stores
+		BitReader reader0 = readers[ 0 ];
+		BitReader reader1 = readers[ 1 ];
+		BitReader reader2 = readers[ 2 ];
+		BitReader reader3 = readers[ 3 ];
+		uint8_t* output0 = outputs[ 0 ];
+		uint8_t* output1 = outputs[ 1 ];
+		uint8_t* output2 = outputs[ 2 ];
+		uint8_t* output3 = outputs[ 3 ];
+
+		while ( output0 < multiEnds[ 0 ] && output1 < multiEnds[ 1 ] && output2 < multiEnds[ 2 ] && output3 < multiEnds[ 3 ] )
+		{
+			reader0.Refill();
+			reader1.Refill();
+			reader2.Refill();
+			reader3.Refill();
+
+			for ( uint32_t j = 0; j < 5; j++ )
+			{
+				output0 += reader0.DecodeMulti( table, output0 );
+				output1 += reader1.DecodeMulti( table, output1 );
+				output2 += reader2.DecodeMulti( table, output2 );
+				output3 += reader3.DecodeMulti( table, output3 );
+			}
+		}
+
+		readers = { reader0, reader1, reader2, reader3 };
+		outputs = { output0, output1, output2, output3 };
+
+		// The streams run out at different times, the ones left go on two at a time until only one is
+		std::array<uint32_t, STREAM_COUNT> leftStreams = {};
+		uint32_t leftCount = 0;
+		for ( uint32_t stream = 0; stream < STREAM_COUNT; stream++ )
+		{
+			if ( outputs[ stream ] < multiEnds[ stream ] )
+			{
+				leftStreams[ leftCount++ ] = stream;
+			}
+		}
+
+		while ( leftCount >= 2 )
+		{
+			const uint32_t first = leftStreams[ 0 ];
+			const uint32_t second = leftStreams[ 1 ];
+			DecodePair( table, readers[ first ], outputs[ first ], multiEnds[ first ], readers[ second ], outputs[ second ], multiEnds[ second ] );
+
+			leftCount = static_cast<uint32_t>(std::remove_if(
+				leftStreams.begin(),
+				leftStreams.begin() + leftCount,
+				[&]( const uint32_t stream ) { return outputs[ stream ] >= multiEnds[ stream ]; } ) - leftStreams.begin());
+		}
+
+		// Each stream finishes on its own, with single entries once there's no room for 5 and one symbol at a time for the last few
+		for ( uint32_t stream = 0; stream < STREAM_COUNT; stream++ )
+		{
+			BitReader& reader = readers[ stream ];
+			uint8_t* output = outputs[ stream ];
+			const uint8_t* streamEnd = block.data() + streamEnds[ stream ];
+
+			while ( output < multiEnds[ stream ] )
+			{
+				reader.Refill();
+				for ( uint32_t j = 0; j < 5; j++ )
+				{
+					output += reader.DecodeMulti( table, output );
+				}
+			}
+
+			while ( static_cast<size_t>(streamEnd - output) >= sizeof( uint64_t ) )
+			{
+				reader.Refill();
+				output += reader.DecodeMulti( table, output );
+			}
+
+			while ( output < streamEnd )
+			{
+				reader.Refill();
+				*output++ = reader.Decode( table );
+			}
+
+			if ( reader.IsOverrun() )
+			{
+				throw std::runtime_error( "Corrupt encoded mesh stream" );
+			}
+		}
+
+		return position;
+	}
+
+	AxeMeshCodec::CodeLengths AxeMeshCodec::BuildCodeLengths( const std::array<uint32_t, 256>& frequencies )
+	{
+		// Huffman tree over the used symbols, leaves are nodes 0-255 and merged nodes follow them
+		std::vector<uint32_t> parents( 512, 0 );
+		std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t>>, std::greater<>> queue;
+
+		std::vector<uint32_t> symbols = {};
+		for ( uint32_t symbol = 0; symbol < 256; symbol++ )
+		{
+			if ( frequencies[ symbol ] != 0 )
+			{
+				queue.emplace( frequencies[ symbol ], symbol );
+				symbols.push_back( symbol );
+			}
+		}
+
+		uint32_t nextNode = 256;
+		while ( queue.size() > 1 )
+		{
+			const auto [ firstFrequency, first ] = queue.top();
+			queue.pop();
+			const auto [ secondFrequency, second ] = queue.top();
+			queue.pop();
+
+			parents[ first ] = nextNode;
+			parents[ second ] = nextNode;
+			queue.emplace( firstFrequency + secondFrequency, nextNode++ );
+		}
+
+		// Parents are always created after their children, so walking the merged nodes backwards sees every parent's depth first
+		std::vector<uint32_t> depths( 512, 0 );
+		for ( uint32_t node = nextNode - 1; node-- > 256; )
+		{
+			depths[ node ] = depths[ parents[ node ] ] + 1;
+		}
+
+		uint32_t lengthCounts[ 64 ] = {};
+		for ( const uint32_t symbol : symbols )
+		{
+			lengthCounts[ std::min<uint32_t>( depths[ parents[ symbol ] ] + 1, 63 ) ]++;
+		}
+
+		// Limits the code lengths the way miniz does: codes that are too long are cut down, then the Kraft sum is brought back to exactly 1
+		for ( uint32_t length = MAX_CODE_LENGTH + 1; length < 64; length++ )
+		{
+			lengthCounts[ MAX_CODE_LENGTH ] += lengthCounts[ length ];
+			lengthCounts[ length ] = 0;
+		}
+
+		uint32_t kraftSum = 0;
+		for ( uint32_t length = 1; length <= MAX_CODE_LENGTH; length++ )
+		{
+			kraftSum += lengthCounts[ length ] << ( MAX_CODE_LENGTH - length );
+		}
+
+		while ( kraftSum != TABLE_SIZE )
+		{
+			lengthCounts[ MAX_CODE_LENGTH ]--;
+			for ( uint32_t length = MAX_CODE_LENGTH - 1; length > 0; length-- )
+			{
+				if ( lengthCounts[ length ] != 0 )
+				{
+					lengthCounts[ length ]--;
+					lengthCounts[ length + 1 ] += 2;
+					break;
+				}
+			}
+
+			kraftSum--;
+		}
+
+		// The longest codes go to the rarest symbols
+		std::ranges::stable_sort( symbols, [&]( const uint32_t a, const uint32_t b ) { return frequencies[ a ] < frequencies[ b ]; } );
+
+		CodeLengths lengths = {};
+		size_t next = 0;
+		for ( uint32_t length = MAX_CODE_LENGTH; length > 0; length-- )
+		{
+			for ( uint32_t i = 0; i < lengthCounts[ length ]; i++ )
+			{
+				lengths[ symbols[ next++ ] ] = static_cast<uint8_t>(length);
+			}
+		}
+
+		return lengths;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Lossless compression of the vertex, index and meshlet arrays of mesh caches.
+	// Every element is delta coded against the previous one and zigzag coded, which turns the small differences between neighbours into small numbers.
+	// The results are split into byte planes so the mostly zero high bytes end up together, and each plane is Huffman coded in blocks.
+	class AxeMeshCodec
+	{
+	public:
+		// Elements per block, the decoder keeps a block of every byte plane around. Big enough for building a block's decoding table to not
+		// take long next to decoding it
+		static constexpr uint32_t BLOCK_SIZE = 1 << 15;
+		// Keeps the decoding table at 16 KiB, small enough to stay in the L1 cache. Its entries hold every code that fits in the bits looked up,
+		// up to 6 of the short codes of the high planes come out of one lookup
+		static constexpr uint32_t MAX_CODE_LENGTH = 11;
+		// Each Huffman block is split into this many bit streams that are decoded interleaved, hiding the latency of the table lookups
+		static constexpr uint32_t STREAM_COUNT = 4;
+
+		// Encodes count records of stride bytes as columns of 32-bit words, the stride has to be a multiple of 4
+		[[nodiscard]] static std::vector<std::byte> EncodeWords( const void* records, size_t count, size_t stride );
+		// Encodes count 16-bit or 32-bit indices
+		[[nodiscard]] static std::vector<std::byte> EncodeIndices( const void* indices, size_t count, uint32_t indexSize );
+
+		// Take the same count and stride or index size the data was encoded with and return how many bytes of the input they read.
+		// Throw if the input is corrupt
+		static size_t DecodeWords( std::span<const std::byte> encoded, void* records, size_t count, size_t stride );
+		static size_t DecodeIndices( std::span<const std::byte> encoded, void* indices, size_t count, uint32_t indexSize );
+
+	private:
+		enum class BlockMode : uint8_t
+		{
+			Raw,
+			Constant,
+			Huffman,
+		};
+
+		// Code lengths of the symbols, 0 for symbols that don't occur
+		using CodeLengths = std::array<uint8_t, 256>;
+
+		template <typename Lane>
+		static std::vector<std::byte> Encode( const std::byte* records, size_t count, size_t stride );
+		template <typename Lane>
+		static size_t Decode( std::span<const std::byte> encoded, std::byte* records, size_t count, size_t stride );
+
+		static void EncodeBlock( std::span<const uint8_t> block, std::vector<std::byte>& output );
+		// Returns the number of bytes of the input the block took
+		static size_t DecodeBlock( std::span<const std::byte> encoded, std::span<uint8_t> block );
+
+		static CodeLengths BuildCodeLengths( const std::array<uint32_t, 256>& frequencies );
+	};
+}
@@ -0,0 +1,380 @@
+#include "axe_mesh_optimizer.h"
+
+// std headers
+#include <algorithm>
+#include <numeric>
+
+namespace Axe
+{
+	// FIFO cache simulated with insertion timestamps, a vertex stays cached until cacheSize other vertices were inserted after it
+	class FifoCache
+	{
+	public:
+		FifoCache( const size_t vertexCount, const uint32_t cacheSize )
+			: timestamps( vertexCount, 0 ), cacheSize{ cacheSize }, time{ cacheSize + 1 } {}
+
+		// Returns true on a cache miss
+		bool Access( const uint32_t vertex )
+		{
+			if ( time - timestamps[ vertex ] > cacheSize )
+			{
+				timestamps[ vertex ] = time++;
+				return true;
+			}
+
+			return false;
+		}
+
+		void Flush()
+		{
+			time += cacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32_t> timestamps;
+		uint32_t cacheSize;
+		uint32_t time;
+	};
+
+	AxeMeshOptimizer::CacheStatistics AxeMeshOptimizer::AnalyzeVertexCache( const std::span<const uint32_t> indices, const size_t vertexCount, const uint32_t cacheSize )
+	{
+		FifoCache cache{ vertexCount, cacheSize };
+		std::vector<bool> referenced( vertexCount, false );
+
+		size_t misses = 0;
+		size_t referencedCount = 0;
+
+		for ( const uint32_t index : indices )
+		{
+			misses += cache.Access( index );
+
+			if ( !referenced[ index ] )
+			{
+				referenced[ index ] = true;
+				referencedCount++;
+			}
+		}
+
+		CacheStatistics statistics = {};
+		if ( indices.size() >= 3 )
+		{
+			statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+			statistics.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+		}
+
+		return statistics;
+	}
+
+	void AxeMeshOptimizer::OptimizeVertexCache( const std::span<uint32_t> indices, const size_t vertexCount, const uint32_t cacheSize )
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if ( triangleCount == 0 )
+		{
+			return;
+		}
+
+		// Triangles around each vertex in compressed rows, the row sizes double as the live triangle counts
+		std::vector<uint32_t> liveTriangles( vertexCount, 0 );
+		for ( const uint32_t index : indices )
+		{
+			liveTriangles[ index ]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets( vertexCount + 1, 0 );
+		std::inclusive_scan( liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1 );
+
+		std::vector<uint32_t> adjacency( indices.size() );
+		{
+			std::vector<uint32_t> cursors{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+			for ( size_t i = 0; i < indices.size(); i++ )
+			{
+				adjacency[ cursors[ indices[ i ] ]++ ] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		std::vector<uint32_t> timestamps( vertexCount, 0 );
+		std::vector<bool> emitted( triangleCount, false );
+		std::vector<uint32_t> deadEnds = {};
+		std::vector<uint32_t> candidates = {};
+		std::vector<uint32_t> output = {};
+		output.reserve( indices.size() );
+
+		uint32_t time = cacheSize + 1;
+		size_t scanCursor = 0;
+
+		// Start where the original order did
+		int64_t fanningVertex = indices[ 0 ];
+
+		while ( fanningVertex >= 0 )
+		{
+			candidates.clear();
+
+			// Emit all remaining triangles around the fanning vertex
+			for ( uint32_t i = adjacencyOffsets[ fanningVertex ]; i < adjacencyOffsets[ fanningVertex + 1 ]; i++ )
+			{
+				const uint32_t triangle = adjacency[ i ];
+				if ( emitted[ triangle ] )
+				{
+					continue;
+				}
+
+				for ( uint32_t k = 0; k < 3; k++ )
+				{
+					const uint32_t vertex = indices[ triangle * 3 + k ];
+
+					output.push_back( vertex );
+					deadEnds.push_back( vertex );
+					candidates.push_back( vertex );
+					liveTriangles[ vertex ]--;
+
+					if ( time - timestamps[ vertex ] > cacheSize )
+					{
+						timestamps[ vertex ] = time++;
+					}
+				}
+
+				emitted[ triangle ] = true;
+			}
+
+			// Next fan around the candidate that has been in the cache the longest but will still be in it after emitting its fan
+			fanningVertex = -1;
+			int64_t bestPriority = -1;
+
+			for ( const uint32_t vertex : candidates )
+			{
+				if ( liveTriangles[ vertex ] == 0 )
+				{
+					continue;
+				}
+
+				int64_t priority = 0;
+				if ( time - timestamps[ vertex ] + 2 * liveTriangles[ vertex ] <= cacheSize )
+				{
+					priority = time - timestamps[ vertex ];
+				}
+
+				if ( priority > bestPriority )
+				{
+					bestPriority = priority;
+					fanningVertex = vertex;
+				}
+			}
+
+			// Dead end, go back to a recently used vertex with triangles left, or scan for any such vertex
+			while ( fanningVertex < 0 && !deadEnds.empty() )
+			{
+				const uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+
+				if ( liveTriangles[ vertex ] > 0 )
+				{
+					fanningVertex = vertex;
+				}
+			}
+
+			while ( fanningVertex < 0 && scanCursor < vertexCount )
+			{
+				if ( liveTriangles[ scanCursor ] > 0 )
+				{
+					fanningVertex = static_cast<int64_t>(scanCursor);
+				}
+
+				scanCursor++;
+			}
+		}
+
+		std::ranges::copy( output, indices.begin() );
+	}
+
+	void AxeMeshOptimizer::OptimizeOverdraw(
+		const std::span<uint32_t> indices,
+		const std::span<const AxeModel::Vertex> vertices,
+		const float threshold,
+		const uint32_t cacheSize )
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if ( triangleCount == 0 )
+		{
+			return;
+		}
+
+		// Hard boundaries where the cache order starts over, which is when none of a triangle's vertices are cached
+		std::vector<size_t> hardClusters = {};
+		std::vector<uint32_t> triangleMisses( triangleCount );
+		{
+			FifoCache cache{ vertices.size(), cacheSize };
+
+			for ( size_t triangle = 0; triangle < triangleCount; triangle++ )
+			{
+				triangleMisses[ triangle ] = cache.Access( indices[ triangle * 3 + 0 ] )
+				                             + cache.Access( indices[ triangle * 3 + 1 ] )
+				                             + cache.Access( indices[ triangle * 3 + 2 ] );
+
+				if ( triangle == 0 || triangleMisses[ triangle ] == 3 )
+				{
+					hardClusters.push_back( triangle );
+				}
+			}
+
+			hardClusters.push_back( triangleCount );
+		}
+
+		// Soft boundaries split hard clusters further wherever starting with an empty cache
+		// keeps the vertex cache efficiency within the threshold of the whole hard cluster's
+		std::vector<size_t> clusters = {};
+		{
+			FifoCache cache{ vertices.size(), cacheSize };
+
+			for ( size_t i = 0; i + 1 < hardClusters.size(); i++ )
+			{
+				const size_t begin = hardClusters[ i ];
+				const size_t end = hardClusters[ i + 1 ];
+
+				uint32_t hardClusterMisses = 0;
+				for ( size_t triangle = begin; triangle < end; triangle++ )
+				{
+					hardClusterMisses += triangleMisses[ triangle ];
+				}
+
+				const float maxAcmr = threshold * static_cast<float>(hardClusterMisses) / static_cast<float>(end - begin);
+
+				cache.Flush();
+				clusters.push_back( begin );
+
+				size_t clusterBegin = begin;
+				uint32_t clusterMisses = 0;
+
+				for ( size_t triangle = begin; triangle < end; triangle++ )
+				{
+					clusterMisses += cache.Access( indices[ triangle * 3 + 0 ] )
+					                 + cache.Access( indices[ triangle * 3 + 1 ] )
+					                 + cache.Access( indices[ triangle * 3 + 2 ] );
+
+					const size_t clusterSize = triangle + 1 - clusterBegin;
+					if ( triangle + 1 < end && static_cast<float>(clusterMisses) <= maxAcmr * static_cast<float>(clusterSize) )
+					{
+						cache.Flush();
+						clusters.push_back( triangle + 1 );
+						clusterBegin = triangle + 1;
+						clusterMisses = 0;
+					}
+				}
+			}
+
+			clusters.push_back( triangleCount );
+		}
+
+		const size_t clusterCount = clusters.size() - 1;
+		if ( clusterCount < 2 )
+		{
+			return;
+		}
+
+		// Area weighted centroids and normals
+		std::vector<glm::vec3> clusterCentroids( clusterCount, glm::vec3{ 0.0f } );
+		std::vector<glm::vec3> clusterNormals( clusterCount, glm::vec3{ 0.0f } );
+		std::vector<float> clusterAreas( clusterCount, 0.0f );
+		glm::vec3 meshCentroid{ 0.0f };
+		float meshArea = 0.0f;
+
+		for ( size_t cluster = 0; cluster < clusterCount; cluster++ )
+		{
+			for ( size_t triangle = clusters[ cluster ]; triangle < clusters[ cluster + 1 ]; triangle++ )
+			{
+				const glm::vec3& p0 = vertices[ indices[ triangle * 3 + 0 ] ].position;
+				const glm::vec3& p1 = vertices[ indices[ triangle * 3 + 1 ] ].position;
+				const glm::vec3& p2 = vertices[ indices[ triangle * 3 + 2 ] ].position;
+
+				const glm::vec3 normal = glm::cross( p1 - p0, p2 - p0 );
+				const float area = glm::length( normal );
+				const glm::vec3 centroid = ( p0 + p1 + p2 ) / 3.0f;
+
+				clusterCentroids[ cluster ] += centroid * area;
+				clusterNormals[ cluster ] += normal;
+				clusterAreas[ cluster ] += area;
+			}
+
+			meshCentroid += clusterCentroids[ cluster ];
+			meshArea += clusterAreas[ cluster ];
+		}
+
+		if ( meshArea > 0.0f )
+		{
+			meshCentroid /= meshArea;
+		}
+
+		std::vector<float> sortKeys( clusterCount, 0.0f );
+		for ( size_t cluster = 0; cluster < clusterCount; cluster++ )
+		{
+			const float normalLength = glm::length( clusterNormals[ cluster ] );
+			if ( clusterAreas[ cluster ] > 0.0f && normalLength > 0.0f )
+			{
+				const glm::vec3 centroid = clusterCentroids[ cluster ] / clusterAreas[ cluster ];
+				sortKeys[ cluster ] = glm::dot( centroid - meshCentroid, clusterNormals[ cluster ] / normalLength );
+			}
+		}
+
+		// Clusters on the outside facing away from the center occlude the rest from most directions, so they go first
+		std::vector<size_t> clusterOrder( clusterCount );
+		std::iota( clusterOrder.begin(), clusterOrder.end(), 0 );
+		std::ranges::stable_sort( clusterOrder, [&sortKeys]( const size_t a, const size_t b ) { return sortKeys[ a ] > sortKeys[ b ]; } );
+
+		std::vector<uint32_t> output = {};
+		output.reserve( indices.size() );
+
+		for ( const size_t cluster : clusterOrder )
+		{
+			output.insert( output.end(), indices.begin() + clusters[ cluster ] * 3, indices.begin() + clusters[ cluster + 1 ] * 3 );
+		}
+
+		std::ranges::copy( output, indices.begin() );
+	}
+
+	void AxeMeshOptimizer::OptimizeVertexFetch( std::vector<AxeModel::Vertex>& vertices, const std::span<uint32_t> indices )
+	{
+		constexpr uint32_t UNUSED = UINT32_MAX;
+
+		std::vector<uint32_t> remap( vertices.size(), UNUSED );
+		std::vector<AxeModel::Vertex> orderedVertices = {};
+		orderedVertices.reserve( vertices.size() );
+
+		for ( uint32_t& index : indices )
+		{
+			if ( remap[ index ] == UNUSED )
+			{
+				remap[ index ] = static_cast<uint32_t>(orderedVertices.size());
+				orderedVertices.push_back( vertices[ index ] );
+			}
+
+			index = remap[ index ];
+		}
+
+		vertices = std::move( orderedVertices );
+	}
+
+	AxeMeshOptimizer::Report AxeMeshOptimizer::Optimize( AxeModel::Data& data )
+	{
+		std::vector<AxeModel::Lod> lods = data.lods;
+		if ( lods.empty() )
+		{
+			lods.push_back( { 0, static_cast<uint32_t>(data.indices.size()), 0.0f } );
+		}
+
+		const auto lodIndices = [&data]( const AxeModel::Lod& lod ) { return std::span{ data.indices }.subspan( lod.firstIndex, lod.indexCount ); };
+
+		Report report = {};
+		report.before = AnalyzeVertexCache( lodIndices( lods[ 0 ] ), data.vertices.size() );
+
+		for ( const AxeModel::Lod& lod : lods )
+		{
+			OptimizeVertexCache( lodIndices( lod ), data.vertices.size() );
+			OptimizeOverdraw( lodIndices( lod ), data.vertices );
+		}
+
+		// The finest level comes first in the index buffer, so its vertices end up in the best fetch order
+		OptimizeVertexFetch( data.vertices, data.indices );
+
+		report.after = AnalyzeVertexCache( lodIndices( lods[ 0 ] ), data.vertices.size() );
+		return report;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "axe_model.h"
+
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Reorders index and vertex buffers of triangle lists for the GPU, without changing the rendered result.
+	// The stages are meant to run in the order they are declared in, Optimize runs all of them.
+	class AxeMeshOptimizer
+	{
+	public:
+		// Post transform vertex caches are modelled as FIFO, which is close enough to what GPUs do for reordering purposes
+		static constexpr uint32_t CACHE_SIZE = 16;
+		// Vertex cache efficiency the overdraw clustering may give up, 1.05 allows 5% more vertex shader invocations
+		static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+		struct CacheStatistics
+		{
+			float acmr = 0.0f;	// Average cache miss ratio, vertex shader invocations per triangle. 0.5 is ideal for large meshes, 3 is the worst
+			float atvr = 0.0f;	// Average transformed vertex ratio, vertex shader invocations per vertex. 1 is ideal
+		};
+
+		struct Report
+		{
+			CacheStatistics before = {};
+			CacheStatistics after = {};
+		};
+
+		[[nodiscard]] static CacheStatistics AnalyzeVertexCache( std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE );
+
+		// Reorders triangles for vertex cache locality with Tipsify (Sander et al. 2007), keeping each triangle's winding
+		static void OptimizeVertexCache( std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE );
+
+		// Splits cache optimized triangles into clusters and draws outward facing clusters first, so early depth testing rejects more of the rest
+		static void OptimizeOverdraw(
+			std::span<uint32_t> indices,
+			std::span<const AxeModel::Vertex> vertices,
+			float threshold = OVERDRAW_THRESHOLD,
+			uint32_t cacheSize = CACHE_SIZE );
+
+		// Orders vertices by first use in the index buffer, dropping unreferenced ones
+		static void OptimizeVertexFetch( std::vector<AxeModel::Vertex>& vertices, std::span<uint32_t> indices );
+
+		// Optimizes every level of detail on its own, the report covers the finest one
+		static Report Optimize( AxeModel::Data& data );
+	};
+}
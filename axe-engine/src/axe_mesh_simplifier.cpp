@@ -0,0 +1,439 @@
+#include "axe_mesh_simplifier.h"
+
+#include "axe_vertex_welder.h"
+
+// std headers
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+namespace Axe
+{
+	// Open borders get planes perpendicular to the surface, weighted well above the surface planes so silhouettes of open meshes stay in place
+	static constexpr double BORDER_WEIGHT = 10.0;
+	// Passes that remove less than 1% of the triangles end the simplification early
+	static constexpr size_t MIN_PASS_REDUCTION_DIVISOR = 100;
+
+	// ####   Quadrics   ####
+
+	// Symmetric 4x4 matrix summing up squared distances to a set of weighted planes
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// Plane through point with a unit length normal
+		static Quadric FromPlane( const glm::dvec3& normal, const glm::dvec3& point, const double weight )
+		{
+			const double d = -glm::dot( normal, point );
+
+			Quadric quadric = {};
+			quadric.a00 = normal.x * normal.x * weight;
+			quadric.a01 = normal.x * normal.y * weight;
+			quadric.a02 = normal.x * normal.z * weight;
+			quadric.a11 = normal.y * normal.y * weight;
+			quadric.a12 = normal.y * normal.z * weight;
+			quadric.a22 = normal.z * normal.z * weight;
+			quadric.b0 = normal.x * d * weight;
+			quadric.b1 = normal.y * d * weight;
+			quadric.b2 = normal.z * d * weight;
+			quadric.c = d * d * weight;
+			quadric.weight = weight;
+			return quadric;
+		}
+
+		Quadric& operator+=( const Quadric& other )
+		{
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+
+		// Weighted mean of the squared distances
+		[[nodiscard]] double Evaluate( const glm::dvec3& p ) const
+		{
+			if ( weight <= 0.0 )
+			{
+				return 0.0;
+			}
+
+			const double error = p.x * ( a00 * p.x + a01 * p.y + a02 * p.z )
+			                     + p.y * ( a01 * p.x + a11 * p.y + a12 * p.z )
+			                     + p.z * ( a02 * p.x + a12 * p.y + a22 * p.z )
+			                     + 2.0 * ( b0 * p.x + b1 * p.y + b2 * p.z )
+			                     + c;
+
+			return std::max( error, 0.0 ) / weight;
+		}
+	};
+
+	static Quadric operator+( Quadric a, const Quadric& b )
+	{
+		return a += b;
+	}
+
+	// ####   Simplification   ####
+
+	// The vertex at the collapse target that best matches the attributes of the corner's old vertex
+	static uint32_t PickWedge( const std::span<const AxeModel::Vertex> vertices, const std::span<const uint32_t> wedges, const AxeModel::Vertex& original )
+	{
+		uint32_t bestWedge = wedges[ 0 ];
+		float bestScore = -std::numeric_limits<float>::max();
+
+		for ( const uint32_t wedge : wedges )
+		{
+			const AxeModel::Vertex& vertex = vertices[ wedge ];
+			const float score = glm::dot( vertex.normal, original.normal )
+			                    - glm::distance( vertex.uv, original.uv )
+			                    - glm::distance( vertex.color, original.color );
+
+			if ( score > bestScore )
+			{
+				bestScore = score;
+				bestWedge = wedge;
+			}
+		}
+
+		return bestWedge;
+	}
+
+	AxeMeshSimplifier::Result AxeMeshSimplifier::Simplify(
+		const std::span<const AxeModel::Vertex> vertices,
+		const std::span<const uint32_t> indices,
+		const size_t targetIndexCount,
+		const float maxError )
+	{
+		Result result = {};
+		result.indices.assign( indices.begin(), indices.end() );
+
+		if ( result.indices.size() <= targetIndexCount )
+		{
+			return result;
+		}
+
+		// Topology comes from positions alone, vertices that only differ in their attributes are "wedges" of the same position
+		std::vector<AxeModel::Vertex> positions = {};
+		std::vector<uint32_t> positionIds( vertices.size() );
+		{
+			AxeVertexWelder::Table table{ positions, vertices.size() };
+			for ( size_t i = 0; i < vertices.size(); i++ )
+			{
+				AxeModel::Vertex position = {};
+				position.position = vertices[ i ].position;
+				positionIds[ i ] = table.Insert( position );
+			}
+		}
+
+		const size_t positionCount = positions.size();
+		const auto positionOf = [&positions]( const uint32_t id ) { return glm::dvec3{ positions[ id ].position }; };
+
+		std::vector<uint32_t> wedgeOffsets( positionCount + 1, 0 );
+		std::vector<uint32_t> wedges( vertices.size() );
+		{
+			for ( const uint32_t id : positionIds )
+			{
+				wedgeOffsets[ id + 1 ]++;
+			}
+
+			std::inclusive_scan( wedgeOffsets.begin(), wedgeOffsets.end(), wedgeOffsets.begin() );
+
+			std::vector<uint32_t> cursors{ wedgeOffsets.begin(), wedgeOffsets.end() - 1 };
+			for ( uint32_t i = 0; i < vertices.size(); i++ )
+			{
+				wedges[ cursors[ positionIds[ i ] ]++ ] = i;
+			}
+		}
+
+		// Triangle planes weighted by area, plus planes along the open borders
+		std::vector<Quadric> quadrics( positionCount );
+		{
+			const auto edgeKey = []( const uint32_t a, const uint32_t b ) { return static_cast<uint64_t>(std::min( a, b )) << 32 | std::max( a, b ); };
+
+			std::unordered_map<uint64_t, uint32_t> edgeUses = {};
+			edgeUses.reserve( result.indices.size() );
+
+			for ( size_t i = 0; i < result.indices.size(); i += 3 )
+			{
+				for ( size_t k = 0; k < 3; k++ )
+				{
+					edgeUses[ edgeKey( positionIds[ result.indices[ i + k ] ], positionIds[ result.indices[ i + ( k + 1 ) % 3 ] ] ) ]++;
+				}
+			}
+
+			for ( size_t i = 0; i < result.indices.size(); i += 3 )
+			{
+				const uint32_t ids[ 3 ] = {
+					positionIds[ result.indices[ i + 0 ] ],
+					positionIds[ result.indices[ i + 1 ] ],
+					positionIds[ result.indices[ i + 2 ] ],
+				};
+
+				const glm::dvec3 p0 = positionOf( ids[ 0 ] );
+				const glm::dvec3 normal = glm::cross( positionOf( ids[ 1 ] ) - p0, positionOf( ids[ 2 ] ) - p0 );
+				const double doubleArea = glm::length( normal );
+				if ( doubleArea <= 0.0 )
+				{
+					continue;
+				}
+
+				const glm::dvec3 unitNormal = normal / doubleArea;
+				const Quadric plane = Quadric::FromPlane( unitNormal, p0, doubleArea * 0.5 );
+
+				for ( const uint32_t id : ids )
+				{
+					quadrics[ id ] += plane;
+				}
+
+				for ( size_t k = 0; k < 3; k++ )
+				{
+					const uint32_t a = ids[ k ];
+					const uint32_t b = ids[ ( k + 1 ) % 3 ];
+					if ( edgeUses[ edgeKey( a, b ) ] != 1 )
+					{
+						continue;
+					}
+
+					const glm::dvec3 edge = positionOf( b ) - positionOf( a );
+					const glm::dvec3 borderNormal = glm::normalize( glm::cross( edge, unitNormal ) );
+					const Quadric border = Quadric::FromPlane( borderNormal, positionOf( a ), glm::dot( edge, edge ) * BORDER_WEIGHT );
+
+					quadrics[ a ] += border;
+					quadrics[ b ] += border;
+				}
+			}
+		}
+
+		struct Collapse
+		{
+			uint32_t from = 0;
+			uint32_t to = 0;
+			double cost = 0.0;
+		};
+
+		std::vector<Collapse> collapses = {};
+		std::vector<uint32_t> collapseTargets( positionCount );
+		std::vector<bool> locked( positionCount );
+		std::vector<uint32_t> adjacencyOffsets( positionCount + 1 );
+		std::vector<uint32_t> adjacency = {};
+
+		const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+		const size_t targetTriangleCount = targetIndexCount / 3;
+		double maxCollapseCost = 0.0;
+
+		// Each pass collapses a set of edges whose neighbourhoods don't overlap, cheapest first, then rebuilds the index buffer
+		while ( result.indices.size() / 3 > targetTriangleCount )
+		{
+			const size_t triangleCount = result.indices.size() / 3;
+			const auto cornerPosition = [&]( const size_t corner ) { return positionIds[ result.indices[ corner ] ]; };
+
+			// Interior edges show up twice, the second one is skipped once the first collapsed or locked its ends
+			collapses.clear();
+			for ( size_t i = 0; i < result.indices.size(); i += 3 )
+			{
+				for ( size_t k = 0; k < 3; k++ )
+				{
+					const uint32_t a = cornerPosition( i + k );
+					const uint32_t b = cornerPosition( i + ( k + 1 ) % 3 );
+
+					const Quadric quadric = quadrics[ a ] + quadrics[ b ];
+					const double costToB = quadric.Evaluate( positionOf( b ) );
+					const double costToA = quadric.Evaluate( positionOf( a ) );
+
+					collapses.push_back( costToB <= costToA ? Collapse{ a, b, costToB } : Collapse{ b, a, costToA } );
+				}
+			}
+
+			std::ranges::sort( collapses, {}, &Collapse::cost );
+
+			std::ranges::fill( adjacencyOffsets, 0 );
+			for ( size_t i = 0; i < result.indices.size(); i++ )
+			{
+				adjacencyOffsets[ cornerPosition( i ) + 1 ]++;
+			}
+
+			std::inclusive_scan( adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin() );
+
+			adjacency.resize( result.indices.size() );
+			{
+				std::vector<uint32_t> cursors{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+				for ( size_t i = 0; i < result.indices.size(); i++ )
+				{
+					adjacency[ cursors[ cornerPosition( i ) ]++ ] = static_cast<uint32_t>(i / 3);
+				}
+			}
+
+			const auto trianglesAround = [&]( const uint32_t position )
+			{
+				return std::span{ adjacency }.subspan( adjacencyOffsets[ position ], adjacencyOffsets[ position + 1 ] - adjacencyOffsets[ position ] );
+			};
+
+			// Rejects collapses that would flip or flatten a triangle that stays
+			const auto keepsOrientation = [&]( const Collapse& collapse )
+			{
+				for ( const uint32_t triangle : trianglesAround( collapse.from ) )
+				{
+					glm::dvec3 before[ 3 ];
+					glm::dvec3 after[ 3 ];
+					bool removed = false;
+
+					for ( size_t k = 0; k < 3; k++ )
+					{
+						const uint32_t position = cornerPosition( triangle * 3 + k );
+						removed |= position == collapse.to;
+						before[ k ] = positionOf( position );
+						after[ k ] = position == collapse.from ? positionOf( collapse.to ) : before[ k ];
+					}
+
+					if ( removed )
+					{
+						continue;
+					}
+
+					const glm::dvec3 normalBefore = glm::cross( before[ 1 ] - before[ 0 ], before[ 2 ] - before[ 0 ] );
+					const glm::dvec3 normalAfter = glm::cross( after[ 1 ] - after[ 0 ], after[ 2 ] - after[ 0 ] );
+					if ( glm::dot( normalBefore, normalAfter ) <= 0.0 )
+					{
+						return false;
+					}
+				}
+
+				return true;
+			};
+
+			std::iota( collapseTargets.begin(), collapseTargets.end(), 0 );
+			std::fill( locked.begin(), locked.end(), false );
+
+			// Only the cheaper half of the edges per pass, the rest get another chance once their neighbourhood changed
+			const size_t passCollapseLimit = collapses.size() / 2 + 1;
+			const size_t trianglesToRemove = triangleCount - targetTriangleCount;
+			size_t removedTriangles = 0;
+			size_t collapseCount = 0;
+
+			for ( size_t i = 0; i < passCollapseLimit && removedTriangles < trianglesToRemove; i++ )
+			{
+				const Collapse& collapse = collapses[ i ];
+				if ( collapse.cost > maxCost )
+				{
+					break;
+				}
+
+				if ( locked[ collapse.from ] || locked[ collapse.to ] || !keepsOrientation( collapse ) )
+				{
+					continue;
+				}
+
+				// Everything around both ends changes shape, so none of it may collapse again this pass
+				for ( const uint32_t position : { collapse.from, collapse.to } )
+				{
+					for ( const uint32_t triangle : trianglesAround( position ) )
+					{
+						for ( size_t k = 0; k < 3; k++ )
+						{
+							locked[ cornerPosition( triangle * 3 + k ) ] = true;
+						}
+					}
+				}
+
+				for ( const uint32_t triangle : trianglesAround( collapse.from ) )
+				{
+					for ( size_t k = 0; k < 3; k++ )
+					{
+						removedTriangles += cornerPosition( triangle * 3 + k ) == collapse.to;
+					}
+				}
+
+				collapseTargets[ collapse.from ] = collapse.to;
+				quadrics[ collapse.to ] += quadrics[ collapse.from ];
+				maxCollapseCost = std::max( maxCollapseCost, collapse.cost );
+				collapseCount++;
+			}
+
+			if ( collapseCount == 0 )
+			{
+				break;
+			}
+
+			// Move the corners of collapsed positions over to a wedge at the target and drop the triangles that became degenerate
+			size_t writeIndex = 0;
+			for ( size_t i = 0; i < result.indices.size(); i += 3 )
+			{
+				uint32_t triangle[ 3 ];
+				for ( size_t k = 0; k < 3; k++ )
+				{
+					const uint32_t vertex = result.indices[ i + k ];
+					const uint32_t target = collapseTargets[ positionIds[ vertex ] ];
+
+					triangle[ k ] = target == positionIds[ vertex ]
+						                ? vertex
+						                : PickWedge( vertices, std::span{ wedges }.subspan( wedgeOffsets[ target ], wedgeOffsets[ target + 1 ] - wedgeOffsets[ target ] ), vertices[ vertex ] );
+				}
+
+				const uint32_t p0 = positionIds[ triangle[ 0 ] ];
+				const uint32_t p1 = positionIds[ triangle[ 1 ] ];
+				const uint32_t p2 = positionIds[ triangle[ 2 ] ];
+				if ( p0 == p1 || p1 == p2 || p2 == p0 )
+				{
+					continue;
+				}
+
+				std::ranges::copy( triangle, result.indices.begin() + static_cast<ptrdiff_t>(writeIndex) );
+				writeIndex += 3;
+			}
+
+			result.indices.resize( writeIndex );
+
+			// Meshes that only lose a sliver per pass, like triangle soups where every edge is an open border, aren't worth the passes
+			if ( removedTriangles < trianglesToRemove && removedTriangles * MIN_PASS_REDUCTION_DIVISOR < triangleCount )
+			{
+				break;
+			}
+		}
+
+		result.error = static_cast<float>(std::sqrt( maxCollapseCost ));
+		return result;
+	}
+
+	// ####   Levels of detail   ####
+
+	void AxeMeshSimplifier::GenerateLods( AxeModel::Data& data )
+	{
+		data.lods.clear();
+		data.lods.push_back( { 0, static_cast<uint32_t>(data.indices.size()), 0.0f } );
+
+		std::vector<uint32_t> previousIndices = data.indices;
+		float error = 0.0f;
+
+		while ( data.lods.size() < AxeModel::MAX_LODS )
+		{
+			const auto targetTriangleCount = static_cast<size_t>(static_cast<float>(previousIndices.size() / 3) * LOD_REDUCTION);
+			if ( targetTriangleCount < MIN_LOD_TRIANGLES )
+			{
+				break;
+			}
+
+			Result simplified = Simplify( data.vertices, previousIndices, targetTriangleCount * 3 );
+			if ( static_cast<float>(simplified.indices.size()) > static_cast<float>(previousIndices.size()) * MIN_LOD_REDUCTION )
+			{
+				break;
+			}
+
+			// Each level is simplified from the one before it, so the distances to the original add up at most
+			error += simplified.error;
+
+			data.lods.push_back( { static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(simplified.indices.size()), error } );
+			data.indices.insert( data.indices.end(), simplified.indices.begin(), simplified.indices.end() );
+			previousIndices = std::move( simplified.indices );
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "axe_model.h"
+
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Quadric error edge collapse simplification (Garland & Heckbert 1997) that only produces new index buffers.
+	// Vertices collapse onto one of their neighbours instead of an optimal new position, so every level of detail can share the original vertex buffer.
+	class AxeMeshSimplifier
+	{
+	public:
+		// Every level aims for half the triangles of the one before it
+		static constexpr float LOD_REDUCTION = 0.5f;
+		// Levels that can't get below this share of the previous level's triangles aren't worth the memory
+		static constexpr float MIN_LOD_REDUCTION = 0.8f;
+		static constexpr size_t MIN_LOD_TRIANGLES = 64;
+
+		struct Result
+		{
+			std::vector<uint32_t> indices = {};
+			float error = 0.0f;	// Largest distance a collapse moved the surface, in the units of the vertex positions
+		};
+
+		// Collapses edges in order of increasing error until the index count is at most the target or the next collapse would exceed maxError.
+		// Vertices at the same position are simplified as one, so attribute seams don't crack.
+		[[nodiscard]] static Result Simplify(
+			std::span<const AxeModel::Vertex> vertices,
+			std::span<const uint32_t> indices,
+			size_t targetIndexCount,
+			float maxError = std::numeric_limits<float>::max() );
+
+		// Appends up to MAX_LODS - 1 simplified index buffers to the data's indices and fills in its levels of detail
+		static void GenerateLods( AxeModel::Data& data );
+	};
+}
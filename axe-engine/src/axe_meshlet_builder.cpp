@@ -0,0 +1,289 @@
+#include "axe_meshlet_builder.h"
+
+#include "axe_mesh_optimizer.h"
+#include "axe_vertex_welder.h"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace Axe
+{
+	void AxeMeshletBuilder::Build( AxeModel::Data& data )
+	{
+		data.meshlets.clear();
+
+		const uint32_t firstIndex = data.lods.empty() ? 0 : data.lods[ 0 ].firstIndex;
+		const uint32_t indexCount = data.lods.empty() ? static_cast<uint32_t>(data.indices.size()) : data.lods[ 0 ].indexCount;
+		const uint32_t triangleCount = indexCount / 3;
+		const std::span<uint32_t> indices{ data.indices.data() + firstIndex, static_cast<size_t>(triangleCount) * 3 };
+
+		if ( triangleCount == 0 )
+		{
+			return;
+		}
+
+		// Adjacency comes from positions alone, so meshlets also grow across attribute seams and flat shaded edges
+		std::vector<AxeModel::Vertex> positions = {};
+		std::vector<uint32_t> positionIds( data.vertices.size() );
+		{
+			AxeVertexWelder::Table table{ positions, data.vertices.size() };
+			for ( size_t i = 0; i < data.vertices.size(); i++ )
+			{
+				AxeModel::Vertex position = {};
+				position.position = data.vertices[ i ].position;
+				positionIds[ i ] = table.Insert( position );
+			}
+		}
+
+		std::vector<uint32_t> triangleOffsets( positions.size() + 1, 0 );
+		std::vector<uint32_t> positionTriangles( indices.size() );
+		{
+			for ( const uint32_t index : indices )
+			{
+				triangleOffsets[ positionIds[ index ] + 1 ]++;
+			}
+
+			std::inclusive_scan( triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin() );
+
+			std::vector<uint32_t> cursors{ triangleOffsets.begin(), triangleOffsets.end() - 1 };
+			for ( uint32_t i = 0; i < indices.size(); i++ )
+			{
+				positionTriangles[ cursors[ positionIds[ indices[ i ] ] ]++ ] = i / 3;
+			}
+		}
+
+		std::vector<glm::vec3> normals( triangleCount );
+		for ( uint32_t triangle = 0; triangle < triangleCount; triangle++ )
+		{
+			const glm::vec3& a = data.vertices[ indices[ triangle * 3 ] ].position;
+			const glm::vec3& b = data.vertices[ indices[ triangle * 3 + 1 ] ].position;
+			const glm::vec3& c = data.vertices[ indices[ triangle * 3 + 2 ] ].position;
+
+			const glm::vec3 normal = glm::cross( b - a, c - a );
+			const float length = glm::length( normal );
+			normals[ triangle ] = length > 0.0f ? normal / length : glm::vec3{ 0.0f };
+		}
+
+		// Which meshlet last used each vertex or listed each triangle as a candidate, so neither needs a per-meshlet set
+		constexpr uint32_t NO_MESHLET = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> vertexMeshlet( data.vertices.size(), NO_MESHLET );
+		std::vector<uint32_t> candidateMeshlet( triangleCount, NO_MESHLET );
+		std::vector<bool> emitted( triangleCount, false );
+
+		std::vector<uint32_t> meshletIndices = {};
+		meshletIndices.reserve( indices.size() );
+		std::vector<uint32_t> candidates = {};
+
+		uint32_t seed = 0;
+		while ( true )
+		{
+			// Seeds follow the existing triangle order, which keeps consecutive meshlets close together
+			while ( seed < triangleCount && emitted[ seed ] )
+			{
+				seed++;
+			}
+
+			if ( seed == triangleCount )
+			{
+				break;
+			}
+
+			const auto meshletId = static_cast<uint32_t>(data.meshlets.size());
+
+			AxeModel::Meshlet meshlet = {};
+			meshlet.firstIndex = firstIndex + static_cast<uint32_t>(meshletIndices.size());
+			uint32_t meshletVertexCount = 0;
+			glm::vec3 normalSum{ 0.0f };
+			candidates.clear();
+
+			const auto countNewVertices = [&]( const uint32_t triangle )
+			{
+				const uint32_t a = indices[ triangle * 3 ];
+				const uint32_t b = indices[ triangle * 3 + 1 ];
+				const uint32_t c = indices[ triangle * 3 + 2 ];
+
+				return static_cast<uint32_t>(vertexMeshlet[ a ] != meshletId)
+				       + static_cast<uint32_t>(vertexMeshlet[ b ] != meshletId && b != a)
+				       + static_cast<uint32_t>(vertexMeshlet[ c ] != meshletId && c != a && c != b);
+			};
+
+			uint32_t triangle = seed;
+			while ( true )
+			{
+				meshletVertexCount += countNewVertices( triangle );
+				normalSum += normals[ triangle ];
+				emitted[ triangle ] = true;
+				meshlet.indexCount += 3;
+
+				for ( uint32_t k = 0; k < 3; k++ )
+				{
+					const uint32_t index = indices[ triangle * 3 + k ];
+					vertexMeshlet[ index ] = meshletId;
+					meshletIndices.push_back( index );
+
+					const uint32_t positionId = positionIds[ index ];
+					for ( uint32_t i = triangleOffsets[ positionId ]; i < triangleOffsets[ positionId + 1 ]; i++ )
+					{
+						const uint32_t neighbour = positionTriangles[ i ];
+						if ( !emitted[ neighbour ] && candidateMeshlet[ neighbour ] != meshletId )
+						{
+							candidateMeshlet[ neighbour ] = meshletId;
+							candidates.push_back( neighbour );
+						}
+					}
+				}
+
+				if ( meshlet.indexCount == MAX_MESHLET_TRIANGLES * 3 )
+				{
+					break;
+				}
+
+				// Fewest new vertices first so the vertex limit isn't hit early, then the triangle facing closest to the meshlet's average so its cone stays narrow
+				const float normalSumLength = glm::length( normalSum );
+				const glm::vec3 axis = normalSumLength > 0.0f ? normalSum / normalSumLength : glm::vec3{ 0.0f };
+
+				uint32_t bestTriangle = NO_MESHLET;
+				float bestScore = std::numeric_limits<float>::max();
+
+				std::erase_if( candidates, [&]( const uint32_t candidate ) { return emitted[ candidate ]; } );
+				for ( const uint32_t candidate : candidates )
+				{
+					const uint32_t newVertices = countNewVertices( candidate );
+					if ( meshletVertexCount + newVertices > MAX_MESHLET_VERTICES )
+					{
+						continue;
+					}
+
+					const float score = static_cast<float>(newVertices) + CONE_WEIGHT * ( 1.0f - glm::dot( normals[ candidate ], axis ) );
+					if ( score < bestScore )
+					{
+						bestScore = score;
+						bestTriangle = candidate;
+					}
+				}
+
+				if ( bestTriangle == NO_MESHLET )
+				{
+					break;
+				}
+
+				triangle = bestTriangle;
+			}
+
+			data.meshlets.push_back( meshlet );
+		}
+
+		std::ranges::copy( meshletIndices, indices.begin() );
+
+		// Growth order isn't vertex cache order, each meshlet is reordered on its own through indices local to it
+		std::vector<uint32_t> localIds( data.vertices.size(), NO_MESHLET );
+		std::vector<uint32_t> localVertices = {};
+		std::vector<uint32_t> localIndices = {};
+
+		for ( AxeModel::Meshlet& meshlet : data.meshlets )
+		{
+			const std::span<uint32_t> range{ data.indices.data() + meshlet.firstIndex, meshlet.indexCount };
+
+			localVertices.clear();
+			localIndices.clear();
+			for ( const uint32_t index : range )
+			{
+				if ( localIds[ index ] == NO_MESHLET )
+				{
+					localIds[ index ] = static_cast<uint32_t>(localVertices.size());
+					localVertices.push_back( index );
+				}
+
+				localIndices.push_back( localIds[ index ] );
+			}
+
+			AxeMeshOptimizer::OptimizeVertexCache( localIndices, localVertices.size() );
+
+			for ( size_t i = 0; i < range.size(); i++ )
+			{
+				range[ i ] = localVertices[ localIndices[ i ] ];
+			}
+
+			for ( const uint32_t index : localVertices )
+			{
+				localIds[ index ] = NO_MESHLET;
+			}
+
+			ComputeBounds( meshlet, data.vertices, data.indices );
+		}
+	}
+
+	void AxeMeshletBuilder::ComputeBounds(
+		AxeModel::Meshlet& meshlet,
+		const std::span<const AxeModel::Vertex> vertices,
+		const std::span<const uint32_t> indices )
+	{
+		const std::span<const uint32_t> meshletIndices = indices.subspan( meshlet.firstIndex, meshlet.indexCount );
+
+		// Centered on the bounding box, which is within a few percent of the minimal sphere for the compact shapes meshlets have
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		for ( const uint32_t index : meshletIndices )
+		{
+			boundsMin = glm::min( boundsMin, vertices[ index ].position );
+			boundsMax = glm::max( boundsMax, vertices[ index ].position );
+		}
+
+		meshlet.center = ( boundsMin + boundsMax ) * 0.5f;
+		meshlet.radius = 0.0f;
+		for ( const uint32_t index : meshletIndices )
+		{
+			meshlet.radius = std::max( meshlet.radius, glm::length( vertices[ index ].position - meshlet.center ) );
+		}
+
+		// Face normals rather than vertex normals, the cone has to hold for the triangles themselves
+		std::vector<glm::vec3> normals = {};
+		normals.reserve( meshletIndices.size() / 3 );
+		for ( size_t i = 0; i + 2 < meshletIndices.size(); i += 3 )
+		{
+			const glm::vec3& a = vertices[ meshletIndices[ i ] ].position;
+			const glm::vec3& b = vertices[ meshletIndices[ i + 1 ] ].position;
+			const glm::vec3& c = vertices[ meshletIndices[ i + 2 ] ].position;
+
+			const glm::vec3 normal = glm::cross( b - a, c - a );
+			const float length = glm::length( normal );
+			if ( length > 0.0f )
+			{
+				normals.push_back( normal / length );
+			}
+		}
+
+		meshlet.coneAxis = {};
+		meshlet.coneCutoff = 1.0f;
+
+		glm::vec3 axis{ 0.0f };
+		for ( const glm::vec3& normal : normals )
+		{
+			axis += normal;
+		}
+
+		const float axisLength = glm::length( axis );
+		if ( axisLength <= 0.0f )
+		{
+			return;
+		}
+
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for ( const glm::vec3& normal : normals )
+		{
+			minDot = std::min( minDot, glm::dot( normal, axis ) );
+		}
+
+		meshlet.coneAxis = axis;
+		if ( minDot > MIN_CONE_DOT )
+		{
+			meshlet.coneCutoff = std::sqrt( 1.0f - minDot * minDot );
+		}
+	}
+}
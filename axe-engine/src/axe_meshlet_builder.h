@@ -0,0 +1,27 @@
+#pragma once
+
+#include "axe_model.h"
+
+#include <span>
+
+namespace Axe
+{
+	// Splits the finest level of detail into meshlets that fit the usual mesh shader limits and gives each one the bounds needed to cull it as a whole
+	class AxeMeshletBuilder
+	{
+	public:
+		static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+		static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+		// How many new vertices a triangle facing perpendicular to the meshlet is worth when choosing the next triangle to add
+		static constexpr float CONE_WEIGHT = 2.0f;
+		// Meshlets whose triangles face this far apart can never be backface culled, so they don't get a cone
+		static constexpr float MIN_CONE_DOT = 0.1f;
+
+		// Grows meshlets greedily over neighbouring triangles and reorders the finest level's indices so every meshlet is a contiguous range.
+		// Replaces the data's meshlets, the finest level is the whole index buffer if the data has no levels of detail.
+		static void Build( AxeModel::Data& data );
+
+		// Bounding sphere and normal cone of the triangles in the meshlet's index range
+		static void ComputeBounds( AxeModel::Meshlet& meshlet, std::span<const AxeModel::Vertex> vertices, std::span<const uint32_t> indices );
+	};
+}
@@ -0,0 +1,75 @@
+#include "axe_meshlet_culler.h"
+
+namespace Axe
+{
+	float AxeMeshletCuller::Statistics::GetCulledPercentage() const
+	{
+		if ( meshletCount == 0 )
+		{
+			return 0.0f;
+		}
+
+		return 100.0f * static_cast<float>(frustumCulledCount + backfaceCulledCount) / static_cast<float>(meshletCount);
+	}
+
+	std::array<glm::vec4, 6> AxeMeshletCuller::TransformPlanes( const std::array<glm::vec4, 6>& planes, const glm::mat4& modelMatrix )
+	{
+		// A plane p transforms with the transpose of the matrix mapping object space points into its space, dot(p, M * x) = dot(transpose(M) * p, x)
+		const glm::mat4 transposedModelMatrix = glm::transpose( modelMatrix );
+
+		std::array<glm::vec4, 6> objectPlanes = {};
+		for ( size_t i = 0; i < planes.size(); i++ )
+		{
+			objectPlanes[ i ] = transposedModelMatrix * planes[ i ];
+			objectPlanes[ i ] /= glm::length( glm::vec3{ objectPlanes[ i ] } );
+		}
+
+		return objectPlanes;
+	}
+
+	void AxeMeshletCuller::Cull(
+		const std::span<const AxeModel::Meshlet> meshlets,
+		const std::array<glm::vec4, 6>& planes,
+		const glm::vec3& cameraPosition,
+		std::vector<DrawRange>& drawRanges,
+		Statistics& statistics )
+	{
+		const size_t firstDrawRange = drawRanges.size();
+
+		for ( const AxeModel::Meshlet& meshlet : meshlets )
+		{
+			statistics.meshletCount++;
+
+			bool outside = false;
+			for ( const glm::vec4& plane : planes )
+			{
+				outside |= glm::dot( glm::vec3{ plane }, meshlet.center ) + plane.w < -meshlet.radius;
+			}
+
+			if ( outside )
+			{
+				statistics.frustumCulledCount++;
+				continue;
+			}
+
+			// Every triangle faces away when the direction to the sphere is within the cone's complement, widened by the sphere's radius
+			const glm::vec3 toCenter = meshlet.center - cameraPosition;
+			if ( glm::dot( toCenter, meshlet.coneAxis ) >= meshlet.coneCutoff * glm::length( toCenter ) + meshlet.radius )
+			{
+				statistics.backfaceCulledCount++;
+				continue;
+			}
+
+			if ( drawRanges.size() > firstDrawRange && drawRanges.back().firstIndex + drawRanges.back().indexCount == meshlet.firstIndex )
+			{
+				drawRanges.back().indexCount += meshlet.indexCount;
+			}
+			else
+			{
+				drawRanges.push_back( { meshlet.firstIndex, meshlet.indexCount } );
+			}
+		}
+
+		statistics.drawCount += static_cast<uint32_t>(drawRanges.size() - firstDrawRange);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "axe_model.h"
+
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Rejects whole meshlets outside the view frustum or facing away from the camera, and merges the index ranges of the rest into as few draws as possible
+	class AxeMeshletCuller
+	{
+	public:
+		// A compacted range of the model's indices, neighbouring visible meshlets share one
+		struct DrawRange
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		struct Statistics
+		{
+			uint32_t meshletCount = 0;
+			uint32_t frustumCulledCount = 0;
+			uint32_t backfaceCulledCount = 0;
+			uint32_t drawCount = 0;
+
+			[[nodiscard]] float GetCulledPercentage() const;
+		};
+
+		// Moves world space frustum planes, as returned by AxeCamera::GetFrustumPlanes, into a model's object space. Culling there keeps the bounds exact
+		// under non-uniform scaling, which only has to be undone for the planes instead of for every meshlet.
+		[[nodiscard]] static std::array<glm::vec4, 6> TransformPlanes( const std::array<glm::vec4, 6>& planes, const glm::mat4& modelMatrix );
+
+		// Planes and camera position are in the meshlets' object space. Appends the visible ranges in index order and adds to the statistics.
+		static void Cull(
+			std::span<const AxeModel::Meshlet> meshlets,
+			const std::array<glm::vec4, 6>& planes,
+			const glm::vec3& cameraPosition,
+			std::vector<DrawRange>& drawRanges,
+			Statistics& statistics );
+	};
+}
@@ -1,74 +1,210 @@
 ﻿#include "axe_model.h"
 
-#include "axe_utils.h"
+#include "axe_mesh_cache.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#include <glm/gtx/hash.hpp>
-
-#include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <unordered_map>
+#include <cmath>
+#include <iostream>
 
-namespace std
+namespace Axe
 {
-	template <>
-	struct hash<Axe::AxeModel::Vertex>
+	// AxeAssetRegistry::LoadModel creates models on whichever thread asks for them, several can do so at once
+	static uint32_t NextModelId()
 	{
-		size_t operator()( const Axe::AxeModel::Vertex& vertex ) const noexcept
+		static std::atomic<uint32_t> nextId = 0;
+		return nextId++;
+	}
+
+	AxeModel::AxeModel( AxeGeometryPool& geometryPool, const Data& data, const VertexFormat vertexFormat )
+		: AxeModel{ geometryPool, data.vertices, data.indices, data.boundsMin, data.boundsMax, data.lods, data.meshlets, vertexFormat } {}
+
+	AxeModel::AxeModel(
+		AxeGeometryPool& geometryPool,
+		const std::span<const Vertex> vertices,
+		const std::span<const uint32_t> indices,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		const std::span<const Lod> lods,
+		const std::span<const Meshlet> meshlets,
+		const VertexFormat vertexFormat )
+		: axeGeometryPool{ geometryPool },
+		  id{ NextModelId() },
+		  lods{ lods.begin(), lods.end() },
+		  meshlets{ meshlets.begin(), meshlets.end() },
+		  vertexFormat{ vertexFormat },
+		  boundsMin{ boundsMin },
+		  boundsMax{ boundsMax }
+	{
+		AllocateGeometry( vertices, indices );
+	}
+
+	AxeModel::AxeModel(
+		AxeGeometryPool& geometryPool,
+		const std::span<const Vertex> vertices,
+		const std::span<const uint16_t> indices,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		const std::span<const Lod> lods,
+		const std::span<const Meshlet> meshlets,
+		const VertexFormat vertexFormat )
+		: axeGeometryPool{ geometryPool },
+		  id{ NextModelId() },
+		  lods{ lods.begin(), lods.end() },
+		  meshlets{ meshlets.begin(), meshlets.end() },
+		  vertexFormat{ vertexFormat },
+		  boundsMin{ boundsMin },
+		  boundsMax{ boundsMax }
+	{
+		AllocateGeometry( vertices, indices );
+	}
+
+	template <typename Index>
+	void AxeModel::AllocateGeometry( const std::span<const Vertex> vertices, const std::span<const Index> indices )
+	{
+		assert( vertices.size() >= 3 && "Vertex count must be at least 3" );
+		assert( lods.size() <= MAX_LODS && "Too many levels of detail" );
+
+		if ( lods.empty() )
 		{
-			size_t seed = 0;
-			Axe::HashCombine( seed, vertex.position, vertex.color, vertex.normal, vertex.uv );
+			lods.push_back( { 0, static_cast<uint32_t>(indices.size()), 0.0f } );
+		}
 
-			return seed;
+		// Tighter than the sphere around the bounds for anything that isn't a box
+		const glm::vec3 center = ( boundsMin + boundsMax ) * 0.5f;
+		float radiusSquared = 0.0f;
+		for ( const Vertex& vertex : vertices )
+		{
+			const glm::vec3 offset = vertex.position - center;
+			radiusSquared = std::max( radiusSquared, glm::dot( offset, offset ) );
 		}
-	};
-}
+		boundingSphere = glm::vec4{ center, std::sqrt( radiusSquared ) };
 
-namespace Axe
-{
-	AxeModel::AxeModel( AxeDevice& device, const Data& data )
-		: axeDevice{ device }
-	{
-		CreateVertexBuffers( data.vertices );
-		CreateIndexBuffers( data.indices );
+		if ( vertexFormat == VertexFormat::Packed )
+		{
+			// Packed into a temporary array, the upload copies it into the staging ring right away
+			std::vector<PackedVertex> packedVertices( vertices.size() );
+			for ( size_t i = 0; i < vertices.size(); i++ )
+			{
+				packedVertices[ i ] = PackedVertex::Pack( vertices[ i ], boundsMin, boundsMax );
+			}
+
+			geometry = axeGeometryPool.Allocate(
+				packedVertices.data(),
+				static_cast<uint32_t>(packedVertices.size()),
+				sizeof( PackedVertex ),
+				indices );
+		}
+		else
+		{
+			geometry = axeGeometryPool.Allocate(
+				vertices.data(),
+				static_cast<uint32_t>(vertices.size()),
+				sizeof( Vertex ),
+				indices );
+		}
 	}
 
-	AxeModel::~AxeModel() {}
+	AxeModel::~AxeModel()
+	{
+		axeGeometryPool.Free( geometry );
+	}
 
-	std::unique_ptr<AxeModel> AxeModel::CreateModelFromFile( AxeDevice& device, const std::string& filePath )
+	std::unique_ptr<AxeModel> AxeModel::CreateModelFromFile(
+		AxeGeometryPool& geometryPool,
+		const std::string& filePath,
+		const LoadOptions& options )
 	{
-		Data data{};
-		data.LoadModel( filePath );
+		// The cached arrays are copied from the mapping straight into the staging ring, no parsing or per-vertex work
+		if ( const auto cachedMesh = AxeMeshCache::Load( filePath, AxeMeshCache::GetFlags( options ) ) )
+		{
+			std::cout << "Loaded cached model '" << filePath << "' with " << cachedMesh->GetHeader().vertexCount << " unique vertices\n";
 
-		std::cout << "Loaded model '" << filePath << "' with " << data.vertices.size() << " unique vertices\n";
+			return cachedMesh->CreateModel( geometryPool, options );
+		}
 
-		return std::make_unique<AxeModel>( device, data );
+		const Data data = ProcessModelFile( filePath, options );
+		return std::make_unique<AxeModel>( geometryPool, data, options.vertexFormat );
 	}
 
-	void AxeModel::Bind( VkCommandBuffer commandBuffer ) const
+	// Defined with the GPU side of the model rather than in axe_mesh_cache.cpp, which tools use without linking Vulkan
+	std::unique_ptr<AxeModel> AxeMeshCache::CachedMesh::CreateModel( AxeGeometryPool& geometryPool, const AxeModel::LoadOptions& options ) const
 	{
-		const VkBuffer buffers[ ] = { vertexBuffer->GetBufferHandle() };
-		constexpr VkDeviceSize offsets[ ] = { 0 };
+		const Header& header = GetHeader();
 
-		vkCmdBindVertexBuffers( commandBuffer, 0, 1, buffers, offsets );
+		// Cooked caches have every flag, meshlets only go to models that asked for them
+		const std::span<const AxeModel::Meshlet> meshlets = options.buildMeshlets ? Meshlets() : std::span<const AxeModel::Meshlet>{};
 
-		if ( hasIndexBuffer )
+		if ( header.indexSize == sizeof( uint16_t ) )
 		{
-			vkCmdBindIndexBuffer( commandBuffer, indexBuffer->GetBufferHandle(), 0, VK_INDEX_TYPE_UINT32 );
+			return std::make_unique<AxeModel>( geometryPool, Vertices(), Indices16(), header.boundsMin, header.boundsMax, Lods(), meshlets, options.vertexFormat );
 		}
+
+		return std::make_unique<AxeModel>( geometryPool, Vertices(), Indices32(), header.boundsMin, header.boundsMax, Lods(), meshlets, options.vertexFormat );
+	}
+
+	void AxeModel::Bind( VkCommandBuffer commandBuffer ) const
+	{
+		axeGeometryPool.Bind( commandBuffer, geometry.page, geometry.indexType );
 	}
 
-	void AxeModel::Draw( VkCommandBuffer commandBuffer ) const
+	void AxeModel::Draw( VkCommandBuffer commandBuffer, const uint32_t lod, const uint32_t instanceCount, const uint32_t firstInstance ) const
 	{
-		if ( hasIndexBuffer )
+		if ( geometry.HasIndices() )
 		{
-			vkCmdDrawIndexed( commandBuffer, indexCount, 1, 0, 0, 0 );
+			vkCmdDrawIndexed( commandBuffer, lods[ lod ].indexCount, instanceCount, geometry.firstIndex + lods[ lod ].firstIndex, geometry.vertexOffset, firstInstance );
 		}
 		else
 		{
-			vkCmdDraw( commandBuffer, vertexCount, 1, 0, 0 );
+			vkCmdDraw( commandBuffer, geometry.vertexCount, instanceCount, static_cast<uint32_t>(geometry.vertexOffset), firstInstance );
+		}
+	}
+
+	void AxeModel::DrawRange(
+		VkCommandBuffer commandBuffer,
+		const uint32_t firstIndex,
+		const uint32_t indexCount,
+		const uint32_t instanceCount,
+		const uint32_t firstInstance ) const
+	{
+		assert( geometry.HasIndices() && "Index ranges need an index buffer" );
+
+		vkCmdDrawIndexed( commandBuffer, indexCount, instanceCount, geometry.firstIndex + firstIndex, geometry.vertexOffset, firstInstance );
+	}
+
+	VkDrawIndexedIndirectCommand AxeModel::GetIndirectCommand( const uint32_t lod ) const
+	{
+		assert( geometry.HasIndices() && "Indirect draws need an index buffer" );
+
+		VkDrawIndexedIndirectCommand command = {};
+		command.indexCount = lods[ lod ].indexCount;
+		command.instanceCount = 0;
+		command.firstIndex = geometry.firstIndex + lods[ lod ].firstIndex;
+		command.vertexOffset = geometry.vertexOffset;
+		command.firstInstance = 0;
+		return command;
+	}
+
+	glm::mat4 AxeModel::GetDequantizationMatrix() const
+	{
+		if ( vertexFormat == VertexFormat::Full )
+		{
+			return glm::mat4{ 1.0f };
 		}
+
+		// Packed positions are 0..1 within the bounds
+		glm::mat4 matrix{ 1.0f };
+		matrix[ 0 ][ 0 ] = boundsMax.x - boundsMin.x;
+		matrix[ 1 ][ 1 ] = boundsMax.y - boundsMin.y;
+		matrix[ 2 ][ 2 ] = boundsMax.z - boundsMin.z;
+		matrix[ 3 ] = glm::vec4{ boundsMin, 1.0f };
+		return matrix;
+	}
+
+	uint32_t AxeModel::GetTriangleCount( const uint32_t lod ) const
+	{
+		return geometry.HasIndices() ? lods[ lod ].indexCount / 3 : geometry.vertexCount / 3;
 	}
 
 	std::vector<VkVertexInputBindingDescription> AxeModel::Vertex::GetBindingDescriptions()
@@ -93,138 +229,26 @@ namespace Axe
 		return attributeDescriptions;
 	}
 
-	void AxeModel::CreateVertexBuffers( const std::vector<Vertex>& vertices )
-	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-
-		assert( vertexCount >= 3 && "Vertex count must be at least 3" );
-
-		const VkDeviceSize bufferSize = sizeof( vertices[ 0 ] ) * vertexCount;
-		constexpr uint32_t vertexSize = sizeof( vertices[ 0 ] );
-
-		AxeBuffer stagingBuffer(
-			axeDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	// Syncs the CPU mapped memory with the actual GPU memory
-		);
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer( vertices.data() );
-
-		vertexBuffer = std::make_unique<AxeBuffer>(
-			axeDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		// Copy data from the (GPU) staging buffer into the (GPU) vertex buffer
-		axeDevice.CopyBuffer( stagingBuffer.GetBufferHandle(), vertexBuffer->GetBufferHandle(), bufferSize );
-	}
-
-	void AxeModel::CreateIndexBuffers( const std::vector<uint32_t>& indices )
+	std::vector<VkVertexInputBindingDescription> AxeModel::PackedVertex::GetBindingDescriptions()
 	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		hasIndexBuffer = indexCount > 0;
-
-		if ( !hasIndexBuffer )
-		{
-			return;
-		}
-
-		const VkDeviceSize bufferSize = sizeof( indices[ 0 ] ) * indexCount;
-		constexpr uint32_t indexSize = sizeof( indices[ 0 ] );
-
-		AxeBuffer stagingBuffer(
-			axeDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	// Syncs the CPU mapped memory with the actual GPU memory
-		);
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer( indices.data() );
-
-		indexBuffer = std::make_unique<AxeBuffer>(
-			axeDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions( 1 );
+		bindingDescriptions[ 0 ].binding = 0;
+		bindingDescriptions[ 0 ].stride = sizeof( PackedVertex );
+		bindingDescriptions[ 0 ].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-		// Copy data from the (GPU) staging buffer into the (GPU) index buffer
-		axeDevice.CopyBuffer( stagingBuffer.GetBufferHandle(), indexBuffer->GetBufferHandle(), bufferSize );
+		return bindingDescriptions;
 	}
 
-	void AxeModel::Data::LoadModel( const std::string& filePath )
+	std::vector<VkVertexInputAttributeDescription> AxeModel::PackedVertex::GetAttributeDescriptions()
 	{
-		tinyobj::attrib_t attributes;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warnings;
-		std::string errors;
-
-		if ( !tinyobj::LoadObj( &attributes, &shapes, &materials, &warnings, &errors, filePath.c_str() ) )
-		{
-			throw std::runtime_error( warnings + errors );
-		}
-
-		vertices.clear();
-		indices.clear();
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions = {};
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+		// Same locations as the full vertex, the packed vertex shader only differs in decoding the normal
+		attributeDescriptions.push_back( { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof( PackedVertex, position ) } );
+		attributeDescriptions.push_back( { 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof( PackedVertex, color ) } );
+		attributeDescriptions.push_back( { 2, 0, VK_FORMAT_R16G16_SNORM, offsetof( PackedVertex, normal ) } );
+		attributeDescriptions.push_back( { 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof( PackedVertex, uv ) } );
 
-		for ( const auto& shape : shapes )
-		{
-			for ( const auto& index : shape.mesh.indices )
-			{
-				Vertex vertex = {};
-
-				if ( index.vertex_index >= 0 )
-				{
-					vertex.position = {
-						attributes.vertices[ 3 * index.vertex_index + 0 ],
-						attributes.vertices[ 3 * index.vertex_index + 1 ],
-						attributes.vertices[ 3 * index.vertex_index + 2 ],
-					};
-
-					vertex.color = {
-						attributes.colors[ 3 * index.vertex_index + 0 ],
-						attributes.colors[ 3 * index.vertex_index + 1 ],
-						attributes.colors[ 3 * index.vertex_index + 2 ],
-					};
-				}
-
-				if ( index.normal_index >= 0 )
-				{
-					vertex.normal = {
-						attributes.normals[ 3 * index.normal_index + 0 ],
-						attributes.normals[ 3 * index.normal_index + 1 ],
-						attributes.normals[ 3 * index.normal_index + 2 ],
-					};
-				}
-
-				if ( index.texcoord_index >= 0 )
-				{
-					vertex.uv = {
-						attributes.texcoords[ 2 * index.texcoord_index + 0 ],
-						attributes.texcoords[ 2 * index.texcoord_index + 1 ],
-					};
-				}
-
-				// Only add to the vertex buffer if this is a new unique vertex
-				if ( !uniqueVertices.contains( vertex ) )
-				{
-					uniqueVertices[ vertex ] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back( vertex );
-				}
-				indices.push_back( uniqueVertices[ vertex ] );
-			}
-		}
+		return attributeDescriptions;
 	}
 }
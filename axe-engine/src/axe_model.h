@@ -1,12 +1,14 @@
 ﻿#pragma once
 
-#include "axe_device.h"
-#include "axe_buffer.h"
+#include "axe_geometry_pool.h"
+#include "axe_utils.h"
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 
 #include <memory>
+#include <span>
 
 namespace Axe
 {
@@ -32,17 +34,106 @@ namespace Axe
 			}
 		};
 
+		// 20 byte alternative to Vertex's 44 bytes. Positions are 16-bit normalized within the model bounds, the model's dequantization matrix maps
+		// them back. Normals are octahedral encoded into two 16-bit normalized values, colors are 8-bit normalized and uvs are half floats.
+		struct PackedVertex
+		{
+			uint16_t position[ 4 ] = {};	// w is padding
+			int16_t normal[ 2 ] = {};
+			uint8_t color[ 4 ] = {};	// a is padding
+			uint16_t uv[ 2 ] = {};
+
+			[[nodiscard]] static PackedVertex Pack( const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax );
+			// Decodes the same way the packed vertex shader does
+			[[nodiscard]] Vertex Unpack( const glm::vec3& boundsMin, const glm::vec3& boundsMax ) const;
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+
+		enum class VertexFormat
+		{
+			Full,	// Vertex
+			Packed,	// PackedVertex
+		};
+
+		static constexpr uint32_t MAX_LODS = 5;
+
+		// A level of detail is a range of the index buffer, all levels share the vertices
+		struct Lod
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			float error = 0.0f;	// Largest distance the simplified surface moved from the original, in object space
+		};
+
+		// A small cluster of the finest level's triangles, a contiguous range of the index buffer that is culled as a whole
+		struct Meshlet
+		{
+			glm::vec3 center = {};	// Bounding sphere
+			float radius = 0.0f;
+			glm::vec3 coneAxis = {};	// Average facing of the triangles
+			float coneCutoff = 1.0f;	// Sine of the widest angle between a triangle normal and the axis, 1 when the cone is too wide to ever cull
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
 		struct Data
 		{
 			std::vector<Vertex> vertices = {};
 			std::vector<uint32_t> indices = {};
+			std::vector<Lod> lods = {};	// Finest first, empty means the whole index buffer is the only level
+			std::vector<Meshlet> meshlets = {};	// Cover the finest level in index order, empty when they weren't built
+
+			glm::vec3 boundsMin = {};
+			glm::vec3 boundsMax = {};
 
+			// Parses an OBJ file with AxeObjParser
 			void LoadModel( const std::string& filePath );
+			// The original single threaded tinyobjloader path, kept as the reference the parser is checked and benchmarked against
+			void LoadModelWithTinyObj( const std::string& filePath );
+			void ComputeBounds();
+		};
+
+		struct LoadOptions
+		{
+			bool optimize = true;	// Reorder indices and vertices with AxeMeshOptimizer
+			// Split the finest level into meshlets with AxeMeshletBuilder, so it can be culled per cluster. Their backface culling assumes back faces
+			// are hidden, which holds for closed meshes even though the pipelines draw both sides.
+			bool buildMeshlets = false;
+			VertexFormat vertexFormat = VertexFormat::Full;
 		};
 
-		static std::unique_ptr<AxeModel> CreateModelFromFile( AxeDevice& device, const std::string& filePath );
+		// Parses the file and runs the processing the options ask for, then writes the mesh cache. Doesn't touch the GPU, so it can run on worker threads.
+		[[nodiscard]] static Data ProcessModelFile( const std::string& filePath, const LoadOptions& options );
 
-		AxeModel( AxeDevice& device, const AxeModel::Data& data );
+		// Loads the mesh cache, or processes the file and caches the result if there's no valid one
+		static std::unique_ptr<AxeModel> CreateModelFromFile( AxeGeometryPool& geometryPool, const std::string& filePath, const LoadOptions& options );
+		static std::unique_ptr<AxeModel> CreateModelFromFile( AxeGeometryPool& geometryPool, const std::string& filePath )
+		{
+			return CreateModelFromFile( geometryPool, filePath, LoadOptions{} );
+		}
+
+		AxeModel( AxeGeometryPool& geometryPool, const AxeModel::Data& data, VertexFormat vertexFormat = VertexFormat::Full );
+		AxeModel(
+			AxeGeometryPool& geometryPool,
+			std::span<const Vertex> vertices,
+			std::span<const uint32_t> indices,
+			const glm::vec3& boundsMin,
+			const glm::vec3& boundsMax,
+			std::span<const Lod> lods = {},
+			std::span<const Meshlet> meshlets = {},
+			VertexFormat vertexFormat = VertexFormat::Full );
+		// For 16-bit indices as stored in mesh caches, skips narrowing them in the geometry pool
+		AxeModel(
+			AxeGeometryPool& geometryPool,
+			std::span<const Vertex> vertices,
+			std::span<const uint16_t> indices,
+			const glm::vec3& boundsMin,
+			const glm::vec3& boundsMax,
+			std::span<const Lod> lods = {},
+			std::span<const Meshlet> meshlets = {},
+			VertexFormat vertexFormat = VertexFormat::Full );
 		~AxeModel();
 
 		AxeModel( const AxeModel& ) = delete;
@@ -50,20 +141,64 @@ namespace Axe
 		AxeModel( const AxeModel&& ) = delete;
 		AxeModel& operator=( const AxeModel&& ) = delete;
 
+		// Binds the geometry pool page the model lives in, models in the same page with the same index type can skip this
 		void Bind( VkCommandBuffer commandBuffer ) const;
-		void Draw( VkCommandBuffer commandBuffer ) const;
+		// Instances are numbered from firstInstance on, which is where the shaders start reading their per-instance data
+		void Draw( VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0 ) const;
+		// Draws a range of the model's indices, for drawing only the meshlets that survived culling
+		void DrawRange( VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstInstance = 0 ) const;
+
+		// The indexed draw of a level of detail without any instances, for GPU culling to fill in
+		[[nodiscard]] VkDrawIndexedIndirectCommand GetIndirectCommand( uint32_t lod ) const;
+
+		// Unique among the models loaded during the run, for render queue keys
+		[[nodiscard]] uint32_t GetId() const { return id; }
+		[[nodiscard]] bool HasIndices() const { return geometry.HasIndices(); }
+		[[nodiscard]] uint32_t GetGeometryPage() const { return geometry.page; }
+		[[nodiscard]] VkIndexType GetIndexType() const { return geometry.indexType; }
+		[[nodiscard]] const glm::vec3& GetBoundsMin() const { return boundsMin; }
+		[[nodiscard]] const glm::vec3& GetBoundsMax() const { return boundsMax; }
+		// Centered on the bounds and just large enough for every vertex, w is the radius
+		[[nodiscard]] const glm::vec4& GetBoundingSphere() const { return boundingSphere; }
+
+		[[nodiscard]] VertexFormat GetVertexFormat() const { return vertexFormat; }
+		// Maps the vertex format's object space to the model's, the identity for full vertices
+		[[nodiscard]] glm::mat4 GetDequantizationMatrix() const;
+
+		[[nodiscard]] uint32_t GetLodCount() const { return static_cast<uint32_t>(lods.size()); }
+		[[nodiscard]] const Lod& GetLod( const uint32_t lod ) const { return lods[ lod ]; }
+		[[nodiscard]] uint32_t GetTriangleCount( uint32_t lod = 0 ) const;
+
+		[[nodiscard]] std::span<const Meshlet> GetMeshlets() const { return meshlets; }
 
 	private:
-		AxeDevice& axeDevice;
-
-		std::unique_ptr<AxeBuffer> vertexBuffer;
-		uint32_t vertexCount = 0;
+		AxeGeometryPool& axeGeometryPool;
+		uint32_t id = 0;
+		AxeGeometryPool::Allocation geometry = {};
+		std::vector<Lod> lods = {};
+		std::vector<Meshlet> meshlets = {};
+		VertexFormat vertexFormat = VertexFormat::Full;
+
+		glm::vec3 boundsMin = {};
+		glm::vec3 boundsMax = {};
+		glm::vec4 boundingSphere = {};
+
+		template <typename Index>
+		void AllocateGeometry( std::span<const Vertex> vertices, std::span<const Index> indices );
+	};
+}
 
-		bool hasIndexBuffer = false;
-		std::unique_ptr<AxeBuffer> indexBuffer;
-		uint32_t indexCount = 0;
+namespace std
+{
+	template <>
+	struct hash<Axe::AxeModel::Vertex>
+	{
+		size_t operator()( const Axe::AxeModel::Vertex& vertex ) const noexcept
+		{
+			size_t seed = 0;
+			Axe::HashCombine( seed, vertex.position, vertex.color, vertex.normal, vertex.uv );
 
-		void CreateVertexBuffers( const std::vector<Vertex>& vertices );
-		void CreateIndexBuffers( const std::vector<uint32_t>& indices );
+			return seed;
+		}
 	};
 }
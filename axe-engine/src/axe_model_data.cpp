@@ -0,0 +1,239 @@
+#include "axe_model.h"
+
+#include "axe_mesh_cache.h"
+#include "axe_mesh_optimizer.h"
+#include "axe_mesh_simplifier.h"
+#include "axe_meshlet_builder.h"
+#include "axe_obj_parser.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <glm/gtc/packing.hpp>
+
+// std headers
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+// CPU side model loading, kept apart from the GPU model so tools can load meshes without a Vulkan device
+namespace Axe
+{
+	AxeModel::Data AxeModel::ProcessModelFile( const std::string& filePath, const LoadOptions& options )
+	{
+		Data data{};
+		data.LoadModel( filePath );
+
+		std::cout << "Loaded model '" << filePath << "' with " << data.vertices.size() << " unique vertices\n";
+
+		AxeMeshSimplifier::GenerateLods( data );
+
+		std::cout << "Generated " << data.lods.size() << " levels of detail for '" << filePath << "' with";
+		for ( const Lod& lod : data.lods )
+		{
+			std::cout << " " << lod.indexCount / 3;
+		}
+		std::cout << " triangles\n";
+
+		if ( options.optimize )
+		{
+			const AxeMeshOptimizer::Report report = AxeMeshOptimizer::Optimize( data );
+
+			std::cout << "Optimized model '" << filePath << "', ACMR " << report.before.acmr << " -> " << report.after.acmr
+				<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << "\n";
+		}
+
+		if ( options.buildMeshlets )
+		{
+			AxeMeshletBuilder::Build( data );
+
+			// The builder reorders the finest level's triangles, which the vertex order should follow again
+			if ( options.optimize )
+			{
+				AxeMeshOptimizer::OptimizeVertexFetch( data.vertices, data.indices );
+			}
+
+			std::cout << "Built " << data.meshlets.size() << " meshlets for '" << filePath << "'\n";
+		}
+
+		if ( !AxeMeshCache::Write( filePath, data, AxeMeshCache::GetFlags( options ) ) )
+		{
+			std::cerr << "Failed to write mesh cache for '" << filePath << "'\n";
+		}
+
+		return data;
+	}
+
+	void AxeModel::Data::LoadModel( const std::string& filePath )
+	{
+		AxeObjParser::Parse( filePath, vertices, indices );
+
+		ComputeBounds();
+	}
+
+	void AxeModel::Data::LoadModelWithTinyObj( const std::string& filePath )
+	{
+		tinyobj::attrib_t attributes;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warnings;
+		std::string errors;
+
+		if ( !tinyobj::LoadObj( &attributes, &shapes, &materials, &warnings, &errors, filePath.c_str() ) )
+		{
+			throw std::runtime_error( warnings + errors );
+		}
+
+		vertices.clear();
+		indices.clear();
+
+		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+
+		for ( const auto& shape : shapes )
+		{
+			for ( const auto& index : shape.mesh.indices )
+			{
+				Vertex vertex = {};
+
+				if ( index.vertex_index >= 0 )
+				{
+					vertex.position = {
+						attributes.vertices[ 3 * index.vertex_index + 0 ],
+						attributes.vertices[ 3 * index.vertex_index + 1 ],
+						attributes.vertices[ 3 * index.vertex_index + 2 ],
+					};
+
+					vertex.color = {
+						attributes.colors[ 3 * index.vertex_index + 0 ],
+						attributes.colors[ 3 * index.vertex_index + 1 ],
+						attributes.colors[ 3 * index.vertex_index + 2 ],
+					};
+				}
+
+				if ( index.normal_index >= 0 )
+				{
+					vertex.normal = {
+						attributes.normals[ 3 * index.normal_index + 0 ],
+						attributes.normals[ 3 * index.normal_index + 1 ],
+						attributes.normals[ 3 * index.normal_index + 2 ],
+					};
+				}
+
+				if ( index.texcoord_index >= 0 )
+				{
+					vertex.uv = {
+						attributes.texcoords[ 2 * index.texcoord_index + 0 ],
+						attributes.texcoords[ 2 * index.texcoord_index + 1 ],
+					};
+				}
+
+				// Only add to the vertex buffer if this is a new unique vertex
+				if ( !uniqueVertices.contains( vertex ) )
+				{
+					uniqueVertices[ vertex ] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back( vertex );
+				}
+				indices.push_back( uniqueVertices[ vertex ] );
+			}
+		}
+
+		ComputeBounds();
+	}
+
+	void AxeModel::Data::ComputeBounds()
+	{
+		if ( vertices.empty() )
+		{
+			boundsMin = {};
+			boundsMax = {};
+			return;
+		}
+
+		boundsMin = vertices[ 0 ].position;
+		boundsMax = vertices[ 0 ].position;
+
+		for ( const Vertex& vertex : vertices )
+		{
+			boundsMin = glm::min( boundsMin, vertex.position );
+			boundsMax = glm::max( boundsMax, vertex.position );
+		}
+	}
+
+	// ####   Packed vertices   ####
+
+	static glm::vec2 SignNotZero( const glm::vec2 value )
+	{
+		return { value.x >= 0.0f ? 1.0f : -1.0f, value.y >= 0.0f ? 1.0f : -1.0f };
+	}
+
+	// Projects the unit sphere onto an octahedron and unfolds its lower half over the corners, giving a square in -1..1
+	static glm::vec2 OctahedralEncode( const glm::vec3 normal )
+	{
+		const float length = std::abs( normal.x ) + std::abs( normal.y ) + std::abs( normal.z );
+		if ( length == 0.0f )
+		{
+			return {};
+		}
+
+		const glm::vec2 projected = glm::vec2{ normal } / length;
+		if ( normal.z >= 0.0f )
+		{
+			return projected;
+		}
+
+		return ( 1.0f - glm::abs( glm::vec2{ projected.y, projected.x } ) ) * SignNotZero( projected );
+	}
+
+	static glm::vec3 OctahedralDecode( const glm::vec2 encoded )
+	{
+		glm::vec3 normal{ encoded, 1.0f - std::abs( encoded.x ) - std::abs( encoded.y ) };
+
+		const float fold = std::max( -normal.z, 0.0f );
+		normal.x += normal.x >= 0.0f ? -fold : fold;
+		normal.y += normal.y >= 0.0f ? -fold : fold;
+
+		return glm::normalize( normal );
+	}
+
+	static glm::vec3 SafeExtent( const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+	{
+		// Flat models have no extent along some axis, their positions all pack to 0 there
+		const glm::vec3 extent = boundsMax - boundsMin;
+		return { extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f };
+	}
+
+	AxeModel::PackedVertex AxeModel::PackedVertex::Pack( const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+	{
+		const glm::vec3 relativePosition = glm::clamp( ( vertex.position - boundsMin ) / SafeExtent( boundsMin, boundsMax ), 0.0f, 1.0f );
+		const glm::u16vec4 position = glm::packUnorm<uint16_t>( glm::vec4{ relativePosition, 0.0f } );
+		const glm::i16vec2 normal = glm::packSnorm<int16_t>( OctahedralEncode( vertex.normal ) );
+		const glm::u8vec4 color = glm::packUnorm<uint8_t>( glm::vec4{ glm::clamp( vertex.color, 0.0f, 1.0f ), 1.0f } );
+
+		PackedVertex packed = {};
+		packed.position[ 0 ] = position.x;
+		packed.position[ 1 ] = position.y;
+		packed.position[ 2 ] = position.z;
+		packed.normal[ 0 ] = normal.x;
+		packed.normal[ 1 ] = normal.y;
+		packed.color[ 0 ] = color.r;
+		packed.color[ 1 ] = color.g;
+		packed.color[ 2 ] = color.b;
+		packed.color[ 3 ] = color.a;
+		packed.uv[ 0 ] = glm::packHalf1x16( vertex.uv.x );
+		packed.uv[ 1 ] = glm::packHalf1x16( vertex.uv.y );
+		return packed;
+	}
+
+	AxeModel::Vertex AxeModel::PackedVertex::Unpack( const glm::vec3& boundsMin, const glm::vec3& boundsMax ) const
+	{
+		const glm::vec3 extent = boundsMax - boundsMin;
+
+		Vertex vertex = {};
+		vertex.position = boundsMin + glm::unpackUnorm<float>( glm::u16vec3{ position[ 0 ], position[ 1 ], position[ 2 ] } ) * extent;
+		vertex.normal = OctahedralDecode( glm::unpackSnorm<float>( glm::i16vec2{ normal[ 0 ], normal[ 1 ] } ) );
+		vertex.color = glm::unpackUnorm<float>( glm::u8vec3{ color[ 0 ], color[ 1 ], color[ 2 ] } );
+		vertex.uv = { glm::unpackHalf1x16( uv[ 0 ] ), glm::unpackHalf1x16( uv[ 1 ] ) };
+		return vertex;
+	}
+}
@@ -0,0 +1,146 @@
+#include "axe_model_streamer.h"
+
+// std headers
+#include <iostream>
+
+namespace Axe
+{
+	AxeModelStreamer::Handle AxeModelStreamer::Handle::FromModel( std::shared_ptr<AxeModel> model )
+	{
+		const auto request = std::make_shared<Request>();
+		request->model = std::move( model );
+		request->state.store( State::Resident, std::memory_order_release );
+
+		return Handle{ request };
+	}
+
+	AxeModelStreamer::AxeModelStreamer( AxeGeometryPool& geometryPool, const VkDeviceSize uploadBudget, AxeThreadPool& threadPool )
+		: axeGeometryPool{ geometryPool }, axeThreadPool{ threadPool }, uploadBudget{ uploadBudget } {}
+
+	AxeModelStreamer::~AxeModelStreamer()
+	{
+		std::unique_lock lock{ mutex };
+		loadFinished.wait( lock, [this]() { return loadingCount == 0; } );
+	}
+
+	AxeModelStreamer::Handle AxeModelStreamer::Load( const std::string& filePath, const AxeModel::LoadOptions& options, ResidentCallback onResident )
+	{
+		const auto request = std::make_shared<Request>();
+		request->filePath = filePath;
+		request->options = options;
+		request->onResident = std::move( onResident );
+
+		{
+			std::scoped_lock lock{ mutex };
+			loadingCount++;
+		}
+
+		pendingCount++;
+
+		// The future isn't needed, the request itself carries the result
+		[[maybe_unused]] auto future = axeThreadPool.Submit( [this, request]() { LoadOnWorker( request ); } );
+
+		return Handle{ request };
+	}
+
+	void AxeModelStreamer::LoadOnWorker( const std::shared_ptr<Request>& request )
+	{
+		bool loaded = true;
+
+		try
+		{
+			if ( auto cachedMesh = AxeMeshCache::Load( request->filePath, AxeMeshCache::GetFlags( request->options ) ) )
+			{
+				request->cachedMesh.emplace( std::move( *cachedMesh ) );
+			}
+			else
+			{
+				request->data = AxeModel::ProcessModelFile( request->filePath, request->options );
+			}
+
+			const uint32_t vertexCount = request->cachedMesh ? request->cachedMesh->GetHeader().vertexCount : static_cast<uint32_t>(request->data.vertices.size());
+			const uint32_t indexCount = request->cachedMesh ? request->cachedMesh->GetHeader().indexCount : static_cast<uint32_t>(request->data.indices.size());
+
+			const VkDeviceSize vertexSize = request->options.vertexFormat == AxeModel::VertexFormat::Packed ? sizeof( AxeModel::PackedVertex ) : sizeof( AxeModel::Vertex );
+			const VkDeviceSize indexSize = vertexCount <= AxeGeometryPool::MAX_UINT16_VERTEX_COUNT ? sizeof( uint16_t ) : sizeof( uint32_t );
+			request->uploadBytes = vertexCount * vertexSize + indexCount * indexSize;
+		}
+		catch ( const std::exception& exception )
+		{
+			loaded = false;
+			request->error = exception.what();
+			request->state.store( State::Failed, std::memory_order_release );
+			pendingCount--;
+
+			std::cerr << "Failed to load model '" << request->filePath << "': " << request->error << "\n";
+		}
+
+		std::scoped_lock lock{ mutex };
+
+		if ( loaded )
+		{
+			request->state.store( State::Uploading, std::memory_order_release );
+			loadedRequests.push_back( request );
+		}
+
+		// Notified under the lock, the destructor may destroy the condition variable as soon as it sees the count reach zero
+		loadingCount--;
+		loadFinished.notify_all();
+	}
+
+	void AxeModelStreamer::Update()
+	{
+		lastUploadBytes = 0;
+
+		while ( true )
+		{
+			std::shared_ptr<Request> request;
+			{
+				std::scoped_lock lock{ mutex };
+
+				if ( loadedRequests.empty() )
+				{
+					break;
+				}
+
+				if ( lastUploadBytes > 0 && lastUploadBytes + loadedRequests.front()->uploadBytes > uploadBudget )
+				{
+					break;
+				}
+
+				request = std::move( loadedRequests.front() );
+				loadedRequests.pop_front();
+			}
+
+			try
+			{
+				request->model = request->cachedMesh
+					                 ? request->cachedMesh->CreateModel( axeGeometryPool, request->options )
+					                 : std::make_unique<AxeModel>( axeGeometryPool, request->data, request->options.vertexFormat );
+			}
+			catch ( const std::exception& exception )
+			{
+				request->error = exception.what();
+				request->state.store( State::Failed, std::memory_order_release );
+				pendingCount--;
+
+				std::cerr << "Failed to upload model '" << request->filePath << "': " << request->error << "\n";
+				continue;
+			}
+
+			// The arrays are in the staging ring now
+			request->cachedMesh.reset();
+			request->data = {};
+
+			lastUploadBytes += request->uploadBytes;
+
+			request->state.store( State::Resident, std::memory_order_release );
+			pendingCount--;
+
+			if ( request->onResident )
+			{
+				request->onResident( request->model );
+			}
+		}
+	}
+}
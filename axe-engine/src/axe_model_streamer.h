@@ -0,0 +1,120 @@
+#pragma once
+
+#include "axe_geometry_pool.h"
+#include "axe_mesh_cache.h"
+#include "axe_model.h"
+#include "axe_thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace Axe
+{
+	// Loads models in the background. Cache loading, parsing and processing run on the thread pool, which leaves the render thread with
+	// only the copies into the staging ring, and those are spread over frames by a per-frame byte budget.
+	class AxeModelStreamer
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_UPLOAD_BUDGET = 16ull * 1024ull * 1024ull;
+
+		enum class State
+		{
+			Loading,	// On the thread pool
+			Uploading,	// Loaded, waiting for upload budget
+			Resident,	// Uploaded, drawable by anything submitted after the upload context's next submit
+			Failed,
+		};
+
+		using ResidentCallback = std::function<void( const std::shared_ptr<AxeModel>& )>;
+
+	private:
+		struct Request
+		{
+			std::string filePath;
+			AxeModel::LoadOptions options;
+			ResidentCallback onResident;
+
+			std::atomic<State> state = State::Loading;
+
+			// What the worker loaded, a valid cache is uploaded straight from its mapping
+			std::optional<AxeMeshCache::CachedMesh> cachedMesh = {};
+			AxeModel::Data data = {};
+			VkDeviceSize uploadBytes = 0;
+
+			// Only read once the state says they are written
+			std::shared_ptr<AxeModel> model = {};
+			std::string error = {};
+		};
+
+	public:
+		// Polled from the game loop like a future, copies refer to the same load
+		class Handle
+		{
+		public:
+			Handle() = default;
+
+			// For a model that is already loaded
+			[[nodiscard]] static Handle FromModel( std::shared_ptr<AxeModel> model );
+
+			[[nodiscard]] bool IsValid() const { return request != nullptr; }
+			[[nodiscard]] State GetState() const { return request->state.load( std::memory_order_acquire ); }
+			[[nodiscard]] bool IsResident() const { return GetState() == State::Resident; }
+			[[nodiscard]] bool HasFailed() const { return GetState() == State::Failed; }
+
+			// Null until the model is resident
+			[[nodiscard]] std::shared_ptr<AxeModel> GetModel() const { return IsResident() ? request->model : nullptr; }
+			// Empty unless the load failed
+			[[nodiscard]] std::string GetError() const { return HasFailed() ? request->error : std::string{}; }
+
+		private:
+			friend class AxeModelStreamer;
+
+			explicit Handle( std::shared_ptr<Request> request ) : request{ std::move( request ) } {}
+
+			std::shared_ptr<Request> request = {};
+		};
+
+		explicit AxeModelStreamer(
+			AxeGeometryPool& geometryPool,
+			VkDeviceSize uploadBudget = DEFAULT_UPLOAD_BUDGET,
+			AxeThreadPool& threadPool = AxeThreadPool::Shared() );
+		// Waits for the loads still on the thread pool
+		~AxeModelStreamer();
+
+		AxeModelStreamer( const AxeModelStreamer& ) = delete;
+		AxeModelStreamer& operator=( const AxeModelStreamer& ) = delete;
+		AxeModelStreamer( AxeModelStreamer&& ) = delete;
+		AxeModelStreamer& operator=( AxeModelStreamer&& ) = delete;
+
+		// The callback runs on the thread calling Update once the model is resident
+		[[nodiscard]] Handle Load( const std::string& filePath, const AxeModel::LoadOptions& options = {}, ResidentCallback onResident = {} );
+
+		// Call once per frame on the render thread, before the upload context is submitted. Uploads loaded models in the order they finished loading
+		// until the budget is spent, but always at least one, so models larger than the budget still get through.
+		void Update();
+
+		[[nodiscard]] uint32_t GetPendingCount() const { return pendingCount.load( std::memory_order_relaxed ); }
+		[[nodiscard]] VkDeviceSize GetLastUploadBytes() const { return lastUploadBytes; }
+
+	private:
+		AxeGeometryPool& axeGeometryPool;
+		AxeThreadPool& axeThreadPool;
+		VkDeviceSize uploadBudget;
+
+		std::mutex mutex;
+		std::condition_variable loadFinished;
+		std::deque<std::shared_ptr<Request>> loadedRequests = {};
+		uint32_t loadingCount = 0;
+
+		std::atomic<uint32_t> pendingCount = 0;	// Loading or uploading
+		VkDeviceSize lastUploadBytes = 0;
+
+		void LoadOnWorker( const std::shared_ptr<Request>& request );
+	};
+}
@@ -0,0 +1,981 @@
+#include "axe_obj_parser.h"
+
+#include "axe_mapped_file.h"
+#include "axe_vertex_welder.h"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Axe
+{
+	// The tokenizing and triangulation below mirror tinyobjloader step by step, down to the float math,
+	// any shortcut here would change vertex positions or triangle splits and break identical output.
+	// The one difference is that faces are triangulated against all positions in the file,
+	// tinyobjloader only sees the positions declared before the end of the face's group.
+
+	// ####   Chunk state   ####
+
+	struct FaceCorner
+	{
+		int32_t position = -1;
+		int32_t texcoord = -1;
+		int32_t normal = -1;
+	};
+
+	// Negative OBJ indices are relative to the attributes parsed so far,
+	// which is only known once the preceding chunks have been counted
+	struct RelativeIndex
+	{
+		uint32_t corner = 0;
+		uint32_t line = 0;	// Within the chunk, an index that counts back past the start of the file fails the load with it
+		int32_t FaceCorner::* attribute = nullptr;
+	};
+
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		std::vector<float> positions = {};
+		std::vector<float> colors = {};
+		std::vector<float> normals = {};
+		std::vector<float> texcoords = {};
+
+		std::vector<FaceCorner> corners = {};
+		std::vector<uint32_t> faceSizes = {};
+		std::vector<RelativeIndex> relativeIndices = {};
+
+		std::vector<FaceCorner> triangles = {};
+		std::vector<AxeModel::Vertex> vertices = {};
+		std::vector<uint32_t> indices = {};
+		std::vector<uint64_t> vertexHashes = {};
+		std::vector<uint32_t> vertexRemap = {};
+
+		uint32_t positionBase = 0;
+		uint32_t normalBase = 0;
+		uint32_t texcoordBase = 0;
+		size_t indexBase = 0;
+
+		size_t lineCount = 0;
+		size_t errorLine = 0;
+		std::string error = {};
+	};
+
+	// ####   Tokenizing   ####
+
+	static bool IsSpace( const char c )
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	static bool IsDigit( const char c )
+	{
+		return static_cast<unsigned int>(c - '0') < 10u;
+	}
+
+	// Lines never contain line breaks, so the end of the line acts as the null terminator tinyobjloader relies on
+	static char CharAt( const char* p, const char* end )
+	{
+		return p < end ? *p : '\0';
+	}
+
+	static const char* SkipSpaces( const char* p, const char* end )
+	{
+		while ( p < end && IsSpace( *p ) )
+		{
+			p++;
+		}
+
+		return p;
+	}
+
+	static const char* SkipToken( const char* p, const char* end )
+	{
+		while ( p < end && !IsSpace( *p ) )
+		{
+			p++;
+		}
+
+		return p;
+	}
+
+	static const char* SkipIndex( const char* p, const char* end )
+	{
+		while ( p < end && *p != '/' && !IsSpace( *p ) )
+		{
+			p++;
+		}
+
+		return p;
+	}
+
+	// Same as atoi
+	static int ParseInt( const char* p, const char* end )
+	{
+		while ( p < end && ( IsSpace( *p ) || *p == '\n' || *p == '\v' || *p == '\f' || *p == '\r' ) )
+		{
+			p++;
+		}
+
+		bool negative = false;
+		if ( p < end && ( *p == '+' || *p == '-' ) )
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		int value = 0;
+		while ( p < end && IsDigit( *p ) )
+		{
+			value = value * 10 + ( *p - '0' );
+			p++;
+		}
+
+		return negative ? -value : value;
+	}
+
+	static bool TryParseDouble( const char* s, const char* sEnd, double& result )
+	{
+		if ( s >= sEnd )
+		{
+			return false;
+		}
+
+		double mantissa = 0.0;
+		int exponent = 0;
+		char sign = '+';
+		char exponentSign = '+';
+		const char* current = s;
+		int read = 0;
+		bool endNotReached = false;
+		bool leadingDecimalDot = false;
+
+		if ( *current == '+' || *current == '-' )
+		{
+			sign = *current;
+			current++;
+			if ( current != sEnd && *current == '.' )
+			{
+				leadingDecimalDot = true;
+			}
+		}
+		else if ( IsDigit( *current ) )
+		{
+		}
+		else if ( *current == '.' )
+		{
+			leadingDecimalDot = true;
+		}
+		else
+		{
+			return false;
+		}
+
+		// Integer part
+		endNotReached = current != sEnd;
+		if ( !leadingDecimalDot )
+		{
+			while ( endNotReached && IsDigit( *current ) )
+			{
+				mantissa *= 10;
+				mantissa += static_cast<int>(*current - 0x30);
+				current++;
+				read++;
+				endNotReached = current != sEnd;
+			}
+
+			if ( read == 0 )
+			{
+				return false;
+			}
+		}
+
+		if ( endNotReached )
+		{
+			bool parseExponent = true;
+
+			// Decimal part
+			if ( *current == '.' )
+			{
+				current++;
+				read = 1;
+				endNotReached = current != sEnd;
+				while ( endNotReached && IsDigit( *current ) )
+				{
+					static constexpr double POW_LUT[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+					constexpr int LUT_ENTRIES = sizeof POW_LUT / sizeof POW_LUT[ 0 ];
+
+					mantissa += static_cast<int>(*current - 0x30) * ( read < LUT_ENTRIES ? POW_LUT[ read ] : std::pow( 10.0, -read ) );
+					read++;
+					current++;
+					endNotReached = current != sEnd;
+				}
+			}
+			else if ( *current != 'e' && *current != 'E' )
+			{
+				parseExponent = false;
+			}
+
+			// Exponent part
+			if ( parseExponent && endNotReached && ( *current == 'e' || *current == 'E' ) )
+			{
+				current++;
+				endNotReached = current != sEnd;
+				if ( endNotReached && ( *current == '+' || *current == '-' ) )
+				{
+					exponentSign = *current;
+					current++;
+				}
+				else if ( !IsDigit( CharAt( current, sEnd ) ) )
+				{
+					return false;
+				}
+
+				read = 0;
+				endNotReached = current != sEnd;
+				while ( endNotReached && IsDigit( *current ) )
+				{
+					if ( exponent > std::numeric_limits<int>::max() / 10 )
+					{
+						return false;
+					}
+
+					exponent *= 10;
+					exponent += static_cast<int>(*current - 0x30);
+					current++;
+					read++;
+					endNotReached = current != sEnd;
+				}
+
+				exponent *= exponentSign == '+' ? 1 : -1;
+				if ( read == 0 )
+				{
+					return false;
+				}
+			}
+		}
+
+		result = ( sign == '+' ? 1 : -1 ) * ( exponent ? std::ldexp( mantissa * std::pow( 5.0, exponent ), exponent ) : mantissa );
+		return true;
+	}
+
+	static float ParseFloat( const char*& p, const char* end, const double defaultValue = 0.0 )
+	{
+		p = SkipSpaces( p, end );
+		const char* tokenEnd = SkipToken( p, end );
+
+		double value = defaultValue;
+		TryParseDouble( p, tokenEnd, value );
+
+		p = tokenEnd;
+		return static_cast<float>(value);
+	}
+
+	static bool TryParseFloat( const char*& p, const char* end, float& out )
+	{
+		p = SkipSpaces( p, end );
+		const char* tokenEnd = SkipToken( p, end );
+
+		double value;
+		const bool parsed = TryParseDouble( p, tokenEnd, value );
+		if ( parsed )
+		{
+			out = static_cast<float>(value);
+		}
+
+		p = tokenEnd;
+		return parsed;
+	}
+
+	// Zero based index, or false for the invalid index 0. Negative indices count back from localCount.
+	static bool FixIndex( const int index, const uint32_t localCount, int32_t& out, bool& relative )
+	{
+		if ( index > 0 )
+		{
+			out = index - 1;
+			return true;
+		}
+
+		if ( index == 0 )
+		{
+			return false;
+		}
+
+		out = static_cast<int32_t>(localCount) + index;
+		relative = true;
+		return true;
+	}
+
+	// Parses one of i, i/j, i//k or i/j/k
+	static bool ParseCorner( const char*& p, const char* end, const ObjChunk& chunk, FaceCorner& corner, bool relative[ 3 ] )
+	{
+		const auto positionCount = static_cast<uint32_t>(chunk.positions.size() / 3);
+		const auto normalCount = static_cast<uint32_t>(chunk.normals.size() / 3);
+		const auto texcoordCount = static_cast<uint32_t>(chunk.texcoords.size() / 2);
+
+		corner = {};
+		relative[ 0 ] = relative[ 1 ] = relative[ 2 ] = false;
+
+		if ( !FixIndex( ParseInt( p, end ), positionCount, corner.position, relative[ 0 ] ) )
+		{
+			return false;
+		}
+
+		p = SkipIndex( p, end );
+		if ( CharAt( p, end ) != '/' )
+		{
+			return true;
+		}
+		p++;
+
+		// i//k
+		if ( CharAt( p, end ) == '/' )
+		{
+			p++;
+			if ( !FixIndex( ParseInt( p, end ), normalCount, corner.normal, relative[ 2 ] ) )
+			{
+				return false;
+			}
+
+			p = SkipIndex( p, end );
+			return true;
+		}
+
+		// i/j/k or i/j
+		if ( !FixIndex( ParseInt( p, end ), texcoordCount, corner.texcoord, relative[ 1 ] ) )
+		{
+			return false;
+		}
+
+		p = SkipIndex( p, end );
+		if ( CharAt( p, end ) != '/' )
+		{
+			return true;
+		}
+		p++;
+
+		if ( !FixIndex( ParseInt( p, end ), normalCount, corner.normal, relative[ 2 ] ) )
+		{
+			return false;
+		}
+
+		p = SkipIndex( p, end );
+		return true;
+	}
+
+	// ####   Parsing   ####
+
+	static bool ParseLine( const char* p, const char* end, ObjChunk& chunk )
+	{
+		p = SkipSpaces( p, end );
+		if ( p == end || *p == '#' )
+		{
+			return true;
+		}
+
+		const char c0 = *p;
+		const char c1 = CharAt( p + 1, end );
+		const char c2 = CharAt( p + 2, end );
+
+		// Vertex positions with optional colors, missing colors default to white
+		if ( c0 == 'v' && IsSpace( c1 ) )
+		{
+			p += 2;
+
+			const float x = ParseFloat( p, end );
+			const float y = ParseFloat( p, end );
+			const float z = ParseFloat( p, end );
+
+			float r, g, b;
+			if ( !( TryParseFloat( p, end, r ) && TryParseFloat( p, end, g ) && TryParseFloat( p, end, b ) ) )
+			{
+				r = g = b = 1.0f;
+			}
+
+			chunk.positions.insert( chunk.positions.end(), { x, y, z } );
+			chunk.colors.insert( chunk.colors.end(), { r, g, b } );
+			return true;
+		}
+
+		if ( c0 == 'v' && c1 == 'n' && IsSpace( c2 ) )
+		{
+			p += 3;
+
+			const float x = ParseFloat( p, end );
+			const float y = ParseFloat( p, end );
+			const float z = ParseFloat( p, end );
+
+			chunk.normals.insert( chunk.normals.end(), { x, y, z } );
+			return true;
+		}
+
+		if ( c0 == 'v' && c1 == 't' && IsSpace( c2 ) )
+		{
+			p += 3;
+
+			const float u = ParseFloat( p, end );
+			const float v = ParseFloat( p, end );
+
+			chunk.texcoords.insert( chunk.texcoords.end(), { u, v } );
+			return true;
+		}
+
+		const bool isFace = c0 == 'f' && IsSpace( c1 );
+
+		// Lines and points don't end up in the mesh, but invalid indices in them still fail the load
+		if ( isFace || ( ( c0 == 'l' || c0 == 'p' ) && IsSpace( c1 ) ) )
+		{
+			p = SkipSpaces( p + 2, end );
+
+			uint32_t cornerCount = 0;
+			while ( p < end )
+			{
+				FaceCorner corner;
+				bool relative[ 3 ];
+				if ( !ParseCorner( p, end, chunk, corner, relative ) )
+				{
+					return false;
+				}
+
+				if ( isFace )
+				{
+					const auto cornerIndex = static_cast<uint32_t>(chunk.corners.size());
+					const auto line = static_cast<uint32_t>(chunk.lineCount);
+					if ( relative[ 0 ] )
+					{
+						chunk.relativeIndices.push_back( { cornerIndex, line, &FaceCorner::position } );
+					}
+					if ( relative[ 1 ] )
+					{
+						chunk.relativeIndices.push_back( { cornerIndex, line, &FaceCorner::texcoord } );
+					}
+					if ( relative[ 2 ] )
+					{
+						chunk.relativeIndices.push_back( { cornerIndex, line, &FaceCorner::normal } );
+					}
+
+					chunk.corners.push_back( corner );
+					cornerCount++;
+				}
+
+				p = SkipSpaces( p, end );
+			}
+
+			if ( isFace )
+			{
+				chunk.faceSizes.push_back( cornerCount );
+			}
+		}
+
+		// Groups, objects, materials and smoothing groups don't affect the merged geometry
+		return true;
+	}
+
+	static void ParseChunk( ObjChunk& chunk )
+	{
+		const char* p = chunk.begin;
+		while ( p < chunk.end )
+		{
+			const char* lineEnd = p;
+			while ( lineEnd < chunk.end && *lineEnd != '\n' && *lineEnd != '\r' )
+			{
+				lineEnd++;
+			}
+
+			chunk.lineCount++;
+
+			if ( !ParseLine( p, lineEnd, chunk ) )
+			{
+				chunk.errorLine = chunk.lineCount;
+				chunk.error = "Failed to parse face, index 0 is not allowed";
+				return;
+			}
+
+			// \n, \r\n and a lone \r all end a line
+			p = lineEnd;
+			if ( p < chunk.end && *p == '\r' )
+			{
+				p++;
+			}
+			if ( p < chunk.end && *p == '\n' )
+			{
+				p++;
+			}
+		}
+	}
+
+	// ####   Triangulation   ####
+
+	static bool IsInsideTriangle( const float* vx, const float* vy, const float testX, const float testY )
+	{
+		bool inside = false;
+		for ( int i = 0, j = 2; i < 3; j = i++ )
+		{
+			if ( ( vy[ i ] > testY ) != ( vy[ j ] > testY ) &&
+			     testX < ( vx[ j ] - vx[ i ] ) * ( testY - vy[ i ] ) / ( vy[ j ] - vy[ i ] ) + vx[ i ] )
+			{
+				inside = !inside;
+			}
+		}
+
+		return inside;
+	}
+
+	static void TriangulateQuad( const FaceCorner* face, const std::vector<float>& v, std::vector<FaceCorner>& triangles )
+	{
+		for ( uint32_t k = 0; k < 4; k++ )
+		{
+			if ( 3 * static_cast<size_t>(face[ k ].position) + 2 >= v.size() )
+			{
+				return;
+			}
+		}
+
+		const size_t vi0 = static_cast<size_t>(face[ 0 ].position) * 3;
+		const size_t vi1 = static_cast<size_t>(face[ 1 ].position) * 3;
+		const size_t vi2 = static_cast<size_t>(face[ 2 ].position) * 3;
+		const size_t vi3 = static_cast<size_t>(face[ 3 ].position) * 3;
+
+		// Split along the shorter diagonal
+		const float e02x = v[ vi2 + 0 ] - v[ vi0 + 0 ];
+		const float e02y = v[ vi2 + 1 ] - v[ vi0 + 1 ];
+		const float e02z = v[ vi2 + 2 ] - v[ vi0 + 2 ];
+		const float e13x = v[ vi3 + 0 ] - v[ vi1 + 0 ];
+		const float e13y = v[ vi3 + 1 ] - v[ vi1 + 1 ];
+		const float e13z = v[ vi3 + 2 ] - v[ vi1 + 2 ];
+
+		const float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+		const float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+		if ( sqr02 < sqr13 )
+		{
+			triangles.insert( triangles.end(), { face[ 0 ], face[ 1 ], face[ 2 ], face[ 0 ], face[ 2 ], face[ 3 ] } );
+		}
+		else
+		{
+			triangles.insert( triangles.end(), { face[ 0 ], face[ 1 ], face[ 3 ], face[ 1 ], face[ 2 ], face[ 3 ] } );
+		}
+	}
+
+	static void TriangulatePolygon( const FaceCorner* face, size_t cornerCount, const std::vector<float>& v, std::vector<FaceCorner>& triangles )
+	{
+		// Project onto the two axes the polygon spans the most, judged by the first real corner
+		size_t axes[ 2 ] = { 1, 2 };
+		for ( size_t k = 0; k < cornerCount; k++ )
+		{
+			const auto vi0 = static_cast<size_t>(face[ ( k + 0 ) % cornerCount ].position);
+			const auto vi1 = static_cast<size_t>(face[ ( k + 1 ) % cornerCount ].position);
+			const auto vi2 = static_cast<size_t>(face[ ( k + 2 ) % cornerCount ].position);
+
+			if ( 3 * vi0 + 2 >= v.size() || 3 * vi1 + 2 >= v.size() || 3 * vi2 + 2 >= v.size() )
+			{
+				continue;
+			}
+
+			const float e0x = v[ vi1 * 3 + 0 ] - v[ vi0 * 3 + 0 ];
+			const float e0y = v[ vi1 * 3 + 1 ] - v[ vi0 * 3 + 1 ];
+			const float e0z = v[ vi1 * 3 + 2 ] - v[ vi0 * 3 + 2 ];
+			const float e1x = v[ vi2 * 3 + 0 ] - v[ vi1 * 3 + 0 ];
+			const float e1y = v[ vi2 * 3 + 1 ] - v[ vi1 * 3 + 1 ];
+			const float e1z = v[ vi2 * 3 + 2 ] - v[ vi1 * 3 + 2 ];
+
+			const float cx = std::fabs( e0y * e1z - e0z * e1y );
+			const float cy = std::fabs( e0z * e1x - e0x * e1z );
+			const float cz = std::fabs( e0x * e1y - e0y * e1x );
+			constexpr float epsilon = std::numeric_limits<float>::epsilon();
+
+			if ( cx > epsilon || cy > epsilon || cz > epsilon )
+			{
+				if ( !( cx > cy && cx > cz ) )
+				{
+					axes[ 0 ] = 0;
+					if ( cz > cx && cz > cy )
+					{
+						axes[ 1 ] = 1;
+					}
+				}
+				break;
+			}
+		}
+
+		// Ear clipping
+		std::vector<FaceCorner> remaining{ face, face + cornerCount };
+		size_t guess = 0;
+		size_t remainingIterations = cornerCount;
+		size_t previousRemaining = cornerCount;
+
+		while ( remaining.size() > 3 && remainingIterations > 0 )
+		{
+			const size_t count = remaining.size();
+			if ( guess >= count )
+			{
+				guess -= count;
+			}
+
+			if ( previousRemaining != count )
+			{
+				previousRemaining = count;
+				remainingIterations = count;
+			}
+			else
+			{
+				remainingIterations--;
+			}
+
+			FaceCorner ear[ 3 ];
+			float vx[ 3 ];
+			float vy[ 3 ];
+			for ( size_t k = 0; k < 3; k++ )
+			{
+				ear[ k ] = remaining[ ( guess + k ) % count ];
+				const auto vi = static_cast<size_t>(ear[ k ].position);
+				if ( vi * 3 + axes[ 0 ] >= v.size() || vi * 3 + axes[ 1 ] >= v.size() )
+				{
+					vx[ k ] = 0.0f;
+					vy[ k ] = 0.0f;
+				}
+				else
+				{
+					vx[ k ] = v[ vi * 3 + axes[ 0 ] ];
+					vy[ k ] = v[ vi * 3 + axes[ 1 ] ];
+				}
+			}
+
+			const float e0x = vx[ 1 ] - vx[ 0 ];
+			const float e0y = vy[ 1 ] - vy[ 0 ];
+			const float e1x = vx[ 2 ] - vx[ 1 ];
+			const float e1y = vy[ 2 ] - vy[ 1 ];
+			const float cross = e0x * e1y - e0y * e1x;
+			const float area = ( vx[ 0 ] * vy[ 1 ] - vy[ 0 ] * vx[ 1 ] ) * 0.5f;
+
+			// Reflex corner
+			if ( cross * area < 0.0f )
+			{
+				guess++;
+				continue;
+			}
+
+			bool overlap = false;
+			for ( size_t other = 3; other < count; other++ )
+			{
+				const auto ovi = static_cast<size_t>(remaining[ ( guess + other ) % count ].position);
+				if ( ovi * 3 + axes[ 0 ] >= v.size() || ovi * 3 + axes[ 1 ] >= v.size() )
+				{
+					continue;
+				}
+
+				if ( IsInsideTriangle( vx, vy, v[ ovi * 3 + axes[ 0 ] ], v[ ovi * 3 + axes[ 1 ] ] ) )
+				{
+					overlap = true;
+					break;
+				}
+			}
+
+			if ( overlap )
+			{
+				guess++;
+				continue;
+			}
+
+			triangles.insert( triangles.end(), { ear[ 0 ], ear[ 1 ], ear[ 2 ] } );
+			remaining.erase( remaining.begin() + static_cast<std::ptrdiff_t>(( guess + 1 ) % count) );
+		}
+
+		if ( remaining.size() == 3 )
+		{
+			triangles.insert( triangles.end(), { remaining[ 0 ], remaining[ 1 ], remaining[ 2 ] } );
+		}
+	}
+
+	static void TriangulateChunk( ObjChunk& chunk, const std::vector<float>& positions )
+	{
+		chunk.triangles.reserve( chunk.corners.size() * 3 / 2 );
+
+		const FaceCorner* face = chunk.corners.data();
+		for ( const uint32_t faceSize : chunk.faceSizes )
+		{
+			if ( faceSize == 3 )
+			{
+				chunk.triangles.insert( chunk.triangles.end(), { face[ 0 ], face[ 1 ], face[ 2 ] } );
+			}
+			else if ( faceSize == 4 )
+			{
+				TriangulateQuad( face, positions, chunk.triangles );
+			}
+			else if ( faceSize > 4 )
+			{
+				TriangulatePolygon( face, faceSize, positions, chunk.triangles );
+			}
+
+			face += faceSize;
+		}
+	}
+
+	// ####   Deduplication   ####
+
+	struct ObjAttributes
+	{
+		std::vector<float> positions = {};
+		std::vector<float> colors = {};
+		std::vector<float> normals = {};
+		std::vector<float> texcoords = {};
+	};
+
+	static AxeModel::Vertex MakeVertex( const FaceCorner& corner, const ObjAttributes& attributes )
+	{
+		AxeModel::Vertex vertex = {};
+
+		if ( corner.position >= 0 )
+		{
+			const size_t i = static_cast<size_t>(corner.position) * 3;
+			if ( i + 2 >= attributes.positions.size() )
+			{
+				throw std::runtime_error( "Face references a vertex position that doesn't exist" );
+			}
+
+			vertex.position = { attributes.positions[ i + 0 ], attributes.positions[ i + 1 ], attributes.positions[ i + 2 ] };
+			vertex.color = { attributes.colors[ i + 0 ], attributes.colors[ i + 1 ], attributes.colors[ i + 2 ] };
+		}
+
+		if ( corner.normal >= 0 )
+		{
+			const size_t i = static_cast<size_t>(corner.normal) * 3;
+			if ( i + 2 >= attributes.normals.size() )
+			{
+				throw std::runtime_error( "Face references a vertex normal that doesn't exist" );
+			}
+
+			vertex.normal = { attributes.normals[ i + 0 ], attributes.normals[ i + 1 ], attributes.normals[ i + 2 ] };
+		}
+
+		if ( corner.texcoord >= 0 )
+		{
+			const size_t i = static_cast<size_t>(corner.texcoord) * 2;
+			if ( i + 1 >= attributes.texcoords.size() )
+			{
+				throw std::runtime_error( "Face references a texture coordinate that doesn't exist" );
+			}
+
+			vertex.uv = { attributes.texcoords[ i + 0 ], attributes.texcoords[ i + 1 ] };
+		}
+
+		return vertex;
+	}
+
+	// Local first occurrence order within each chunk, merged chunk by chunk, is the same as the global first occurrence order
+	static void DeduplicateChunk( ObjChunk& chunk, const ObjAttributes& attributes )
+	{
+		AxeVertexWelder::Table uniqueVertices{ chunk.vertices, chunk.triangles.size() / 4 };
+
+		chunk.indices.reserve( chunk.triangles.size() );
+
+		for ( const FaceCorner& corner : chunk.triangles )
+		{
+			const AxeModel::Vertex vertex = MakeVertex( corner, attributes );
+			const uint64_t hash = AxeVertexWelder::Hash( vertex );
+
+			// Hashes are kept for the merge, which then doesn't have to hash the vertex again
+			const uint32_t index = uniqueVertices.Insert( vertex, hash );
+			if ( index == chunk.vertexHashes.size() )
+			{
+				chunk.vertexHashes.push_back( hash );
+			}
+
+			chunk.indices.push_back( index );
+		}
+
+		chunk.triangles = {};
+	}
+
+	// ####   Chunking   ####
+
+	static std::vector<ObjChunk> SplitIntoChunks( const char* data, const size_t size, const uint32_t threadCount )
+	{
+		const size_t targetCount = std::max<size_t>( 1, std::min<size_t>( size / AxeObjParser::MIN_CHUNK_SIZE, static_cast<size_t>(threadCount) * AxeObjParser::CHUNKS_PER_THREAD ) );
+		const size_t targetSize = size / targetCount;
+
+		std::vector<ObjChunk> chunks = {};
+		chunks.reserve( targetCount );
+
+		const char* const end = data + size;
+		const char* begin = data;
+
+		while ( begin < end )
+		{
+			// Cut right after the next line break, keeping \r\n together
+			const char* chunkEnd = begin + std::min<size_t>( targetSize, end - begin );
+			while ( chunkEnd < end && *chunkEnd != '\n' && *chunkEnd != '\r' )
+			{
+				chunkEnd++;
+			}
+
+			if ( chunkEnd < end && *chunkEnd == '\r' )
+			{
+				chunkEnd++;
+			}
+			if ( chunkEnd < end && *chunkEnd == '\n' )
+			{
+				chunkEnd++;
+			}
+
+			ObjChunk& chunk = chunks.emplace_back();
+			chunk.begin = begin;
+			chunk.end = chunkEnd;
+
+			begin = chunkEnd;
+		}
+
+		return chunks;
+	}
+
+	// ####   Parser   ####
+
+	// Chunk errors hold their line within the chunk, the file's line number needs the line counts of the chunks before it
+	static void ThrowChunkError( const std::vector<ObjChunk>& chunks, const std::string& filePath )
+	{
+		size_t lineBase = 0;
+		for ( const ObjChunk& chunk : chunks )
+		{
+			if ( !chunk.error.empty() )
+			{
+				throw std::runtime_error( chunk.error + " (line " + std::to_string( lineBase + chunk.errorLine ) + " of '" + filePath + "')" );
+			}
+
+			lineBase += chunk.lineCount;
+		}
+	}
+
+	void AxeObjParser::Parse(
+		const std::string& filePath,
+		std::vector<AxeModel::Vertex>& vertices,
+		std::vector<uint32_t>& indices,
+		AxeThreadPool& threadPool )
+	{
+		const AxeMappedFile file{ filePath };
+		const auto* data = reinterpret_cast<const char*>(file.Data());
+
+		std::vector<ObjChunk> chunks = SplitIntoChunks( data, file.Size(), threadPool.GetThreadCount() );
+		const auto chunkCount = static_cast<uint32_t>(chunks.size());
+
+		threadPool.ParallelFor( chunkCount, [&chunks]( const uint32_t i ) { ParseChunk( chunks[ i ] ); } );
+		ThrowChunkError( chunks, filePath );
+
+		// Attribute offsets of each chunk
+		ObjAttributes attributes = {};
+		size_t positionFloats = 0;
+		size_t normalFloats = 0;
+		size_t texcoordFloats = 0;
+
+		for ( ObjChunk& chunk : chunks )
+		{
+			chunk.positionBase = static_cast<uint32_t>(positionFloats / 3);
+			chunk.normalBase = static_cast<uint32_t>(normalFloats / 3);
+			chunk.texcoordBase = static_cast<uint32_t>(texcoordFloats / 2);
+
+			positionFloats += chunk.positions.size();
+			normalFloats += chunk.normals.size();
+			texcoordFloats += chunk.texcoords.size();
+		}
+
+		attributes.positions.resize( positionFloats );
+		attributes.colors.resize( positionFloats );
+		attributes.normals.resize( normalFloats );
+		attributes.texcoords.resize( texcoordFloats );
+
+		threadPool.ParallelFor( chunkCount, [&chunks, &attributes]( const uint32_t i )
+		{
+			ObjChunk& chunk = chunks[ i ];
+
+			std::ranges::copy( chunk.positions, attributes.positions.begin() + chunk.positionBase * 3ull );
+			std::ranges::copy( chunk.colors, attributes.colors.begin() + chunk.positionBase * 3ull );
+			std::ranges::copy( chunk.normals, attributes.normals.begin() + chunk.normalBase * 3ull );
+			std::ranges::copy( chunk.texcoords, attributes.texcoords.begin() + chunk.texcoordBase * 2ull );
+
+			chunk.positions = {};
+			chunk.colors = {};
+			chunk.normals = {};
+			chunk.texcoords = {};
+
+			for ( const RelativeIndex& relative : chunk.relativeIndices )
+			{
+				int32_t& index = chunk.corners[ relative.corner ].*relative.attribute;
+
+				if ( relative.attribute == &FaceCorner::position )
+				{
+					index += static_cast<int32_t>(chunk.positionBase);
+				}
+				else if ( relative.attribute == &FaceCorner::normal )
+				{
+					index += static_cast<int32_t>(chunk.normalBase);
+				}
+				else
+				{
+					index += static_cast<int32_t>(chunk.texcoordBase);
+				}
+
+				// Left negative it would read as a missing attribute and silently drop or empty the corner
+				if ( index < 0 && chunk.error.empty() )
+				{
+					chunk.errorLine = relative.line;
+					chunk.error = "Failed to parse face, relative index points before the start of the file";
+				}
+			}
+		} );
+
+		ThrowChunkError( chunks, filePath );
+
+		threadPool.ParallelFor( chunkCount, [&chunks, &attributes]( const uint32_t i )
+		{
+			ObjChunk& chunk = chunks[ i ];
+
+			TriangulateChunk( chunk, attributes.positions );
+			chunk.corners = {};
+
+			DeduplicateChunk( chunk, attributes );
+		} );
+
+		// The only sequential step, it touches each chunk's unique vertices once
+		vertices.clear();
+		indices.clear();
+
+		size_t localVertexCount = 0;
+		for ( const ObjChunk& chunk : chunks )
+		{
+			localVertexCount += chunk.vertices.size();
+		}
+
+		vertices.reserve( localVertexCount );
+		AxeVertexWelder::Table uniqueVertices{ vertices, localVertexCount };
+		size_t indexCount = 0;
+
+		for ( ObjChunk& chunk : chunks )
+		{
+			chunk.vertexRemap.resize( chunk.vertices.size() );
+
+			for ( size_t i = 0; i < chunk.vertices.size(); i++ )
+			{
+				chunk.vertexRemap[ i ] = uniqueVertices.Insert( chunk.vertices[ i ], chunk.vertexHashes[ i ] );
+			}
+
+			chunk.vertices = {};
+			chunk.vertexHashes = {};
+			chunk.indexBase = indexCount;
+			indexCount += chunk.indices.size();
+		}
+
+		indices.resize( indexCount );
+
+		threadPool.ParallelFor( chunkCount, [&chunks, &indices]( const uint32_t i )
+		{
+			const ObjChunk& chunk = chunks[ i ];
+
+			for ( size_t k = 0; k < chunk.indices.size(); k++ )
+			{
+				indices[ chunk.indexBase + k ] = chunk.vertexRemap[ chunk.indices[ k ] ];
+			}
+		} );
+	}
+}
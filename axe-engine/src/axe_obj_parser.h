@@ -0,0 +1,28 @@
+#pragma once
+
+#include "axe_model.h"
+#include "axe_thread_pool.h"
+
+#include <string>
+#include <vector>
+
+namespace Axe
+{
+	// Wavefront OBJ loader working directly on a memory mapping of the file.
+	// The file is cut into line aligned chunks which are parsed, triangulated and deduplicated in parallel,
+	// then merged in file order. The result is identical to running tinyobjloader and deduplicating its output.
+	class AxeObjParser
+	{
+	public:
+		// Chunks smaller than this aren't worth the scheduling overhead
+		static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+		static constexpr uint32_t CHUNKS_PER_THREAD = 4;
+
+		// Throws with the offending line number on malformed faces, like tinyobjloader would fail the load
+		static void Parse(
+			const std::string& filePath,
+			std::vector<AxeModel::Vertex>& vertices,
+			std::vector<uint32_t>& indices,
+			AxeThreadPool& threadPool = AxeThreadPool::Shared() );
+	};
+}
@@ -1,5 +1,6 @@
 ﻿#include "axe_pipeline.h"
 
+#include "axe_asset_pack.h"
 #include "axe_model.h"
 
 #include <fstream>
@@ -20,11 +21,19 @@ namespace Axe
 		CreateGraphicsPipeline( vertFilePath, fragFilePath, pipelineConfig );
 	}
 
+	AxePipeline::AxePipeline( AxeDevice& device, const VkPipelineLayout pipelineLayout, const std::string& compFilePath )
+		: axeDevice{ device },
+		  bindPoint{ VK_PIPELINE_BIND_POINT_COMPUTE }
+	{
+		CreateComputePipeline( pipelineLayout, compFilePath );
+	}
+
 	AxePipeline::~AxePipeline()
 	{
 		vkDestroyShaderModule( axeDevice.Device(), vertShaderModule, nullptr );
 		vkDestroyShaderModule( axeDevice.Device(), fragShaderModule, nullptr );
-		vkDestroyPipeline( axeDevice.Device(), graphicsPipeline, nullptr );
+		vkDestroyShaderModule( axeDevice.Device(), compShaderModule, nullptr );
+		vkDestroyPipeline( axeDevice.Device(), pipeline, nullptr );
 	}
 
 
@@ -66,11 +75,8 @@ namespace Axe
 
 		// ####################   Setup shader modules   ####################
 
-		const auto vertCode = ReadFile( vertFilePath );
-		const auto fragCode = ReadFile( fragFilePath );
-
-		CreateShaderModule( vertCode, &vertShaderModule );
-		CreateShaderModule( fragCode, &fragShaderModule );
+		CreateShaderModule( vertFilePath, &vertShaderModule );
+		CreateShaderModule( fragFilePath, &fragShaderModule );
 
 		// ####################   Setup shader stages from shader modules   ####################
 
@@ -127,13 +133,52 @@ namespace Axe
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = nullptr;
 
-		if ( vkCreateGraphicsPipelines( axeDevice.Device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline ) != VK_SUCCESS )
+		if ( vkCreateGraphicsPipelines( axeDevice.Device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
 		{
 			throw std::runtime_error( "Failed to create graphics pipeline" );
 		}
 	}
 
-	void AxePipeline::CreateShaderModule( const std::vector<char>& shaderCode, VkShaderModule* shaderModule ) const
+	void AxePipeline::CreateComputePipeline( const VkPipelineLayout pipelineLayout, const std::string& compFilePath )
+	{
+		assert( pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided" );
+
+		CreateShaderModule( compFilePath, &compShaderModule );
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = compShaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = nullptr;
+
+		if ( vkCreateComputePipelines( axeDevice.Device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to create compute pipeline" );
+		}
+	}
+
+	void AxePipeline::CreateShaderModule( const std::string& filePath, VkShaderModule* shaderModule ) const
+	{
+		// Packed SPIR-V goes to Vulkan straight from the pack's mapping, loose files are the fallback during development
+		if ( const AxeAssetPack* pack = AxeAssetPack::Mounted() )
+		{
+			const std::span<const std::byte> packedCode = pack->Find( filePath );
+			if ( !packedCode.empty() )
+			{
+				CreateShaderModule( packedCode, shaderModule );
+				return;
+			}
+		}
+
+		const std::vector<char> shaderCode = ReadFile( filePath );
+		CreateShaderModule( std::as_bytes( std::span{ shaderCode } ), shaderModule );
+	}
+
+	void AxePipeline::CreateShaderModule( const std::span<const std::byte> shaderCode, VkShaderModule* shaderModule ) const
 	{
 		VkShaderModuleCreateInfo createShaderInfo = {};
 		createShaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -148,7 +193,7 @@ namespace Axe
 
 	void AxePipeline::Bind( const VkCommandBuffer commandBuffer ) const
 	{
-		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline );
+		vkCmdBindPipeline( commandBuffer, bindPoint, pipeline );
 	}
 
 	void AxePipeline::DefaultPipelineConfigInfo( PipelineConfigInfo& pipelineConfig )
@@ -2,6 +2,8 @@
 
 #include "axe_device.h"
 
+#include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -45,6 +47,8 @@ namespace Axe
 			const std::string& vertFilePath,
 			const std::string& fragFilePath
 		);
+		// A compute pipeline, bound to the compute bind point
+		AxePipeline( AxeDevice& device, VkPipelineLayout pipelineLayout, const std::string& compFilePath );
 		~AxePipeline();
 
 		AxePipeline( const AxePipeline& ) = delete;
@@ -59,9 +63,11 @@ namespace Axe
 
 	private:
 		AxeDevice& axeDevice;	// This will outlive any instance of AxePipeline, so it won't turn into a dangling pointer
-		VkPipeline graphicsPipeline = {};
+		VkPipeline pipeline = {};
+		VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		VkShaderModule vertShaderModule = {};
 		VkShaderModule fragShaderModule = {};
+		VkShaderModule compShaderModule = {};
 
 		static std::vector<char> ReadFile( const std::string& filepath );
 
@@ -70,7 +76,10 @@ namespace Axe
 			const std::string& fragFilePath,
 			const PipelineConfigInfo& pipelineConfig
 		);
+		void CreateComputePipeline( VkPipelineLayout pipelineLayout, const std::string& compFilePath );
 
-		void CreateShaderModule( const std::vector<char>& shaderCode, VkShaderModule* shaderModule ) const;
+		// Reads the SPIR-V from the mounted asset pack if it's in there, otherwise from the loose file
+		void CreateShaderModule( const std::string& filePath, VkShaderModule* shaderModule ) const;
+		void CreateShaderModule( std::span<const std::byte> shaderCode, VkShaderModule* shaderModule ) const;
 	};
 }
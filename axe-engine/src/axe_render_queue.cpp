@@ -0,0 +1,117 @@
+#include "axe_render_queue.h"
+
+// std headers
+#include <bit>
+#include <cassert>
+#include <utility>
+
+namespace Axe
+{
+	static_assert( 1 + AxeRenderQueue::PIPELINE_BITS + AxeRenderQueue::MATERIAL_BITS + AxeRenderQueue::MODEL_BITS + AxeRenderQueue::DEPTH_BITS == 64,
+		"The key's fields have to fill all 64 bits" );
+
+	static constexpr uint64_t TRANSPARENT_BIT = 1ull << 63;
+	static constexpr uint64_t MODEL_MASK = ( 1ull << AxeRenderQueue::MODEL_BITS ) - 1;
+	static constexpr uint64_t DEPTH_MASK = ( 1ull << AxeRenderQueue::DEPTH_BITS ) - 1;
+
+	uint64_t AxeRenderQueue::QuantizeDepth( const float depth )
+	{
+		// Also turns NaN into 0
+		const float clampedDepth = depth > 0.0f ? depth : 0.0f;
+		return std::bit_cast<uint32_t>( clampedDepth ) >> ( 31 - DEPTH_BITS );
+	}
+
+	uint64_t AxeRenderQueue::MakeOpaqueKey( const uint32_t pipeline, const uint32_t material, const uint32_t model, const float depth )
+	{
+		assert( pipeline < 1u << PIPELINE_BITS && "Too many pipelines for the render queue's keys" );
+		assert( material < 1u << MATERIAL_BITS && "Too many materials for the render queue's keys" );
+
+		// State first, so packets sharing it end up together, and nearer ones first within them so the depth test rejects more of the farther ones
+		return static_cast<uint64_t>(pipeline) << ( MATERIAL_BITS + MODEL_BITS + DEPTH_BITS ) |
+		       static_cast<uint64_t>(material) << ( MODEL_BITS + DEPTH_BITS ) |
+		       ( model & MODEL_MASK ) << DEPTH_BITS |
+		       QuantizeDepth( depth );
+	}
+
+	uint64_t AxeRenderQueue::MakeTransparentKey( const uint32_t pipeline, const uint32_t material, const uint32_t model, const float depth )
+	{
+		assert( pipeline < 1u << PIPELINE_BITS && "Too many pipelines for the render queue's keys" );
+		assert( material < 1u << MATERIAL_BITS && "Too many materials for the render queue's keys" );
+
+		// Blending needs the farthest first, the state only breaks ties
+		return TRANSPARENT_BIT |
+		       ( DEPTH_MASK - QuantizeDepth( depth ) ) << ( PIPELINE_BITS + MATERIAL_BITS + MODEL_BITS ) |
+		       static_cast<uint64_t>(pipeline) << ( MATERIAL_BITS + MODEL_BITS ) |
+		       static_cast<uint64_t>(material) << MODEL_BITS |
+		       ( model & MODEL_MASK );
+	}
+
+	void AxeRenderQueue::Sort()
+	{
+		const size_t count = packets.size();
+		// Below this the radix sort's fixed cost of clearing and summing its histograms outweighs the quadratic number of moves
+		if ( count <= INSERTION_SORT_THRESHOLD )
+		{
+			for ( size_t i = 1; i < count; i++ )
+			{
+				const Packet packet = packets[ i ];
+				size_t j = i;
+				for ( ; j > 0 && packets[ j - 1 ].key > packet.key; j-- )
+				{
+					packets[ j ] = packets[ j - 1 ];
+				}
+				packets[ j ] = packet;
+			}
+
+			return;
+		}
+
+		scratch.resize( count );
+
+		// Every digit's histogram in a single pass over the keys
+		uint32_t histograms[ DIGIT_COUNT ][ RADIX_SIZE ] = {};
+		for ( const Packet& packet : packets )
+		{
+			for ( uint32_t digit = 0; digit < DIGIT_COUNT; digit++ )
+			{
+				histograms[ digit ][ ( packet.key >> ( digit * RADIX_BITS ) ) & ( RADIX_SIZE - 1 ) ]++;
+			}
+		}
+
+		Packet* source = packets.data();
+		Packet* destination = scratch.data();
+
+		for ( uint32_t digit = 0; digit < DIGIT_COUNT; digit++ )
+		{
+			const uint32_t shift = digit * RADIX_BITS;
+			uint32_t* histogram = histograms[ digit ];
+
+			// Digits every key shares wouldn't move anything, which skips most passes as the keys' fields are rarely full
+			if ( histogram[ ( source[ 0 ].key >> shift ) & ( RADIX_SIZE - 1 ) ] == count )
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for ( uint32_t bucket = 0; bucket < RADIX_SIZE; bucket++ )
+			{
+				const uint32_t bucketCount = histogram[ bucket ];
+				histogram[ bucket ] = offset;
+				offset += bucketCount;
+			}
+
+			for ( size_t i = 0; i < count; i++ )
+			{
+				destination[ histogram[ ( source[ i ].key >> shift ) & ( RADIX_SIZE - 1 ) ]++ ] = source[ i ];
+			}
+
+			std::swap( source, destination );
+		}
+
+		// An odd number of passes leaves the result in the scratch array, swapping keeps both allocations around
+		if ( source != packets.data() )
+		{
+			packets.swap( scratch );
+		}
+	}
+}
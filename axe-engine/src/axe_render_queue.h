@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Draw packets of a frame ordered by 64-bit keys, so a render system records them with as few state changes and as little overdraw as possible.
+	// Opaque keys sort by pipeline, material, model and then front to back, transparent keys come after all opaque ones and sort back to front first.
+	// The packets are sorted with an LSD radix sort into a scratch array that is kept between frames, so a frame doesn't allocate once the arrays are large enough
+	class AxeRenderQueue
+	{
+	public:
+		// Widths of the key's fields, the top bit tells transparent packets apart.
+		// Pipelines and materials have to fit, model ids are masked and only cost some batching once they wrap around
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t MATERIAL_BITS = 12;
+		static constexpr uint32_t MODEL_BITS = 20;
+		static constexpr uint32_t DEPTH_BITS = 23;
+
+		// The key and what the render system needs to find the draw again, usually an index into its own array of the frame's draws
+		struct Packet
+		{
+			uint64_t key = 0;
+			uint32_t payload = 0;
+		};
+
+		// Depth is any distance that grows away from the camera, negative depths count as 0
+		[[nodiscard]] static uint64_t MakeOpaqueKey( uint32_t pipeline, uint32_t material, uint32_t model, float depth );
+		[[nodiscard]] static uint64_t MakeTransparentKey( uint32_t pipeline, uint32_t material, uint32_t model, float depth );
+
+		// Forgets the last frame's packets, keeping the memory
+		void Clear() { packets.clear(); }
+		void Submit( const uint64_t key, const uint32_t payload ) { packets.push_back( { key, payload } ); }
+
+		// Stable, packets with equal keys stay in the order they were submitted in
+		void Sort();
+
+		[[nodiscard]] std::span<const Packet> GetPackets() const { return packets; }
+
+	private:
+		static constexpr uint32_t RADIX_BITS = 8;
+		static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+		static constexpr uint32_t DIGIT_COUNT = 64 / RADIX_BITS;
+		static constexpr size_t INSERTION_SORT_THRESHOLD = 64;
+
+		std::vector<Packet> packets = {};
+		std::vector<Packet> scratch = {};
+
+		// The top DEPTH_BITS of the float's bits, which order the same as the non-negative floats themselves
+		[[nodiscard]] static uint64_t QuantizeDepth( float depth );
+	};
+}
@@ -1,5 +1,7 @@
 ﻿#include "axe_renderer.h"
 
+#include "axe_thread_pool.h"
+
 #include <stdexcept>
 #include <array>
 
@@ -10,10 +12,12 @@ namespace Axe
 	{
 		RecreateSwapChain();
 		CreateCommandBuffers();
+		CreateWorkerCommandPools();
 	}
 
 	AxeRenderer::~AxeRenderer()
 	{
+		DestroyWorkerCommandPools();
 		FreeCommandBuffers();
 	}
 
@@ -39,6 +43,16 @@ namespace Axe
 
 		isFrameStarted = true;
 
+		// Acquiring the image waited on the frame's fence, so none of the secondary command buffers the frame recorded last time are in use anymore
+		for ( WorkerCommandPool& workerCommandPool : workerCommandPools[ currentFrameIndex ] )
+		{
+			if ( vkResetCommandPool( axeDevice.Device(), workerCommandPool.commandPool, 0 ) != VK_SUCCESS )
+			{
+				throw std::runtime_error( "Failed to reset worker command pool" );
+			}
+			workerCommandPool.usedCount = 0;
+		}
+
 		const auto commandBuffer = GetCurrentCommandBuffer();
 
 
@@ -83,7 +97,7 @@ namespace Axe
 		currentFrameIndex = (currentFrameIndex + 1) % AxeSwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void AxeRenderer::BeginSwapChainRenderPass( const VkCommandBuffer commandBuffer ) const
+	void AxeRenderer::BeginSwapChainRenderPass( const VkCommandBuffer commandBuffer, const VkSubpassContents contents ) const
 	{
 		assert( isFrameStarted && "Cannot call BeginSwapChainRenderPass() while frame is not in progress" );
 		assert( commandBuffer == GetCurrentCommandBuffer() && "Cannot begin render pass on a command buffer from a different frame" );
@@ -103,8 +117,16 @@ namespace Axe
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+		vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, contents );
+
+		if ( contents == VK_SUBPASS_CONTENTS_INLINE )
+		{
+			SetViewportAndScissor( commandBuffer );
+		}
+	}
 
+	void AxeRenderer::SetViewportAndScissor( const VkCommandBuffer commandBuffer ) const
+	{
 		// Set the dynamic viewport and scissor values
 		VkViewport viewport;
 		viewport.x = 0.0f;
@@ -128,6 +150,72 @@ namespace Axe
 		vkCmdEndRenderPass( commandBuffer );
 	}
 
+	VkCommandBuffer AxeRenderer::BeginSecondaryCommandBuffer( const uint32_t worker )
+	{
+		assert( isFrameStarted && "Cannot begin a secondary command buffer while frame is not in progress" );
+		assert( worker < workerCount && "Worker index out of range" );
+
+		WorkerCommandPool& workerCommandPool = workerCommandPools[ currentFrameIndex ][ worker ];
+
+		if ( workerCommandPool.usedCount == workerCommandPool.commandBuffers.size() )
+		{
+			VkCommandBufferAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandPool = workerCommandPool.commandPool;
+			allocateInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			if ( vkAllocateCommandBuffers( axeDevice.Device(), &allocateInfo, &commandBuffer ) != VK_SUCCESS )
+			{
+				throw std::runtime_error( "Failed to allocate secondary command buffer" );
+			}
+			workerCommandPool.commandBuffers.push_back( commandBuffer );
+		}
+
+		const VkCommandBuffer commandBuffer = workerCommandPool.commandBuffers[ workerCommandPool.usedCount++ ];
+
+		BeginSecondary( commandBuffer, axeSwapChain->GetFrameBuffer( currentImageIndex ), VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+
+		return commandBuffer;
+	}
+
+	void AxeRenderer::BeginCachedSecondaryCommandBuffer( const VkCommandBuffer commandBuffer ) const
+	{
+		// Without a framebuffer it can be executed in the render pass of any swap chain image, which is all that changes between frames
+		BeginSecondary( commandBuffer, VK_NULL_HANDLE, 0 );
+	}
+
+	void AxeRenderer::BeginSecondary( const VkCommandBuffer commandBuffer, const VkFramebuffer framebuffer, const VkCommandBufferUsageFlags flags ) const
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = axeSwapChain->GetRenderPass();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if ( vkBeginCommandBuffer( commandBuffer, &beginInfo ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to begin recording secondary command buffer" );
+		}
+
+		// Secondary command buffers don't inherit dynamic state from the primary one
+		SetViewportAndScissor( commandBuffer );
+	}
+
+	void AxeRenderer::EndSecondaryCommandBuffer( const VkCommandBuffer commandBuffer ) const
+	{
+		if ( vkEndCommandBuffer( commandBuffer ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to end recording secondary command buffer" );
+		}
+	}
+
 	void AxeRenderer::RecreateSwapChain()
 	{
 		// Wait until the current swap chain is no longer being used
@@ -156,6 +244,9 @@ namespace Axe
 				throw std::runtime_error("Swap chain image (or depth) format has changed");
 			}
 		}
+
+		// The render pass and the extent baked into the viewport of cached command buffers are gone with the old swap chain
+		swapChainGeneration++;
 	}
 
 	void AxeRenderer::CreateCommandBuffers()
@@ -174,6 +265,42 @@ namespace Axe
 		}
 	}
 
+	void AxeRenderer::CreateWorkerCommandPools()
+	{
+		workerCount = AxeThreadPool::Shared().GetThreadCount() + 1;
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = axeDevice.FindPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		workerCommandPools.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		for ( std::vector<WorkerCommandPool>& framePools : workerCommandPools )
+		{
+			framePools.resize( workerCount );
+			for ( WorkerCommandPool& workerCommandPool : framePools )
+			{
+				if ( vkCreateCommandPool( axeDevice.Device(), &poolInfo, nullptr, &workerCommandPool.commandPool ) != VK_SUCCESS )
+				{
+					throw std::runtime_error( "Failed to create worker command pool" );
+				}
+			}
+		}
+	}
+
+	void AxeRenderer::DestroyWorkerCommandPools()
+	{
+		// Destroying a pool frees its command buffers
+		for ( const std::vector<WorkerCommandPool>& framePools : workerCommandPools )
+		{
+			for ( const WorkerCommandPool& workerCommandPool : framePools )
+			{
+				vkDestroyCommandPool( axeDevice.Device(), workerCommandPool.commandPool, nullptr );
+			}
+		}
+		workerCommandPools.clear();
+	}
+
 	void AxeRenderer::FreeCommandBuffers()
 	{
 		vkFreeCommandBuffers(
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <cassert>
+#include <vector>
 
 namespace Axe
 {
@@ -36,18 +37,46 @@ namespace Axe
 			return currentFrameIndex;
 		}
 
+		// Changes whenever the swap chain is recreated, command buffers recorded for the old one have to be recorded again
+		[[nodiscard]] uint32_t GetSwapChainGeneration() const { return swapChainGeneration; }
+
+		// How many workers can record secondary command buffers for a frame at the same time, one per thread of the shared thread pool plus the main thread
+		[[nodiscard]] uint32_t GetWorkerCount() const { return workerCount; }
+
 		VkCommandBuffer BeginFrame();
 		void EndFrame();
 
-		void BeginSwapChainRenderPass( VkCommandBuffer commandBuffer ) const;
+		// Secondary command buffers can only be executed in a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+		// which can't have any commands of its own
+		void BeginSwapChainRenderPass( VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE ) const;
 		void EndSwapChainRenderPass( VkCommandBuffer commandBuffer ) const;
 
+		// Begins a secondary command buffer of the current frame that continues the swap chain render pass, with the viewport and scissor set.
+		// Each worker has its own command pools, so different workers can record at the same time as long as each only uses its own index
+		[[nodiscard]] VkCommandBuffer BeginSecondaryCommandBuffer( uint32_t worker );
+		// Begins a secondary command buffer owned by the caller that continues the swap chain render pass on any of its framebuffers, so it can be
+		// executed again in later frames until the swap chain generation changes. Its pool needs VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+		void BeginCachedSecondaryCommandBuffer( VkCommandBuffer commandBuffer ) const;
+		void EndSecondaryCommandBuffer( VkCommandBuffer commandBuffer ) const;
+
 	private:
 		AxeWindow& axeWindow;
 		AxeDevice& axeDevice;
 		std::unique_ptr<AxeSwapChain> axeSwapChain;
 		std::vector<VkCommandBuffer> commandBuffers;
 
+		// A worker's secondary command buffers of one frame in flight, the whole pool is reset once the frame's fence has been waited on
+		struct WorkerCommandPool
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers = {};	// Allocated as needed and reused by the later frames with the same index
+			uint32_t usedCount = 0;
+		};
+
+		uint32_t workerCount = 0;
+		std::vector<std::vector<WorkerCommandPool>> workerCommandPools = {};	// Per frame in flight, then per worker
+
+		uint32_t swapChainGeneration = 0;
 		uint32_t currentImageIndex = 0;
 		int currentFrameIndex = 0;
 		bool isFrameStarted = false;
@@ -55,5 +84,9 @@ namespace Axe
 		void RecreateSwapChain();
 		void CreateCommandBuffers();
 		void FreeCommandBuffers();
+		void CreateWorkerCommandPools();
+		void DestroyWorkerCommandPools();
+		void SetViewportAndScissor( VkCommandBuffer commandBuffer ) const;
+		void BeginSecondary( VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkCommandBufferUsageFlags flags ) const;
 	};
 }
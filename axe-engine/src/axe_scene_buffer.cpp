@@ -0,0 +1,243 @@
+#include "axe_scene_buffer.h"
+
+#include "axe_frustum_culler.h"
+#include "axe_swap_chain.h"
+
+// std headers
+#include <stdexcept>
+
+namespace Axe
+{
+	static_assert( sizeof( AxeSceneBuffer::Object ) == 144, "Objects are read by the shaders with std430 layout" );
+
+	static void RecordBarrier(
+		VkCommandBuffer commandBuffer,
+		const VkPipelineStageFlags sourceStages,
+		const VkAccessFlags sourceAccess,
+		const VkPipelineStageFlags destinationStages,
+		const VkAccessFlags destinationAccess )
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = sourceAccess;
+		barrier.dstAccessMask = destinationAccess;
+
+		vkCmdPipelineBarrier( commandBuffer, sourceStages, destinationStages, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+	}
+
+	static std::unique_ptr<AxeBuffer> CreateObjectBuffer( AxeDevice& device, const uint32_t capacity )
+	{
+		return std::make_unique<AxeBuffer>(
+			device,
+			sizeof( AxeSceneBuffer::Object ),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+	}
+
+	static std::unique_ptr<AxeBuffer> CreateStagingBuffer( AxeDevice& device, const uint32_t capacity )
+	{
+		auto buffer = std::make_unique<AxeBuffer>(
+			device,
+			sizeof( AxeSceneBuffer::Object ),
+			capacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+
+		return buffer;
+	}
+
+	AxeSceneBuffer::AxeSceneBuffer( AxeDevice& device )
+		: axeDevice{ device }
+	{
+		objectBuffer = CreateObjectBuffer( axeDevice, INITIAL_CAPACITY );
+
+		stagingBuffers.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		for ( std::unique_ptr<AxeBuffer>& stagingBuffer : stagingBuffers )
+		{
+			stagingBuffer = CreateStagingBuffer( axeDevice, INITIAL_CAPACITY );
+		}
+	}
+
+	uint32_t AxeSceneBuffer::AllocateSlot( const AxeGameObject::UID owner )
+	{
+		uint32_t slot = 0;
+		if ( freeSlots.empty() )
+		{
+			slot = static_cast<uint32_t>(slots.size());
+			slots.emplace_back();
+		}
+		else
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+
+		slots[ slot ] = {};
+		slots[ slot ].owner = owner;
+		slots[ slot ].used = true;
+
+		return slot;
+	}
+
+	void AxeSceneBuffer::GrowObjectBuffer( VkCommandBuffer commandBuffer )
+	{
+		uint32_t capacity = objectBuffer->GetInstanceCount();
+		while ( capacity < slots.size() )
+		{
+			capacity *= 2;
+		}
+
+		std::unique_ptr<AxeBuffer> grownBuffer = CreateObjectBuffer( axeDevice, capacity );
+
+		// Objects that didn't change this frame are only in the old buffer
+		VkBufferCopy copyRegion = {};
+		copyRegion.size = objectBuffer->GetBufferSize();
+		vkCmdCopyBuffer( commandBuffer, objectBuffer->GetBufferHandle(), grownBuffer->GetBufferHandle(), 1, &copyRegion );
+
+		retiredBuffers.push_back( { std::move( objectBuffer ), updateCount } );
+		objectBuffer = std::move( grownBuffer );
+		generation++;
+	}
+
+	void AxeSceneBuffer::Update( VkCommandBuffer commandBuffer, const int frameIndex, AxeGameObject::Map& gameObjects )
+	{
+		updateCount++;
+		statistics = {};
+
+		// A retired buffer was last used by the frame that replaced it, whose fence has been waited on once its frame index comes around again
+		std::erase_if(
+			retiredBuffers,
+			[this]( const RetiredBuffer& retiredBuffer ) { return updateCount - retiredBuffer.retiredAt >= AxeSwapChain::MAX_FRAMES_IN_FLIGHT; } );
+
+		uploads.clear();
+		copyRegions.clear();
+
+		for ( auto& [ id, gameObject ] : gameObjects )
+		{
+			if ( gameObject.model == nullptr )
+			{
+				continue;
+			}
+
+			statistics.objectCount++;
+
+			// A slot that isn't the object's anymore means the object is new or was given a slot by an earlier scene buffer
+			bool changed = false;
+			if ( gameObject.sceneSlot >= slots.size() || !slots[ gameObject.sceneSlot ].used || slots[ gameObject.sceneSlot ].owner != id )
+			{
+				gameObject.sceneSlot = AllocateSlot( id );
+				changed = true;
+			}
+
+			Slot& slot = slots[ gameObject.sceneSlot ];
+			slot.lastSeen = updateCount;
+
+			const AxeModel& model = *gameObject.model;
+			changed |= slot.modelId != model.GetId() || slot.transform != gameObject.transform;
+			if ( !changed )
+			{
+				continue;
+			}
+
+			slot.modelId = model.GetId();
+			slot.transform = gameObject.transform;
+			slot.modelMatrix = gameObject.transform.Mat4();
+			slot.boundingSphere = AxeFrustumCuller::TransformSphere( model.GetBoundingSphere(), slot.modelMatrix );
+
+			Object object = {};
+			object.modelMatrix = slot.modelMatrix * model.GetDequantizationMatrix();
+			object.normalMatrix = gameObject.transform.NormalMatrix();
+			object.boundingSphere = slot.boundingSphere;
+
+			// The uploads are packed in order, so an object right after the last region's slots extends it
+			const VkDeviceSize destinationOffset = static_cast<VkDeviceSize>(gameObject.sceneSlot) * sizeof( Object );
+			if ( !copyRegions.empty() && copyRegions.back().dstOffset + copyRegions.back().size == destinationOffset )
+			{
+				copyRegions.back().size += sizeof( Object );
+			}
+			else
+			{
+				copyRegions.push_back( { uploads.size() * sizeof( Object ), destinationOffset, sizeof( Object ) } );
+			}
+
+			uploads.push_back( object );
+		}
+
+		// Objects that weren't found are gone, their slots can be handed out again from the next update on
+		for ( uint32_t i = 0; i < slots.size(); i++ )
+		{
+			if ( slots[ i ].used && slots[ i ].lastSeen != updateCount )
+			{
+				slots[ i ].used = false;
+				freeSlots.push_back( i );
+			}
+		}
+
+		const bool needsGrowth = slots.size() > objectBuffer->GetInstanceCount();
+		if ( uploads.empty() && !needsGrowth )
+		{
+			return;
+		}
+
+		// The frame's fence has been waited on, so its staging buffer isn't in use anymore
+		std::unique_ptr<AxeBuffer>& stagingBuffer = stagingBuffers[ frameIndex ];
+		if ( uploads.size() > stagingBuffer->GetInstanceCount() )
+		{
+			uint32_t capacity = stagingBuffer->GetInstanceCount();
+			while ( capacity < uploads.size() )
+			{
+				capacity *= 2;
+			}
+			stagingBuffer = CreateStagingBuffer( axeDevice, capacity );
+		}
+
+		if ( !uploads.empty() )
+		{
+			stagingBuffer->WriteToBuffer( uploads.data(), uploads.size() * sizeof( Object ) );
+			if ( stagingBuffer->Flush() != VK_SUCCESS )
+			{
+				throw std::runtime_error( "Error flushing scene staging buffer to GPU" );
+			}
+		}
+
+		// Earlier frames may still be reading the slots about to be overwritten, or copying into them
+		RecordBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT );
+
+		if ( needsGrowth )
+		{
+			GrowObjectBuffer( commandBuffer );
+
+			// The changed objects are copied over what was copied from the old buffer
+			RecordBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT );
+		}
+
+		if ( !copyRegions.empty() )
+		{
+			vkCmdCopyBuffer(
+				commandBuffer,
+				stagingBuffer->GetBufferHandle(),
+				objectBuffer->GetBufferHandle(),
+				static_cast<uint32_t>(copyRegions.size()),
+				copyRegions.data() );
+		}
+
+		RecordBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT );
+
+		statistics.uploadedCount = static_cast<uint32_t>(uploads.size());
+		statistics.uploadedBytes = uploads.size() * sizeof( Object );
+	}
+}
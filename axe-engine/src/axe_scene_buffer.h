@@ -0,0 +1,105 @@
+#pragma once
+
+#include "axe_buffer.h"
+#include "axe_device.h"
+#include "axe_game_object.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Axe
+{
+	// Keeps every game object with a model in a device local buffer at a slot that stays the same for as long as the object exists, so the
+	// shaders fetch an object's matrices and bounds by slot instead of getting them written again every frame.
+	// Update compares each object's transform and model with what was uploaded for its slot and copies only the changed objects over,
+	// as a single scatter copy from a per-frame staging buffer
+	class AxeSceneBuffer
+	{
+	public:
+		static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+		// The buffers start out with room for this many objects and double whenever they run out
+		static constexpr uint32_t INITIAL_CAPACITY = 256;
+
+		// Matches SceneObject in the simple and culling shaders
+		struct Object
+		{
+			glm::mat4 modelMatrix{ 1.0f };	// With the model's dequantization folded in
+			glm::mat4 normalMatrix{ 1.0f };
+			glm::vec4 boundingSphere = {};	// In world space, w is the radius
+		};
+
+		struct Statistics
+		{
+			uint32_t objectCount = 0;
+			uint32_t uploadedCount = 0;
+			VkDeviceSize uploadedBytes = 0;
+		};
+
+		explicit AxeSceneBuffer( AxeDevice& device );
+
+		AxeSceneBuffer( const AxeSceneBuffer& ) = delete;
+		AxeSceneBuffer& operator=( const AxeSceneBuffer& ) = delete;
+		AxeSceneBuffer( const AxeSceneBuffer&& ) = delete;
+		AxeSceneBuffer& operator=( const AxeSceneBuffer&& ) = delete;
+
+		// Gives new game objects with a model a slot, frees the slots of the ones that are gone and records the upload of the changed ones,
+		// outside of a render pass. Barriers make the upload visible to vertex and compute shaders that come after it
+		void Update( VkCommandBuffer commandBuffer, int frameIndex, AxeGameObject::Map& gameObjects );
+
+		// The model matrix without the dequantization and the world space bounding sphere of the slot's object as of the last Update
+		[[nodiscard]] const glm::mat4& GetModelMatrix( const uint32_t slot ) const { return slots[ slot ].modelMatrix; }
+		[[nodiscard]] const glm::vec4& GetBoundingSphere( const uint32_t slot ) const { return slots[ slot ].boundingSphere; }
+
+		[[nodiscard]] VkDescriptorBufferInfo DescriptorInfo() const { return objectBuffer->DescriptorInfo(); }
+		// Changes whenever the object buffer is replaced by a larger one, descriptor sets pointing at it have to be written again
+		[[nodiscard]] uint32_t GetGeneration() const { return generation; }
+
+		// What the last Update call uploaded
+		[[nodiscard]] const Statistics& GetStatistics() const { return statistics; }
+
+	private:
+		// What was last uploaded for a slot, to find the objects that changed
+		struct Slot
+		{
+			AxeGameObject::UID owner = 0;
+			bool used = false;
+			uint64_t lastSeen = 0;	// The Update call that last found the owner
+			uint32_t modelId = 0;
+			TransformComponent transform = {};
+			glm::mat4 modelMatrix{ 1.0f };
+			glm::vec4 boundingSphere = {};
+		};
+
+		// A buffer replaced while earlier frames in flight may still read it, destroyed once they're done
+		struct RetiredBuffer
+		{
+			std::unique_ptr<AxeBuffer> buffer = {};
+			uint64_t retiredAt = 0;
+		};
+
+		AxeDevice& axeDevice;
+
+		std::unique_ptr<AxeBuffer> objectBuffer = {};
+		std::vector<std::unique_ptr<AxeBuffer>> stagingBuffers = {};	// One per frame in flight
+		std::vector<RetiredBuffer> retiredBuffers = {};
+		uint32_t generation = 0;
+
+		std::vector<Slot> slots = {};
+		std::vector<uint32_t> freeSlots = {};
+		uint64_t updateCount = 0;
+
+		// Reused between updates
+		std::vector<Object> uploads = {};
+		std::vector<VkBufferCopy> copyRegions = {};
+
+		Statistics statistics = {};
+
+		// Takes a free slot or adds one, the object buffer is grown to fit after all objects have their slots
+		[[nodiscard]] uint32_t AllocateSlot( AxeGameObject::UID owner );
+		// Replaces the object buffer with one twice as large until all slots fit and records the copy of the old contents
+		void GrowObjectBuffer( VkCommandBuffer commandBuffer );
+	};
+}
@@ -53,7 +53,7 @@ namespace Axe
 		{
 			vkDestroyImageView( device.Device(), depthImageViews[ i ], nullptr );
 			vkDestroyImage( device.Device(), depthImages[ i ], nullptr );
-			vkFreeMemory( device.Device(), depthImageMemoryHandles[ i ], nullptr );
+			device.FreeMemory( depthImageAllocations[ i ] );
 		}
 
 		for ( const auto framebuffer : swapChainFramebuffers )
@@ -347,7 +347,7 @@ namespace Axe
 		const VkExtent2D swapChainImageExtent = GetSwapChainExtent();
 
 		depthImages.resize( ImageCount() );
-		depthImageMemoryHandles.resize( ImageCount() );
+		depthImageAllocations.resize( ImageCount() );
 		depthImageViews.resize( ImageCount() );
 
 		for ( size_t i = 0; i < depthImages.size(); i++ )
@@ -372,7 +372,7 @@ namespace Axe
 				imageInfo,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				depthImages[ i ],
-				depthImageMemoryHandles[ i ] );
+				depthImageAllocations[ i ] );
 
 			VkImageViewCreateInfo viewInfo = {};
 			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
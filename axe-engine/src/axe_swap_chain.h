@@ -58,7 +58,7 @@ namespace Axe
 		VkRenderPass renderPass = {};
 
 		std::vector<VkImage> depthImages;
-		std::vector<VkDeviceMemory> depthImageMemoryHandles;
+		std::vector<AxeAllocation> depthImageAllocations;
 		std::vector<VkImageView> depthImageViews;
 		std::vector<VkImage> swapChainImages;
 		std::vector<VkImageView> swapChainImageViews;
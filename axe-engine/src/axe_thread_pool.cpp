@@ -0,0 +1,150 @@
+#include "axe_thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace Axe
+{
+	AxeThreadPool::AxeThreadPool( uint32_t threadCount )
+	{
+		if ( threadCount == 0 )
+		{
+			threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+		}
+
+		workers.reserve( threadCount );
+		for ( uint32_t i = 0; i < threadCount; i++ )
+		{
+			workers.emplace_back( [this]() { WorkerLoop(); } );
+		}
+	}
+
+	AxeThreadPool::~AxeThreadPool()
+	{
+		{
+			std::scoped_lock lock{ mutex };
+			stopping = true;
+		}
+
+		taskAvailable.notify_all();
+
+		for ( auto& worker : workers )
+		{
+			worker.join();
+		}
+	}
+
+	AxeThreadPool& AxeThreadPool::Shared()
+	{
+		static AxeThreadPool sharedPool;
+		return sharedPool;
+	}
+
+	void AxeThreadPool::ParallelFor( const uint32_t count, const std::function<void( uint32_t )>& body )
+	{
+		if ( count == 0 )
+		{
+			return;
+		}
+
+		if ( count == 1 )
+		{
+			body( 0 );
+			return;
+		}
+
+		// Shared between the helpers, which might outlive this call if they only get scheduled after all the work is done
+		struct Job
+		{
+			std::atomic<uint32_t> nextIndex = 0;
+			std::atomic<uint32_t> finishedCount = 0;
+			uint32_t count = 0;
+			const std::function<void( uint32_t )>* body = nullptr;
+
+			std::mutex mutex;
+			std::condition_variable finished;
+			std::exception_ptr exception;
+		};
+
+		const auto job = std::make_shared<Job>();
+		job->count = count;
+		job->body = &body;
+
+		const auto work = [job]()
+		{
+			for ( uint32_t i = job->nextIndex++; i < job->count; i = job->nextIndex++ )
+			{
+				try
+				{
+					( *job->body )( i );
+				}
+				catch ( ... )
+				{
+					std::scoped_lock lock{ job->mutex };
+					if ( !job->exception )
+					{
+						job->exception = std::current_exception();
+					}
+				}
+
+				if ( ++job->finishedCount == job->count )
+				{
+					std::scoped_lock lock{ job->mutex };
+					job->finished.notify_all();
+				}
+			}
+		};
+
+		const uint32_t helperCount = std::min( count - 1, GetThreadCount() );
+		for ( uint32_t i = 0; i < helperCount; i++ )
+		{
+			Enqueue( work );
+		}
+
+		work();
+
+		{
+			std::unique_lock lock{ job->mutex };
+			job->finished.wait( lock, [&job]() { return job->finishedCount == job->count; } );
+		}
+
+		if ( job->exception )
+		{
+			std::rethrow_exception( job->exception );
+		}
+	}
+
+	void AxeThreadPool::Enqueue( std::function<void()> task )
+	{
+		{
+			std::scoped_lock lock{ mutex };
+			tasks.push( std::move( task ) );
+		}
+
+		taskAvailable.notify_one();
+	}
+
+	void AxeThreadPool::WorkerLoop()
+	{
+		while ( true )
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock lock{ mutex };
+				taskAvailable.wait( lock, [this]() { return stopping || !tasks.empty(); } );
+
+				if ( stopping && tasks.empty() )
+				{
+					return;
+				}
+
+				task = std::move( tasks.front() );
+				tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Axe
+{
+	// Fixed set of worker threads for CPU heavy work like asset parsing.
+	class AxeThreadPool
+	{
+	public:
+		// Defaults to one worker per hardware thread
+		explicit AxeThreadPool( uint32_t threadCount = 0 );
+		~AxeThreadPool();
+
+		AxeThreadPool( const AxeThreadPool& ) = delete;
+		AxeThreadPool& operator=( const AxeThreadPool& ) = delete;
+		AxeThreadPool( AxeThreadPool&& ) = delete;
+		AxeThreadPool& operator=( AxeThreadPool&& ) = delete;
+
+		// Pool shared by the engine systems, created on first use
+		static AxeThreadPool& Shared();
+
+		template <typename Function>
+		auto Submit( Function&& function ) -> std::future<std::invoke_result_t<Function>>
+		{
+			using Result = std::invoke_result_t<Function>;
+
+			auto task = std::make_shared<std::packaged_task<Result()>>( std::forward<Function>( function ) );
+			std::future<Result> future = task->get_future();
+
+			Enqueue( [task]() { ( *task )(); } );
+
+			return future;
+		}
+
+		// Calls body( i ) for every i in [0, count) and returns when all of them are done.
+		// The calling thread helps out, so this is safe to call from inside a worker as well.
+		void ParallelFor( uint32_t count, const std::function<void( uint32_t )>& body );
+
+		[[nodiscard]] uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	private:
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+
+		std::mutex mutex;
+		std::condition_variable taskAvailable;
+		bool stopping = false;
+
+		void Enqueue( std::function<void()> task );
+		void WorkerLoop();
+	};
+}
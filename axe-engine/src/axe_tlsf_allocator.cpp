@@ -0,0 +1,309 @@
+#include "axe_tlsf_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace Axe
+{
+	static uint32_t Log2( const uint64_t value )
+	{
+		return 63u - static_cast<uint32_t>(std::countl_zero( value ));
+	}
+
+	static uint64_t AlignUp( const uint64_t value, const uint64_t alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	AxeTlsfAllocator::AxeTlsfAllocator( const uint64_t size ) : totalSize{ size }
+	{
+		assert( size > 0 && "TLSF allocator size must be greater than 0" );
+
+		for ( auto& firstLevel : freeHeads )
+		{
+			std::fill( std::begin( firstLevel ), std::end( firstLevel ), INVALID_NODE );
+		}
+
+		// The whole range starts out as a single free node
+		const uint32_t node = CreateNode();
+		nodes[ node ].offset = 0;
+		nodes[ node ].size = size;
+		nodes[ node ].isFree = true;
+		InsertFreeNode( node );
+	}
+
+	AxeTlsfAllocator::Allocation AxeTlsfAllocator::Allocate( uint64_t size, const uint64_t alignment )
+	{
+		assert( alignment > 0 && "TLSF allocation alignment must be greater than 0" );
+
+		size = std::max<uint64_t>( size, 1 );
+
+		// Searching for the worst case padding guarantees that the aligned allocation fits in the found node
+		const uint64_t searchSize = size + alignment - 1;
+		if ( searchSize > GetFreeSize() )
+		{
+			return {};
+		}
+
+		uint32_t node = FindFreeNode( searchSize );
+		if ( node == INVALID_NODE )
+		{
+			return {};
+		}
+
+		RemoveFreeNode( node );
+
+		// ####################   Split off the alignment padding in front   ####################
+
+		const uint64_t alignedOffset = AlignUp( nodes[ node ].offset, alignment );
+		const uint64_t padding = alignedOffset - nodes[ node ].offset;
+
+		if ( padding > 0 )
+		{
+			const uint32_t front = CreateNode();
+			nodes[ front ].offset = nodes[ node ].offset;
+			nodes[ front ].size = padding;
+			nodes[ front ].isFree = true;
+			nodes[ front ].prevPhysical = nodes[ node ].prevPhysical;
+			nodes[ front ].nextPhysical = node;
+
+			if ( nodes[ front ].prevPhysical != INVALID_NODE )
+			{
+				nodes[ nodes[ front ].prevPhysical ].nextPhysical = front;
+			}
+
+			nodes[ node ].prevPhysical = front;
+			nodes[ node ].offset = alignedOffset;
+			nodes[ node ].size -= padding;
+
+			InsertFreeNode( front );
+		}
+
+		// ####################   Split off the unused tail   ####################
+
+		const uint64_t remaining = nodes[ node ].size - size;
+
+		if ( remaining > 0 )
+		{
+			const uint32_t tail = CreateNode();
+			nodes[ tail ].offset = nodes[ node ].offset + size;
+			nodes[ tail ].size = remaining;
+			nodes[ tail ].isFree = true;
+			nodes[ tail ].prevPhysical = node;
+			nodes[ tail ].nextPhysical = nodes[ node ].nextPhysical;
+
+			if ( nodes[ tail ].nextPhysical != INVALID_NODE )
+			{
+				nodes[ nodes[ tail ].nextPhysical ].prevPhysical = tail;
+			}
+
+			nodes[ node ].nextPhysical = tail;
+			nodes[ node ].size = size;
+
+			InsertFreeNode( tail );
+		}
+
+		nodes[ node ].isFree = false;
+		usedSize += size;
+		allocationCount++;
+
+		return Allocation{ nodes[ node ].offset, size, node };
+	}
+
+	void AxeTlsfAllocator::Free( uint32_t node )
+	{
+		assert( node < nodes.size() && !nodes[ node ].isFree && "Cannot free an invalid or already freed TLSF node" );
+
+		usedSize -= nodes[ node ].size;
+		allocationCount--;
+		nodes[ node ].isFree = true;
+
+		// Merge with the physical neighbours, so that free nodes are never adjacent to each other
+
+		const uint32_t prev = nodes[ node ].prevPhysical;
+		if ( prev != INVALID_NODE && nodes[ prev ].isFree )
+		{
+			RemoveFreeNode( prev );
+			nodes[ prev ].size += nodes[ node ].size;
+			nodes[ prev ].nextPhysical = nodes[ node ].nextPhysical;
+
+			if ( nodes[ prev ].nextPhysical != INVALID_NODE )
+			{
+				nodes[ nodes[ prev ].nextPhysical ].prevPhysical = prev;
+			}
+
+			ReleaseNode( node );
+			node = prev;
+		}
+
+		const uint32_t next = nodes[ node ].nextPhysical;
+		if ( next != INVALID_NODE && nodes[ next ].isFree )
+		{
+			RemoveFreeNode( next );
+			nodes[ node ].size += nodes[ next ].size;
+			nodes[ node ].nextPhysical = nodes[ next ].nextPhysical;
+
+			if ( nodes[ node ].nextPhysical != INVALID_NODE )
+			{
+				nodes[ nodes[ node ].nextPhysical ].prevPhysical = node;
+			}
+
+			ReleaseNode( next );
+		}
+
+		InsertFreeNode( node );
+	}
+
+	uint64_t AxeTlsfAllocator::GetLargestFreeRegion() const
+	{
+		if ( firstLevelBitmap == 0 )
+		{
+			return 0;
+		}
+
+		const uint32_t firstLevel = Log2( firstLevelBitmap );
+		const uint32_t secondLevel = Log2( secondLevelBitmaps[ firstLevel ] );
+
+		// Nodes in the same bin can differ in size, so the whole list has to be checked
+		uint64_t largest = 0;
+		for ( uint32_t node = freeHeads[ firstLevel ][ secondLevel ]; node != INVALID_NODE; node = nodes[ node ].nextFree )
+		{
+			largest = std::max( largest, nodes[ node ].size );
+		}
+
+		return largest;
+	}
+
+	void AxeTlsfAllocator::Mapping( const uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel )
+	{
+		if ( size < SECOND_LEVEL_COUNT )
+		{
+			// Small sizes are stored linearly in the first bin
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size);
+			return;
+		}
+
+		const uint32_t log2 = Log2( size );
+		firstLevel = log2 - SECOND_LEVEL_LOG2 + 1;
+		secondLevel = static_cast<uint32_t>(( size >> ( log2 - SECOND_LEVEL_LOG2 ) ) ^ SECOND_LEVEL_COUNT);
+	}
+
+	uint64_t AxeTlsfAllocator::RoundUpToBinSize( const uint64_t size )
+	{
+		// Rounding up to the next bin means any node found in that bin (or a larger one) is big enough
+		if ( size < SECOND_LEVEL_COUNT )
+		{
+			return size;
+		}
+
+		return size + ( 1ull << ( Log2( size ) - SECOND_LEVEL_LOG2 ) ) - 1;
+	}
+
+	uint32_t AxeTlsfAllocator::CreateNode()
+	{
+		if ( !unusedNodes.empty() )
+		{
+			const uint32_t node = unusedNodes.back();
+			unusedNodes.pop_back();
+			nodes[ node ] = {};
+			return node;
+		}
+
+		nodes.emplace_back();
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	void AxeTlsfAllocator::ReleaseNode( const uint32_t node )
+	{
+		unusedNodes.push_back( node );
+	}
+
+	void AxeTlsfAllocator::InsertFreeNode( const uint32_t node )
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		Mapping( nodes[ node ].size, firstLevel, secondLevel );
+
+		const uint32_t head = freeHeads[ firstLevel ][ secondLevel ];
+		nodes[ node ].prevFree = INVALID_NODE;
+		nodes[ node ].nextFree = head;
+
+		if ( head != INVALID_NODE )
+		{
+			nodes[ head ].prevFree = node;
+		}
+
+		freeHeads[ firstLevel ][ secondLevel ] = node;
+		firstLevelBitmap |= 1ull << firstLevel;
+		secondLevelBitmaps[ firstLevel ] |= 1u << secondLevel;
+	}
+
+	void AxeTlsfAllocator::RemoveFreeNode( const uint32_t node )
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		Mapping( nodes[ node ].size, firstLevel, secondLevel );
+
+		const uint32_t prev = nodes[ node ].prevFree;
+		const uint32_t next = nodes[ node ].nextFree;
+
+		if ( prev != INVALID_NODE )
+		{
+			nodes[ prev ].nextFree = next;
+		}
+		else
+		{
+			freeHeads[ firstLevel ][ secondLevel ] = next;
+		}
+
+		if ( next != INVALID_NODE )
+		{
+			nodes[ next ].prevFree = prev;
+		}
+
+		nodes[ node ].prevFree = INVALID_NODE;
+		nodes[ node ].nextFree = INVALID_NODE;
+
+		if ( freeHeads[ firstLevel ][ secondLevel ] == INVALID_NODE )
+		{
+			secondLevelBitmaps[ firstLevel ] &= ~( 1u << secondLevel );
+
+			if ( secondLevelBitmaps[ firstLevel ] == 0 )
+			{
+				firstLevelBitmap &= ~( 1ull << firstLevel );
+			}
+		}
+	}
+
+	uint32_t AxeTlsfAllocator::FindFreeNode( const uint64_t size ) const
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		Mapping( RoundUpToBinSize( size ), firstLevel, secondLevel );
+
+		if ( firstLevel >= FIRST_LEVEL_COUNT )
+		{
+			return INVALID_NODE;
+		}
+
+		// Look for a non-empty bin in the same first level first, then in any larger first level
+		uint32_t secondLevelMap = secondLevelBitmaps[ firstLevel ] & ( ~0u << secondLevel );
+
+		if ( secondLevelMap == 0 )
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap & ( ~0ull << ( firstLevel + 1 ) ) : 0;
+			if ( firstLevelMap == 0 )
+			{
+				return INVALID_NODE;
+			}
+
+			firstLevel = static_cast<uint32_t>(std::countr_zero( firstLevelMap ));
+			secondLevelMap = secondLevelBitmaps[ firstLevel ];
+		}
+
+		secondLevel = static_cast<uint32_t>(std::countr_zero( secondLevelMap ));
+		return freeHeads[ firstLevel ][ secondLevel ];
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Axe
+{
+	// Two-Level Segregated Fit (TLSF) offset allocator.
+	// Manages offsets inside a fixed-size range without touching any memory itself, so it can be used to
+	// sub-allocate device memory blocks as well as ranges inside large buffers. Allocation and freeing are O(1).
+	// http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+	class AxeTlsfAllocator
+	{
+	public:
+		static constexpr uint32_t INVALID_NODE = ~0u;
+
+		struct Allocation
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+			uint32_t node = INVALID_NODE;
+
+			[[nodiscard]] bool IsValid() const { return node != INVALID_NODE; }
+		};
+
+		explicit AxeTlsfAllocator( uint64_t size );
+
+		AxeTlsfAllocator( const AxeTlsfAllocator& ) = delete;
+		AxeTlsfAllocator& operator=( const AxeTlsfAllocator& ) = delete;
+		AxeTlsfAllocator( AxeTlsfAllocator&& ) = default;
+		AxeTlsfAllocator& operator=( AxeTlsfAllocator&& ) = default;
+
+		// Returns an invalid allocation if there's no free region large enough
+		[[nodiscard]] Allocation Allocate( uint64_t size, uint64_t alignment = 1 );
+		void Free( uint32_t node );
+
+		[[nodiscard]] uint64_t GetSize() const { return totalSize; }
+		[[nodiscard]] uint64_t GetUsedSize() const { return usedSize; }
+		[[nodiscard]] uint64_t GetFreeSize() const { return totalSize - usedSize; }
+		[[nodiscard]] uint32_t GetAllocationCount() const { return allocationCount; }
+		[[nodiscard]] bool IsEmpty() const { return allocationCount == 0; }
+		[[nodiscard]] uint64_t GetLargestFreeRegion() const;
+
+	private:
+		static constexpr uint32_t SECOND_LEVEL_LOG2 = 4;
+		static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_LOG2;
+		static constexpr uint32_t FIRST_LEVEL_COUNT = 64 - SECOND_LEVEL_LOG2 + 1;
+
+		struct Node
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+			uint32_t prevPhysical = INVALID_NODE;
+			uint32_t nextPhysical = INVALID_NODE;
+			uint32_t prevFree = INVALID_NODE;
+			uint32_t nextFree = INVALID_NODE;
+			bool isFree = false;
+		};
+
+		uint64_t totalSize;
+		uint64_t usedSize = 0;
+		uint32_t allocationCount = 0;
+
+		uint64_t firstLevelBitmap = 0;
+		uint32_t secondLevelBitmaps[ FIRST_LEVEL_COUNT ] = {};
+		uint32_t freeHeads[ FIRST_LEVEL_COUNT ][ SECOND_LEVEL_COUNT ] = {};
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> unusedNodes;
+
+		static void Mapping( uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel );
+		static uint64_t RoundUpToBinSize( uint64_t size );
+
+		uint32_t CreateNode();
+		void ReleaseNode( uint32_t node );
+		void InsertFreeNode( uint32_t node );
+		void RemoveFreeNode( uint32_t node );
+		[[nodiscard]] uint32_t FindFreeNode( uint64_t size ) const;
+	};
+}
@@ -0,0 +1,374 @@
+#include "axe_upload_context.h"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Axe
+{
+	// Satisfies the bufferOffset requirements of image copies (multiple of 4 and of the texel size) for every format we use
+	static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	static VkDeviceSize AlignUp( const VkDeviceSize value, const VkDeviceSize alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	AxeUploadContext::AxeUploadContext( AxeDevice& device, const VkDeviceSize stagingSize )
+		: axeDevice{ device }, stagingSize{ stagingSize }
+	{
+		CreateCommandPool();
+		CreateBatches();
+
+		stagingBuffer = std::make_unique<AxeBuffer>(
+			axeDevice,
+			stagingSize,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	// Syncs the CPU mapped memory with the actual GPU memory
+		);
+		stagingBuffer->Map();
+	}
+
+	AxeUploadContext::~AxeUploadContext()
+	{
+		WaitIdle();
+
+		for ( const Batch& batch : batches )
+		{
+			vkDestroyFence( axeDevice.Device(), batch.fence, nullptr );
+		}
+
+		vkDestroyCommandPool( axeDevice.Device(), commandPool, nullptr );
+		// Command buffers are destroyed when the command pool they are allocated from is destroyed
+	}
+
+	AxeUploadContext::Ticket AxeUploadContext::CopyToBuffer(
+		const void* data, const VkDeviceSize size, const VkBuffer dstBuffer, const VkDeviceSize dstOffset )
+	{
+		std::scoped_lock lock{ mutex };
+
+		// Chunks of half the ring can always be staged while the other half is still in flight
+		const VkDeviceSize maxChunkSize = stagingSize / 2;
+
+		VkDeviceSize copied = 0;
+		while ( copied < size )
+		{
+			const VkDeviceSize chunkSize = std::min( size - copied, maxChunkSize );
+			const VkDeviceSize stagingOffset = AllocateStaging( chunkSize, STAGING_ALIGNMENT );
+
+			memcpy( static_cast<char*>(stagingBuffer->GetMappedMemory()) + stagingOffset, static_cast<const char*>(data) + copied, chunkSize );
+
+			VkBufferCopy copyRegion;
+			copyRegion.srcOffset = stagingOffset;
+			copyRegion.dstOffset = dstOffset + copied;
+			copyRegion.size = chunkSize;
+			vkCmdCopyBuffer( GetRecordingBatch().commandBuffer, stagingBuffer->GetBufferHandle(), dstBuffer, 1, &copyRegion );
+
+			copied += chunkSize;
+		}
+
+		return GetRecordingBatch().ticket;
+	}
+
+	AxeUploadContext::Ticket AxeUploadContext::CopyToImage(
+		const void* data,
+		const VkDeviceSize size,
+		const VkImage image,
+		const uint32_t width,
+		const uint32_t height,
+		const uint32_t layerCount )
+	{
+		std::scoped_lock lock{ mutex };
+
+		const VkDeviceSize stagingOffset = AllocateStaging( size, STAGING_ALIGNMENT );
+		memcpy( static_cast<char*>(stagingBuffer->GetMappedMemory()) + stagingOffset, data, size );
+
+		VkBufferImageCopy region;
+		region.bufferOffset = stagingOffset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layerCount;
+
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+
+		Batch& batch = GetRecordingBatch();
+		vkCmdCopyBufferToImage(
+			batch.commandBuffer,
+			stagingBuffer->GetBufferHandle(),
+			image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&region
+		);
+
+		return batch.ticket;
+	}
+
+	AxeUploadContext::Ticket AxeUploadContext::Submit()
+	{
+		std::scoped_lock lock{ mutex };
+
+		Batch& batch = batches[ currentBatch ];
+		if ( batch.state != BatchState::Recording )
+		{
+			// Nothing recorded, the last ticket handed out is already submitted
+			return nextTicket - 1;
+		}
+
+		// Makes the copies visible to everything submitted to the queue after this batch
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+		                        VK_ACCESS_INDEX_READ_BIT |
+		                        VK_ACCESS_UNIFORM_READ_BIT |
+		                        VK_ACCESS_SHADER_READ_BIT |
+		                        VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+		                        VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			batch.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr
+		);
+
+		if ( vkEndCommandBuffer( batch.commandBuffer ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to end recording upload command buffer" );
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		if ( vkQueueSubmit( axeDevice.GraphicsQueue(), 1, &submitInfo, batch.fence ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to submit upload command buffer" );
+		}
+
+		batch.stagingEnd = stagingHead;
+		batch.state = BatchState::Submitted;
+		currentBatch = ( currentBatch + 1 ) % BATCH_COUNT;
+
+		return batch.ticket;
+	}
+
+	bool AxeUploadContext::IsComplete( const Ticket ticket )
+	{
+		std::scoped_lock lock{ mutex };
+
+		RetireCompletedBatches();
+		return ticket <= completedTicket;
+	}
+
+	void AxeUploadContext::Wait( const Ticket ticket )
+	{
+		std::scoped_lock lock{ mutex };
+
+		if ( ticket <= completedTicket )
+		{
+			return;
+		}
+
+		// Waiting on a batch that is still being recorded would never finish
+		if ( batches[ currentBatch ].state == BatchState::Recording && batches[ currentBatch ].ticket <= ticket )
+		{
+			Submit();
+		}
+
+		while ( completedTicket < ticket && RetireOldestBatch( true ) ) {}
+	}
+
+	void AxeUploadContext::WaitIdle()
+	{
+		std::scoped_lock lock{ mutex };
+
+		Submit();
+		while ( RetireOldestBatch( true ) ) {}
+	}
+
+	void AxeUploadContext::CreateCommandPool()
+	{
+		const QueueFamilyIndices queueFamilyIndices = axeDevice.FindPhysicalQueueFamilies();
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if ( vkCreateCommandPool( axeDevice.Device(), &poolInfo, nullptr, &commandPool ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to create upload command pool" );
+		}
+	}
+
+	void AxeUploadContext::CreateBatches()
+	{
+		VkCommandBuffer commandBuffers[ BATCH_COUNT ];
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = BATCH_COUNT;
+
+		if ( vkAllocateCommandBuffers( axeDevice.Device(), &allocInfo, commandBuffers ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to allocate upload command buffers" );
+		}
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for ( uint32_t i = 0; i < BATCH_COUNT; i++ )
+		{
+			batches[ i ].commandBuffer = commandBuffers[ i ];
+
+			if ( vkCreateFence( axeDevice.Device(), &fenceInfo, nullptr, &batches[ i ].fence ) != VK_SUCCESS )
+			{
+				throw std::runtime_error( "Failed to create upload fence" );
+			}
+		}
+	}
+
+	AxeUploadContext::Batch& AxeUploadContext::GetRecordingBatch()
+	{
+		Batch& batch = batches[ currentBatch ];
+
+		if ( batch.state == BatchState::Recording )
+		{
+			return batch;
+		}
+
+		// Every batch is in flight, so the next one to record is the oldest
+		if ( batch.state == BatchState::Submitted )
+		{
+			assert( currentBatch == oldestBatch && "Upload batches must retire in submission order" );
+			RetireOldestBatch( true );
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if ( vkBeginCommandBuffer( batch.commandBuffer, &beginInfo ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to begin recording upload command buffer" );
+		}
+
+		batch.state = BatchState::Recording;
+		batch.ticket = nextTicket++;
+
+		return batch;
+	}
+
+	VkDeviceSize AxeUploadContext::AllocateStaging( const VkDeviceSize size, const VkDeviceSize alignment )
+	{
+		VkDeviceSize offset = 0;
+
+		while ( !TryAllocateStaging( size, alignment, offset ) )
+		{
+			// Out of room, flush what has been recorded and free up the ring one batch at a time
+			Submit();
+
+			if ( !RetireOldestBatch( true ) )
+			{
+				throw std::runtime_error( "Upload is larger than the staging ring buffer" );
+			}
+		}
+
+		return offset;
+	}
+
+	bool AxeUploadContext::TryAllocateStaging( const VkDeviceSize size, const VkDeviceSize alignment, VkDeviceSize& offset )
+	{
+		// The used part of the ring is [tail, head), wrapping around the end. Head never catches up with the tail,
+		// so head == tail always means that the ring is empty.
+		const VkDeviceSize alignedHead = AlignUp( stagingHead, alignment );
+
+		if ( stagingHead >= stagingTail )
+		{
+			if ( alignedHead + size <= stagingSize )
+			{
+				offset = alignedHead;
+				stagingHead = alignedHead + size;
+				return true;
+			}
+
+			// Wrap around, the bytes skipped at the end are reclaimed together with the current batch
+			if ( size < stagingTail )
+			{
+				offset = 0;
+				stagingHead = size;
+				return true;
+			}
+
+			return false;
+		}
+
+		if ( alignedHead + size < stagingTail )
+		{
+			offset = alignedHead;
+			stagingHead = alignedHead + size;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool AxeUploadContext::RetireOldestBatch( const bool wait )
+	{
+		Batch& batch = batches[ oldestBatch ];
+
+		if ( batch.state != BatchState::Submitted )
+		{
+			return false;
+		}
+
+		if ( wait )
+		{
+			vkWaitForFences( axeDevice.Device(), 1, &batch.fence, VK_TRUE, UINT64_MAX );
+		}
+		else if ( vkGetFenceStatus( axeDevice.Device(), batch.fence ) != VK_SUCCESS )
+		{
+			return false;
+		}
+
+		vkResetFences( axeDevice.Device(), 1, &batch.fence );
+
+		batch.state = BatchState::Idle;
+		completedTicket = batch.ticket;
+		stagingTail = batch.stagingEnd;
+		oldestBatch = ( oldestBatch + 1 ) % BATCH_COUNT;
+
+		// Start from the beginning again when everything has been consumed, keeps large uploads from wrapping needlessly
+		if ( stagingTail == stagingHead )
+		{
+			stagingTail = 0;
+			stagingHead = 0;
+		}
+
+		return true;
+	}
+
+	void AxeUploadContext::RetireCompletedBatches()
+	{
+		while ( RetireOldestBatch( false ) ) {}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "axe_buffer.h"
+#include "axe_device.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace Axe
+{
+	// Batches buffer and image uploads through a persistent staging ring buffer.
+	// Copies are recorded into the current batch and submitted together with a fence, callers get a ticket
+	// they can poll or wait on instead of stalling the queue after every copy.
+	class AxeUploadContext
+	{
+	public:
+		using Ticket = uint64_t;
+
+		static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 64ull * 1024ull * 1024ull;
+		static constexpr uint32_t BATCH_COUNT = 4;
+
+		explicit AxeUploadContext( AxeDevice& device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE );
+		~AxeUploadContext();
+
+		AxeUploadContext( const AxeUploadContext& ) = delete;
+		AxeUploadContext& operator=( const AxeUploadContext& ) = delete;
+		AxeUploadContext( AxeUploadContext&& ) = delete;
+		AxeUploadContext& operator=( AxeUploadContext&& ) = delete;
+
+		// The data is copied into the staging ring right away, so it doesn't have to outlive the call.
+		// Large buffer uploads are split over several batches if they don't fit into the ring at once.
+		Ticket CopyToBuffer( const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0 );
+
+		// The image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the batch executes
+		Ticket CopyToImage( const void* data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount );
+
+		// Submits everything recorded so far. Work submitted to the graphics queue afterward sees the uploaded data.
+		Ticket Submit();
+
+		[[nodiscard]] bool IsComplete( Ticket ticket );
+		void Wait( Ticket ticket );
+		void WaitIdle();
+
+		[[nodiscard]] VkDeviceSize GetStagingSize() const { return stagingSize; }
+
+	private:
+		enum class BatchState
+		{
+			Idle,
+			Recording,
+			Submitted
+		};
+
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			BatchState state = BatchState::Idle;
+			Ticket ticket = 0;
+			VkDeviceSize stagingEnd = 0;	// Ring head when the batch was submitted, everything before it is free once the batch is done
+		};
+
+		AxeDevice& axeDevice;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		std::array<Batch, BATCH_COUNT> batches = {};
+		uint32_t currentBatch = 0;
+		uint32_t oldestBatch = 0;
+
+		std::unique_ptr<AxeBuffer> stagingBuffer;
+		VkDeviceSize stagingSize;
+		VkDeviceSize stagingHead = 0;
+		VkDeviceSize stagingTail = 0;
+
+		Ticket nextTicket = 1;
+		Ticket completedTicket = 0;
+
+		std::recursive_mutex mutex;
+
+		void CreateCommandPool();
+		void CreateBatches();
+
+		Batch& GetRecordingBatch();
+		VkDeviceSize AllocateStaging( VkDeviceSize size, VkDeviceSize alignment );
+		[[nodiscard]] bool TryAllocateStaging( VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset );
+
+		bool RetireOldestBatch( bool wait );
+		void RetireCompletedBatches();
+		[[nodiscard]] bool HasBatchesInFlight() const { return batches[ oldestBatch ].state == BatchState::Submitted; }
+	};
+}
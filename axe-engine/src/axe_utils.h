@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace Axe
@@ -11,4 +14,38 @@ namespace Axe
 		seed ^= std::hash<T>{}( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
 		(HashCombine( seed, rest ), ...);
 	};
+
+	// Final mixing step of SplitMix64, spreads every input bit over the whole output
+	inline uint64_t HashMix( uint64_t value )
+	{
+		value ^= value >> 30;
+		value *= 0xbf58476d1ce4e5b9ull;
+		value ^= value >> 27;
+		value *= 0x94d049bb133111ebull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	// Fast non-cryptographic 64-bit hash of a byte range, used for content hashes of asset files
+	inline uint64_t HashBytes( const void* data, const size_t size, const uint64_t seed = 0 )
+	{
+		constexpr uint64_t PRIME = 0x9e3779b97f4a7c15ull;
+
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed ^ ( size * PRIME );
+
+		size_t i = 0;
+		for ( ; i + 8 <= size; i += 8 )
+		{
+			uint64_t word;
+			memcpy( &word, bytes + i, sizeof( word ) );
+			hash = std::rotl( hash ^ HashMix( word ), 27 ) * PRIME;
+		}
+
+		uint64_t tail = 0;
+		memcpy( &tail, bytes + i, size - i );
+		hash = std::rotl( hash ^ HashMix( tail ), 27 ) * PRIME;
+
+		return HashMix( hash );
+	}
 }
@@ -0,0 +1,303 @@
+#include "axe_vertex_welder.h"
+
+#include "axe_utils.h"
+
+// std headers
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace Axe
+{
+	// ####   Table   ####
+
+	AxeVertexWelder::Table::Table( std::vector<AxeModel::Vertex>& vertices, const size_t expectedCount ) : vertices{ vertices }
+	{
+		Rehash( std::bit_ceil( std::max<size_t>( 16, expectedCount * 2 ) ) );
+	}
+
+	uint32_t AxeVertexWelder::Table::Insert( const AxeModel::Vertex& vertex, const uint64_t hash )
+	{
+		// Keep the load factor at or below one half so probe sequences stay short
+		if ( ( count + 1 ) * 2 > slots.size() )
+		{
+			Rehash( slots.size() * 2 );
+		}
+
+		const auto shortHash = static_cast<uint32_t>(hash);
+
+		for ( size_t i = shortHash & mask; ; i = ( i + 1 ) & mask )
+		{
+			Slot& slot = slots[ i ];
+
+			if ( slot.index == EMPTY_SLOT )
+			{
+				slot.hash = shortHash;
+				slot.index = static_cast<uint32_t>(vertices.size());
+				vertices.push_back( vertex );
+				count++;
+
+				return slot.index;
+			}
+
+			if ( slot.hash == shortHash && vertices[ slot.index ] == vertex )
+			{
+				return slot.index;
+			}
+		}
+	}
+
+	void AxeVertexWelder::Table::Rehash( const size_t capacity )
+	{
+		std::vector<Slot> oldSlots = std::exchange( slots, std::vector<Slot>( capacity ) );
+		mask = capacity - 1;
+
+		for ( const Slot& oldSlot : oldSlots )
+		{
+			if ( oldSlot.index == EMPTY_SLOT )
+			{
+				continue;
+			}
+
+			size_t i = oldSlot.hash & mask;
+			while ( slots[ i ].index != EMPTY_SLOT )
+			{
+				i = ( i + 1 ) & mask;
+			}
+
+			slots[ i ] = oldSlot;
+		}
+	}
+
+	// ####   Welding   ####
+
+	static uint64_t FloatBits( const float value )
+	{
+		// Done on the bits as fast math may drop a "+ 0.0f"
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		return bits << 1 == 0 ? 0 : bits;
+	}
+
+	uint64_t AxeVertexWelder::Hash( const AxeModel::Vertex& vertex )
+	{
+		const float values[ 12 ] = {
+			vertex.position.x, vertex.position.y, vertex.position.z,
+			vertex.color.r, vertex.color.g, vertex.color.b,
+			vertex.normal.x, vertex.normal.y, vertex.normal.z,
+			vertex.uv.x, vertex.uv.y, 0.0f,
+		};
+
+		uint64_t hash = 0;
+		for ( size_t i = 0; i < 12; i += 2 )
+		{
+			hash = HashMix( hash ^ ( FloatBits( values[ i ] ) | FloatBits( values[ i + 1 ] ) << 32 ) );
+		}
+
+		return hash;
+	}
+
+	AxeVertexWelder::Result AxeVertexWelder::Weld( const std::span<const AxeModel::Vertex> corners, const Strategy strategy, AxeThreadPool& threadPool )
+	{
+		switch ( strategy )
+		{
+			case Strategy::HashTable:
+				return WeldWithHashTable( corners );
+			case Strategy::RadixSort:
+				return WeldWithRadixSort( corners, threadPool );
+		}
+
+		return {};
+	}
+
+	AxeVertexWelder::Result AxeVertexWelder::WeldWithHashTable( const std::span<const AxeModel::Vertex> corners )
+	{
+		Result result = {};
+		result.indices.resize( corners.size() );
+
+		// Triangle meshes tend to share each vertex between about six corners
+		Table table{ result.vertices, corners.size() / 4 };
+
+		for ( size_t i = 0; i < corners.size(); i++ )
+		{
+			result.indices[ i ] = table.Insert( corners[ i ] );
+		}
+
+		return result;
+	}
+
+	// Sorts the corners by a 32-bit hash so equal vertices end up next to each other. The sort is stable,
+	// so the first corner of each group of equal vertices is also the first one in the input, which keeps the same order as the table.
+	AxeVertexWelder::Result AxeVertexWelder::WeldWithRadixSort( const std::span<const AxeModel::Vertex> corners, AxeThreadPool& threadPool )
+	{
+		constexpr size_t MIN_BLOCK_SIZE = 16 * 1024;
+		constexpr uint32_t RADIX_BITS = 8;
+		constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+
+		Result result = {};
+
+		const size_t count = corners.size();
+		if ( count == 0 )
+		{
+			return result;
+		}
+
+		const auto blockCount = static_cast<uint32_t>(std::clamp<size_t>( count / MIN_BLOCK_SIZE, 1, threadPool.GetThreadCount() * 4ull ));
+		const auto blockBegin = [count, blockCount]( const uint32_t block ) { return count * block / blockCount; };
+
+		// Hash in the upper half, corner index in the lower half
+		std::vector<uint64_t> keys( count );
+		std::vector<uint64_t> sortedKeys( count );
+
+		threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+		{
+			for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+			{
+				keys[ i ] = static_cast<uint64_t>(static_cast<uint32_t>(Hash( corners[ i ] ))) << 32 | i;
+			}
+		} );
+
+		// Least significant digit first radix sort of the hash, each block scatters its keys in order which keeps the sort stable
+		std::vector<size_t> offsets( static_cast<size_t>(blockCount) * RADIX_SIZE );
+
+		for ( uint32_t shift = 32; shift < 64; shift += RADIX_BITS )
+		{
+			std::ranges::fill( offsets, 0 );
+
+			threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+			{
+				size_t* histogram = &offsets[ block * RADIX_SIZE ];
+				for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+				{
+					histogram[ keys[ i ] >> shift & ( RADIX_SIZE - 1 ) ]++;
+				}
+			} );
+
+			size_t offset = 0;
+			bool allEqual = false;
+			for ( uint32_t digit = 0; digit < RADIX_SIZE; digit++ )
+			{
+				size_t digitCount = 0;
+				for ( uint32_t block = 0; block < blockCount; block++ )
+				{
+					const size_t blockDigitCount = offsets[ block * RADIX_SIZE + digit ];
+					offsets[ block * RADIX_SIZE + digit ] = offset;
+					offset += blockDigitCount;
+					digitCount += blockDigitCount;
+				}
+
+				allEqual |= digitCount == count;
+			}
+
+			// Nothing moves when every key has the same digit
+			if ( allEqual )
+			{
+				continue;
+			}
+
+			threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+			{
+				size_t* blockOffsets = &offsets[ block * RADIX_SIZE ];
+				for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+				{
+					sortedKeys[ blockOffsets[ keys[ i ] >> shift & ( RADIX_SIZE - 1 ) ]++ ] = keys[ i ];
+				}
+			} );
+
+			std::swap( keys, sortedKeys );
+		}
+
+		sortedKeys = {};
+
+		// Point every corner at the first corner with an equal vertex. Hash collisions are rare,
+		// so each run of equal hashes only holds a handful of distinct vertices to compare against.
+		std::vector<uint32_t> firstCorners( count );
+
+		const auto hashAt = [&keys]( const size_t i ) { return static_cast<uint32_t>(keys[ i ] >> 32); };
+		const auto runBegin = [&]( const uint32_t block )
+		{
+			size_t i = blockBegin( block );
+			while ( i > 0 && i < count && hashAt( i ) == hashAt( i - 1 ) )
+			{
+				i++;
+			}
+
+			return i;
+		};
+
+		threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+		{
+			std::vector<uint32_t> distinctCorners = {};
+
+			const size_t end = runBegin( block + 1 );
+			for ( size_t i = runBegin( block ); i < end; i++ )
+			{
+				if ( i == 0 || hashAt( i ) != hashAt( i - 1 ) )
+				{
+					distinctCorners.clear();
+				}
+
+				const auto corner = static_cast<uint32_t>(keys[ i ]);
+
+				const auto firstCorner = std::ranges::find_if( distinctCorners, [&]( const uint32_t other ) { return corners[ other ] == corners[ corner ]; } );
+				if ( firstCorner != distinctCorners.end() )
+				{
+					firstCorners[ corner ] = *firstCorner;
+				}
+				else
+				{
+					firstCorners[ corner ] = corner;
+					distinctCorners.push_back( corner );
+				}
+			}
+		} );
+
+		keys = {};
+
+		// Number the first corners in input order, which needs the count of first corners in the blocks before
+		std::vector<uint32_t> blockVertexOffsets( blockCount + 1 );
+
+		threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+		{
+			uint32_t vertexCount = 0;
+			for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+			{
+				vertexCount += firstCorners[ i ] == i;
+			}
+
+			blockVertexOffsets[ block + 1 ] = vertexCount;
+		} );
+
+		for ( uint32_t block = 0; block < blockCount; block++ )
+		{
+			blockVertexOffsets[ block + 1 ] += blockVertexOffsets[ block ];
+		}
+
+		result.vertices.resize( blockVertexOffsets[ blockCount ] );
+		result.indices.resize( count );
+
+		std::vector<uint32_t> vertexIndices( count );
+
+		threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+		{
+			uint32_t vertexIndex = blockVertexOffsets[ block ];
+			for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+			{
+				if ( firstCorners[ i ] == i )
+				{
+					result.vertices[ vertexIndex ] = corners[ i ];
+					vertexIndices[ i ] = vertexIndex++;
+				}
+			}
+		} );
+
+		threadPool.ParallelFor( blockCount, [&]( const uint32_t block )
+		{
+			for ( size_t i = blockBegin( block ); i < blockBegin( block + 1 ); i++ )
+			{
+				result.indices[ i ] = vertexIndices[ firstCorners[ i ] ];
+			}
+		} );
+
+		return result;
+	}
+}
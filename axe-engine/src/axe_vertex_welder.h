@@ -0,0 +1,69 @@
+#pragma once
+
+#include "axe_model.h"
+#include "axe_thread_pool.h"
+
+#include <span>
+#include <vector>
+
+namespace Axe
+{
+	// Merges equal vertices of unindexed geometry into a vertex and an index array.
+	// Vertices are equal when all their components compare equal, unique vertices keep the order they first appear in.
+	class AxeVertexWelder
+	{
+	public:
+		enum class Strategy
+		{
+			HashTable,	// Single pass through a flat open addressing table, best for small and medium meshes
+			RadixSort,	// Sorts the vertices by hash on the thread pool and welds neighbours, scales with core count
+		};
+
+		struct Result
+		{
+			std::vector<AxeModel::Vertex> vertices = {};
+			std::vector<uint32_t> indices = {};
+		};
+
+		// Open addressing table that appends the vertices it hasn't seen yet to a vertex array.
+		// Also usable on its own by code that produces vertices one at a time.
+		class Table
+		{
+		public:
+			explicit Table( std::vector<AxeModel::Vertex>& vertices, size_t expectedCount = 0 );
+
+			// Returns the index of the equal vertex in the array, appending the vertex first if there is none
+			uint32_t Insert( const AxeModel::Vertex& vertex ) { return Insert( vertex, Hash( vertex ) ); }
+			uint32_t Insert( const AxeModel::Vertex& vertex, uint64_t hash );
+
+		private:
+			static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+			struct Slot
+			{
+				uint32_t hash = 0;
+				uint32_t index = EMPTY_SLOT;
+			};
+
+			std::vector<AxeModel::Vertex>& vertices;
+			std::vector<Slot> slots = {};
+			size_t mask = 0;
+			size_t count = 0;
+
+			void Rehash( size_t capacity );
+		};
+
+		// Hashes the bit patterns of the components, with -0 folded into +0 since the two compare equal
+		[[nodiscard]] static uint64_t Hash( const AxeModel::Vertex& vertex );
+
+		// Both strategies produce identical results
+		[[nodiscard]] static Result Weld(
+			std::span<const AxeModel::Vertex> corners,
+			Strategy strategy,
+			AxeThreadPool& threadPool = AxeThreadPool::Shared() );
+
+	private:
+		[[nodiscard]] static Result WeldWithHashTable( std::span<const AxeModel::Vertex> corners );
+		[[nodiscard]] static Result WeldWithRadixSort( std::span<const AxeModel::Vertex> corners, AxeThreadPool& threadPool );
+	};
+}
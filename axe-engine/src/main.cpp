@@ -1,4 +1,5 @@
 #include "app.h"
+#include "axe_asset_pack.h"
 
 #include <cstdlib>
 #include <iostream>
@@ -9,6 +10,9 @@ int main()
 
 	try
 	{
+		// Shipped builds read their assets from the pack, without one they're loaded from the loose files
+		Axe::AxeAssetPack::Mount();
+
 		Axe::App app{};
 		app.Run();
 	}
@@ -1,21 +1,19 @@
 ﻿#include "point_light_system.h"
 
+#include "axe_swap_chain.h"
+
+#include <array>
 #include <stdexcept>
 #include <ranges>
-#include <map>
 
 namespace Axe
 {
-	struct PointLightPushConstants
-	{
-		glm::vec4 position{};
-		glm::vec4 color{};
-		float radius = 0;
-	};
+	static_assert( sizeof( PointLightSystem::Billboard ) == 32, "Billboards are read by the vertex shader with std430 layout" );
 
 	PointLightSystem::PointLightSystem( AxeDevice& device, const VkRenderPass renderPass, const VkDescriptorSetLayout globalSetLayout )
 		: axeDevice{ device }
 	{
+		CreateBillboardBuffers();
 		CreatePipelineLayout( globalSetLayout );
 		CreatePipeline( renderPass );
 	}
@@ -25,22 +23,79 @@ namespace Axe
 		vkDestroyPipelineLayout( axeDevice.Device(), pipelineLayout, nullptr );
 	}
 
-	void PointLightSystem::CreatePipelineLayout( const VkDescriptorSetLayout globalSetLayout )
+	void PointLightSystem::CreateBillboardBuffers()
+	{
+		billboardSetLayout = AxeDescriptorSetLayout::Builder( axeDevice )
+		                     .AddBinding( 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT )	// Billboards
+		                     .Build();
+
+		billboardPool = AxeDescriptorPool::Builder( axeDevice )
+		                .SetMaxSets( AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		                .AddPoolSize( VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		                .Build();
+
+		billboardBuffers.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		billboardDescriptorSets.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+
+		for ( size_t i = 0; i < billboardBuffers.size(); i++ )
+		{
+			billboardBuffers[ i ] = std::make_unique<AxeBuffer>(
+				axeDevice,
+				sizeof( Billboard ),
+				INITIAL_BILLBOARD_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			billboardBuffers[ i ]->Map();
+
+			auto bufferInfo = billboardBuffers[ i ]->DescriptorInfo();
+			AxeDescriptorWriter( *billboardSetLayout, *billboardPool )
+				.WriteBuffer( 0, &bufferInfo )
+				.Build( billboardDescriptorSets[ i ] );
+		}
+	}
+
+	void PointLightSystem::ReserveBillboards( const int frameIndex, const size_t billboardCount )
 	{
-		// Used for specifying uniform variables
-		VkPushConstantRange pushConstantRange;
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof( PointLightPushConstants );
+		std::unique_ptr<AxeBuffer>& billboardBuffer = billboardBuffers[ frameIndex ];
+		if ( billboardCount <= billboardBuffer->GetInstanceCount() )
+		{
+			return;
+		}
 
-		const std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalSetLayout };
+		uint32_t capacity = billboardBuffer->GetInstanceCount();
+		while ( capacity < billboardCount )
+		{
+			capacity *= 2;
+		}
+
+		// The frame's fence has been waited on, so neither the old buffer nor the descriptor set pointing at it is in use anymore
+		billboardBuffer = std::make_unique<AxeBuffer>(
+			axeDevice,
+			sizeof( Billboard ),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		billboardBuffer->Map();
+
+		auto bufferInfo = billboardBuffer->DescriptorInfo();
+		AxeDescriptorWriter( *billboardSetLayout, *billboardPool )
+			.WriteBuffer( 0, &bufferInfo )
+			.Overwrite( billboardDescriptorSets[ frameIndex ] );
+	}
+
+	void PointLightSystem::CreatePipelineLayout( const VkDescriptorSetLayout globalSetLayout )
+	{
+		// The billboards come from a storage buffer, so there are no push constants
+		const std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalSetLayout, billboardSetLayout->GetDescriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if ( vkCreatePipelineLayout( axeDevice.Device(), &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
 		{
@@ -68,7 +123,7 @@ namespace Axe
 		);
 	}
 
-	void PointLightSystem::Update( const FrameInfo& frameInfo, GlobalUBO& ubo ) const
+	void PointLightSystem::Update( const FrameInfo& frameInfo ) const
 	{
 		const auto rotateLight = glm::rotate(
 			glm::mat4{ 1.0f },
@@ -76,7 +131,6 @@ namespace Axe
 			glm::vec3{ 0.0f, -1.0f, 0.0f }
 		);
 
-		int lightIndex = 0;
 		for ( auto& gameObject : frameInfo.gameObjects | std::views::values )
 		{
 			if ( gameObject.pointLight == nullptr )
@@ -84,25 +138,16 @@ namespace Axe
 				continue;
 			}
 
-			assert( lightIndex < MAX_LIGHTS && "Point lights amount exceeds MAX_LIGHTS" );
-
 			// Update light position
 			gameObject.transform.translation = glm::vec3{ rotateLight * glm::vec4( gameObject.transform.translation, 1.0f ) };
-
-			// Copy light to ubo
-			ubo.pointLights[ lightIndex ].position = glm::vec4{ gameObject.transform.translation, 1.0f };
-			ubo.pointLights[ lightIndex ].color = glm::vec4{ gameObject.color, gameObject.pointLight->lightIntensity };
-
-			lightIndex++;
 		}
-
-		ubo.numActiveLights = lightIndex;
 	}
 
-	void PointLightSystem::Render( const FrameInfo& frameInfo ) const
+	void PointLightSystem::Render( const FrameInfo& frameInfo )
 	{
-		// Sort lights
-		std::map<float, AxeGameObject::UID> sortedLights;
+		// The billboards' bounding spheres are culled in one go, in the order of the lights
+		lights.clear();
+		frustumCuller.Clear();
 		for ( const auto& gameObject : frameInfo.gameObjects | std::views::values )
 		{
 			if ( gameObject.pointLight == nullptr )
@@ -110,43 +155,70 @@ namespace Axe
 				continue;
 			}
 
-			auto offset = frameInfo.camera.GetWorldSpacePosition() - gameObject.transform.translation;
+			frustumCuller.Add( glm::vec4{ gameObject.transform.translation, gameObject.transform.scale.x } );
+			lights.push_back( &gameObject );
+		}
+		frustumCuller.Cull( frameInfo.camera.GetFrustumPlanes() );
+
+		// Sort lights, lights at the same distance keep their order instead of replacing each other
+		renderQueue.Clear();
+		for ( uint32_t i = 0; i < lights.size(); i++ )
+		{
+			if ( !frustumCuller.IsVisible( i ) )
+			{
+				continue;
+			}
+
+			auto offset = frameInfo.camera.GetWorldSpacePosition() - lights[ i ]->transform.translation;
 			float distanceSquared = glm::dot( offset, offset );
-			sortedLights[ distanceSquared ] = gameObject.GetId();
+			renderQueue.Submit( AxeRenderQueue::MakeTransparentKey( 0, 0, 0, distanceSquared ), i );
 		}
+		renderQueue.Sort();
 
-		axePipeline->Bind( frameInfo.commandBuffer );
+		if ( renderQueue.GetPackets().empty() )
+		{
+			return;
+		}
+
+		billboards.clear();
+		for ( const AxeRenderQueue::Packet& packet : renderQueue.GetPackets() )
+		{
+			const AxeGameObject& gameObject = *lights[ packet.payload ];
+			billboards.push_back(
+				{ glm::vec4{ gameObject.transform.translation, gameObject.transform.scale.x }, glm::vec4{ gameObject.color, gameObject.pointLight->lightIntensity } } );
+		}
+
+		// The frame's fence has been waited on, so its buffer can be rewritten
+		ReserveBillboards( frameInfo.frameIndex, billboards.size() );
+		const std::unique_ptr<AxeBuffer>& billboardBuffer = billboardBuffers[ frameInfo.frameIndex ];
+		billboardBuffer->WriteToBuffer( billboards.data(), billboards.size() * sizeof( Billboard ) );
+		if ( billboardBuffer->Flush() != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Error flushing billboard buffer to GPU" );
+		}
+
+		// The render pass executes secondary command buffers only, the single draw is recorded on this thread
+		const VkCommandBuffer commandBuffer = frameInfo.renderer.BeginSecondaryCommandBuffer( 0 );
+
+		axePipeline->Bind( commandBuffer );
+
+		const std::array<VkDescriptorSet, 2> descriptorSets = { frameInfo.globalDescriptorSet, billboardDescriptorSets[ frameInfo.frameIndex ] };
 
 		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
-			1,
-			&frameInfo.globalDescriptorSet,
+			static_cast<uint32_t>(descriptorSets.size()),
+			descriptorSets.data(),
 			0,
 			nullptr
 		);
 
-		// Iterate through sorted lights in reverse order
-		for ( auto it = sortedLights.rbegin(); it != sortedLights.rend(); ++it )
-		{
-			auto& gameObject = frameInfo.gameObjects.at( it->second );
-
-			PointLightPushConstants pushConstants = {};
-			pushConstants.position = glm::vec4( gameObject.transform.translation, 1.0f );
-			pushConstants.color = glm::vec4( gameObject.color, gameObject.pointLight->lightIntensity );
-			pushConstants.radius = gameObject.transform.scale.x;
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof( PointLightPushConstants ),
-				&pushConstants
-			);
-			vkCmdDraw( frameInfo.commandBuffer, 6, 1, 0, 0 );
-		}
+		// Six vertices per billboard, the instances are the billboards in the order they were written
+		vkCmdDraw( commandBuffer, 6, static_cast<uint32_t>(billboards.size()), 0, 0 );
+
+		frameInfo.renderer.EndSecondaryCommandBuffer( commandBuffer );
+		vkCmdExecuteCommands( frameInfo.commandBuffer, 1, &commandBuffer );
 	}
 }
@@ -1,16 +1,33 @@
 ﻿#pragma once
 
+#include "axe_buffer.h"
+#include "axe_descriptors.h"
 #include "axe_device.h"
 #include "axe_pipeline.h"
 #include "axe_frame_info.h"
+#include "axe_frustum_culler.h"
+#include "axe_render_queue.h"
 
 #include <memory>
+#include <vector>
 
 namespace Axe
 {
+	// Draws a billboard for every point light in view with a single instanced draw. The billboards are frustum culled, sorted back to front
+	// and written to a per-frame storage buffer in that order, which the vertex shader indexes with gl_InstanceIndex
 	class PointLightSystem
 	{
 	public:
+		// The billboard buffers start out with room for this many billboards and double whenever they run out
+		static constexpr uint32_t INITIAL_BILLBOARD_CAPACITY = 256;
+
+		// Matches Billboard in the point light shaders
+		struct Billboard
+		{
+			glm::vec4 position = {};	// w is the radius
+			glm::vec4 color = {};	// w is intensity
+		};
+
 		PointLightSystem( AxeDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout );
 		~PointLightSystem();
 
@@ -19,8 +36,13 @@ namespace Axe
 		PointLightSystem( const PointLightSystem&& ) = delete;
 		PointLightSystem& operator=( const PointLightSystem&& ) = delete;
 
-		void Update( const FrameInfo& frameInfo, GlobalUBO& ubo ) const;
-		void Render( const FrameInfo& frameInfo ) const;
+		// Moves the lights, AxeLightClusters picks them up from the game objects afterwards
+		void Update( const FrameInfo& frameInfo ) const;
+		// Back to front, so the blended billboards cover each other in the right order
+		void Render( const FrameInfo& frameInfo );
+
+		// What the last Render call culled
+		[[nodiscard]] const AxeFrustumCuller::Statistics& GetCullingStatistics() const { return frustumCuller.GetStatistics(); }
 
 	private:
 		AxeDevice& axeDevice;
@@ -28,6 +50,21 @@ namespace Axe
 		VkPipelineLayout pipelineLayout = {};
 		std::unique_ptr<AxePipeline> axePipeline;
 
+		std::unique_ptr<AxeDescriptorSetLayout> billboardSetLayout = {};
+		std::unique_ptr<AxeDescriptorPool> billboardPool = {};
+		// One per frame in flight, a frame only rewrites its buffer once the GPU is done with it
+		std::vector<std::unique_ptr<AxeBuffer>> billboardBuffers = {};
+		std::vector<VkDescriptorSet> billboardDescriptorSets = {};
+
+		// Reused between frames
+		std::vector<const AxeGameObject*> lights = {};
+		std::vector<Billboard> billboards = {};
+		AxeFrustumCuller frustumCuller = {};
+		AxeRenderQueue renderQueue = {};
+
+		void CreateBillboardBuffers();
+		// Replaces the frame's billboard buffer with one twice as large until the billboards fit, and points its descriptor set at the new one
+		void ReserveBillboards( int frameIndex, size_t billboardCount );
 		void CreatePipelineLayout( VkDescriptorSetLayout globalSetLayout );
 		void CreatePipeline( VkRenderPass renderPass );
 	};
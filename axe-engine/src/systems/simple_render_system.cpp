@@ -1,46 +1,241 @@
 ﻿#include "simple_render_system.h"
 
+#include "axe_swap_chain.h"
+#include "axe_thread_pool.h"
+
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <ranges>
+#include <utility>
 
 namespace Axe
 {
-	struct SimplePushConstantData
+	// The instance buffers hold the scene buffer slots of the instances, the simple shaders fetch the rest from the scene buffer
+	static constexpr VkDeviceSize INSTANCE_SIZE = sizeof( uint32_t );
+
+	// Picks the coarsest level whose error projected at the distance of the model's bounding sphere stays under the threshold
+	static uint32_t SelectLod( const AxeGameObject& gameObject, const glm::mat4& modelMatrix, const AxeCamera& camera )
+	{
+		const AxeModel& model = *gameObject.model;
+		const uint32_t lodCount = model.GetLodCount();
+		if ( lodCount == 1 )
+		{
+			return 0;
+		}
+
+		const glm::vec3 scale = glm::abs( gameObject.transform.scale );
+		const float maxScale = std::max( { scale.x, scale.y, scale.z } );
+
+		const glm::vec3 center = glm::vec3{ modelMatrix * glm::vec4{ glm::vec3{ model.GetBoundingSphere() }, 1.0f } };
+		const float radius = model.GetBoundingSphere().w * maxScale;
+
+		const float distance = glm::length( center - camera.GetWorldSpacePosition() ) - radius;
+		if ( distance <= 0.0f )
+		{
+			return 0;
+		}
+
+		// The [1][1] element of a perspective projection is 1 / tan(fovY / 2), which scales sizes at a distance to fractions of half the screen height
+		const float errorScale = std::abs( camera.GetProjection()[ 1 ][ 1 ] ) * maxScale / distance;
+		const auto screenError = [&]( const uint32_t lod ) { return model.GetLod( lod ).error * errorScale; };
+
+		uint32_t lod = std::min( gameObject.lod, lodCount - 1 );
+
+		while ( lod > 0 && screenError( lod ) > SimpleRenderSystem::LOD_ERROR_THRESHOLD )
+		{
+			lod--;
+		}
+
+		while ( lod + 1 < lodCount && screenError( lod + 1 ) <= SimpleRenderSystem::LOD_ERROR_THRESHOLD * ( 1.0f - SimpleRenderSystem::LOD_HYSTERESIS ) )
+		{
+			lod++;
+		}
+
+		return lod;
+	}
+
+	// Mixes a static object's id and model id into a well spread 64-bit value, summing them gives the same signature in any order
+	static uint64_t HashStaticObject( const AxeGameObject& gameObject )
 	{
-		glm::mat4 modelMatrix{ 1.0f };
-		glm::mat4 normalMatrix{ 1.0f };
-	};
+		uint64_t hash = static_cast<uint64_t>(gameObject.GetId()) << 32 | gameObject.model->GetId();
+		hash = ( hash ^ ( hash >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+		hash = ( hash ^ ( hash >> 27 ) ) * 0x94d049bb133111ebull;
+		return hash ^ ( hash >> 31 );
+	}
 
-	SimpleRenderSystem::SimpleRenderSystem( AxeDevice& device, const VkRenderPass renderPass, const VkDescriptorSetLayout globalSetLayout )
-		: axeDevice{ device }
+	SimpleRenderSystem::SimpleRenderSystem(
+		AxeDevice& device,
+		const AxeSceneBuffer& sceneBuffer,
+		const AxeLightClusters& lightClusters,
+		const VkRenderPass renderPass,
+		const VkDescriptorSetLayout globalSetLayout )
+		: axeDevice{ device },
+		  sceneBuffer{ sceneBuffer },
+		  lightClusters{ lightClusters }
 	{
+		CreateInstanceBuffers();
+		CreateStaticCaches();
 		CreatePipelineLayout( globalSetLayout );
 		CreatePipeline( renderPass );
+
+		if ( axeDevice.SupportsDrawIndirectCount() )
+		{
+			gpuCuller = std::make_unique<AxeGpuCuller>( axeDevice, *instanceSetLayout, sceneBuffer );
+		}
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
+		// Destroying the pool frees the cached command buffers
+		vkDestroyCommandPool( axeDevice.Device(), staticCommandPool, nullptr );
 		vkDestroyPipelineLayout( axeDevice.Device(), pipelineLayout, nullptr );
 	}
 
-	void SimpleRenderSystem::CreatePipelineLayout( const VkDescriptorSetLayout globalSetLayout )
+	void SimpleRenderSystem::CreateInstanceBuffers()
+	{
+		instanceSetLayout = AxeDescriptorSetLayout::Builder( axeDevice )
+		                    .AddBinding( 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT )	// Instances
+		                    .AddBinding( 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT )	// Scene objects
+		                    .Build();
+
+		instancePool = AxeDescriptorPool::Builder( axeDevice )
+		               .SetMaxSets( 2 * AxeSwapChain::MAX_FRAMES_IN_FLIGHT )	// The frames' instance buffers and the static caches' ones
+		               .AddPoolSize( VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * AxeSwapChain::MAX_FRAMES_IN_FLIGHT )
+		               .Build();
+
+		instanceBuffers.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		instanceDescriptorSets.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		instanceSceneGenerations.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+
+		for ( size_t i = 0; i < instanceBuffers.size(); i++ )
+		{
+			instanceBuffers[ i ] = std::make_unique<AxeBuffer>(
+				axeDevice,
+				INSTANCE_SIZE,
+				INITIAL_INSTANCE_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			instanceBuffers[ i ]->Map();
+
+			auto bufferInfo = instanceBuffers[ i ]->DescriptorInfo();
+			auto sceneInfo = sceneBuffer.DescriptorInfo();
+			AxeDescriptorWriter( *instanceSetLayout, *instancePool )
+				.WriteBuffer( 0, &bufferInfo )
+				.WriteBuffer( 1, &sceneInfo )
+				.Build( instanceDescriptorSets[ i ] );
+			instanceSceneGenerations[ i ] = sceneBuffer.GetGeneration();
+		}
+	}
+
+	void SimpleRenderSystem::CreateStaticCaches()
+	{
+		// The cached command buffers are reset one at a time when they're recorded again
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = axeDevice.FindPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if ( vkCreateCommandPool( axeDevice.Device(), &poolInfo, nullptr, &staticCommandPool ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to create static command pool" );
+		}
+
+		std::vector<VkCommandBuffer> commandBuffers( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocateInfo.commandPool = staticCommandPool;
+		allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if ( vkAllocateCommandBuffers( axeDevice.Device(), &allocateInfo, commandBuffers.data() ) != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Failed to allocate static command buffers" );
+		}
+
+		staticCaches.resize( AxeSwapChain::MAX_FRAMES_IN_FLIGHT );
+		for ( size_t i = 0; i < staticCaches.size(); i++ )
+		{
+			StaticCache& staticCache = staticCaches[ i ];
+			staticCache.commandBuffer = commandBuffers[ i ];
+
+			staticCache.instanceBuffer = std::make_unique<AxeBuffer>(
+				axeDevice,
+				INSTANCE_SIZE,
+				INITIAL_INSTANCE_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			staticCache.instanceBuffer->Map();
+
+			auto bufferInfo = staticCache.instanceBuffer->DescriptorInfo();
+			auto sceneInfo = sceneBuffer.DescriptorInfo();
+			AxeDescriptorWriter( *instanceSetLayout, *instancePool )
+				.WriteBuffer( 0, &bufferInfo )
+				.WriteBuffer( 1, &sceneInfo )
+				.Build( staticCache.instanceDescriptorSet );
+			staticCache.sceneGeneration = sceneBuffer.GetGeneration();
+		}
+	}
+
+	void SimpleRenderSystem::ReserveInstances(
+		std::unique_ptr<AxeBuffer>& instanceBuffer,
+		const VkDescriptorSet descriptorSet,
+		uint32_t& sceneGeneration,
+		const size_t instanceCount )
 	{
-		// Used for specifying uniform variables
-		VkPushConstantRange pushConstantRange;
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof( SimplePushConstantData );
+		if ( instanceCount <= instanceBuffer->GetInstanceCount() && sceneGeneration == sceneBuffer.GetGeneration() )
+		{
+			return;
+		}
+
+		uint32_t capacity = instanceBuffer->GetInstanceCount();
+		while ( capacity < instanceCount )
+		{
+			capacity *= 2;
+		}
+
+		// The frame's fence has been waited on, so neither the old buffer nor the descriptor set pointing at it is in use anymore.
+		// Both belong to the frame or to its static cache, no other frame in flight uses them
+		if ( capacity != instanceBuffer->GetInstanceCount() )
+		{
+			instanceBuffer = std::make_unique<AxeBuffer>(
+				axeDevice,
+				INSTANCE_SIZE,
+				capacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			instanceBuffer->Map();
+		}
 
-		const std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalSetLayout };
+		auto bufferInfo = instanceBuffer->DescriptorInfo();
+		auto sceneInfo = sceneBuffer.DescriptorInfo();
+		AxeDescriptorWriter( *instanceSetLayout, *instancePool )
+			.WriteBuffer( 0, &bufferInfo )
+			.WriteBuffer( 1, &sceneInfo )
+			.Overwrite( descriptorSet );
+		sceneGeneration = sceneBuffer.GetGeneration();
+	}
+
+	void SimpleRenderSystem::CreatePipelineLayout( const VkDescriptorSetLayout globalSetLayout )
+	{
+		// The instances' matrices come from the scene buffer, so there are no push constants
+		const std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {
+			globalSetLayout,
+			instanceSetLayout->GetDescriptorSetLayout(),
+			lightClusters.GetDescriptorSetLayout()
+		};
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if ( vkCreatePipelineLayout( axeDevice.Device(), &pipelineLayoutInfo, nullptr, &pipelineLayout ) != VK_SUCCESS )
 		{
@@ -63,46 +258,502 @@ namespace Axe
 			"shaders/simple_shader.vert.spv",
 			"shaders/simple_shader.frag.spv"
 		);
+
+		pipelineConfig.bindingDescriptions = AxeModel::PackedVertex::GetBindingDescriptions();
+		pipelineConfig.attributeDescriptions = AxeModel::PackedVertex::GetAttributeDescriptions();
+
+		packedVertexPipeline = std::make_unique<AxePipeline>(
+			axeDevice,
+			pipelineConfig,
+			"shaders/simple_shader_packed.vert.spv",
+			"shaders/simple_shader.frag.spv"
+		);
 	}
 
-	void SimpleRenderSystem::RenderGameObjects( const FrameInfo& frameInfo ) const
+	void SimpleRenderSystem::CollectDrawItems( const FrameInfo& frameInfo, const DrawItemFilter filter, std::vector<DrawItem>& items )
 	{
-		axePipeline->Bind( frameInfo.commandBuffer );
+		items.clear();
+		if ( filter != DrawItemFilter::Static )
+		{
+			frustumCuller.Clear();
+		}
 
-		vkCmdBindDescriptorSets(
+		uint64_t signature = 0;
+		for ( auto& gameObject : frameInfo.gameObjects | std::views::values )
+		{
+			// Skip the gameObject if there's no model to render			TODO: implement ECS instead
+			if ( gameObject.model == nullptr )
+			{
+				continue;
+			}
+
+			if ( filter != DrawItemFilter::All && gameObject.isStatic != ( filter == DrawItemFilter::Static ) )
+			{
+				// Skipped static objects are hashed on the way, so the static caches notice changes without another walk over the objects
+				if ( gameObject.isStatic )
+				{
+					signature += HashStaticObject( gameObject );
+				}
+				continue;
+			}
+
+			DrawItem drawItem = {};
+			drawItem.pipeline = gameObject.model->GetVertexFormat() == AxeModel::VertexFormat::Packed ? packedVertexPipeline.get() : axePipeline.get();
+			drawItem.model = gameObject.model.get();
+			drawItem.gameObject = &gameObject;
+
+			// The scene buffer's update has the matrix and bounds ready, they're only computed again when the object moves
+			assert( gameObject.sceneSlot != AxeSceneBuffer::INVALID_SLOT && "The scene buffer has to be updated before collecting draw items" );
+			drawItem.slot = gameObject.sceneSlot;
+			drawItem.modelMatrix = sceneBuffer.GetModelMatrix( drawItem.slot );
+
+			if ( filter == DrawItemFilter::Dynamic )
+			{
+				frustumCuller.Add( sceneBuffer.GetBoundingSphere( drawItem.slot ) );
+			}
+
+			items.push_back( drawItem );
+		}
+
+		// All bounds are tested in one go, the spheres were added in the order of the items
+		if ( filter == DrawItemFilter::Dynamic )
+		{
+			if ( signature != staticSignature )
+			{
+				staticSignature = signature;
+				staticVersion++;
+			}
+
+			frustumCuller.Cull( frameInfo.camera.GetFrustumPlanes() );
+
+			size_t visibleCount = 0;
+			for ( uint32_t i = 0; i < items.size(); i++ )
+			{
+				if ( frustumCuller.IsVisible( i ) )
+				{
+					items[ visibleCount++ ] = items[ i ];
+				}
+			}
+			items.resize( visibleCount );
+		}
+
+		// Culled objects keep their last level, so they come back into view without popping.
+		// Static objects are replayed from anywhere, so they're recorded at their finest level
+		for ( DrawItem& drawItem : items )
+		{
+			if ( filter != DrawItemFilter::Static )
+			{
+				drawItem.gameObject->lod = SelectLod( *drawItem.gameObject, drawItem.modelMatrix, frameInfo.camera );
+				drawItem.lod = drawItem.gameObject->lod;
+			}
+		}
+
+		// Grouped by pipeline and geometry binding first, so state changes only happen between groups, then by model and level of detail so each
+		// group is one instanced draw, and front to back within it
+		const glm::vec3 cameraPosition = frameInfo.camera.GetWorldSpacePosition();
+		renderQueue.Clear();
+		for ( uint32_t i = 0; i < items.size(); i++ )
+		{
+			const DrawItem& drawItem = items[ i ];
+			const AxeModel& model = *drawItem.model;
+
+			const uint32_t pipeline = drawItem.pipeline == packedVertexPipeline.get() ? 1 : 0;
+			// Models that share a geometry pool page and index type share the vertex/index buffer binding, which is all the material there is
+			const uint32_t material = model.GetGeometryPage() << 1 | ( model.GetIndexType() == VK_INDEX_TYPE_UINT32 ? 1 : 0 );
+
+			const glm::vec3 offset = glm::vec3{ sceneBuffer.GetBoundingSphere( drawItem.slot ) } - cameraPosition;
+
+			renderQueue.Submit( AxeRenderQueue::MakeOpaqueKey( pipeline, material, model.GetId() * AxeModel::MAX_LODS + drawItem.lod, glm::dot( offset, offset ) ), i );
+		}
+		renderQueue.Sort();
+
+		sortedDrawItems.clear();
+		for ( const AxeRenderQueue::Packet& packet : renderQueue.GetPackets() )
+		{
+			sortedDrawItems.push_back( items[ packet.payload ] );
+		}
+		std::swap( items, sortedDrawItems );
+	}
+
+	void SimpleRenderSystem::CullGameObjects( const FrameInfo& frameInfo )
+	{
+		if ( !gpuDriven )
+		{
+			return;
+		}
+
+		lodStatistics = {};
+		CollectDrawItems( frameInfo, DrawItemFilter::All, drawItems );
+
+		gpuObjects.clear();
+		gpuDraws.clear();
+		gpuBatches.clear();
+
+		for ( size_t drawStart = 0; drawStart < drawItems.size(); )
+		{
+			const DrawItem& first = drawItems[ drawStart ];
+			const AxeModel& model = *first.model;
+
+			size_t drawEnd = drawStart + 1;
+			while ( drawEnd < drawItems.size() && drawItems[ drawEnd ].model == first.model && drawItems[ drawEnd ].lod == first.lod )
+			{
+				drawEnd++;
+			}
+
+			// Indirect draws are indexed, models without indices are left out
+			if ( !model.HasIndices() )
+			{
+				drawStart = drawEnd;
+				continue;
+			}
+
+			// The sort keeps pipelines and geometry bindings together, so a batch ends where either changes
+			const bool newBatch = gpuBatches.empty() ||
+			                      gpuBatches.back().pipeline != first.pipeline ||
+			                      gpuBatches.back().model->GetGeometryPage() != model.GetGeometryPage() ||
+			                      gpuBatches.back().model->GetIndexType() != model.GetIndexType();
+			if ( newBatch )
+			{
+				gpuBatches.push_back( { first.pipeline, &model, static_cast<uint32_t>(gpuDraws.size()), 0 } );
+			}
+
+			GpuBatch& batch = gpuBatches.back();
+
+			AxeGpuCuller::Draw draw = {};
+			draw.command = model.GetIndirectCommand( first.lod );
+			draw.command.firstInstance = static_cast<uint32_t>(gpuObjects.size());
+			draw.batch = static_cast<uint32_t>(gpuBatches.size() - 1);
+			draw.batchFirstDraw = batch.firstDraw;
+
+			for ( size_t i = drawStart; i < drawEnd; i++ )
+			{
+				AxeGpuCuller::Object object = {};
+				object.slot = drawItems[ i ].slot;
+				object.drawIndex = static_cast<uint32_t>(gpuDraws.size());
+				gpuObjects.push_back( object );
+			}
+
+			// Counted before culling, the GPU knows how many of them end up drawn
+			const uint32_t objectCount = static_cast<uint32_t>(drawEnd - drawStart);
+			lodStatistics.objectCounts[ first.lod ] += objectCount;
+			lodStatistics.triangleCounts[ first.lod ] += static_cast<uint64_t>(model.GetTriangleCount( first.lod )) * objectCount;
+
+			gpuDraws.push_back( draw );
+			batch.drawCount++;
+
+			drawStart = drawEnd;
+		}
+
+		gpuCuller->Cull(
 			frameInfo.commandBuffer,
+			frameInfo.frameIndex,
+			gpuObjects,
+			gpuDraws,
+			static_cast<uint32_t>(gpuBatches.size()),
+			frameInfo.camera.GetFrustumPlanes() );
+	}
+
+	void SimpleRenderSystem::RenderGpuDriven( const FrameInfo& frameInfo )
+	{
+		// A handful of indirect draws, not worth spreading over the workers
+		const VkCommandBuffer commandBuffer = frameInfo.renderer.BeginSecondaryCommandBuffer( 0 );
+
+		const std::array<VkDescriptorSet, 3> descriptorSets = {
+			frameInfo.globalDescriptorSet,
+			gpuCuller->GetInstanceDescriptorSet( frameInfo.frameIndex ),
+			lightClusters.GetDescriptorSet( frameInfo.frameIndex )
+		};
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
-			1,
-			&frameInfo.globalDescriptorSet,
+			static_cast<uint32_t>(descriptorSets.size()),
+			descriptorSets.data(),
 			0,
 			nullptr
 		);
 
-		for ( auto& gameObject : frameInfo.gameObjects | std::views::values )
+		const AxePipeline* boundPipeline = nullptr;
+
+		for ( uint32_t i = 0; i < gpuBatches.size(); i++ )
 		{
-			// Skip the gameObject if there's no model to render			TODO: implement ECS instead
-			if ( gameObject.model == nullptr )
+			const GpuBatch& batch = gpuBatches[ i ];
+
+			if ( batch.pipeline != boundPipeline )
 			{
-				continue;
+				batch.pipeline->Bind( commandBuffer );
+				boundPipeline = batch.pipeline;
 			}
 
-			SimplePushConstantData push = {};
-			push.modelMatrix = gameObject.transform.Mat4();
-			push.normalMatrix = gameObject.transform.NormalMatrix();
+			// Consecutive batches always differ in pipeline or geometry binding
+			batch.model->Bind( commandBuffer );
+			gpuCuller->DrawBatch( commandBuffer, frameInfo.frameIndex, i, batch.firstDraw, batch.drawCount );
+		}
 
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof( SimplePushConstantData ),
-				&push
-			);
+		frameInfo.renderer.EndSecondaryCommandBuffer( commandBuffer );
+		vkCmdExecuteCommands( frameInfo.commandBuffer, 1, &commandBuffer );
+
+		drawCount = static_cast<uint32_t>(gpuBatches.size());
+	}
+
+	void SimpleRenderSystem::RenderGameObjects( const FrameInfo& frameInfo )
+	{
+		meshletStatistics = {};
+		drawCount = 0;
+
+		// The levels of detail were picked and counted by CullGameObjects
+		if ( gpuDriven )
+		{
+			RenderGpuDriven( frameInfo );
+			return;
+		}
+
+		CollectDrawItems( frameInfo, DrawItemFilter::Dynamic, drawItems );
+
+		// After collecting the dynamic objects, which noticed any static ones that were added, removed or changed model
+		UpdateStaticCache( frameInfo );
+
+		// The static objects' draws count every frame they're replayed
+		const StaticCache& staticCache = staticCaches[ frameInfo.frameIndex ];
+		lodStatistics = staticCache.recording.lodStatistics;
+		drawCount = staticCache.recording.recordedDrawCount;
+
+		ReserveInstances(
+			instanceBuffers[ frameInfo.frameIndex ],
+			instanceDescriptorSets[ frameInfo.frameIndex ],
+			instanceSceneGenerations[ frameInfo.frameIndex ],
+			drawItems.size() );
+		BuildInstancedDraws( drawItems );
+
+		// Split into contiguous runs of draws with about the same number of instances and draws each, one per worker.
+		// Small frames use fewer workers, handing out a few draws costs more than recording them
+		const uint32_t work = static_cast<uint32_t>(drawItems.size() + instancedDraws.size());
+		const uint32_t workerCount = std::clamp( work / MIN_RECORDING_WORK, 1u, frameInfo.renderer.GetWorkerCount() );
+
+		recordingChunks.resize( std::max<size_t>( recordingChunks.size(), workerCount ) );
+		uint32_t chunkCount = 0;
+		uint32_t chunkWork = 0;
+		uint32_t doneWork = 0;
+		for ( uint32_t i = 0; i < instancedDraws.size(); i++ )
+		{
+			if ( chunkWork == 0 )
+			{
+				recordingChunks[ chunkCount ].firstDraw = i;
+				recordingChunks[ chunkCount ].drawCount = 0;
+				chunkCount++;
+			}
+
+			recordingChunks[ chunkCount - 1 ].drawCount++;
+			chunkWork += instancedDraws[ i ].instanceCount + 1;
+			doneWork += instancedDraws[ i ].instanceCount + 1;
+
+			if ( static_cast<uint64_t>(doneWork) * workerCount >= static_cast<uint64_t>(work) * chunkCount )
+			{
+				chunkWork = 0;
+			}
+		}
+
+		const std::array<glm::vec4, 6> frustumPlanes = frameInfo.camera.GetFrustumPlanes();
+		const AxeBuffer& instanceBuffer = *instanceBuffers[ frameInfo.frameIndex ];
+
+		// Chunk i is recorded with worker i's command pool, so no two threads ever share one
+		AxeThreadPool::Shared().ParallelFor(
+			chunkCount,
+			[&]( const uint32_t chunk )
+			{
+				RecordingChunk& recordingChunk = recordingChunks[ chunk ];
+				recordingChunk.commandBuffer = frameInfo.renderer.BeginSecondaryCommandBuffer( chunk );
+				RecordChunk( frameInfo, recordingChunk.commandBuffer, instanceBuffer, instanceDescriptorSets[ frameInfo.frameIndex ], &frustumPlanes, drawItems, recordingChunk );
+				frameInfo.renderer.EndSecondaryCommandBuffer( recordingChunk.commandBuffer );
+			} );
+
+		// Executed in chunk order after the static objects, so the draws end up in the same order no matter which thread recorded what
+		secondaryCommandBuffers.clear();
+		if ( staticCache.recording.drawCount > 0 )
+		{
+			secondaryCommandBuffers.push_back( staticCache.commandBuffer );
+		}
+
+		for ( uint32_t chunk = 0; chunk < chunkCount; chunk++ )
+		{
+			const RecordingChunk& recordingChunk = recordingChunks[ chunk ];
+			secondaryCommandBuffers.push_back( recordingChunk.commandBuffer );
+
+			for ( uint32_t lod = 0; lod < AxeModel::MAX_LODS; lod++ )
+			{
+				lodStatistics.objectCounts[ lod ] += recordingChunk.lodStatistics.objectCounts[ lod ];
+				lodStatistics.triangleCounts[ lod ] += recordingChunk.lodStatistics.triangleCounts[ lod ];
+			}
+			meshletStatistics.meshletCount += recordingChunk.meshletStatistics.meshletCount;
+			meshletStatistics.frustumCulledCount += recordingChunk.meshletStatistics.frustumCulledCount;
+			meshletStatistics.backfaceCulledCount += recordingChunk.meshletStatistics.backfaceCulledCount;
+			meshletStatistics.drawCount += recordingChunk.meshletStatistics.drawCount;
+			drawCount += recordingChunk.recordedDrawCount;
+		}
+
+		if ( !secondaryCommandBuffers.empty() )
+		{
+			vkCmdExecuteCommands( frameInfo.commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data() );
+		}
+
+		if ( !drawItems.empty() && instanceBuffer.Flush() != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Error flushing instance buffer to GPU" );
+		}
+	}
+
+	void SimpleRenderSystem::BuildInstancedDraws( const std::vector<DrawItem>& items )
+	{
+		instancedDraws.clear();
+		for ( uint32_t drawStart = 0; drawStart < items.size(); )
+		{
+			uint32_t drawEnd = drawStart + 1;
+			while ( drawEnd < items.size() && items[ drawEnd ].model == items[ drawStart ].model && items[ drawEnd ].lod == items[ drawStart ].lod )
+			{
+				drawEnd++;
+			}
+
+			instancedDraws.push_back( { drawStart, drawEnd - drawStart } );
+			drawStart = drawEnd;
+		}
+	}
+
+	void SimpleRenderSystem::UpdateStaticCache( const FrameInfo& frameInfo )
+	{
+		StaticCache& staticCache = staticCaches[ frameInfo.frameIndex ];
+		// Pointing the cache's descriptor set at a replaced scene buffer, or the frame's light set at replaced light buffers, invalidates the recording as well
+		if ( staticCache.version == staticVersion &&
+		     staticCache.swapChainGeneration == frameInfo.renderer.GetSwapChainGeneration() &&
+		     staticCache.sceneGeneration == sceneBuffer.GetGeneration() &&
+		     staticCache.lightGeneration == lightClusters.GetGeneration() )
+		{
+			return;
+		}
+
+		CollectDrawItems( frameInfo, DrawItemFilter::Static, staticDrawItems );
+
+		// The frame's fence has been waited on, so its cache isn't in use and can be rewritten
+		ReserveInstances( staticCache.instanceBuffer, staticCache.instanceDescriptorSet, staticCache.sceneGeneration, staticDrawItems.size() );
+		BuildInstancedDraws( staticDrawItems );
+
+		staticCache.recording.firstDraw = 0;
+		staticCache.recording.drawCount = static_cast<uint32_t>(instancedDraws.size());
+
+		frameInfo.renderer.BeginCachedSecondaryCommandBuffer( staticCache.commandBuffer );
+		RecordChunk( frameInfo, staticCache.commandBuffer, *staticCache.instanceBuffer, staticCache.instanceDescriptorSet, nullptr, staticDrawItems, staticCache.recording );
+		frameInfo.renderer.EndSecondaryCommandBuffer( staticCache.commandBuffer );
+
+		if ( !staticDrawItems.empty() && staticCache.instanceBuffer->Flush() != VK_SUCCESS )
+		{
+			throw std::runtime_error( "Error flushing static instance buffer to GPU" );
+		}
+
+		staticCache.version = staticVersion;
+		staticCache.swapChainGeneration = frameInfo.renderer.GetSwapChainGeneration();
+		staticCache.lightGeneration = lightClusters.GetGeneration();
+	}
+
+	void SimpleRenderSystem::RecordChunk(
+		const FrameInfo& frameInfo,
+		const VkCommandBuffer commandBuffer,
+		const AxeBuffer& instanceBuffer,
+		const VkDescriptorSet instanceDescriptorSet,
+		const std::array<glm::vec4, 6>* frustumPlanes,
+		const std::vector<DrawItem>& items,
+		RecordingChunk& chunk ) const
+	{
+		chunk.lodStatistics = {};
+		chunk.meshletStatistics = {};
+		chunk.recordedDrawCount = 0;
 
-			gameObject.model->Bind( frameInfo.commandBuffer );
-			gameObject.model->Draw( frameInfo.commandBuffer );
+		// Secondary command buffers don't inherit bound state, every chunk binds its own
+		const std::array<VkDescriptorSet, 3> descriptorSets = {
+			frameInfo.globalDescriptorSet,
+			instanceDescriptorSet,
+			lightClusters.GetDescriptorSet( frameInfo.frameIndex )
+		};
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			0,
+			static_cast<uint32_t>(descriptorSets.size()),
+			descriptorSets.data(),
+			0,
+			nullptr
+		);
+
+		// Models that share a geometry pool page and index type also share the vertex/index buffer binding
+		uint32_t boundGeometryPage = AxeGeometryPool::INVALID_PAGE;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		// Both pipelines share the layout, so the descriptor sets stay bound when switching
+		const AxePipeline* boundPipeline = nullptr;
+
+		for ( uint32_t drawIndex = chunk.firstDraw; drawIndex < chunk.firstDraw + chunk.drawCount; drawIndex++ )
+		{
+			const InstancedDraw& instancedDraw = instancedDraws[ drawIndex ];
+			const DrawItem& first = items[ instancedDraw.firstItem ];
+			const AxeModel& model = *first.model;
+
+			// Instances are written in draw order, so the draw's instances are numbered from its first item on.
+			// Every chunk writes its own range of the instance buffer
+			const uint32_t firstInstance = instancedDraw.firstItem;
+			const uint32_t instanceCount = instancedDraw.instanceCount;
+
+			for ( uint32_t i = firstInstance; i < firstInstance + instanceCount; i++ )
+			{
+				instanceBuffer.WriteToBuffer( &items[ i ].slot, INSTANCE_SIZE, i * INSTANCE_SIZE );
+			}
+
+			if ( first.pipeline != boundPipeline )
+			{
+				first.pipeline->Bind( commandBuffer );
+				boundPipeline = first.pipeline;
+			}
+
+			if ( model.GetGeometryPage() != boundGeometryPage || model.GetIndexType() != boundIndexType )
+			{
+				model.Bind( commandBuffer );
+				boundGeometryPage = model.GetGeometryPage();
+				boundIndexType = model.GetIndexType();
+			}
+
+			chunk.lodStatistics.objectCounts[ first.lod ] += instanceCount;
+
+			// Meshlets only cover the finest level, coarser levels are small enough to draw whole.
+			// The visible meshlets differ per object, so only models drawn once get culled, shared models draw all of them instanced
+			const std::span<const AxeModel::Meshlet> meshlets = model.GetMeshlets();
+			if ( frustumPlanes != nullptr && first.lod == 0 && instanceCount == 1 && !meshlets.empty() )
+			{
+				// Culled in object space, meshlet bounds are in the model's space rather than the packed vertex format's
+				const glm::vec3 objectCameraPosition = glm::inverse( first.modelMatrix ) * glm::vec4{ frameInfo.camera.GetWorldSpacePosition(), 1.0f };
+
+				chunk.drawRanges.clear();
+				AxeMeshletCuller::Cull(
+					meshlets,
+					AxeMeshletCuller::TransformPlanes( *frustumPlanes, first.modelMatrix ),
+					objectCameraPosition,
+					chunk.drawRanges,
+					chunk.meshletStatistics );
+
+				for ( const AxeMeshletCuller::DrawRange& drawRange : chunk.drawRanges )
+				{
+					model.DrawRange( commandBuffer, drawRange.firstIndex, drawRange.indexCount, 1, firstInstance );
+					chunk.lodStatistics.triangleCounts[ 0 ] += drawRange.indexCount / 3;
+				}
+
+				chunk.recordedDrawCount += static_cast<uint32_t>(chunk.drawRanges.size());
+			}
+			else
+			{
+				model.Draw( commandBuffer, first.lod, instanceCount, firstInstance );
+				chunk.lodStatistics.triangleCounts[ first.lod ] += static_cast<uint64_t>(model.GetTriangleCount( first.lod )) * instanceCount;
+				chunk.recordedDrawCount++;
+			}
 		}
 	}
 }
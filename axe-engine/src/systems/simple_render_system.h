@@ -1,17 +1,55 @@
 ﻿#pragma once
 
+#include "axe_buffer.h"
+#include "axe_descriptors.h"
 #include "axe_device.h"
 #include "axe_pipeline.h"
 #include "axe_frame_info.h"
+#include "axe_frustum_culler.h"
+#include "axe_gpu_culler.h"
+#include "axe_light_clusters.h"
+#include "axe_meshlet_culler.h"
+#include "axe_render_queue.h"
+#include "axe_scene_buffer.h"
 
+#include <array>
 #include <memory>
+#include <vector>
 
 namespace Axe
 {
+	// Draws the game objects that survive frustum culling grouped by model and level of detail, each group is one instanced draw.
+	// The instances' scene buffer slots go in a per-frame storage buffer that the vertex shaders index with gl_InstanceIndex, the matrices
+	// themselves are fetched from the scene buffer. The fragment shader lights them with the point lights of their AxeLightClusters cluster.
+	// In GPU-driven mode the objects are frustum culled by AxeGpuCuller instead, which writes the instances and the draws itself.
+	// The CPU-driven draws are split into contiguous chunks recorded in parallel into secondary command buffers, executed in chunk order.
+	// Static objects are recorded once per frame in flight into a cached secondary command buffer and replayed until they change, at their finest
+	// level and without culling since both depend on the camera. The GPU-driven mode culls them with the rest
 	class SimpleRenderSystem
 	{
 	public:
-		SimpleRenderSystem( AxeDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout );
+		// The instance buffers start out with room for this many instances and double whenever they run out
+		static constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 256;
+
+		// Largest error of a level of detail on screen, as a fraction of half the screen height (about a pixel at 900 pixels high)
+		static constexpr float LOD_ERROR_THRESHOLD = 0.002f;
+		// A coarser level is only picked once its error is this much below the threshold, so objects near a switching distance don't keep popping
+		static constexpr float LOD_HYSTERESIS = 0.25f;
+		// Instances plus draws a recording chunk should have at least, below that fewer workers record the frame
+		static constexpr uint32_t MIN_RECORDING_WORK = 256;
+
+		struct LodStatistics
+		{
+			uint32_t objectCounts[ AxeModel::MAX_LODS ] = {};
+			uint64_t triangleCounts[ AxeModel::MAX_LODS ] = {};
+		};
+
+		SimpleRenderSystem(
+			AxeDevice& device,
+			const AxeSceneBuffer& sceneBuffer,
+			const AxeLightClusters& lightClusters,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout );
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem( const SimpleRenderSystem& ) = delete;
@@ -20,14 +58,153 @@ namespace Axe
 		SimpleRenderSystem& operator=( const SimpleRenderSystem&& ) = delete;
 
 
-		void RenderGameObjects( const FrameInfo& frameInfo ) const;
+		// Records the GPU-driven mode's culling passes, has to come before the render pass of the same frame's RenderGameObjects call.
+		// Does nothing in the CPU-driven mode
+		void CullGameObjects( const FrameInfo& frameInfo );
+		void RenderGameObjects( const FrameInfo& frameInfo );
+
+		// The GPU-driven mode needs multiDrawIndirect and drawIndirectCount, without them the CPU-driven mode is always used
+		[[nodiscard]] bool SupportsGpuDriven() const { return gpuCuller != nullptr; }
+		[[nodiscard]] bool IsGpuDriven() const { return gpuDriven; }
+		void SetGpuDriven( const bool enabled ) { gpuDriven = enabled && SupportsGpuDriven(); }
+
+		// What the last RenderGameObjects call drew per level of detail
+		[[nodiscard]] const LodStatistics& GetLodStatistics() const { return lodStatistics; }
+		// What the last RenderGameObjects call culled of the meshlets of objects drawn at their finest level
+		[[nodiscard]] const AxeMeshletCuller::Statistics& GetMeshletStatistics() const { return meshletStatistics; }
+		// How many draw calls the last RenderGameObjects call recorded, an indirect draw counts once however many draws it ends up making
+		[[nodiscard]] uint32_t GetDrawCount() const { return drawCount; }
+		// What the last RenderGameObjects call culled on the CPU, nothing in the GPU-driven mode and never the static objects
+		[[nodiscard]] const AxeFrustumCuller::Statistics& GetCullingStatistics() const { return frustumCuller.GetStatistics(); }
+		// How many objects survived frustum culling in the GPU-driven mode, a few frames late since it's read back from the GPU
+		[[nodiscard]] uint32_t GetVisibleObjectCount() const { return gpuCuller ? gpuCuller->GetVisibleObjectCount() : 0; }
 
 	private:
+		// A game object to draw this frame, sorted by the render queue so objects sharing a model and level of detail end up next to each other
+		struct DrawItem
+		{
+			const AxePipeline* pipeline = nullptr;
+			const AxeModel* model = nullptr;
+			uint32_t lod = 0;
+			AxeGameObject* gameObject = nullptr;
+			uint32_t slot = 0;	// In the scene buffer
+			glm::mat4 modelMatrix{ 1.0f };
+		};
+
+		// Consecutive GPU-driven draws sharing a pipeline and geometry binding, drawn with one indirect draw
+		struct GpuBatch
+		{
+			const AxePipeline* pipeline = nullptr;
+			const AxeModel* model = nullptr;	// Any of the batch's models, they all bind the same geometry
+			uint32_t firstDraw = 0;
+			uint32_t drawCount = 0;
+		};
+
+		// Consecutive draw items sharing a model and level of detail, drawn with one instanced draw
+		struct InstancedDraw
+		{
+			uint32_t firstItem = 0;
+			uint32_t instanceCount = 0;
+		};
+
+		// A contiguous run of instanced draws recorded by one worker, with what the recording counted so it can be summed up afterwards
+		struct RecordingChunk
+		{
+			uint32_t firstDraw = 0;
+			uint32_t drawCount = 0;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			LodStatistics lodStatistics = {};
+			AxeMeshletCuller::Statistics meshletStatistics = {};
+			uint32_t recordedDrawCount = 0;
+			std::vector<AxeMeshletCuller::DrawRange> drawRanges = {};	// Reused between objects and frames
+		};
+
+		// The static objects recorded for a frame in flight, with their own instance buffer since the frame's one is rewritten every frame
+		struct StaticCache
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			std::unique_ptr<AxeBuffer> instanceBuffer = {};
+			VkDescriptorSet instanceDescriptorSet = VK_NULL_HANDLE;
+			uint64_t version = 0;	// The static version it was recorded at, 0 until it's recorded
+			uint32_t swapChainGeneration = 0;
+			uint32_t sceneGeneration = 0;	// Of the scene buffer the descriptor set points at
+			uint32_t lightGeneration = 0;	// Of the light buffers the frame's light set pointed at when recording
+			RecordingChunk recording = {};
+		};
+
+		// Which game objects CollectDrawItems collects
+		enum class DrawItemFilter
+		{
+			All,	// For the GPU-driven mode, which culls on the GPU
+			Dynamic,	// Frustum culled
+			Static	// Not culled, at their finest level
+		};
+
 		AxeDevice& axeDevice;
+		const AxeSceneBuffer& sceneBuffer;
+		const AxeLightClusters& lightClusters;
 
 		VkPipelineLayout pipelineLayout = {};
 		std::unique_ptr<AxePipeline> axePipeline;
+		std::unique_ptr<AxePipeline> packedVertexPipeline;	// For models with AxeModel::VertexFormat::Packed
+
+		std::unique_ptr<AxeDescriptorSetLayout> instanceSetLayout = {};
+		std::unique_ptr<AxeDescriptorPool> instancePool = {};
+		// One per frame in flight, a frame only rewrites its buffer once the GPU is done with it
+		std::vector<std::unique_ptr<AxeBuffer>> instanceBuffers = {};
+		std::vector<VkDescriptorSet> instanceDescriptorSets = {};
+		std::vector<uint32_t> instanceSceneGenerations = {};	// Of the scene buffer each descriptor set points at
+
+		LodStatistics lodStatistics = {};
+		AxeMeshletCuller::Statistics meshletStatistics = {};
+		uint32_t drawCount = 0;
+		std::vector<DrawItem> drawItems = {};	// Reused between frames
+		std::vector<DrawItem> sortedDrawItems = {};	// Swapped with drawItems after sorting, reused between frames
+		AxeRenderQueue renderQueue = {};
+		AxeFrustumCuller frustumCuller = {};
+		// Reused between frames
+		std::vector<InstancedDraw> instancedDraws = {};
+		std::vector<RecordingChunk> recordingChunks = {};
+		std::vector<VkCommandBuffer> secondaryCommandBuffers = {};
+
+		VkCommandPool staticCommandPool = VK_NULL_HANDLE;
+		std::vector<StaticCache> staticCaches = {};	// One per frame in flight
+		std::vector<DrawItem> staticDrawItems = {};	// Reused between recordings
+		uint64_t staticVersion = 1;
+		// Count and order independent hash of the static objects' ids and models, a change means one was added, removed or got another model
+		uint64_t staticSignature = 0;
+
+		std::unique_ptr<AxeGpuCuller> gpuCuller = {};
+		bool gpuDriven = false;
+		// Built by CullGameObjects for RenderGameObjects, reused between frames
+		std::vector<AxeGpuCuller::Object> gpuObjects = {};
+		std::vector<AxeGpuCuller::Draw> gpuDraws = {};
+		std::vector<GpuBatch> gpuBatches = {};
+
+		// Collects the game objects with a model that pass the filter, culls the dynamic ones, picks their level of detail and sorts them into drawItems.
+		// Collecting the dynamic ones also checks whether the static ones were added, removed or changed model
+		void CollectDrawItems( const FrameInfo& frameInfo, DrawItemFilter filter, std::vector<DrawItem>& items );
+		// Groups the sorted draw items sharing a model and level of detail into instancedDraws
+		void BuildInstancedDraws( const std::vector<DrawItem>& items );
+		void RenderGpuDriven( const FrameInfo& frameInfo );
+		// Records the static objects into the frame's cache if they changed since it was recorded, or the swap chain or a buffer it binds did
+		void UpdateStaticCache( const FrameInfo& frameInfo );
+		// Records the chunk's draws into a begun secondary command buffer, writing their instances to the instance buffer as it goes.
+		// Without frustum planes every meshlet is drawn, for draws that are replayed from other viewpoints
+		void RecordChunk(
+			const FrameInfo& frameInfo,
+			VkCommandBuffer commandBuffer,
+			const AxeBuffer& instanceBuffer,
+			VkDescriptorSet instanceDescriptorSet,
+			const std::array<glm::vec4, 6>* frustumPlanes,
+			const std::vector<DrawItem>& items,
+			RecordingChunk& chunk ) const;
 
+		void CreateInstanceBuffers();
+		void CreateStaticCaches();
+		// Replaces the instance buffer with one twice as large until the instances fit, and points the descriptor set at the new one.
+		// Also points it at the scene buffer again if that was replaced since
+		void ReserveInstances( std::unique_ptr<AxeBuffer>& instanceBuffer, VkDescriptorSet descriptorSet, uint32_t& sceneGeneration, size_t instanceCount );
 		void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void CreatePipeline( VkRenderPass renderPass );
 	};